@@ -30,6 +30,7 @@ class type_unit;
 class die;
 class value;
 class expr;
+struct loclist_entry;
 class expr_context;
 class expr_result;
 class rangelist;
@@ -39,6 +40,7 @@ class line_table;
 struct section;
 struct abbrev_entry;
 struct cursor;
+struct expr_program;
 
 // XXX Audit for binary-compatibility
 
@@ -55,8 +57,8 @@ struct cursor;
 
 // XXX Indicate DWARF4 in all spec references
 
-// XXX Big missing support: .debug_aranges, .debug_frame, loclists,
-// macros
+// XXX Big missing support: .debug_aranges, .debug_frame, DWARF 5
+// loclists, macros
 
 //////////////////////////////////////////////////////////////////
 // DWARF files
@@ -247,6 +249,15 @@ public:
          */
         const abbrev_entry &get_abbrev(std::uint64_t acode) const;
 
+        /**
+         * \internal Return the cache slot for the pre-decoded form of
+         * the expression at offset in section sec (relative to this
+         * unit for .debug_info).  The slot is empty until the
+         * expression is first evaluated.
+         */
+        std::unique_ptr<expr_program> &
+        get_expr_program(section_type sec, section_offset offset) const;
+
 protected:
         friend struct ::std::hash<unit>;
         struct impl;
@@ -660,7 +671,15 @@ public:
          */
         bool as_flag() const;
 
-        // XXX loclistptr, macptr
+        // XXX macptr
+
+        /**
+         * Return this value as a location list (a loclistptr into
+         * .debug_loc).  Entries are returned in the order they
+         * appear in the list, with base address selection entries
+         * already applied, so low and high are absolute addresses.
+         */
+        std::vector<loclist_entry> as_loclist() const;
 
         /**
          * Return this value as a rangelist.
@@ -771,13 +790,29 @@ private:
         expr(const unit *cu,
              section_offset offset, section_length len);
 
+        // An expression stored outside the unit's .debug_info
+        // data, such as in a location list in .debug_loc.
+        expr(const unit *cu, section_type sec,
+             section_offset offset, section_length len);
+
         friend class value;
 
         const unit *cu;
+        section_type sec;
         section_offset offset;
         section_length len;
 };
 
+/**
+ * An entry in a location list: the location description that applies
+ * while the PC is in [low, high).
+ */
+struct loclist_entry
+{
+        taddr low, high;
+        expr location;
+};
+
 /**
  * An interface that provides contextual information for expression
  * evaluation.  Callers of expr::evaluate are expected to subclass
@@ -799,6 +834,25 @@ public:
                 throw expr_error("DW_OP_breg* operations not supported");
         }
 
+        /**
+         * Return the frame base of the function whose variable is
+         * being located (the value of its DW_AT_frame_base).  This is
+         * used to implement DW_OP_fbreg.
+         */
+        virtual taddr frame_base()
+        {
+                throw expr_error("DW_OP_fbreg operations not supported");
+        }
+
+        /**
+         * Return the canonical frame address of the current frame.
+         * This is used to implement DW_OP_call_frame_cfa.
+         */
+        virtual taddr call_frame_cfa()
+        {
+                throw expr_error("DW_OP_call_frame_cfa operations not supported");
+        }
+
         /**
          * Implement DW_OP_deref_size.
          */
@@ -822,6 +876,17 @@ public:
         {
                 throw expr_error("DW_OP_form_tls_address operations not supported");
         }
+
+        /**
+         * Translate the link-time address operand of DW_OP_addr to
+         * a run-time address (for example, by adding the load bias
+         * of a position-independent executable).  The default
+         * returns the address unchanged.
+         */
+        virtual taddr relocate(taddr address)
+        {
+                return address;
+        }
 };
 
 /**
@@ -158,6 +158,10 @@ struct unit::impl
         std::vector<abbrev_entry> abbrevs_vec;
         std::unordered_map<abbrev_code, abbrev_entry> abbrevs_map;
 
+        // Pre-decoded expressions, keyed by section type in the top
+        // byte and offset in the rest
+        std::unordered_map<uint64_t, std::unique_ptr<expr_program> > exprs;
+
         impl(const dwarf &file, section_offset offset,
              const std::shared_ptr<section> &subsec,
              section_offset debug_abbrev_offset, section_offset root_offset,
@@ -227,6 +231,12 @@ unknown:
         throw format_error("unknown abbrev code 0x" + to_hex(acode));
 }
 
+std::unique_ptr<expr_program> &
+unit::get_expr_program(section_type sec, section_offset offset) const
+{
+        return m->exprs[((uint64_t)sec << 56) | offset];
+}
+
 void
 unit::impl::force_abbrevs()
 {
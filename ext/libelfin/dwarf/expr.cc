@@ -12,7 +12,13 @@ expr_context no_expr_context;
 
 expr::expr(const unit *cu,
            section_offset offset, section_length len)
-        : cu(cu), offset(offset), len(len)
+        : cu(cu), sec(section_type::info), offset(offset), len(len)
+{
+}
+
+expr::expr(const unit *cu, section_type sec,
+           section_offset offset, section_length len)
+        : cu(cu), sec(sec), offset(offset), len(len)
 {
 }
 
@@ -28,33 +34,231 @@ expr::evaluate(expr_context *ctx, taddr argument) const
         return evaluate(ctx, {argument});
 }
 
+constexpr ubyte expr_program::op_fault;
+constexpr uint64_t expr_program::bad_target;
+constexpr unsigned expr_program::max_stack;
+
+/**
+ * Decode the raw DW_OP bytes of an expression into an expr_program.
+ * Decoding stops at the first operation that cannot be decoded; that
+ * point becomes an op_fault instruction, so the error is raised only
+ * if evaluation actually reaches it.
+ */
+static unique_ptr<expr_program>
+decode_expr(const unit *cu, section_type sec,
+            section_offset offset, section_length len)
+{
+        // Create a subsection for just this expression so we can
+        // easily detect the end (including premature end).
+        auto cusec = cu->data();
+        auto base = sec == section_type::info ? cusec : cu->get_dwarf().get_section(sec);
+        shared_ptr<section> subsec
+                (make_shared<section>(cusec->type,
+                                      base->begin + offset, len,
+                                      cusec->ord, cusec->fmt,
+                                      cusec->addr_size));
+        cursor cur(subsec);
+
+        unique_ptr<expr_program> prog(new expr_program);
+        prog->addr_size = subsec->addr_size;
+
+        // Byte offset of each instruction, and branches whose byte
+        // targets must be mapped to instruction indexes
+        vector<section_offset> starts;
+        vector<pair<size_t, int64_t> > branches;
+
+        auto fault = [&](const string &message) {
+                prog->insns.push_back(expr_insn{expr_program::op_fault,
+                                                prog->messages.size(), 0});
+                prog->messages.push_back(message);
+        };
+
+        try {
+                while (!cur.end()) {
+                        starts.push_back(cur.get_section_offset());
+                        expr_insn insn{cur.fixed<ubyte>(), 0, 0};
+                        DW_OP op = (DW_OP)insn.op;
+                        switch (op) {
+                        case DW_OP::addr:
+                                insn.a = cur.address();
+                                break;
+                        case DW_OP::const1u:
+                                insn.a = cur.fixed<uint8_t>();
+                                break;
+                        case DW_OP::const2u:
+                                insn.a = cur.fixed<uint16_t>();
+                                break;
+                        case DW_OP::const4u:
+                                insn.a = cur.fixed<uint32_t>();
+                                break;
+                        case DW_OP::const8u:
+                                insn.a = cur.fixed<uint64_t>();
+                                break;
+                        case DW_OP::const1s:
+                                insn.a = (int64_t)cur.fixed<int8_t>();
+                                break;
+                        case DW_OP::const2s:
+                                insn.a = (int64_t)cur.fixed<int16_t>();
+                                break;
+                        case DW_OP::const4s:
+                                insn.a = (int64_t)cur.fixed<int32_t>();
+                                break;
+                        case DW_OP::const8s:
+                                insn.a = cur.fixed<int64_t>();
+                                break;
+                        case DW_OP::constu:
+                        case DW_OP::plus_uconst:
+                        case DW_OP::regx:
+                        case DW_OP::piece:
+                                insn.a = cur.uleb128();
+                                break;
+                        case DW_OP::consts:
+                        case DW_OP::fbreg:
+                                insn.a = cur.sleb128();
+                                break;
+                        case DW_OP::breg0...DW_OP::breg31:
+                                insn.a = (unsigned)op - (unsigned)DW_OP::breg0;
+                                insn.b = cur.sleb128();
+                                break;
+                        case DW_OP::bregx:
+                                insn.a = cur.uleb128();
+                                insn.b = cur.sleb128();
+                                break;
+                        case DW_OP::bit_piece:
+                                insn.a = cur.uleb128();
+                                insn.b = cur.uleb128();
+                                break;
+                        case DW_OP::pick:
+                                insn.a = cur.fixed<uint8_t>();
+                                break;
+                        case DW_OP::deref:
+                        case DW_OP::xderef:
+                                insn.a = subsec->addr_size;
+                                break;
+                        case DW_OP::deref_size:
+                        case DW_OP::xderef_size:
+                                insn.a = cur.fixed<uint8_t>();
+                                if (insn.a > subsec->addr_size) {
+                                        fault(to_string(op) + " operand exceeds address size");
+                                        return prog;
+                                }
+                                break;
+                        case DW_OP::skip:
+                        case DW_OP::bra: {
+                                int64_t rel = cur.fixed<int16_t>();
+                                branches.emplace_back(prog->insns.size(),
+                                                      (int64_t)cur.get_section_offset() + rel);
+                                break;
+                        }
+                        case DW_OP::call2:
+                                insn.a = cur.fixed<uint16_t>();
+                                break;
+                        case DW_OP::call4:
+                                insn.a = cur.fixed<uint32_t>();
+                                break;
+                        case DW_OP::call_ref:
+                                insn.a = cur.offset();
+                                break;
+                        case DW_OP::implicit_value:
+                                insn.a = cur.uleb128();
+                                cur.ensure(insn.a);
+                                insn.b = (uintptr_t)cur.pos;
+                                cur += insn.a;
+                                break;
+
+                        case DW_OP::lit0...DW_OP::lit31:
+                        case DW_OP::reg0...DW_OP::reg31:
+                        case DW_OP::dup:
+                        case DW_OP::drop:
+                        case DW_OP::over:
+                        case DW_OP::swap:
+                        case DW_OP::rot:
+                        case DW_OP::push_object_address:
+                        case DW_OP::form_tls_address:
+                        case DW_OP::call_frame_cfa:
+                        case DW_OP::abs:
+                        case DW_OP::and_:
+                        case DW_OP::div:
+                        case DW_OP::minus:
+                        case DW_OP::mod:
+                        case DW_OP::mul:
+                        case DW_OP::neg:
+                        case DW_OP::not_:
+                        case DW_OP::or_:
+                        case DW_OP::plus:
+                        case DW_OP::shl:
+                        case DW_OP::shr:
+                        case DW_OP::shra:
+                        case DW_OP::xor_:
+                        case DW_OP::le:
+                        case DW_OP::ge:
+                        case DW_OP::eq:
+                        case DW_OP::lt:
+                        case DW_OP::gt:
+                        case DW_OP::ne:
+                        case DW_OP::nop:
+                        case DW_OP::stack_value:
+                                break;
+
+                        case DW_OP::lo_user...DW_OP::hi_user:
+                                // XXX We could let the context evaluate this,
+                                // but we don't know its operand length.
+                                fault("unknown user op " + to_string(op));
+                                return prog;
+
+                        default:
+                                fault("bad operation " + to_string(op));
+                                return prog;
+                        }
+                        prog->insns.push_back(insn);
+                }
+        } catch (format_error &e) {
+                // Truncated operand
+                fault(e.what());
+        }
+
+        // Resolve branch targets.  A target one past the last
+        // operation ends the expression.
+        for (auto &branch : branches) {
+                auto &insn = prog->insns[branch.first];
+                insn.a = expr_program::bad_target;
+                if (branch.second == (int64_t)len && prog->messages.empty()) {
+                        insn.a = prog->insns.size();
+                } else if (branch.second >= 0) {
+                        auto it = lower_bound(starts.begin(), starts.end(),
+                                              (section_offset)branch.second);
+                        if (it != starts.end() && *it == (section_offset)branch.second)
+                                insn.a = it - starts.begin();
+                }
+        }
+        return prog;
+}
+
 expr_result
 expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments) const
 {
+        // Decode once per (unit, section, offset); later evaluations
+        // run straight from the cached instructions.
+        auto &slot = cu->get_expr_program(sec, offset);
+        if (!slot)
+                slot = decode_expr(cu, sec, offset, len);
+        const expr_program &prog = *slot;
+
         // The stack machine's stack.  The top of the stack is
-        // stack.back().
+        // stack[sp - 1].  It has a fixed capacity so evaluation
+        // never allocates.
         // XXX This stack must be in target machine representation,
         // since I see both (DW_OP_breg0 (eax): -28; DW_OP_stack_value)
         // and (DW_OP_lit1; DW_OP_stack_value).
-        small_vector<taddr, 8> stack;
+        taddr stack[expr_program::max_stack];
+        size_t sp = 0;
 
         // Create the initial stack.  arguments are in reverse order
         // (that is, element 0 is TOS), so reverse it.
-        stack.reserve(arguments.size());
-        if(arguments.size() != 0){
-                for (const taddr *elt = arguments.end() - 1;    elt >= arguments.begin();       elt--)
-                        stack.push_back(*elt);
-        }
-
-        // Create a subsection for just this expression so we can
-        // easily detect the end (including premature end).
-        auto cusec = cu->data();
-        shared_ptr<section> subsec
-                (make_shared<section>(cusec->type,
-                                      cusec->begin + offset, len,
-                                      cusec->ord, cusec->fmt,
-                                      cusec->addr_size));
-        cursor cur(subsec);
+        if (arguments.size() > expr_program::max_stack)
+                throw expr_error("too many arguments to DWARF expression");
+        for (auto elt = arguments.end(); elt != arguments.begin(); )
+                stack[sp++] = *--elt;
 
         // Prepare the expression result.  Some location descriptions
         // create the result directly, rather than using the top of
@@ -62,7 +266,7 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
         expr_result result;
 
         // 2.6.1.1.4 Empty location descriptions
-        if (cur.end()) {
+        if (prog.insns.empty()) {
                 result.location_type = expr_result::type::empty;
                 result.value = 0;
                 return result;
@@ -72,10 +276,17 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
         // grabbed from the top of stack at the end.
         result.location_type = expr_result::type::address;
 
+        const expr_insn *insns = prog.insns.data();
+        const size_t count = prog.insns.size();
+        size_t pc = 0;
+
         // Execute!
-        while (!cur.end()) {
-#define CHECK() do { if (stack.empty()) goto underflow; } while (0)
-#define CHECKN(n) do { if (stack.size() < n) goto underflow; } while (0)
+        while (pc < count) {
+#define CHECK() do { if (sp == 0) goto underflow; } while (0)
+#define CHECKN(n) do { if (sp < (n)) goto underflow; } while (0)
+#define PUSH(v) do { taddr v_ = (v); if (sp == expr_program::max_stack) goto overflow; stack[sp++] = v_; } while (0)
+#define TOP stack[sp - 1]
+#define REVAT(n) stack[sp - 1 - (n)]
                 union
                 {
                         uint64_t u;
@@ -83,166 +294,134 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
                 } tmp1, tmp2, tmp3;
                 static_assert(sizeof(tmp1) == sizeof(taddr), "taddr is not 64 bits");
 
+                const expr_insn &insn = insns[pc++];
+
                 // Tell GCC to warn us about missing switch cases,
                 // even though we have a default case.
 #pragma GCC diagnostic push
 #pragma GCC diagnostic warning "-Wswitch-enum"
-                DW_OP op = (DW_OP)cur.fixed<ubyte>();
+                DW_OP op = (DW_OP)insn.op;
                 switch (op) {
                         // 2.5.1.1 Literal encodings
                 case DW_OP::lit0...DW_OP::lit31:
-                        stack.push_back((unsigned)op - (unsigned)DW_OP::lit0);
+                        PUSH((unsigned)op - (unsigned)DW_OP::lit0);
                         break;
                 case DW_OP::addr:
-                        stack.push_back(cur.address());
+                        PUSH(ctx->relocate(insn.a));
                         break;
                 case DW_OP::const1u:
-                        stack.push_back(cur.fixed<uint8_t>());
-                        break;
                 case DW_OP::const2u:
-                        stack.push_back(cur.fixed<uint16_t>());
-                        break;
                 case DW_OP::const4u:
-                        stack.push_back(cur.fixed<uint32_t>());
-                        break;
                 case DW_OP::const8u:
-                        stack.push_back(cur.fixed<uint64_t>());
-                        break;
                 case DW_OP::const1s:
-                        stack.push_back(cur.fixed<int8_t>());
-                        break;
                 case DW_OP::const2s:
-                        stack.push_back(cur.fixed<int16_t>());
-                        break;
                 case DW_OP::const4s:
-                        stack.push_back(cur.fixed<int32_t>());
-                        break;
                 case DW_OP::const8s:
-                        stack.push_back(cur.fixed<int64_t>());
-                        break;
                 case DW_OP::constu:
-                        stack.push_back(cur.uleb128());
-                        break;
                 case DW_OP::consts:
-                        stack.push_back(cur.sleb128());
+                        PUSH(insn.a);
                         break;
 
-                //@todo type of offset?
                         // 2.5.1.2 Register based addressing
-                case DW_OP::fbreg: {
-                        uint64_t offset = cur.sleb128(); // 获取SLEB128编码的偏移量
-                        auto frameBase = ctx->reg(6); // 
-                        stack.push_back(frameBase + offset); // 将帧基址和偏移量相加的结果压栈
+                case DW_OP::fbreg:
+                        PUSH((int64_t)ctx->frame_base() + (int64_t)insn.a);
                         break;
-                }
                 case DW_OP::breg0...DW_OP::breg31:
-                        tmp1.u = (unsigned)op - (unsigned)DW_OP::breg0;
-                        tmp2.s = cur.sleb128();
-                        stack.push_back((int64_t)ctx->reg(tmp1.u) + tmp2.s);
-                        break;
                 case DW_OP::bregx:
-                        tmp1.u = cur.uleb128();
-                        tmp2.s = cur.sleb128();
-                        stack.push_back((int64_t)ctx->reg(tmp1.u) + tmp2.s);
+                        PUSH((int64_t)ctx->reg(insn.a) + (int64_t)insn.b);
                         break;
 
                         // 2.5.1.3 Stack operations
                 case DW_OP::dup:
                         CHECK();
-                        stack.push_back(stack.back());
+                        PUSH(TOP);
                         break;
                 case DW_OP::drop:
                         CHECK();
-                        stack.pop_back();
+                        sp--;
                         break;
                 case DW_OP::pick:
-                        tmp1.u = cur.fixed<uint8_t>();
-                        CHECKN(tmp1.u);
-                        stack.push_back(stack.revat(tmp1.u));
+                        CHECKN(insn.a + 1);
+                        PUSH(REVAT(insn.a));
                         break;
                 case DW_OP::over:
                         CHECKN(2);
-                        stack.push_back(stack.revat(1));
+                        PUSH(REVAT(1));
                         break;
                 case DW_OP::swap:
                         CHECKN(2);
-                        tmp1.u = stack.back();
-                        stack.back() = stack.revat(1);
-                        stack.revat(1) = tmp1.u;
+                        tmp1.u = TOP;
+                        TOP = REVAT(1);
+                        REVAT(1) = tmp1.u;
                         break;
                 case DW_OP::rot:
                         CHECKN(3);
-                        tmp1.u = stack.back();
-                        stack.back() = stack.revat(1);
-                        stack.revat(1) = stack.revat(2);
-                        stack.revat(2) = tmp1.u;
+                        tmp1.u = TOP;
+                        TOP = REVAT(1);
+                        REVAT(1) = REVAT(2);
+                        REVAT(2) = tmp1.u;
                         break;
                 case DW_OP::deref:
-                        tmp1.u = subsec->addr_size;
-                        goto deref_common;
                 case DW_OP::deref_size:
-                        tmp1.u = cur.fixed<uint8_t>();
-                        if (tmp1.u > subsec->addr_size)
-                                throw expr_error("DW_OP_deref_size operand exceeds address size");
-                deref_common:
                         CHECK();
-                        stack.back() = ctx->deref_size(stack.back(), tmp1.u);
+                        TOP = ctx->deref_size(TOP, insn.a);
                         break;
                 case DW_OP::xderef:
-                        tmp1.u = subsec->addr_size;
-                        goto xderef_common;
                 case DW_OP::xderef_size:
-                        tmp1.u = cur.fixed<uint8_t>();
-                        if (tmp1.u > subsec->addr_size)
-                                throw expr_error("DW_OP_xderef_size operand exceeds address size");
-                xderef_common:
                         CHECKN(2);
-                        tmp2.u = stack.back();
-                        stack.pop_back();
-                        stack.back() = ctx->xderef_size(tmp2.u, stack.back(), tmp1.u);
+                        tmp2.u = TOP;
+                        sp--;
+                        TOP = ctx->xderef_size(tmp2.u, TOP, insn.a);
                         break;
                 case DW_OP::push_object_address:
                         // XXX
                         throw runtime_error("DW_OP_push_object_address not implemented");
                 case DW_OP::form_tls_address:
                         CHECK();
-                        stack.back() = ctx->form_tls_address(stack.back());
+                        TOP = ctx->form_tls_address(TOP);
                         break;
                 case DW_OP::call_frame_cfa:
-                        // XXX
-                        throw runtime_error("DW_OP_call_frame_cfa not implemented");
+                        PUSH(ctx->call_frame_cfa());
+                        break;
 
                         // 2.5.1.4 Arithmetic and logical operations
 #define UBINOP(binop)                                                   \
                         do {                                            \
                                 CHECKN(2);                              \
-                                tmp1.u = stack.back();                  \
-                                stack.pop_back();                       \
-                                tmp2.u = stack.back();                  \
-                                stack.back() = tmp2.u binop tmp1.u;     \
+                                tmp1.u = TOP;                           \
+                                sp--;                                   \
+                                TOP = TOP binop tmp1.u;                 \
                         } while (0)
                 case DW_OP::abs:
                         CHECK();
-                        tmp1.u = stack.back();
+                        tmp1.u = TOP;
                         if (tmp1.s < 0)
                                 tmp1.s = -tmp1.s;
-                        stack.back() = tmp1.u;
+                        TOP = tmp1.u;
                         break;
                 case DW_OP::and_:
                         UBINOP(&);
                         break;
                 case DW_OP::div:
+                        // The second entry divided by the top entry,
+                        // both signed
                         CHECKN(2);
-                        tmp1.u = stack.back();
-                        stack.pop_back();
-                        tmp2.u = stack.back();
-                        tmp3.s = tmp1.s / tmp2.s;
-                        stack.back() = tmp3.u;
+                        tmp1.u = TOP;
+                        sp--;
+                        tmp2.u = TOP;
+                        if (tmp1.s == 0)
+                                throw expr_error("division by zero in DWARF expression");
+                        // INT64_MIN / -1 overflows; negate as unsigned instead
+                        tmp3.u = tmp1.s == -1 ? -tmp2.u : (uint64_t)(tmp2.s / tmp1.s);
+                        TOP = tmp3.u;
                         break;
                 case DW_OP::minus:
                         UBINOP(-);
                         break;
                 case DW_OP::mod:
+                        CHECKN(2);
+                        if (TOP == 0)
+                                throw expr_error("division by zero in DWARF expression");
                         UBINOP(%);
                         break;
                 case DW_OP::mul:
@@ -250,13 +429,13 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
                         break;
                 case DW_OP::neg:
                         CHECK();
-                        tmp1.u = stack.back();
+                        tmp1.u = TOP;
                         tmp1.s = -tmp1.s;
-                        stack.back() = tmp1.u;
+                        TOP = tmp1.u;
                         break;
                 case DW_OP::not_:
                         CHECK();
-                        stack.back() = ~stack.back();
+                        TOP = ~TOP;
                         break;
                 case DW_OP::or_:
                         UBINOP(|);
@@ -265,39 +444,38 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
                         UBINOP(+);
                         break;
                 case DW_OP::plus_uconst:
-                        tmp1.u = cur.uleb128();
                         CHECK();
-                        stack.back() += tmp1.u;
+                        TOP += insn.a;
                         break;
                 case DW_OP::shl:
                         CHECKN(2);
-                        tmp1.u = stack.back();
-                        stack.pop_back();
-                        tmp2.u = stack.back();
+                        tmp1.u = TOP;
+                        sp--;
+                        tmp2.u = TOP;
                         // C++ does not define what happens if you
                         // shift by more bits than the width of the
                         // type, so we handle this case specially
                         if (tmp1.u < sizeof(tmp2.u)*8)
-                                stack.back() = tmp2.u << tmp1.u;
+                                TOP = tmp2.u << tmp1.u;
                         else
-                                stack.back() = 0;
+                                TOP = 0;
                         break;
                 case DW_OP::shr:
                         CHECKN(2);
-                        tmp1.u = stack.back();
-                        stack.pop_back();
-                        tmp2.u = stack.back();
+                        tmp1.u = TOP;
+                        sp--;
+                        tmp2.u = TOP;
                         // Same as above
                         if (tmp1.u < sizeof(tmp2.u)*8)
-                                stack.back() = tmp2.u >> tmp1.u;
+                                TOP = tmp2.u >> tmp1.u;
                         else
-                                stack.back() = 0;
+                                TOP = 0;
                         break;
                 case DW_OP::shra:
                         CHECKN(2);
-                        tmp1.u = stack.back();
-                        stack.pop_back();
-                        tmp2.u = stack.back();
+                        tmp1.u = TOP;
+                        sp--;
+                        tmp2.u = TOP;
                         // Shifting a negative number is
                         // implementation-defined in C++.
                         tmp3.u = (tmp2.s < 0);
@@ -311,7 +489,7 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
                         // number should result in 0, not ~0.
                         if (tmp3.u)
                                 tmp2.s = -tmp2.s;
-                        stack.back() = tmp2.u;
+                        TOP = tmp2.u;
                         break;
                 case DW_OP::xor_:
                         UBINOP(^);
@@ -322,10 +500,10 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
 #define SRELOP(relop)                                                   \
                         do {                                            \
                                 CHECKN(2);                              \
-                                tmp1.u = stack.back();                  \
-                                stack.pop_back();                       \
-                                tmp2.u = stack.back();                  \
-                                stack.back() = (tmp2.s <= tmp1.s) ? 1 : 0; \
+                                tmp1.u = TOP;                           \
+                                sp--;                                   \
+                                tmp2.u = TOP;                           \
+                                TOP = (tmp2.s relop tmp1.s) ? 1 : 0;    \
                         } while (0)
                 case DW_OP::le:
                         SRELOP(<=);
@@ -345,18 +523,15 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
                 case DW_OP::ne:
                         SRELOP(!=);
                         break;
-                case DW_OP::skip:
-                        tmp1.s = cur.fixed<int16_t>();
-                        goto skip_common;
                 case DW_OP::bra:
-                        tmp1.s = cur.fixed<int16_t>();
                         CHECK();
-                        tmp2.u = stack.back();
-                        stack.pop_back();
-                        if (tmp2.u == 0)
+                        if (stack[--sp] == 0)
                                 break;
-                skip_common:
-                        cur = cursor(subsec, (int64_t)cur.get_section_offset() + tmp1.s);
+                        // Fall through
+                case DW_OP::skip:
+                        if (insn.a == expr_program::bad_target)
+                                throw expr_error("DWARF branch target is not an operation boundary");
+                        pc = insn.a;
                         break;
                 case DW_OP::call2:
                 case DW_OP::call4:
@@ -376,20 +551,19 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
                         break;
                 case DW_OP::regx:
                         result.location_type = expr_result::type::reg;
-                        result.value = cur.uleb128();
+                        result.value = insn.a;
                         break;
 
                         // 2.6.1.1.3 Implicit location descriptions
                 case DW_OP::implicit_value:
                         result.location_type = expr_result::type::implicit;
-                        result.implicit_len = cur.uleb128();
-                        cur.ensure(result.implicit_len);
-                        result.implicit = cur.pos;
+                        result.implicit_len = insn.a;
+                        result.implicit = (const char*)(uintptr_t)insn.b;
                         break;
                 case DW_OP::stack_value:
                         CHECK();
                         result.location_type = expr_result::type::literal;
-                        result.value = stack.back();
+                        result.value = TOP;
                         break;
 
                         // 2.6.1.2 Composite location descriptions
@@ -399,30 +573,32 @@ expr::evaluate(expr_context *ctx, const std::initializer_list<taddr> &arguments)
                         throw runtime_error(to_string(op) + " not implemented");
 
                 case DW_OP::lo_user...DW_OP::hi_user:
-                        // XXX We could let the context evaluate this,
-                        // but it would need access to the cursor.
-                        throw expr_error("unknown user op " + to_string(op));
-
                 default:
-                        throw expr_error("bad operation " + to_string(op));
+                        // Decoding stopped here (op_fault)
+                        throw expr_error(prog.messages[insn.a]);
                 }
 #pragma GCC diagnostic pop
 #undef CHECK
 #undef CHECKN
+#undef PUSH
+#undef TOP
+#undef REVAT
         }
 
         if (result.location_type == expr_result::type::address) {
                 // The result type is still and address, so we should
-                // fetch it from the top of stack.
-                if (stack.empty())
+                // fetch it from the top of stack at the end.
+                if (sp == 0)
                         throw expr_error("final stack is empty; no result given");
-                result.value = stack.back();
+                result.value = stack[sp - 1];
         }
 
         return result;
 
 underflow:
         throw expr_error("stack underflow evaluating DWARF expression");
+overflow:
+        throw expr_error("stack overflow evaluating DWARF expression");
 }
 
 DWARFPP_END_NAMESPACE
@@ -8,7 +8,9 @@
 #include "dwarf++.hh"
 #include "../elf/to_hex.hh"
 
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -291,6 +293,41 @@ struct name_entry
         }
 };
 
+/**
+ * A single pre-decoded DWARF expression operation.  Operands are
+ * already unpacked from their LEB128 or fixed-size encodings, and
+ * branch targets are resolved to instruction indexes.
+ */
+struct expr_insn
+{
+        // The DW_OP, or op_fault if decoding stopped here
+        ubyte op;
+        // First and second operand.  For DW_OP_skip and DW_OP_bra,
+        // a is the target instruction index (bad_target if the
+        // target is not an operation boundary); for
+        // DW_OP_implicit_value, a is the length and b points at the
+        // data; for op_fault, a indexes expr_program::messages.
+        std::uint64_t a, b;
+};
+
+/**
+ * The pre-decoded form of one DWARF expression, built the first time
+ * the expression is evaluated and cached by its unit.
+ */
+struct expr_program
+{
+        // Operation byte that DWARF never assigns; marks the point
+        // where decoding failed
+        static constexpr ubyte op_fault = 0;
+        static constexpr std::uint64_t bad_target = ~(std::uint64_t)0;
+        // Capacity of the evaluation stack
+        static constexpr unsigned max_stack = 64;
+
+        std::vector<expr_insn> insns;
+        std::vector<std::string> messages;
+        unsigned addr_size;
+};
+
 DWARFPP_END_NAMESPACE
 
 #endif
@@ -142,6 +142,41 @@ value::as_flag() const
         }
 }
 
+vector<loclist_entry>
+value::as_loclist() const
+{
+        section_offset off = as_sec_offset();
+
+        // Addresses are relative to the compilation unit's base
+        // address until a base address selection entry changes it.
+        die cudie = cu->root();
+        taddr base = cudie.has(DW_AT::low_pc) ? at_low_pc(cudie) : 0;
+        auto cusec = cu->data();
+        auto sec = cu->get_dwarf().get_section(section_type::loc);
+        auto addrsec = make_shared<section>(sec->type, sec->begin, sec->size(),
+                                            sec->ord, cusec->fmt,
+                                            cusec->addr_size);
+        taddr largest = cusec->addr_size == 4 ? 0xffffffff : ~(taddr)0;
+
+        vector<loclist_entry> entries;
+        cursor cur(addrsec, off);
+        while (true) {
+                taddr low = cur.address(), high = cur.address();
+                if (low == 0 && high == 0)
+                        break;
+                if (low == largest) {
+                        base = high;
+                        continue;
+                }
+                size_t size = cur.fixed<uint16_t>();
+                section_offset expr_off = cur.get_section_offset();
+                cur += size;
+                entries.push_back(loclist_entry{low + base, high + base,
+                                        expr(cu, section_type::loc, expr_off, size)});
+        }
+        return entries;
+}
+
 rangelist
 value::as_rangelist() const
 {
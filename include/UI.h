@@ -66,7 +66,35 @@ private:
 
     char commandInput[256];        ///< 命令行输入缓冲区
     char newVariableName[256];     ///< 输入变量名缓冲区
-    std::unordered_map<std::string, std::string> watchedVariables;  ///< 存储变量名和对应的值
+    char chainExpression[256];     ///< 链式结构遍历的起点表达式
+    char chainFields[128];         ///< 链接成员，逗号分隔
+    int chainLimit;                ///< 最多访问的节点数
+    chain_result chainResult;      ///< 最近一次遍历的结果
+    std::vector<std::string> chainBackLinks;   ///< 各节点指回已访问节点的链接，如 "#0"
+    char arrayExpression[256];     ///< 被检查数组的表达式
+    int arrayCount;                ///< 元素个数，0表示按类型
+    int arrayPredicate;            ///< 查找条件在下拉框中的序号
+    double arrayOperand;           ///< 查找条件的比较值
+    std::string arrayFound;        ///< 最近一次查找的结果
+    char searchRange[256];         ///< 内存查找的范围 "起始, 结束|+长度"，空表示全部可读的映射
+    char searchPattern[256];       ///< 内存查找的模式
+    int searchLimit;               ///< 最多报告的命中数
+    std::string searchError;       ///< 最近一次开始查找失败的原因
+    int scanType;                  ///< 值扫描的类型在下拉框中的序号
+    int scanFilter;                ///< 值扫描的条件在下拉框中的序号
+    char scanValue[64];            ///< 值扫描比较的值
+    std::string scanError;         ///< 最近一次扫描失败的原因
+    char memoryTarget[256];        ///< 内存查看器跳转的表达式或符号
+    std::string memoryError;       ///< 最近一次跳转失败的原因
+    int memoryFormat;              ///< 内存查看器的列类型在下拉框中的序号
+    bool memoryAscii;              ///< 是否显示 ASCII 列
+    uint64_t memoryBase;           ///< 内存查看器表格第0行的地址
+    uint64_t memoryTop;            ///< 最上面一行可见的地址
+    uint64_t memoryJump;           ///< 下一帧要滚动到的地址
+    bool memoryJumpPending;
+    bool memoryPlaced;             ///< 是否已停在过某处，第一次打开时停在栈顶
+    std::vector<uint8_t> memoryBytes;  ///< 可见行的内容，逐帧复用
+    std::vector<uint8_t> memoryValid;  ///< 与 memoryBytes 对应，可读的字节为1
 
     // UI窗口显示控制
     static bool show_program;
@@ -79,6 +107,15 @@ private:
     static bool show_command_inputBar;
     static bool show_demo_window;
     static bool show_watcher;
+    static bool show_tracepoints;
+    static bool show_locals;
+    static bool show_globals;
+    static bool show_chains;
+    static bool show_arrays;
+    static bool show_search;
+    static bool show_scanner;
+    static bool show_changes;
+    static bool show_memory;
     static int windows_status;
 
     // 私有成员函数，用于显示不同的窗口和组件
@@ -92,7 +129,16 @@ private:
     void showOptionMainMenuBar();
     void showCommandInputBar();
     void showVariableWatcher();
-    void updateWatchedVariables();
+    void showTracepoints(bool* p_open);
+    void showLocals(bool* p_open);
+    void showGlobals(bool* p_open);
+    void showChains(bool* p_open);
+    void showArrays(bool* p_open);
+    void showSearch(bool* p_open);
+    void showScanner(bool* p_open);
+    void showChanges(bool* p_open);
+    void showMemory(bool* p_open);
+    bool showValueNode(const value_ref &v, const watch_entry *watch);
 };
 
 } // namespace minidbg
@@ -0,0 +1,143 @@
+/**
+ * @file array_inspector.h
+ * @brief 数值数组的检查：整个缓冲区每次停止只批量读取一次，最小值、最大值、均值、NaN/Inf 个数和直方图
+ * 用 SSE2 向量化的循环一次扫描得到，并为绘图预先按列降采样；也可查找第一个满足条件的元素。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_ARRAY_INSPECTOR_H
+#define MINIDBG_ARRAY_INSPECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "inferior_memory.h"
+#include "type_db.h"
+
+namespace minidbg {
+
+/**
+ * @brief 元素的数值类型。
+ *
+ */
+enum class number_kind : uint8_t {
+    none,
+    i8, u8, i16, u16, i32, u32, i64, u64,
+    f32, f64
+};
+
+// 按数值类型把 data 当作 T 数组调用 f(const T *)
+#define DISPATCH_NUMBERS(kind, data, f)                                          \
+    switch (kind) {                                                              \
+    case number_kind::i8: f(reinterpret_cast<const int8_t *>(data)); break;      \
+    case number_kind::u8: f(reinterpret_cast<const uint8_t *>(data)); break;     \
+    case number_kind::i16: f(reinterpret_cast<const int16_t *>(data)); break;    \
+    case number_kind::u16: f(reinterpret_cast<const uint16_t *>(data)); break;   \
+    case number_kind::i32: f(reinterpret_cast<const int32_t *>(data)); break;    \
+    case number_kind::u32: f(reinterpret_cast<const uint32_t *>(data)); break;   \
+    case number_kind::i64: f(reinterpret_cast<const int64_t *>(data)); break;    \
+    case number_kind::u64: f(reinterpret_cast<const uint64_t *>(data)); break;   \
+    case number_kind::f32: f(reinterpret_cast<const float *>(data)); break;      \
+    case number_kind::f64: f(reinterpret_cast<const double *>(data)); break;     \
+    default: break;                                                              \
+    }
+
+/**
+ * @brief 查找元素时的条件。
+ *
+ */
+enum class array_predicate : uint8_t {
+    eq, ne, lt, le, gt, ge,
+    nan,            // 不是数（整数数组中没有）
+    inf,            // 正负无穷
+    not_finite      // NaN 或无穷
+};
+
+/**
+ * @brief 整个数组的统计量。NaN 不参与最小值、最大值、均值和直方图。
+ *
+ */
+struct array_stats {
+    uint64_t count = 0;         // 读到的元素个数
+    uint64_t nan_count = 0;
+    uint64_t inf_count = 0;
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    uint64_t min_index = 0;     // 第一个最小值的下标
+    uint64_t max_index = 0;
+    std::vector<uint32_t> histogram;    // [min, max] 等分为 histogram_bins 段，无穷不计入
+};
+
+class array_inspector {
+public:
+    static constexpr std::size_t max_bytes = 256u << 20;   // 一次读取的字节数上限
+    static constexpr std::size_t histogram_bins = 64;
+    static constexpr std::size_t plot_columns = 1024;      // 绘图的列数，每列取该段的最小值和最大值
+
+    array_inspector(inferior_memory &memory, type_db &types);
+
+    /**
+     * @brief 一次批量读取 count 个 element 类型的元素并计算统计量。
+     *
+     * @return false 元素不是数值类型或内存不可读，原因见 error()；只读到一部分时统计读到的部分
+     */
+    bool load(uint64_t address, type_id element, uint64_t count);
+
+    /**
+     * @brief 丢弃已读取的数组，error 非空时作为失败的原因。
+     *
+     */
+    void clear(const std::string &error = std::string());
+
+    bool loaded() const { return m_kind != number_kind::none; }
+    const std::string &error() const { return m_error; }
+    uint64_t address() const { return m_address; }
+    uint64_t requested() const { return m_requested; }     // 请求读取的元素个数
+    const array_stats &stats() const { return m_stats; }
+
+    /**
+     * @brief 降采样后的绘图数据：元素不超过 plot_columns 时为全部元素，否则每列依次为该段的最小值和最大值。
+     *
+     */
+    const std::vector<float> &plot() const { return m_plot; }
+
+    /**
+     * @brief 第i个元素的值。
+     *
+     */
+    double value(uint64_t i) const;
+
+    /**
+     * @brief 元素的C写法，如 "-1.5"、"nan"、"42"。
+     *
+     */
+    std::string format(uint64_t i) const;
+
+    /**
+     * @brief 从 from 起第一个满足条件的元素。
+     *
+     * @return int64_t 下标，没有时返回-1
+     */
+    int64_t find(array_predicate predicate, double operand, uint64_t from = 0) const;
+
+private:
+    inferior_memory &m_memory;
+    type_db &m_types;
+    number_kind m_kind;
+    std::size_t m_element_size;
+    uint64_t m_address;
+    uint64_t m_requested;
+    std::vector<uint8_t> m_bytes;
+    array_stats m_stats;
+    std::vector<float> m_plot;
+    std::string m_error;
+
+    void compute();
+};
+
+}   // namespace minidbg
+
+#endif
@@ -1,41 +1,175 @@
 /**
  * @file breakpoint.h
- * @brief 断点类，包含启用和禁用功能，实例化后存储于debugger类中的m_breakpoints向量。
- * @version 0.1
- * @date 2024-03-11
- * 
+ * @brief 断点表。断点位置（site）按地址排序存放在扁平数组中，多个逻辑断点可共享同一位置；插入和移除按批规划，按页合并后写入被调试进程。
+ * @version 0.2
+ * @date 2026-10-18
+ *
  * Copyright (c) 2024
- * 
+ *
  */
 #ifndef BREAKPOINT_H
 #define BREAKPOINT_H
 
 #include <linux/types.h>
 #include "utility.hpp"
+#include "inferior_memory.h"
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace minidbg
 {
     /**
-     * @brief 断点类，包含启用和禁用功能，实例化后存储于debugger类中的m_breakpoints向量。
-     * 
+     * @brief 内存中的一个断点位置。同一地址只有一个site，由引用计数记录有多少逻辑断点（含内部临时断点）使用它。
+     *
      */
-    class breakpoint
+    struct breakpoint_site
+    {
+        std::intptr_t addr;
+        uint32_t refcount;      // 引用该位置的逻辑断点数
+        uint8_t saved_data;     // 被0xcc覆盖的原始字节
+        bool inserted;          // 0xcc当前是否写在内存中
+    };
+
+    /**
+     * @brief 用户可见的逻辑断点，一个逻辑断点可对应多个地址（如rbreak匹配到的所有函数）。
+     *
+     */
+    struct logical_breakpoint
+    {
+        int id;
+        std::string spec;                       // 用户输入的断点描述
+        std::vector<std::intptr_t> addrs;       // 对应的所有位置
+    };
+
+    /**
+     * @brief 断点表。查找为二分查找；add()/acquire()等批量接口一次性规划所有需要写入的位置，
+     * 按页分组，每组读写一次内存，而不是每个断点各一次PEEK和POKE。
+     *
+     */
+    class breakpoint_table
     {
     public:
-        breakpoint();
-        breakpoint(pid_t pid, std::intptr_t addr);
+        explicit breakpoint_table(inferior_memory &mem);
+
+        /**
+         * @brief 新建逻辑断点并批量插入其所有位置。
+         *
+         * @return int 逻辑断点编号
+         */
+        int add(const std::vector<std::intptr_t> &addrs, const std::string &spec);
+
+        /**
+         * @brief 为已有的逻辑断点追加位置（如挂起断点在新加载的共享库中解析成功）。
+         *
+         * @return false 编号不存在
+         */
+        bool extend(int id, const std::vector<std::intptr_t> &addrs);
+
+        /**
+         * @brief 删除逻辑断点，只移除不再被引用的位置。
+         *
+         * @return false 编号不存在
+         */
+        bool remove(int id);
+
+        /**
+         * @brief 为内部临时断点（step over、finish）增加位置引用，不产生逻辑断点。
+         *
+         */
+        void acquire(const std::vector<std::intptr_t> &addrs);
 
-        void enable();
-        void disable();
-        auto is_enabled() const -> bool;
-        auto get_address() const -> intptr_t;
+        /**
+         * @brief 释放acquire()增加的引用。
+         *
+         */
+        void release(const std::vector<std::intptr_t> &addrs);
+
+        /**
+         * @brief 二分查找地址上的断点位置。
+         *
+         * @return const breakpoint_site* 不存在时返回nullptr
+         */
+        const breakpoint_site *find(std::intptr_t addr) const;
+
+        /**
+         * @brief 暂时恢复原指令，用于单步越过断点。
+         *
+         */
+        void lift(std::intptr_t addr);
+
+        /**
+         * @brief 重新写入lift()移除的0xcc。
+         *
+         */
+        void restore(std::intptr_t addr);
+
+        /**
+         * @brief 从内存中移除全部0xcc但保留断点表，用于复制进程（checkpoint）前得到干净的副本。
+         *
+         */
+        void suspend();
+
+        /**
+         * @brief 重新写入全部未写入的0xcc。
+         *
+         */
+        void resume();
+
+        /**
+         * @brief 进程被替换为不含断点的副本后，把全部位置标记为未写入，不访问被调试进程。
+         *
+         */
+        void invalidate();
+
+        /**
+         * @brief 丢弃 [lo, hi) 内的断点位置而不访问被调试进程，用于共享库已被卸载时。
+         *
+         * @return std::vector<int> 因此失去全部位置的逻辑断点编号
+         */
+        std::vector<int> forget(std::intptr_t lo, std::intptr_t hi);
+
+        /**
+         * @brief 把从 [addr, addr + len) 读出的内存中已写入的0xcc换回原始字节。
+         *
+         */
+        void unpatch(std::intptr_t addr, uint8_t *buf, std::size_t len) const;
+
+        /**
+         * @brief 清空断点表，不访问被调试进程（用于进程已被替换时）。
+         *
+         */
+        void clear();
+
+        const logical_breakpoint *get(int id) const;
+        const std::vector<logical_breakpoint> &logical() const { return m_logical; }
+        const std::vector<breakpoint_site> &sites() const { return m_sites; }
 
     private:
-        pid_t m_pid;
-        std::intptr_t m_addr;
-        bool m_enabled;
-        uint8_t m_save_data;
+        inferior_memory &m_memory;
+        std::vector<breakpoint_site> m_sites;           // 按addr升序
+        std::vector<logical_breakpoint> m_logical;
+        int m_next_id;
+
+        std::vector<breakpoint_site>::iterator lower_bound(std::intptr_t addr);
+
+        /**
+         * @brief 增加引用计数，返回需要新写入0xcc的地址（已排序去重）。
+         *
+         */
+        std::vector<std::intptr_t> plan_insert(std::vector<std::intptr_t> addrs);
+
+        /**
+         * @brief 减少引用计数，返回需要恢复原指令的地址。
+         *
+         */
+        std::vector<std::intptr_t> plan_remove(const std::vector<std::intptr_t> &addrs);
+
+        /**
+         * @brief 执行一批插入和移除：按页分组，每组读一次、改字节、写一次。
+         *
+         */
+        void apply(const std::vector<std::intptr_t> &to_insert, const std::vector<std::intptr_t> &to_remove);
     };
 }
 
@@ -0,0 +1,169 @@
+/**
+ * @file c_expr.h
+ * @brief C/C++ 表达式：成员访问、->、下标、解引用、取地址、强制类型转换、算术、比较和逻辑运算。
+ * 表达式在某个作用域中只解析一次，变量绑定到DIE、每个节点的类型在编译时确定；此后每次求值只遍历语法树，
+ * 变量位置由调用者在寄存器快照上求出，内存经本次停止的页缓存读取。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_C_EXPR_H
+#define MINIDBG_C_EXPR_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dwarf/dwarf++.hh"
+#include "stop_state.h"
+#include "type_db.h"
+#include "value_tree.h"
+
+namespace minidbg {
+
+/**
+ * @brief 编译时的名字查找。
+ *
+ */
+struct expr_scope {
+    std::function<dwarf::die(const std::string &)> variable;   // 变量名 -> 具体实例，找不到返回无效DIE
+    std::function<dwarf::die(const std::string &)> type;       // 类型名（如 "point"、"struct point"）-> 类型DIE
+};
+
+/**
+ * @brief 求值时对被调试进程的访问。
+ *
+ */
+struct expr_env {
+    std::function<bool(const dwarf::die &var, value_ref &out)> locate;     // 变量的位置，失败时原因写入 out.error
+    stop_state *memory;
+};
+
+/**
+ * @brief 编译好的表达式，只在编译时的作用域中有效。
+ *
+ */
+class c_expr {
+public:
+    c_expr();
+
+    /**
+     * @brief 解析表达式，绑定变量并推出每个节点的类型。
+     *
+     * @return false 语法或类型错误，原因见 error()
+     */
+    bool compile(const std::string &text, type_db &types, const expr_scope &scope);
+
+    bool valid() const { return m_root >= 0; }
+    const std::string &text() const { return m_text; }
+    const std::string &error() const { return m_error; }
+
+    /**
+     * @brief 表达式的静态类型。
+     *
+     */
+    type_id type() const;
+
+    /**
+     * @brief 求值，结果是值树的根：左值给出地址，其余给出值本身。失败时原因写入结果的 error。
+     *
+     */
+    value_ref evaluate(const expr_env &env) const;
+
+    /**
+     * @brief 作为条件求值，非零为真。
+     *
+     * @return false 值为零，或求值失败（原因写入 error）
+     */
+    bool test(const expr_env &env, std::string &error) const;
+
+private:
+    enum class op : uint8_t {
+        variable,       // var
+        constant,       // imm 为值的位模式
+        member,         // 结构体成员：imm 为位偏移，bit_size 为位域位数
+        index,          // lhs[rhs]
+        deref,          // *lhs，也用于引用类型的隐式解引用
+        address_of,     // &lhs
+        decay,          // 数组退化为指向首元素的指针
+        cast,           // (type)lhs
+        negate,
+        logical_not,
+        bit_not,
+        add, sub, mul, div, mod, shl, shr,
+        bit_and, bit_or, bit_xor,
+        lt, gt, le, ge, eq, ne,
+        logical_and, logical_or
+    };
+
+    struct node {
+        op code;
+        type_id type;           // 结果的类型
+        uint32_t dim;           // 结果为多维数组的子数组时从第几维开始
+        int lhs;
+        int rhs;
+        uint64_t imm;
+        uint16_t bit_size;
+        dwarf::die var;
+    };
+
+    friend class expr_parser;
+
+    std::string m_text;
+    std::string m_error;
+    std::vector<node> m_nodes;
+    int m_root;
+    type_db *m_types;
+
+    value_ref eval(int n, const expr_env &env) const;
+    bool scalar(const value_ref &v, uint64_t &bits, std::string &error, const expr_env &env) const;
+};
+
+/**
+ * @brief 表达式文本及其按作用域编译的形式。同一表达式在不同函数或词法块中绑定的变量不同，
+ * 每个 (函数, 作用域) 只编译一次。
+ *
+ */
+class scoped_expr {
+public:
+    static constexpr std::size_t max_forms = 16;       // 保留的编译形式个数，超过时丢弃最早的
+
+    scoped_expr() = default;
+    explicit scoped_expr(std::string text) : m_text(std::move(text)) {}
+
+    const std::string &text() const { return m_text; }
+
+    /**
+     * @brief 在函数（DIE偏移）的第scope个作用域中编译过的形式。
+     *
+     * @return const c_expr* 尚未编译时返回nullptr
+     */
+    const c_expr *find(dwarf::section_offset function, int scope) const;
+
+    /**
+     * @brief 在该作用域中编译并保存，编译失败的结果也保存，错误信息见其 error()。
+     *
+     */
+    const c_expr &compile(dwarf::section_offset function, int scope, type_db &types, const expr_scope &names);
+
+    /**
+     * @brief 丢弃全部编译形式（类型库已清空）。
+     *
+     */
+    void clear() { m_forms.clear(); }
+
+private:
+    struct form {
+        dwarf::section_offset function;
+        int scope;
+        c_expr expr;
+    };
+
+    std::string m_text;
+    std::vector<form> m_forms;
+};
+
+}   // namespace minidbg
+
+#endif
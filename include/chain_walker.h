@@ -0,0 +1,75 @@
+/**
+ * @file chain_walker.h
+ * @brief 链式结构的遍历：从一个结构体指针出发，沿指定的指针成员（如 next，或 left 和 right）广度优先访问链表和树。
+ * 每一层的全部节点所在的页用一次批量读取读入停止快照的页缓存，下一层的地址从中解出；链表每层只有一个节点，
+ * 窄的层连同前后若干页一起读入，相邻分配的节点不再各自读取。遇到已访问的节点不再展开，节点数有上限。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_CHAIN_WALKER_H
+#define MINIDBG_CHAIN_WALKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "stop_state.h"
+#include "type_db.h"
+
+namespace minidbg {
+
+/**
+ * @brief 遍历到的一个节点。
+ *
+ */
+struct chain_node {
+    uint64_t address;
+    uint32_t depth;         // 离起点的层数
+    int parent;             // 父节点在结果中的下标，起点为-1
+    int field;              // 经父节点的第几个链接成员到达，起点为-1
+    bool readable;          // 不可读的节点没有值，也不再展开
+    std::string value;
+};
+
+/**
+ * @brief 一次遍历的结果，节点按广度优先的顺序排列。
+ *
+ */
+struct chain_result {
+    type_id type = no_type;                 // 节点的类型
+    std::vector<std::string> fields;        // 链接成员的名字
+    std::vector<chain_node> nodes;
+    std::vector<std::pair<int, int>> back_links;    // 指向已访问节点的链接（环或共享的节点）：(来自的节点, 指向的节点)
+    std::size_t levels = 0;                 // 遍历的层数
+    std::size_t reads = 0;                  // 批量读取的次数，节点已在页缓存中的层不读取
+    bool truncated = false;                 // 达到节点上限时还有未访问的节点
+    std::string error;                      // 非空时没有结果
+};
+
+class chain_walker {
+public:
+    static constexpr std::size_t default_limit = 10000;    // 默认最多访问的节点数
+    static constexpr std::size_t max_node_bytes = 4096;    // 每个节点最多读取和显示的字节数
+    static constexpr std::size_t narrow_level = 16;        // 节点数不超过此值的层连同附近的页一起读入
+    static constexpr std::size_t readahead_pages = 16;     // 窄的层每个节点附近读入的页数
+
+    chain_walker(stop_state &state, type_db &types);
+
+    /**
+     * @brief 从 start 出发遍历 type 类型的节点。
+     *
+     * @param fields 链接成员的名字，每个都须是指向 type 的指针
+     * @param limit 最多访问的节点数
+     */
+    chain_result walk(uint64_t start, type_id type, const std::vector<std::string> &fields, std::size_t limit);
+
+private:
+    stop_state &m_state;
+    type_db &m_types;
+};
+
+}   // namespace minidbg
+
+#endif
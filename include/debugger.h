@@ -23,6 +23,7 @@
 #include <cstdio>
 #include <algorithm>
 #include <iterator>
+#include <regex>
 
 #include "breakpoint.h"
 #include "registers.h"
@@ -33,17 +34,103 @@
 #include "asmparaser.h"
 #include "utility.hpp"
 #include "ptrace_expr_context.h"
+#include "inferior_memory.h"
+#include "tracepoint.h"
+#include "solib.h"
+#include "record.h"
+#include "insn_decoder.h"
+#include "unwinder.h"
+#include "inline_index.h"
+#include "location_cache.h"
+#include "scope_index.h"
+#include "stop_state.h"
+#include "type_db.h"
+#include "value_tree.h"
+#include "c_expr.h"
+#include "global_table.h"
+#include "chain_walker.h"
+#include "array_inspector.h"
+#include "memory_search.h"
+#include "value_scanner.h"
+#include "dirty_tracker.h"
 
 
 namespace minidbg
 {
 
+/**
+ * @brief 选中帧中的一个局部变量或参数及其值。
+ *
+ */
+struct frame_variable
+{
+    std::string name;
+    bool parameter;
+    std::string value;
+};
+
+/**
+ * @brief 监视表达式及其在最近一次停止时的值。表达式在每个作用域中只编译一次，停止后才重新求值，
+ * 位置和读到的字节都未变时沿用上一次的值。所在帧的寄存器未变、且求值读过的页都没有被写过时不再求值。
+ *
+ */
+struct watch_entry
+{
+    watch_entry(int watch_id, scoped_expr watch_expr) : id(watch_id), expr(std::move(watch_expr)) {}
+
+    int id;
+    scoped_expr expr;
+    value_ref root;                 // 最近一次停止时的结果，作为值树的根
+    std::string value;              // 最近一次停止时的摘要
+    bool changed = false;           // 与上一次停止时的值不同，界面上高亮
+    std::vector<uint8_t> raw;       // 最近一次读取的原始字节（不在内存中的值为其本身），相同则不再格式化
+    std::vector<uint64_t> pages;    // 最近一次求值和格式化读过的页，递增
+    bool pages_known = false;       // pages 是否完整，新加入或求值失败时为false
+};
+
+/**
+ * @brief 值扫描的一个候选地址，供显示。
+ *
+ */
+struct scan_candidate
+{
+    uint64_t address;
+    std::string value;      // 最近一次扫描时的值
+    std::string where;      // 所在的映射和符号
+};
+
+/**
+ * @brief 上次查看以来被写过的一段内存，由相邻的页合并而成。
+ *
+ */
+struct changed_range
+{
+    uint64_t lo;
+    uint64_t hi;
+    std::string where;      // 所在的映射和符号
+};
+
+/**
+ * @brief 检查点：在被调试进程中注入fork()得到的副本，保持暂停，写时复制使其几乎不占额外内存。
+ *
+ */
+struct checkpoint
+{
+    int id;
+    pid_t pid;              // 暂停中的副本进程
+    uint64_t pc;
+    std::string where;      // 创建时所在的源代码位置
+};
+
 /**
  * @brief 调试器类，用于跟踪和调试程序执行。
  */
 class debugger
 {
 public:
+    static constexpr std::size_t max_scan_rows = 1000;     // 值扫描显示的候选数上限
+    static constexpr std::size_t max_change_rows = 1000;   // 被写过的内存显示的段数上限
+
     // 需要展示的数据
     std::vector<asm_head> m_asm_vct;            /**< 存储汇编信息, 包括起止地址、汇编条目等 */
     std::vector<std::string> m_src_vct;         /**< 存储源代码 */
@@ -55,20 +142,156 @@ public:
 public:
 
     /**
-     * @brief 从绝对 pc 获取当前函数die
+     * @brief 读取选中帧中可见的变量的值。
      * 
-     * @param pc 
-     * @return dwarf::die 
+     * @details 按作用域索引查找变量（局部变量由内向外、参数、本编译单元的静态变量、全局变量），
+     * 评估其位置表达式（或位置列表中当前pc处的条目），然后根据表达式的结果读取变量的值。
+    */
+    std::string read_variable(const std::string& var_name);
+
+    /**
+     * @brief 选中帧中可见的局部变量（由内层作用域向外）和参数及其值，一次批量读取，按停止和选中的帧缓存。
+     *
      */
-    dwarf::die get_function_die_from_pc(uint64_t pc);
+    const std::vector<frame_variable> &get_frame_variables();
 
+    /**
+     * @brief 展开值树和读取节点的值，读取经本次停止的页缓存。
+     *
+     */
+    value_tree &values() { return m_values; }
 
     /**
-     * @brief 读取并打印当前函数中所有变量的值。
-     * 
-     * @details 遍历当前函数的所有变量DIE，评估它们的位置表达式（如果存在），然后根据表达式的结果读取并打印变量的值。
-    */
-    std::string read_variable(const std::string& var_name);
+     * @brief 主程序的全局变量和静态变量，按编译单元分组；每次停止后第一次调用时一次批量读取全部值。
+     *
+     */
+    const global_table &get_globals();
+
+    /**
+     * @brief 从表达式（结构体指针或结构体左值）出发，沿 fields 中的指针成员广度优先遍历链表或树，节点经本次停止的页缓存分层批量读取。
+     *
+     * @param limit 最多访问的节点数
+     */
+    chain_result follow(const std::string &expression, const std::vector<std::string> &fields, std::size_t limit = chain_walker::default_limit);
+
+    /**
+     * @brief 检查数值数组：表达式为数组、std::vector，或给出元素个数的指针。整个缓冲区一次读取并计算统计量，
+     * 之后每次停止后第一次取用时重新读取。
+     *
+     * @param count 元素个数，0表示数组或 vector 本身的长度；表达式为指针时必须给出
+     */
+    const array_inspector &inspect_array(const std::string &expression, uint64_t count);
+
+    /**
+     * @brief 正在检查的数组，进程停止过则按原表达式重新读取。
+     *
+     */
+    const array_inspector &get_array();
+
+    /**
+     * @brief 在后台开始查找内存，立即返回。参数形如 [起始地址, 结束地址,] 模式，结束地址可写作 +长度，省略范围时查找全部可读的映射。
+     * 模式为带引号的字符串（不含结尾的0，可用 \xNN 转义）或表达式，表达式按其类型的大小取值的字节。
+     *
+     * @return false 参数有误，原因在 error 中
+     */
+    bool find_memory(const std::string &args, std::size_t limit, std::string &error);
+
+    /**
+     * @brief 查找到的命中，取回新命中并标注所在的映射和符号。
+     *
+     */
+    const std::vector<search_hit> &get_search_hits();
+
+    const memory_search &get_search() const { return m_search; }
+
+    /**
+     * @brief 停止正在进行的查找。
+     *
+     */
+    void cancel_search() { m_search.cancel(); }
+
+    /**
+     * @brief 值扫描。参数为 "类型 条件 值" 时开始新的一轮，为 "条件 [值]" 时在上次的候选中筛选；
+     * 条件为 == != > < changed unchanged increased decreased。
+     *
+     * @return false 参数有误，原因在 error 中
+     */
+    bool scan_values(const std::string &args, std::string &error);
+
+    /**
+     * @brief 结束本轮值扫描，丢弃候选。
+     *
+     */
+    void reset_scan();
+
+    const value_scanner &get_scanner() const { return m_scanner; }
+
+    /**
+     * @brief 前 max_scan_rows 个候选及其位置说明，每次扫描后重新生成一次。
+     *
+     */
+    const std::vector<scan_candidate> &get_scan_candidates();
+
+    /**
+     * @brief 上次查看以来可写映射中被写过的内存，最多 max_change_rows 段，每次停止重新生成一次。
+     * 代码页的改动多是断点的写入，不列出。
+     *
+     */
+    const std::vector<changed_range> &get_changed_memory();
+
+    std::size_t get_changed_pages() const { return m_changed_pages; }      // 可写映射中被写过的页数，含未列出的段
+    const dirty_tracker &get_dirty_tracker() const { return m_dirty; }
+
+    /**
+     * @brief 内存查看器跳转的地址：先按表达式求值（指针和整数取其值，数组取首地址），求值不成时按主程序的符号名查找。
+     *
+     * @return false 都找不到，原因在 error 中
+     */
+    bool resolve_view_address(const std::string &text, uint64_t &address, std::string &error);
+
+    /**
+     * @brief 内存查看器读取 [addr, addr + len)。经本次停止的页缓存读取，只有新进入视野的页产生系统调用；
+     * 不可读的页不尝试读取。
+     *
+     * @param bytes 读到的字节，不可读处为0
+     * @param valid 与 bytes 等长，可读的字节为1
+     */
+    void view_memory(uint64_t addr, std::size_t len, std::vector<uint8_t> &bytes, std::vector<uint8_t> &valid);
+
+    /**
+     * @brief 地址所在的映射及符号，不在任何映射中时返回空串。映射表每次停止读取一次。
+     *
+     */
+    std::string describe_view_address(uint64_t address);
+
+    /**
+     * @brief 相邻的可读映射：forward 时为起点在 address 之后的第一个，否则为起点在 address 之前的最后一个。
+     *
+     * @return false 没有这样的映射
+     */
+    bool adjacent_view_region(uint64_t address, bool forward, uint64_t &target);
+
+    /**
+     * @brief 添加监视表达式（C/C++表达式），下次取监视列表时求值。
+     *
+     * @return int 监视的编号
+     */
+    int add_watch(const std::string &expression);
+
+    /**
+     * @brief 按编号删除监视。
+     *
+     * @return false 没有该编号
+     */
+    bool remove_watch(int id);
+
+    /**
+     * @brief 全部监视及其值，只在进程停止或换帧后重新求值，其余时间直接返回缓存。
+     *
+     * @details 每个监视在作用域未变时沿用已编译的表达式；所有表达式在同一份寄存器快照上求值，
+     * 位于内存中的值涉及的页一次批量读入。位置、类型和读到的字节都与上次相同的监视不再格式化，changed 置为false。
+     */
+    const std::vector<watch_entry> &get_watches();
 
 
     /**
@@ -79,6 +302,13 @@ public:
     * @details 根据命令的前缀进行分类处理，具体逻辑如下：
     * 
     * - 如果命令以 "break" 开头，则处理设置断点的逻辑。
+    * - 如果命令为 "rbreak"，则在所有名称匹配正则表达式的函数上设置一个逻辑断点。
+    * - 如果命令以 "delete" 开头，则按编号删除逻辑断点。
+    * - 如果命令为 "trace"，则在指定位置安装追踪点，可附带 `<reg>[+-offset]:<len>` 形式的内存采集；"tstatus"、"tdump [n]"、"tdelete <id>" 查看和删除追踪点。
+    * - 如果命令为 "info"，"info sharedlibrary" 列出已加载的共享库，"info breakpoints" 列出逻辑断点（含挂起断点），"info checkpoints" 列出检查点。
+    * - 如果命令为 "record [MB]"，则开始记录执行（默认上限256MB），"record stop" 停止；"info record" 查看记录量和每条指令的开销。
+    * - 如果命令为 "reverse-stepi"、"reverse-next"、"reverse-continue"，则在记录范围内反向执行。
+    * - 如果命令为 "checkpoint"，则在当前位置保存检查点；"restart <n>" 回到检查点n；"delete checkpoint <n>" 删除检查点。
     * - 如果命令以 "register" 开头，则根据子命令执行相关的寄存器操作，包括查看寄存器内容、修改寄存器值等。
     * - 如果命令以 "symbol" 开头，则查找并打印符号信息。
     * - 如果命令以 "memory" 开头，则根据子命令执行内存读写操作。
@@ -86,7 +316,7 @@ public:
     * - 如果命令以 "step" 开头，则执行单步进入操作。
     * - 如果命令以 "next" 开头，则执行下一步操作。
     * - 如果命令以 "finish" 开头，则执行执行到函数返回操作。
-    * - 如果命令以 "backtrace" 开头，则打印回溯信息。
+    * - 如果命令以 "backtrace" 或 "bt" 开头，则打印回溯信息；"frame <n>" 选择第n帧，之后读取变量使用该帧的寄存器。
     * - 如果命令以 "ls" 开头，则打印源代码和汇编信息。
     * - 其他情况下，输出错误信息。
     */
@@ -141,16 +371,120 @@ public:
     std::vector<std::pair<uint64_t, std::string>> get_backtrace_vct();
 
     /**
-     * @brief 获取全局堆栈信息。
-     * 
-     * @details 从指定的起始地址开始，以8字节为单位遍历内存区域，读取每个地址处的数据，将其转换为字节向量存储起来。
-     * 最后返回包含这些信息的向量，每个元素是一个地址和对应的字节向量。
-     * 
-     * @param start_addr 起始地址（包含）
-     * @param end_addr 终止地址（不包含）
-     * @return std::vector<std::pair<uint64_t, std::vector<uint8_t>>> 包含全局堆栈信息的向量，每个元素为一个地址和对应的字节向量
-    */
-    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> get_global_stack_vct(uint64_t start_addr, uint64_t end_addr);
+     * @brief 第i帧（0为当前帧）所在的物理栈帧，带有恢复出的寄存器，可用于读取外层帧的局部变量。
+     *
+     * @details 帧号计入内联帧：pc处于内联展开中时，每层内联函数各占一帧，它们共享同一个物理栈帧。
+     * 每次停止后第一次调用时从新的寄存器开始，外层帧与上一次停止时相同的部分直接复用；
+     * 只回溯到第i帧为止，更外层的帧在需要时才回溯。
+     *
+     * @return const unwind_frame* 超出最外层帧时返回nullptr；指针在下一次调用前有效
+     */
+    const unwind_frame *get_stack_frame(std::size_t i);
+
+    /**
+     * @brief 第i帧所在函数的起始地址和函数名，结果按地址缓存；内联帧为内联函数的最低地址和名字。
+     *
+     */
+    std::pair<uint64_t, std::string> get_backtrace_entry(std::size_t i);
+
+    /**
+     * @brief 第i帧是否为内联展开（没有自己的物理栈帧）。
+     *
+     */
+    bool is_inlined_frame(std::size_t i);
+
+    /**
+     * @brief 第i帧正在执行的源代码位置：最内层帧取自行号表，外层的内联帧和其所在函数取内层内联展开的调用位置。
+     *
+     * @return false 没有调试信息
+     */
+    bool get_frame_location(std::size_t i, std::string &file, unsigned &line);
+
+    /**
+     * @brief 已回溯出的帧数（含内联帧），以及是否已到达最外层帧。
+     *
+     */
+    std::size_t get_stack_frames_known() const { return m_frames.size(); }
+    bool is_stack_complete() const { return m_unwinder.stack_complete() && m_frames_physical == m_unwinder.frames_known(); }
+
+    /**
+     * @brief 在当前位置保存检查点。
+     *
+     * @details 先从内存中移除全部断点，再向被调试进程注入fork()，子进程作为副本暂停保留，之后重新写入断点。
+     *
+     * @return int 检查点编号，失败时返回-1
+     */
+    int checkpoint_execution();
+
+    /**
+     * @brief 程序启动后继续到main的断点时调用：确认确实停在main的断点上，再保存检查点，"start" 回到这里。
+     *
+     * @return int 检查点编号；进程已退出、因信号或其他断点停下、保存失败时返回-1
+     */
+    int checkpoint_at_main();
+
+    /**
+     * @brief checkpoint_at_main() 保存的检查点编号，没有时为-1。
+     *
+     */
+    int get_start_checkpoint() const { return m_start_checkpoint; }
+
+    /**
+     * @brief 回到检查点：再复制一次检查点中的副本（检查点本身保留，可反复回到同一位置），结束当前进程并切换到新副本。
+     *
+     * @return false 检查点不存在或复制失败
+     */
+    bool restart_execution(int id);
+
+    /**
+     * @brief 反向执行一条指令。
+     *
+     */
+    void reverse_stepi_execution();
+
+    /**
+     * @brief 反向执行到上一个源代码行的开始，不进入被调用的函数。
+     *
+     */
+    void reverse_next_execution();
+
+    /**
+     * @brief 反向执行到上一个断点或记录的开始。
+     *
+     */
+    void reverse_continue_execution();
+
+    /**
+     * @brief 是否处于记录模式。
+     *
+     */
+    bool is_recording() const { return m_record.active(); }
+
+    /**
+     * @brief 获取检查点列表。
+     *
+     */
+    const std::vector<checkpoint> &get_checkpoints() const { return m_checkpoints; }
+
+    /**
+     * @brief 获取追踪点列表及命中次数。
+     *
+     */
+    std::vector<tracepoint> get_tracepoints();
+
+    /**
+     * @brief 获取最近读取的追踪记录。
+     *
+     * @param max_records 最多返回的记录数
+     */
+    std::vector<trace_record> get_trace_records(std::size_t max_records);
+
+    /**
+     * @brief 因环形缓冲区覆盖而丢失的追踪记录数。
+     *
+     */
+    uint64_t get_trace_lost();
+
 
 
     /**
@@ -211,10 +545,80 @@ private:
     std::string m_prog_name;
     std::string m_asm_name;
     pid_t m_pid;
-    std::unordered_map<std::intptr_t, minidbg::breakpoint> m_breakpoints;
+    inferior_memory m_memory;               // 被调试进程内存读写器，须先于断点表构造
+    stop_state m_stop_state;                // 本次停止的寄存器、内存区域和页缓存，进程运行后只丢弃被写过的页
+    dirty_tracker m_dirty;                  // 两次采集之间被写过的页，须在 m_memory 之后构造
+    breakpoint_table m_breakpoints;
+    tracepoint_manager m_tracepoints;
+    solib_manager m_solibs;                 // 已加载的共享库，ELF/DWARF按需加载
+    std::vector<int> m_pending_breakpoints; // 尚未解析出任何位置、等待共享库加载的逻辑断点
+    uint64_t m_solib_event;                 // 动态链接器通知地址上的内部断点，0表示未设置
+    int m_wait_status;                      // 最近一次 waitpid 得到的状态
+    int m_pending_signal;                   // 记录时单步收到、尚未交给被调试进程的信号，下次继续执行时送达，0表示没有
+    std::vector<checkpoint> m_checkpoints;
+    int m_next_checkpoint;
+    int m_start_checkpoint;                 // main处的检查点，-1表示没有
+    record_log m_record;                    // 记录模式下的撤销记录
+    user_regs_struct m_record_regs;         // 记录模式下当前（下一条指令执行前）的寄存器
+    std::vector<mem_write> m_record_writes;
+    std::vector<mem_request> m_record_images;
+    std::vector<uint8_t> m_record_buffer;
     dwarf::dwarf m_dwarf;
     elf::elf m_elf;
     uint64_t m_load_address; // 偏移量，很重要
+    unwinder m_unwinder;                    // 按模块缓存CFI的栈回溯器
+    std::size_t m_selected_frame;           // frame 命令选择的帧，进程每次停止后回到第0帧
+    uint64_t m_stop_id;                     // 每次停止（或寄存器被改写）加1
+    uint64_t m_stack_stop_id;               // m_unwinder 中的调用栈属于哪一次停止
+    std::unordered_map<uint64_t, std::pair<uint64_t, std::string>> m_symbol_cache;    // 地址 -> (函数起始地址, 函数名)
+    inline_index m_inlines;                 // 主程序中函数及内联展开的地址范围索引
+    location_cache m_locations;             // 变量的位置表达式或位置列表，按变量解码一次
+    scope_index m_scopes;                   // 各函数中按pc区间划分的可见变量
+    type_db m_types;                        // 类型布局，按类型DIE建立一次
+    value_tree m_values;                    // 按类型布局展开值，须在 m_types 和 m_stop_state 之后构造
+    std::vector<frame_variable> m_locals;   // 选中帧的局部变量和参数，每次停止或换帧后重新读取
+    uint64_t m_locals_stop_id;
+    std::size_t m_locals_frame;
+    global_table m_globals;                 // 全局变量，须在 m_memory 和 m_types 之后构造
+    uint64_t m_globals_stop_id;
+    chain_walker m_chains;                  // 链式结构的遍历，须在 m_stop_state 和 m_types 之后构造
+    array_inspector m_array;                // 数组检查，须在 m_memory 和 m_types 之后构造
+    std::string m_array_expr;               // 被检查数组的表达式
+    uint64_t m_array_count;                 // 指定的元素个数，0表示按类型
+    uint64_t m_array_stop_id;               // m_array 的内容属于哪一次停止
+    memory_search m_search;                 // 内存查找，须在 m_memory 之后构造；进程再次停止时取消
+    std::vector<search_hit> m_search_hits;  // 已取回并标注的命中
+    value_scanner m_scanner;                // 值扫描的候选，须在 m_memory 之后构造
+    std::vector<scan_candidate> m_scan_rows;    // 供显示的前若干个候选
+    std::size_t m_scan_rows_scan;           // m_scan_rows 对应第几次扫描，0表示未生成
+    const page_changes *m_changes;          // 最近一次采集的结果，nullptr表示无从得知
+    uint64_t m_changes_stop_id;             // m_changes 采集于哪一次停止
+    std::vector<uint64_t> m_unseen_pages;   // 上次查看以来各次采集到的被写过的页，递增；只在查看时清空
+    std::vector<changed_range> m_changed_rows;
+    std::size_t m_changed_pages;
+    uint64_t m_changed_rows_stop_id;        // m_changed_rows 属于哪一次停止
+    std::vector<memory_region> m_view_regions;     // 内存查看器用的映射表
+    uint64_t m_view_stop_id;                // m_view_regions 属于哪一次停止
+    std::unordered_map<int, scoped_expr> m_conditions;     // 断点编号 -> 条件，断点位置固定，每个位置只编译一次
+    std::vector<watch_entry> m_watches;     // 监视列表，按添加顺序
+    int m_next_watch;
+    uint64_t m_watches_stop_id;             // m_watches 的值属于哪一次停止和哪一帧，0表示需要重新求值
+    std::size_t m_watches_frame;
+    unwind_frame m_watch_regs;              // 最近一次求值时所在帧的寄存器
+    uint64_t m_watch_resets;                // 最近一次求值时 m_stop_state.resets()，不同说明调试器改写过内存或寄存器
+    std::vector<uint64_t> m_watch_dirty;    // 最近一次求值之前的那次采集以来被写过的页，递增
+
+    /**
+     * @brief 调用栈中的一帧：所在的物理栈帧，以及对应的函数或内联展开（inline_index 节点，-1表示没有调试信息）。
+     *
+     */
+    struct virtual_frame
+    {
+        std::size_t physical;
+        int inline_node;
+    };
+    std::vector<virtual_frame> m_frames;    // 当前调用栈（含内联帧），按需从 m_unwinder 展开
+    std::size_t m_frames_physical;          // m_frames 已展开的物理帧数
 
     /**
      * @brief 根据 SIGTRAP 信号信息执行不同的操作，包括触发断点、打印调试信息等。
@@ -357,11 +761,249 @@ private:
     void remove_breakpoint(std::intptr_t addr);
 
     /**
-     * @brief 跳出函数：从rbp获取返回地址，检查是否有断点，无则设置，然后continue；如刚设置了断点，则去除，如原有则不动。
+     * @brief 跳出函数：按CFI回溯得到返回地址和调用者的rsp，在返回地址设置临时断点后continue；
+     * 递归调用中更深一层先返回到同一地址时（rsp低于调用者的rsp）继续运行。当前帧为内联帧时只跳出该内联展开。
      * 
     */
     void step_out();
 
+    /**
+     * @brief 供栈回溯器查找pc所属模块（主程序或共享库）的ELF及其加载偏移。
+     *
+     */
+    const elf::elf *unwind_module_for_pc(uint64_t pc, uint64_t &bias, uint64_t &lo, uint64_t &hi);
+
+    /**
+     * @brief 地址所在的函数名及其起始地址，依次查找主程序的反汇编和共享库的符号表。
+     *
+     * @return std::string 找不到时返回 "??"，start为0
+     */
+    std::string function_name_at(uint64_t pc, uint64_t &start);
+
+    /**
+     * @brief 打印调用栈：帧号、pc、函数名和源代码位置。
+     *
+     * @param limit 最多打印的帧数，0表示全部
+     */
+    void print_backtrace(std::size_t limit);
+
+    /**
+     * @brief 按CFI回溯得到的第p个物理栈帧，不计内联帧。
+     *
+     */
+    const unwind_frame *get_physical_frame(std::size_t p);
+
+    /**
+     * @brief 展开物理栈帧，直到 m_frames 中有第i帧。
+     *
+     * @return false 调用栈不足i+1帧
+     */
+    bool expand_frames(std::size_t i);
+
+    /**
+     * @brief 实际地址pc处的内联链，最内层在前，最后一个为所在的函数；不在主程序中时为空。
+     *
+     */
+    void inline_chain_at(uint64_t pc, std::vector<int> &out);
+
+    /**
+     * @brief 跳出内联展开：单步执行直到pc离开该节点的地址范围，途中调用的函数在返回地址设临时断点直接运行完。
+     *
+     */
+    void step_out_of_inline(int node);
+
+    /**
+     * @brief 在某一帧中查找和读取变量所需的上下文。
+     *
+     */
+    struct frame_scope_info
+    {
+        dwarf::die function;        // 所在函数或内联展开，用于查找作用域
+        dwarf::die subprogram;      // 外层的 DW_TAG_subprogram，提供 DW_AT_frame_base
+        uint64_t pc;                // 文件地址
+        unwind_frame regs;          // 该帧的寄存器快照，含CFA
+    };
+
+    /**
+     * @brief 第i帧的作用域和寄存器快照。
+     *
+     * @return false 该帧没有调试信息
+     */
+    bool frame_scope(std::size_t i, frame_scope_info &scope);
+
+    /**
+     * @brief 求变量在帧中的位置：内存地址，或寄存器、DW_OP_stack_value 给出的值本身。
+     *
+     * @return false 无法取值，原因写入 out.error
+     */
+    bool locate(ptrace_expr_context &context, const frame_scope_info &scope, const dwarf::die &var, value_ref &out);
+
+    /**
+     * @brief 批量读取一帧中多个变量的值。
+     *
+     * @details 所有位置表达式在同一份寄存器快照上求值；位于内存中的变量涉及的页通过一次批量读取
+     * 读入停止快照的页缓存，再从中解码各变量的值。
+     *
+     * @param values 输出，与vars一一对应
+     */
+    void materialize(const frame_scope_info &scope, const std::vector<dwarf::die> &vars, std::vector<std::string> &values);
+
+    /**
+     * @brief info locals / info args：打印选中帧中可见的局部变量或参数。
+     *
+     */
+    void print_frame_variables(bool parameters);
+
+    /**
+     * @brief 表达式在帧所在作用域中的编译形式，第一次用到时编译。
+     *
+     */
+    const c_expr &compiled(scoped_expr &expr, const frame_scope_info &scope);
+
+    /**
+     * @brief 在帧中对编译好的表达式求值，变量位置在 context 的寄存器快照上求出。
+     *
+     */
+    value_ref evaluate(const c_expr &expr, const frame_scope_info &scope, ptrace_expr_context &context);
+
+    /**
+     * @brief 在选中帧中编译并求值一个一次性的表达式。
+     *
+     * @return false 没有调试信息或表达式有错，原因写入 error；求值时的错误写入 out.error
+     */
+    bool evaluate_text(const std::string &text, value_ref &out, std::string &error);
+
+    /**
+     * @brief print：在选中帧中编译并求值一个表达式。
+     *
+     */
+    void print_expression(const std::string &text);
+
+    /**
+     * @brief follow：打印 follow() 遍历到的节点，以及指回已访问节点的链接。
+     *
+     */
+    void print_follow(const std::string &expression, const std::vector<std::string> &fields, std::size_t limit);
+
+    /**
+     * @brief 按 m_array_expr 求值并读取整个数组。
+     *
+     */
+    void load_array();
+
+    /**
+     * @brief inspect：打印正在检查的数组的统计量和直方图。
+     *
+     */
+    void print_array();
+
+    /**
+     * @brief 表达式的值作为地址或整数。
+     *
+     */
+    bool evaluate_address(const std::string &text, uint64_t &address, std::string &error);
+
+    /**
+     * @brief 查找模式的字节：带引号的字符串按C转义解析，其余按表达式求值。
+     *
+     */
+    bool search_pattern(const std::string &text, std::vector<uint8_t> &bytes, std::string &error);
+
+    /**
+     * @brief 地址的位置说明：代码中的地址给出函数名，主程序中的数据给出变量名，其余给出映射名和偏移。
+     *
+     */
+    std::string describe_address(uint64_t address, const memory_region &region);
+
+    /**
+     * @brief find：查找并在命中陆续到达时打印，最后打印扫描的字节数和速度。
+     *
+     */
+    void print_find(const std::string &args, std::size_t limit);
+
+    /**
+     * @brief scan：扫描后打印候选个数、读取的段数和用时，候选不多时一并列出。
+     *
+     */
+    void print_scan(const std::string &args);
+
+    /**
+     * @brief scan list：列出前 limit 个候选。
+     *
+     */
+    void print_scan_candidates(std::size_t limit);
+
+    /**
+     * @brief 上次采集以来被写过的页，每次停止最多采集一次。采集会清除软脏位，页缓存触发的采集也要把结果并入
+     * m_unseen_pages，留给被写过的内存的显示。
+     *
+     */
+    const page_changes *memory_changes();
+
+    /**
+     * @brief 供页缓存使用的被写过的页。本次停止已采集过时直接使用；否则只在软脏位可用、且要读的 pagemap
+     * 远小于缓存的页时才采集，哈希方式或地址空间很大时返回nullptr，缓存整体丢弃。条件断点每次命中都会读内存，
+     * 不能每次都付出一次完整的采集。
+     *
+     */
+    const page_changes *cache_changes(std::size_t cached_pages);
+
+    /**
+     * @brief 去掉落在追踪点跳转上的断点地址并逐个报告，0xcc 写进跳转会破坏它。
+     *
+     * @return std::vector<std::intptr_t> 剩下的地址
+     */
+    std::vector<std::intptr_t> drop_traced_addresses(const std::vector<std::intptr_t> &addrs);
+
+    /**
+     * @brief 单步、finish 用的临时断点实际下在哪里。跳转的第一个字节可以临时换成0xcc，越过断点时执行的就是原来的跳转；
+     * 覆盖范围内的其余地址改为蹦床中被搬来的同一条指令。
+     *
+     */
+    std::intptr_t temporary_breakpoint_address(uint64_t addr);
+
+    /**
+     * @brief info changes：列出上次查看以来被写过的内存。
+     *
+     */
+    void print_changes();
+
+    /**
+     * @brief 内存查看器用的映射表，每次停止读取一次。
+     *
+     */
+    const std::vector<memory_region> &view_regions();
+
+    /**
+     * @brief condition：设置或（text为空时）清除断点条件。
+     *
+     */
+    void set_breakpoint_condition(int id, const std::string &text);
+
+    /**
+     * @brief 停在pc上的断点时是否应停下：有内部临时断点或无条件断点，或某个条件为真；条件求值出错时也停下。
+     *
+     */
+    bool breakpoint_condition_holds(uint64_t pc);
+
+    /**
+     * @brief info globals：按编译单元打印全部全局变量和静态变量。
+     *
+     */
+    void print_globals();
+
+    /**
+     * @brief info display：打印全部监视及其值，自上次停止以来变化的用 * 标出。
+     *
+     */
+    void print_watches();
+
+    /**
+     * @brief 进程停止或寄存器被改写后调用：调用栈需要重新回溯，选中的帧回到第0帧。
+     *
+     */
+    void note_stop();
+
     /**
      * @brief 单步进入/进入到下一个源代码行: 循环执行单条指令，源代码行号发生变化，循环结束
      * 
@@ -370,6 +1012,7 @@ private:
 
     /**
      * @brief 检查下一行源码是否设置了断点，如没有则设置，然后continue，再删除；如有则直接continue.
+     * 下一行落在新进入的内联展开中时，继续执行到离开该内联展开为止。
      * 
     */
     void step_over();
@@ -380,6 +1023,59 @@ private:
     */
     void set_breakpoint_at_function(const std::string &name);
 
+    /**
+     * @brief 在所有名称匹配正则表达式的函数上设置断点，所有位置属于同一个逻辑断点并批量写入。
+     *
+     * @param pattern ECMAScript 正则表达式
+     */
+    void set_breakpoint_at_regex(const std::string &pattern);
+
+    /**
+     * @brief 函数断点的地址：每个同名函数序言之后的第一行。
+     *
+     * @return std::vector<std::intptr_t> 找不到时为空
+     */
+    std::vector<std::intptr_t> function_breakpoint_addresses(const std::string &name);
+
+    /**
+     * @brief 源代码行对应的第一条语句地址。
+     *
+     * @return std::intptr_t 找不到时返回0
+     */
+    std::intptr_t source_line_address(const std::string &file, unsigned line);
+
+    /**
+     * @brief 解析与 break 命令相同格式的位置（0xADDRESS、file:line、函数名）为实际地址。
+     *
+     */
+    std::vector<std::intptr_t> resolve_location(const std::string &location);
+
+    /**
+     * @brief 在共享库中解析函数名或 file:line 形式的位置。
+     *
+     * @param only 只在这些下标的共享库中查找，为nullptr时查找全部已加载的库
+     */
+    std::vector<std::intptr_t> resolve_in_solibs(const std::string &location, const std::vector<std::size_t> *only);
+
+    /**
+     * @brief 在动态链接器的通知函数上设置内部断点（只设置一次）。
+     *
+     */
+    void install_solib_event_breakpoint();
+
+    /**
+     * @brief 停在动态链接器通知断点时调用：更新共享库列表，丢弃已卸载库中的断点，在新库中解析挂起断点。
+     *
+     */
+    void handle_solib_event();
+
+    /**
+     * @brief 在新加载的共享库中解析挂起断点。
+     *
+     * @param added 新增库在 m_solibs.modules() 中的下标
+     */
+    void resolve_pending_breakpoints(const std::vector<std::size_t> &added);
+
     /**
      * @brief 通过'file:line'形式的命令设置断点。
      * 
@@ -399,7 +1095,7 @@ private:
      * 首先，通过m_elf.get_hdr().type获取目标程序的 ELF 文件类型。
      * 如果是动态链接库（et::dyn），则需要通过其他方式获取加载地址。
      * /proc/<pid>/maps是一个特殊的 Linux 文件，用于列出进程的内存映射。
-     * 从maps文件中读取第一行，这一行包含了动态库的内存映射范围，形如<start_addr>-<end_addr>。
+     * 取maps中属于程序文件本身、文件偏移为0的映射起始地址，形如<start_addr>-<end_addr>。
      * 
     */
     void initialise_load_address();
@@ -422,6 +1118,94 @@ private:
     */
     void initialise_load_src();
 
+    /**
+     * @brief 让被调试进程在当前pc处执行一次系统调用，执行后恢复原指令和全部寄存器。
+     *
+     * @param number 系统调用号
+     * @param args 最多6个参数
+     * @return long 系统调用返回值（失败时为 -errno）
+     */
+    long inject_syscall(long number, std::initializer_list<uint64_t> args);
+
+    /**
+     * @brief 让进程pid在当前pc处执行一次fork()，恢复父子两个进程的原指令和寄存器。
+     *
+     * @details 只在注入期间开启 PTRACE_O_TRACEFORK，子进程自动被跟踪并停在SIGSTOP。
+     *
+     * @return pid_t 暂停中的子进程，失败时返回-1
+     */
+    pid_t inject_fork(pid_t pid);
+
+    /**
+     * @brief 把被调试进程切换为pid（检查点的副本）：重新绑定内存读写、共享库列表和断点。
+     *
+     */
+    void switch_inferior(pid_t pid);
+
+    /**
+     * @brief 结束全部检查点进程。
+     *
+     */
+    void discard_checkpoints();
+
+    /**
+     * @brief 记录模式下执行一条指令：解码将写入的内存并保存原始内容，单步后保存寄存器差值。
+     *
+     * @return false 进程因其他信号停止或已退出，记录随之停止
+     */
+    bool record_step();
+
+    /**
+     * @brief 记录模式下的 continue：逐条指令记录，直到遇到断点。
+     *
+     */
+    void record_continue();
+
+    /**
+     * @brief 撤销最近执行的一条指令：写回内存原始内容并恢复寄存器。
+     *
+     * @return false 没有更早的记录
+     */
+    bool undo_instruction();
+
+    /**
+     * @brief 打印记录量、每条指令占用的字节数和时间开销。
+     *
+     */
+    void print_record_info();
+
+    /**
+     * @brief 地址对应的源代码行号，不在主程序行表中时返回0。
+     *
+     */
+    unsigned line_of_pc(uint64_t pc);
+
+    /**
+     * @brief 在被调试进程地址空间中寻找离 center 最近（±2GB内）的空闲区域。
+     *
+     * @return uint64_t 区域起始地址，找不到时返回0
+     */
+    uint64_t find_free_area_near(uint64_t center, uint64_t size);
+
+    /**
+     * @brief 在被调试进程中分配蹦床代码区和追踪环形缓冲区。
+     *
+     */
+    bool setup_tracepoint_area();
+
+    /**
+     * @brief 选出探测点处将被跳转指令覆盖的完整指令（至少5字节），并检查它们可以安全地搬到蹦床中执行。
+     *
+     * @param why 失败原因
+     */
+    bool plan_displaced_instructions(uint64_t addr, std::vector<uint8_t> &displaced, std::string &why);
+
+    /**
+     * @brief 处理 trace 命令。
+     *
+     */
+    void set_tracepoint(const std::vector<std::string> &args);
+
 };   // class debugger
 
 }   // namespace minidbg
@@ -0,0 +1,90 @@
+/**
+ * @file dirty_tracker.h
+ * @brief 被调试进程在两次采集之间写过的页：内核支持软脏位时，采集读取 /proc/pid/pagemap 中各页的软脏位，
+ * 再向 /proc/pid/clear_refs 写入 4 清除，开始下一段；不支持时退回逐页哈希可写的私有映射，与上次采集的哈希比较。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_DIRTY_TRACKER_H
+#define MINIDBG_DIRTY_TRACKER_H
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "inferior_memory.h"
+#include "memory_search.h"
+#include "stop_state.h"
+
+namespace minidbg {
+
+enum class tracking_mode : uint8_t {
+    none,           // 未绑定进程，或 pagemap 和内存都无法读取
+    soft_dirty,
+    hashing
+};
+
+class dirty_tracker {
+public:
+    static constexpr std::size_t page_size = 4096;
+    static constexpr uint64_t max_hash_bytes = 256u << 20;     // 哈希方式每次采集最多读取的字节数，超出部分的映射不跟踪
+    static constexpr std::size_t chunk_bytes = 4u << 20;        // 每次读取 pagemap 或内存的字节数
+
+    explicit dirty_tracker(inferior_memory &memory);
+    ~dirty_tracker();
+
+    dirty_tracker(const dirty_tracker &) = delete;
+    dirty_tracker &operator=(const dirty_tracker &) = delete;
+
+    /**
+     * @brief 绑定到新的被调试进程：试写一字节检验软脏位是否可用，然后建立基线。进程须处于停止状态。
+     *
+     */
+    void attach(pid_t pid);
+
+    void detach();
+
+    /**
+     * @brief 采集上次采集（或绑定）以来写过的页，并开始新的一段。进程须处于停止状态。
+     *
+     * @return const page_changes* 只跟踪私有映射，共享映射和 [vvar] 等内核映射不在跟踪区间内；
+     * 哈希方式只跟踪上次采集时已存在的可写映射。未绑定时返回nullptr
+     */
+    const page_changes *collect();
+
+    tracking_mode mode() const { return m_mode; }
+    uint64_t tracked_bytes() const;                         // 最近一次采集时跟踪的私有映射的总字节数
+    const std::vector<memory_region> &regions() const { return m_regions; }    // 最近一次采集时的映射
+    uint64_t bytes_read() const { return m_bytes_read; }   // 最近一次采集读取的 pagemap 或内存字节数
+    double seconds() const { return m_seconds; }           // 最近一次采集的用时
+
+private:
+    struct hashed_region {
+        uint64_t lo;
+        uint64_t hi;
+        std::vector<uint64_t> hashes;   // 每页一个，不可读的页为 unreadable
+    };
+
+    inferior_memory &m_memory;
+    pid_t m_pid;
+    int m_pagemap;          // /proc/pid/pagemap，打开失败时为 -1
+    int m_clear_refs;       // /proc/pid/clear_refs，打开失败时为 -1
+    tracking_mode m_mode;
+    page_changes m_changes;
+    std::vector<memory_region> m_regions;
+    std::vector<hashed_region> m_hashes;    // 上次采集的哈希，按地址递增
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_bytes_read;
+    double m_seconds;
+
+    bool clear_soft_dirty();
+    bool soft_dirty_works();
+    bool read_soft_dirty(uint64_t lo, uint64_t hi, std::vector<uint64_t> &dirty);
+    void collect_soft_dirty();
+    void collect_hashes();
+};
+
+}   // namespace minidbg
+
+#endif
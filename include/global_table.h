@@ -0,0 +1,103 @@
+/**
+ * @file global_table.h
+ * @brief 全局变量表：主程序中全部全局变量、文件作用域和函数内的静态变量按编译单元分组，地址和类型只从DWARF取一次。
+ * 每次停止后把变量所在的 .data/.bss 按地址合并成少数几段，一次批量读取后从缓冲区解码全部变量，
+ * 字节未变的变量沿用上次格式化的值。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_GLOBAL_TABLE_H
+#define MINIDBG_GLOBAL_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "dwarf/dwarf++.hh"
+#include "inferior_memory.h"
+#include "type_db.h"
+
+namespace minidbg {
+
+/**
+ * @brief 全局变量或文件作用域的静态变量及其在最近一次刷新时的值。
+ *
+ */
+struct global_variable {
+    std::string name;           // 命名空间中的变量带限定名，如 "ns::count"
+    bool is_static;             // 没有 DW_AT_external，只在本编译单元可见
+    uint64_t address;           // 运行时地址，线程局部变量为0
+    std::string type;
+    std::string value;
+};
+
+/**
+ * @brief 一个编译单元中的全局变量，在 variables() 中的下标区间为 [first, first + count)。
+ *
+ */
+struct global_unit {
+    std::string name;
+    std::size_t first;
+    std::size_t count;
+};
+
+class global_table {
+public:
+    static constexpr std::size_t max_value_bytes = 4096;   // 每个变量最多读取和解码的字节数
+    static constexpr uint64_t merge_gap = 4096;            // 间隔不超过该值的变量合并到同一段读取
+
+    global_table(inferior_memory &memory, type_db &types);
+
+    /**
+     * @brief 换用新的程序，变量表在下次 refresh() 时重新建立。
+     *
+     */
+    void reset(const dwarf::dwarf &dw);
+
+    /**
+     * @brief 进程停止后重新读取全部变量的值：所有段一次批量读取，字节与上次相同的变量不再格式化。
+     *
+     * @param load_address 主程序的加载偏移，第一次刷新时用于把DWARF中的文件地址换算为运行时地址
+     */
+    void refresh(uint64_t load_address);
+
+    const std::vector<global_variable> &variables() const { return m_vars; }
+    const std::vector<global_unit> &units() const { return m_units; }
+    std::size_t spans() const { return m_spans.size(); }   // 每次刷新读取的段数
+
+private:
+    struct span {
+        uint64_t addr;
+        std::size_t len;
+        std::size_t offset;     // 在缓冲区中的起始位置
+    };
+
+    struct layout {
+        type_id type;
+        std::size_t len;        // 要读取的字节数，0表示不读取（线程局部变量等）
+        std::size_t offset;     // 在缓冲区中的位置
+    };
+
+    inferior_memory &m_memory;
+    type_db &m_types;
+    dwarf::dwarf m_dwarf;
+    bool m_built;
+    std::vector<global_variable> m_vars;
+    std::vector<global_unit> m_units;
+    std::vector<layout> m_layout;           // 与 m_vars 一一对应
+    std::vector<span> m_spans;              // 按地址排序
+    std::vector<uint8_t> m_image;           // 本次读到的全部段
+    std::vector<uint8_t> m_previous;        // 上次读到的全部段
+    std::vector<std::size_t> m_done;        // 各段实际读到的字节数
+    bool m_have_previous;
+    std::unordered_set<uint64_t> m_seen;    // 建表时已登记的文件地址
+
+    void build(uint64_t load_address);
+    void collect(const dwarf::die &parent, const std::string &prefix, uint64_t load_address);
+};
+
+}   // namespace minidbg
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file inferior_memory.h
+ * @brief 被调试进程的内存读写接口。批量读取使用 process_vm_readv，写入使用 /proc/pid/mem（可写入只读的代码页），均不可用时退回 ptrace PEEK/POKE。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_INFERIOR_MEMORY_H
+#define MINIDBG_INFERIOR_MEMORY_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace minidbg {
+
+/**
+ * @brief 一次批量读取中的单个请求，done 由 read_batch() 填写为实际读到的字节数。
+ *
+ */
+struct mem_request {
+    uint64_t addr;      // 被调试进程中的地址
+    void *buf;          // 调试器中的目标缓冲区
+    size_t len;         // 请求的字节数
+    size_t done;        // 实际读取的字节数
+};
+
+/**
+ * @brief 被调试进程内存的读写器。调试器持有一个实例，断点表等模块通过它访问内存。
+ *
+ */
+class inferior_memory {
+public:
+    inferior_memory();
+    ~inferior_memory();
+
+    inferior_memory(const inferior_memory &) = delete;
+    inferior_memory &operator=(const inferior_memory &) = delete;
+
+    /**
+     * @brief 绑定到新的被调试进程，打开其 /proc/pid/mem。
+     *
+     * @param pid
+     */
+    void attach(pid_t pid);
+
+    /**
+     * @brief 关闭 /proc/pid/mem。
+     *
+     */
+    void detach();
+
+    pid_t pid() const { return m_pid; }
+
+    /**
+     * @brief 读取一段连续内存。
+     *
+     * @return size_t 实际读取的字节数，遇到不可读的页时提前结束
+     */
+    size_t read(uint64_t addr, void *buf, size_t len);
+
+    /**
+     * @brief 批量读取多段内存，尽量合并为少量 process_vm_readv 调用。
+     *
+     * @param reqs 请求数组，每个请求的 done 字段会被填写
+     * @param n 请求个数
+     * @return size_t 完整读取的请求个数
+     */
+    size_t read_batch(mem_request *reqs, size_t n);
+
+    /**
+     * @brief 写入一段连续内存，可写入代码段。
+     *
+     * @return true 全部写入成功
+     */
+    bool write(uint64_t addr, const void *buf, size_t len);
+
+private:
+    pid_t m_pid;
+    int m_fd;       // /proc/pid/mem，打开失败时为 -1
+
+    size_t peek_read(uint64_t addr, void *buf, size_t len);
+    bool poke_write(uint64_t addr, const void *buf, size_t len);
+};
+
+}   // namespace minidbg
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * @file inline_index.h
+ * @brief 内联函数索引：把每个函数（DW_TAG_subprogram）及嵌套其中的 DW_TAG_inlined_subroutine 的地址范围
+ * 展开为互不重叠、按地址排序的区间，每个区间对应最内层的节点，沿父节点即得到完整的内联链，查询为 O(log n)。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_INLINE_INDEX_H
+#define MINIDBG_INLINE_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dwarf/dwarf++.hh"
+
+namespace minidbg {
+
+/**
+ * @brief 一个函数或一次内联展开。
+ *
+ */
+struct inline_node {
+    std::string name;                                   // 函数名（内联节点取自 DW_AT_abstract_origin）
+    std::string call_file;                              // 内联节点的调用位置，即外层函数中正在执行的源代码行
+    unsigned call_line;
+    int parent;                                         // 外层节点，-1表示最外层函数
+    bool inlined;                                       // false 为 DW_TAG_subprogram
+    uint64_t entry;                                     // 最低地址（文件地址）
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;  // 文件地址范围 [lo, hi)
+    dwarf::die die;
+};
+
+/**
+ * @brief 主程序的内联链索引，第一次查询时建立。
+ *
+ */
+class inline_index {
+public:
+    inline_index();
+
+    /**
+     * @brief 换用新的DWARF，丢弃已建立的索引。
+     *
+     */
+    void reset(const dwarf::dwarf &dw);
+
+    /**
+     * @brief 文件地址pc处的内联链。
+     *
+     * @param out 输出节点编号，最内层在前，最后一个为所在的函数；不在任何函数中时为空
+     */
+    void chain(uint64_t pc, std::vector<int> &out);
+
+    const inline_node &node(int i) const { return m_nodes[i]; }
+
+    /**
+     * @brief 节点的地址范围是否包含文件地址pc。
+     *
+     */
+    bool contains(int i, uint64_t pc) const;
+
+private:
+    struct segment {
+        uint64_t lo;
+        uint64_t hi;
+        int node;           // 该区间内最内层的节点
+    };
+
+    dwarf::dwarf m_dwarf;
+    bool m_built;
+    std::vector<inline_node> m_nodes;
+    std::vector<segment> m_segments;
+
+    void build();
+    void collect(const dwarf::die &die, const dwarf::line_table &lines, int parent);
+};
+
+}   // namespace minidbg
+
+#endif
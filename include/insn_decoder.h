@@ -0,0 +1,44 @@
+/**
+ * @file insn_decoder.h
+ * @brief x86-64 指令解码：只解析前缀、操作码、ModRM/SIB 和位移，找出一条指令执行时将写入的内存区间。
+ * 用于记录执行（record）时在单步之前保存被覆盖内存的原始内容。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_INSN_DECODER_H
+#define MINIDBG_INSN_DECODER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/user.h>
+
+namespace minidbg {
+
+/**
+ * @brief 指令将写入的一段内存 [addr, addr + len)。
+ *
+ */
+struct mem_write {
+    uint64_t addr;
+    uint64_t len;
+};
+
+/**
+ * @brief 解码 code 处的一条指令，按执行前的寄存器计算它将写入的内存区间。
+ *
+ * @details 结果是保守估计：无法精确判断宽度时取较大值，多保存的字节恢复时不会改变内容。
+ * 包括 ModRM 内存操作数、push/call 等隐式栈写入、rep stos/movs，以及 read、fstat 等常见系统调用的输出缓冲区。
+ * 其余系统调用对内存的修改无法得知。
+ *
+ * @param code 指令字节（断点处须已换回原始字节）
+ * @param len code 中有效字节数，最多需要15字节
+ * @param regs 执行前的寄存器
+ * @param out 追加写入区间
+ * @return false 无法解码（如 VSIB scatter），写入区间未知
+ */
+bool decode_mem_writes(const uint8_t *code, std::size_t len, const user_regs_struct &regs, std::vector<mem_write> &out);
+
+}   // namespace minidbg
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file location_cache.h
+ * @brief 变量位置缓存：每个变量的 DW_AT_location 只解码一次。位置列表（.debug_loc）解码为按起始地址排序的
+ * [lo, hi) -> 位置表达式 表，此后查找某个pc处变量的位置只需一次二分查找，不必每次重新扫描位置列表。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_LOCATION_CACHE_H
+#define MINIDBG_LOCATION_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "dwarf/dwarf++.hh"
+
+namespace minidbg {
+
+/**
+ * @brief 按变量DIE缓存解码后的位置表。
+ *
+ */
+class location_cache {
+public:
+    /**
+     * @brief 变量在文件地址pc处的位置表达式。单个表达式（exprloc）在整个作用域内有效。
+     *
+     * @return const dwarf::expr* 没有 DW_AT_location，或位置列表中没有覆盖pc的条目（变量在此处已被优化掉）时返回nullptr；
+     * 指针在 clear() 之前有效
+     */
+    const dwarf::expr *find(const dwarf::die &var, uint64_t pc);
+
+    /**
+     * @brief 丢弃全部位置表（被调试程序已更换）。
+     *
+     */
+    void clear() { m_tables.clear(); }
+
+    std::size_t size() const { return m_tables.size(); }    // 已解码的变量数
+
+private:
+    struct entry {
+        uint64_t lo;
+        uint64_t hi;
+        dwarf::expr location;
+    };
+
+    std::unordered_map<dwarf::section_offset, std::vector<entry>> m_tables;     // 键：变量DIE在 .debug_info 中的偏移
+
+    static void decode(const dwarf::die &var, std::vector<entry> &out);
+};
+
+}   // namespace minidbg
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * @file memory_search.h
+ * @brief 被调试进程内存中的字节串查找：可读的映射按大块切分，多个工作线程各自用 process_vm_readv 读入整块，
+ * 以 memchr 定位模式中的一个锚字节后再比较整个模式。命中逐块汇入结果队列，界面边查找边显示。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_MEMORY_SEARCH_H
+#define MINIDBG_MEMORY_SEARCH_H
+
+#include <sys/types.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "inferior_memory.h"
+
+namespace minidbg {
+
+/**
+ * @brief /proc/pid/maps 中的一个映射。
+ *
+ */
+struct memory_region {
+    uint64_t lo;
+    uint64_t hi;
+    bool readable;
+    bool writable;
+    bool executable;
+    bool shared;            // MAP_SHARED，其他进程也可能写入
+    uint64_t offset;        // 文件映射在文件中的偏移
+    std::string name;       // 文件路径或 [heap]、[stack] 等，匿名映射为空
+};
+
+/**
+ * @brief 一个命中的地址及其后的若干字节。
+ *
+ */
+struct search_hit {
+    uint64_t address;
+    std::size_t region;     // 所在映射在 regions() 中的下标
+    std::size_t context_len;
+    std::array<uint8_t, 16> context;    // 从命中地址起读到的字节
+    std::string where;      // 由调用者填写的位置说明，如 "[heap]+0x10" 或 "<main+4>"
+};
+
+class memory_search {
+public:
+    static constexpr std::size_t chunk_bytes = 4u << 20;   // 每次读取和扫描的块大小
+    static constexpr std::size_t max_threads = 8;
+    static constexpr std::size_t default_limit = 1000;     // 默认最多报告的命中数
+
+    explicit memory_search(inferior_memory &memory);
+    ~memory_search();
+
+    memory_search(const memory_search &) = delete;
+    memory_search &operator=(const memory_search &) = delete;
+
+    /**
+     * @brief 解析 /proc/pid/maps。
+     *
+     */
+    static std::vector<memory_region> read_maps(pid_t pid);
+
+    /**
+     * @brief 取消正在进行的查找，开始新的查找后立即返回。
+     *
+     * @param lo, hi 查找的地址范围，都为0时查找全部可读的映射；范围中不可读的部分跳过
+     * @param limit 最多报告的命中数，达到后停止
+     * @return false 模式为空或范围内没有可读的内存，原因见 error()
+     */
+    bool start(const std::vector<uint8_t> &pattern, uint64_t lo, uint64_t hi, std::size_t limit);
+
+    /**
+     * @brief 停止查找并等待工作线程退出，已找到的命中保留。
+     *
+     */
+    void cancel();
+
+    /**
+     * @brief 等待查找结束。
+     *
+     */
+    void wait();
+
+    /**
+     * @brief 取走上次调用以来新找到的命中，追加到 out 末尾。
+     *
+     * @return std::size_t 新命中的个数
+     */
+    std::size_t take(std::vector<search_hit> &out);
+
+    bool running() const { return m_active.load() > 0; }
+    bool truncated() const { return m_truncated.load(); }      // 达到命中数上限而提前停止
+    bool cancelled() const { return m_cancel.load() && !m_truncated.load(); }
+    uint64_t scanned() const { return m_scanned.load(); }      // 已扫描的字节数
+    uint64_t total() const { return m_total; }                 // 要扫描的字节数
+    double seconds() const;                                     // 已用的时间，结束后为总用时
+    const std::vector<memory_region> &regions() const { return m_regions; }
+    const std::string &error() const { return m_error; }
+
+private:
+    struct chunk {
+        uint64_t addr;
+        std::size_t len;        // 命中须起始于 [addr, addr + len)
+        std::size_t tail;       // 多读的字节，供跨块的命中比较和 context 使用
+    };
+
+    inferior_memory &m_memory;
+    std::vector<memory_region> m_regions;
+    std::vector<uint8_t> m_pattern;
+    std::size_t m_anchor;                   // memchr 查找的模式字节的下标
+    std::vector<chunk> m_chunks;
+    std::size_t m_limit;
+    uint64_t m_total;
+    std::string m_error;
+    std::vector<std::thread> m_threads;
+    std::atomic<std::size_t> m_next;        // 下一个待扫描的块
+    std::atomic<std::size_t> m_active;      // 未退出的工作线程数
+    std::atomic<std::size_t> m_found;
+    std::atomic<uint64_t> m_scanned;
+    std::atomic<bool> m_cancel;
+    std::atomic<bool> m_truncated;
+    std::atomic<int64_t> m_elapsed_ns;      // 结束时的总用时，未结束为-1
+    int64_t m_start_ns;
+    std::mutex m_lock;                      // 保护 m_pending
+    std::vector<search_hit> m_pending;
+
+    void worker();
+    void scan(uint64_t base, uint64_t end, const uint8_t *data, std::size_t len, std::vector<search_hit> &hits);   // 命中须起始于 end 之前
+    std::size_t region_of(uint64_t addr) const;
+};
+
+}   // namespace minidbg
+
+#endif
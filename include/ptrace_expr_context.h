@@ -10,6 +10,8 @@
 #include "dwarf/dwarf++.hh"
 #include "elf/elf++.hh"
 // #include "dwarf/expr.cc"
+#include "unwinder.h"
+#include "stop_state.h"
 
 
 namespace minidbg{
@@ -29,6 +31,26 @@ public:
     */
     ptrace_expr_context(pid_t pid, uint64_t load_address);
 
+    /**
+    * @brief 在外层栈帧中求值：寄存器和pc取自回溯恢复出的帧，帧中未知的寄存器只在第0帧读取当前值，外层帧中求值失败。
+    * @param frame 回溯得到的栈帧，须在求值期间保持有效。
+    */
+    ptrace_expr_context(pid_t pid, uint64_t load_address, const unwind_frame *frame);
+
+    /**
+    * @brief 在栈帧中求某个函数的变量的位置：DW_OP_fbreg 使用该函数 DW_AT_frame_base 的值，
+    * DW_OP_call_frame_cfa 使用回溯得到的CFA。
+    * @param subprogram 变量所在的 DW_TAG_subprogram（内联展开取其外层函数）
+    */
+    ptrace_expr_context(pid_t pid, uint64_t load_address, const unwind_frame *frame, const dwarf::die &subprogram);
+
+    /**
+    * @brief 使用停止时的快照求值：第0帧中未知的寄存器取快照中的寄存器组，内存经快照的页缓存读取，
+    * 常见情况下不产生系统调用。
+    * @param state 当前停止的快照，须在求值期间保持有效。
+    */
+    ptrace_expr_context(stop_state &state, uint64_t load_address, const unwind_frame *frame, const dwarf::die &subprogram);
+
     /**
     * @brief 获取指定寄存器的值。
     * @param regnum DWARF定义的寄存器编号。
@@ -44,15 +66,35 @@ public:
 
     /**
     * @brief 读取指定地址的内存值。
-    * @param address 目标地址，相对于加载地址。
-    * @param size 读取的数据大小（目前未使用）。
+    * @param address 目标地址（实际地址）。
+    * @param size 读取的字节数，不超过8。
     * @return 地址处的内存值。
     */
     dwarf::taddr deref_size(dwarf::taddr address, unsigned size) override;
 
+    /**
+    * @brief DW_OP_addr 给出的文件地址加上加载地址。
+    */
+    dwarf::taddr relocate(dwarf::taddr address) override;
+
+    /**
+    * @brief 函数的帧基址，第一次使用时计算 DW_AT_frame_base。
+    */
+    dwarf::taddr frame_base() override;
+
+    /**
+    * @brief 帧的CFA，未回溯出时抛出 dwarf::expr_error。
+    */
+    dwarf::taddr call_frame_cfa() override;
+
 private:
     pid_t m_pid; // 被调试的进程ID
     uint64_t m_load_address; // 程序加载地址
+    const unwind_frame *m_frame; // 求值所在的栈帧，为nullptr时使用当前寄存器
+    stop_state *m_state; // 停止时的快照，为nullptr时直接用ptrace读取
+    dwarf::die m_subprogram; // 提供 DW_AT_frame_base 的函数
+    bool m_has_frame_base;
+    dwarf::taddr m_frame_base;
 };
 
 }
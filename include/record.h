@@ -0,0 +1,127 @@
+/**
+ * @file record.h
+ * @brief 执行记录：记录模式下每执行一条指令保存一条撤销记录（变化寄存器的差值和被覆盖内存的原始内容），
+ * 以紧凑的差分编码存放在有容量上限的环形缓冲区中，用于反向执行。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_RECORD_H
+#define MINIDBG_RECORD_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+#include <utility>
+#include <sys/user.h>
+
+#include "inferior_memory.h"
+
+namespace minidbg {
+
+/**
+ * @brief 撤销记录日志。
+ *
+ * @details 每条记录的编码（全部为变长整数）：
+ * 变化寄存器的位图、每个变化寄存器的 (执行前 - 执行后) 的zigzag编码、内存区间数、
+ * 每个区间的 (地址 - 执行后rsp) 的zigzag编码、长度和原始字节，最后是4字节的记录长度，用于从尾部向前遍历。
+ * 记录按顺序写入1MB的块，总量超过上限时整块丢弃最旧的记录。
+ */
+class record_log {
+public:
+    record_log();
+
+    /**
+     * @brief 开始记录，丢弃旧记录。
+     *
+     * @param cap_bytes 记录占用内存的上限
+     */
+    void start(std::size_t cap_bytes);
+
+    /**
+     * @brief 停止记录并丢弃全部记录。
+     *
+     */
+    void stop();
+
+    bool active() const { return m_active; }
+
+    /**
+     * @brief 追加一条指令的撤销记录。
+     *
+     * @param before 执行前的寄存器
+     * @param after 执行后的寄存器
+     * @param images 执行前读取的内存，只保存每个请求实际读到的 done 字节
+     * @param complete 解码器能否确定全部写入区间
+     */
+    void push(const user_regs_struct &before, const user_regs_struct &after,
+              const mem_request *images, std::size_t n, bool complete);
+
+    /**
+     * @brief 撤销最近一条记录。
+     *
+     * @param regs 输入当前寄存器，输出执行该指令之前的寄存器
+     * @param images 需要写回的原始内存
+     * @return false 没有记录
+     */
+    bool pop(user_regs_struct &regs, std::vector<std::pair<uint64_t, std::vector<uint8_t>>> &images);
+
+    /**
+     * @brief 不撤销，只计算最近一条记录之前的寄存器。
+     *
+     */
+    bool peek(const user_regs_struct &regs, user_regs_struct &before) const;
+
+    /**
+     * @brief 不撤销，从最近一条记录开始向前依次计算每条指令执行之前的寄存器。
+     *
+     * @param visit 依次收到第1、2、……条之前的寄存器，返回false时停止
+     * @return 访问过的记录数
+     */
+    std::size_t walk_back(const user_regs_struct &regs,
+                          const std::function<bool(const user_regs_struct &before)> &visit) const;
+
+    bool empty() const { return m_entries == 0; }
+    std::size_t entries() const { return m_entries; }          // 当前保存的记录数
+    std::size_t bytes() const { return m_bytes; }
+    std::size_t cap() const { return m_cap; }
+    uint64_t recorded() const { return m_recorded; }           // 开始记录以来执行的指令数
+    uint64_t dropped() const { return m_dropped; }             // 因超出上限而丢弃的记录数
+    uint64_t incomplete() const { return m_incomplete; }       // 写入区间未知的指令数
+    uint64_t elapsed_ns() const { return m_elapsed_ns; }       // 记录模式下单步执行的总耗时
+    void add_time(uint64_t ns) { m_elapsed_ns += ns; }
+
+private:
+    struct chunk {
+        std::vector<uint8_t> data;
+        std::size_t entries;
+    };
+
+    bool m_active;
+    std::deque<chunk> m_chunks;
+    std::size_t m_cap;
+    std::size_t m_bytes;
+    std::size_t m_entries;
+    uint64_t m_recorded;
+    uint64_t m_dropped;
+    uint64_t m_incomplete;
+    uint64_t m_elapsed_ns;
+
+    /**
+     * @brief 解码 [p, end) 中的一条记录：把寄存器差值加到 regs 上，需要时取出内存原始内容。
+     *
+     */
+    static void decode(const uint8_t *p, const uint8_t *end, user_regs_struct &regs,
+                       std::vector<std::pair<uint64_t, std::vector<uint8_t>>> *images);
+
+    /**
+     * @brief 最近一条记录在最后一个块中的范围。
+     *
+     */
+    bool last_entry(const uint8_t *&begin, const uint8_t *&end) const;
+};
+
+}   // namespace minidbg
+
+#endif
@@ -89,6 +89,15 @@ namespace minidbg
      */
     uint64_t get_register_value_from_dwarf_register(pid_t pid, unsigned regnum);
 
+    /**
+     * @brief 从已读取的寄存器组中按DWARF编号取寄存器的值，不产生系统调用
+     * 
+     * @param regs 寄存器组
+     * @param regnum DWARF编号
+     * @return uint64_t 寄存器值
+     */
+    uint64_t get_register_value_from_dwarf_register(const user_regs_struct &regs, unsigned regnum);
+
     /**
      * @brief 通过寄存器名称获取寄存器枚举
      * 
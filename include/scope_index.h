@@ -0,0 +1,127 @@
+/**
+ * @file scope_index.h
+ * @brief 作用域索引：每个函数（或内联展开）只遍历一次DIE树，把嵌套的 DW_TAG_lexical_block 展开为按地址排序、
+ * 互不重叠的区间，每个区间对应最内层的作用域；某个pc处可见的变量按查找顺序排列并消除遮蔽，按作用域缓存。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_SCOPE_INDEX_H
+#define MINIDBG_SCOPE_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dwarf/dwarf++.hh"
+
+namespace minidbg {
+
+/**
+ * @brief 变量的作用域种类，也是同名时的查找顺序。
+ *
+ */
+enum class scope_kind : uint8_t {
+    local,          // 局部变量（含函数内的静态变量）
+    parameter,      // 形参
+    file_static,    // 本编译单元的文件作用域变量
+    global          // 其他编译单元中的外部变量
+};
+
+/**
+ * @brief 一个可见的变量。
+ *
+ */
+struct scope_var {
+    std::string name;
+    scope_kind kind;
+    unsigned depth;         // 局部变量所在词法块的嵌套深度，函数体为0
+    dwarf::die die;         // 具体实例（带 DW_AT_location 的DIE）
+};
+
+/**
+ * @brief 主程序的作用域索引，函数的作用域在第一次查询时建立。
+ *
+ */
+class scope_index {
+public:
+    scope_index();
+
+    /**
+     * @brief 换用新的DWARF，丢弃已建立的索引。
+     *
+     */
+    void reset(const dwarf::dwarf &dw);
+
+    /**
+     * @brief pc处最内层作用域的编号，函数体为0。编号相同的pc处可见的变量相同。
+     *
+     */
+    int scope_at(const dwarf::die &function, uint64_t pc);
+
+    /**
+     * @brief 函数（或内联展开）在文件地址pc处可见的局部变量和参数：最内层作用域的局部变量在前，
+     * 向外逐层直到函数体，然后是参数；被内层同名变量遮蔽的不出现。
+     *
+     * @param function DW_TAG_subprogram 或 DW_TAG_inlined_subroutine
+     * @return const std::vector<scope_var>& 引用在 reset() 之前有效
+     */
+    const std::vector<scope_var> &frame_variables(const dwarf::die &function, uint64_t pc);
+
+    /**
+     * @brief 按名字查找pc处可见的变量：依次为局部变量、参数、函数所在编译单元的静态变量、全局变量。
+     *
+     * @return const scope_var* 找不到时返回nullptr
+     */
+    const scope_var *lookup(const dwarf::die &function, uint64_t pc, const std::string &name);
+
+    /**
+     * @brief 按名字查找编译单元顶层定义的类型：typedef、基本类型，以及 struct/union/enum/class。
+     * 后者既可以写成 "struct point"，也可以只写 "point"。
+     *
+     * @return dwarf::die 找不到时返回无效的DIE
+     */
+    dwarf::die find_type(const std::string &name);
+
+private:
+    struct scope {
+        int parent;                         // 外层作用域，函数体为-1
+        unsigned depth;
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;      // 文件地址范围 [lo, hi)
+        std::vector<scope_var> vars;        // 按声明顺序
+    };
+
+    struct segment {
+        uint64_t lo;
+        uint64_t hi;
+        int scope;
+    };
+
+    struct function_scopes {
+        std::vector<scope> scopes;          // 0为函数体
+        std::vector<scope_var> parameters;
+        std::vector<segment> segments;      // 函数体之外的地址不在其中
+        std::unordered_map<int, std::vector<scope_var>> visible;    // 最内层作用域 -> 可见变量
+    };
+
+    using name_map = std::unordered_map<std::string, scope_var>;
+
+    dwarf::dwarf m_dwarf;
+    std::unordered_map<dwarf::section_offset, function_scopes> m_functions;    // 键：函数DIE的偏移
+    std::unordered_map<dwarf::section_offset, name_map> m_statics;              // 键：编译单元的偏移
+    name_map m_globals;
+    bool m_globals_built;
+    std::unordered_map<std::string, dwarf::die> m_types;       // 类型名 -> 类型DIE，第一次 find_type() 时建立
+    bool m_types_built;
+
+    function_scopes &scopes_of(const dwarf::die &function);
+    void collect(function_scopes &fs, const dwarf::die &die, int current);
+    const name_map &statics_of(const dwarf::unit &cu);
+    void build_globals();
+    void build_types();
+};
+
+}   // namespace minidbg
+
+#endif
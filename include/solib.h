@@ -0,0 +1,170 @@
+/**
+ * @file solib.h
+ * @brief 共享库管理：通过动态链接器的 rendezvous 结构（r_debug / link_map）跟踪被调试进程加载的共享库。
+ * 每个共享库的 ELF 和 DWARF 在第一次需要时才加载，加载了几百个库的进程也不需要预先索引全部库。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_SOLIB_H
+#define MINIDBG_SOLIB_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <sys/types.h>
+
+#include "dwarf/dwarf++.hh"
+#include "elf/elf++.hh"
+#include "inferior_memory.h"
+
+namespace minidbg {
+
+/**
+ * @brief 一个已加载的共享库。
+ *
+ */
+struct shared_object {
+    std::string name;               // link_map 中的 l_name
+    std::string file;               // /proc/pid/maps 中的实际文件路径，用于打开ELF
+    uint64_t base;                  // l_addr：文件中的地址加上base即为实际地址
+    uint64_t dynamic;               // l_ld：.dynamic 的实际地址，用于区分同一路径的不同加载
+    uint64_t start;                 // 映射范围 [start, end)
+    uint64_t end;
+
+    bool elf_tried;                 // 是否已尝试加载ELF（失败时elf无效）
+    elf::elf elf;
+    bool dwarf_tried;               // 是否已尝试加载DWARF（无调试信息时dwarf无效）
+    dwarf::dwarf dwarf;
+};
+
+/**
+ * @brief 共享库管理器。
+ *
+ * @details 动态链接器每次加载或卸载共享库时都会调用 _dl_debug_state()（即 r_debug.r_brk），
+ * 调试器在该函数上设置内部断点；命中且 r_state 为 RT_CONSISTENT 时重新遍历 link_map 链表，
+ * 与已有列表比较得出新增和卸载的库。
+ */
+class solib_manager {
+public:
+    explicit solib_manager(inferior_memory &mem);
+
+    solib_manager(const solib_manager &) = delete;
+    solib_manager &operator=(const solib_manager &) = delete;
+
+    /**
+     * @brief 丢弃全部状态，在被调试进程刚被exec、动态链接器尚未运行时调用。
+     *
+     * @param pid 被调试进程
+     * @param exe 主程序的ELF
+     * @param exe_load 主程序的加载地址
+     */
+    void reset(pid_t pid, const elf::elf &exe, uint64_t exe_load);
+
+    /**
+     * @brief 被调试进程被替换为其副本（fork）后改为读取新进程，已加载的库列表保留，由下一次 update() 比较差异。
+     *
+     */
+    void rebind(pid_t pid) { m_pid = pid; }
+
+    /**
+     * @brief 动态链接器通知调试器的地址：优先取 ld.so 导出的 _dl_debug_state，
+     * 动态链接器初始化之后也可以从 r_debug.r_brk 读出。
+     *
+     * @return uint64_t 找不到（如静态链接程序）时返回0
+     */
+    uint64_t event_address();
+
+    /**
+     * @brief 在rendezvous断点处调用：读取 r_debug 和 link_map，更新共享库列表。
+     *
+     * @param added 新增库在 modules() 中的下标
+     * @param removed 已卸载库的映射范围
+     * @return false 链表正在修改中（RT_ADD / RT_DELETE）或无法读取，列表未更新
+     */
+    bool update(std::vector<std::size_t> &added, std::vector<std::pair<uint64_t, uint64_t>> &removed);
+
+    std::vector<shared_object> &modules() { return m_modules; }
+
+    /**
+     * @brief 库列表是否完整：静态链接程序始终完整；动态链接程序在 r_state 为 RT_CONSISTENT 时更新过列表后完整，
+     * 动态链接器开始修改链表后又变为不完整。
+     *
+     */
+    bool complete() const { return m_complete; }
+
+    /**
+     * @brief 查找包含地址的共享库。
+     *
+     * @return shared_object* 不属于任何共享库时返回nullptr
+     */
+    shared_object *module_for_pc(uint64_t pc);
+
+    /**
+     * @brief 首次调用时打开共享库的ELF文件。
+     *
+     * @return false 文件无法打开（如 linux-vdso.so.1）
+     */
+    bool load_elf(shared_object &so);
+
+    /**
+     * @brief 首次调用时加载共享库的DWARF。
+     *
+     * @return false 没有调试信息
+     */
+    bool load_dwarf(shared_object &so);
+
+    /**
+     * @brief 在共享库中查找函数断点地址。先查ELF符号表，只有找到符号时才加载DWARF，用行表跳过函数序言。
+     *
+     * @return std::vector<std::intptr_t> 实际地址，找不到时为空
+     */
+    std::vector<std::intptr_t> function_addresses(shared_object &so, const std::string &name);
+
+    /**
+     * @brief 在共享库中查找源代码行对应的第一条语句地址。
+     *
+     * @return std::intptr_t 实际地址，找不到时返回0
+     */
+    std::intptr_t source_line_address(shared_object &so, const std::string &file, unsigned line);
+
+    /**
+     * @brief 在共享库的ELF符号表中查找包含实际地址pc的函数。
+     *
+     * @param start 输出：函数的实际起始地址
+     * @return false 没有符号覆盖pc
+     */
+    bool symbolize(shared_object &so, uint64_t pc, uint64_t &start, std::string &name);
+
+private:
+    inferior_memory &m_memory;
+    pid_t m_pid;
+    uint64_t m_exe_dynamic;                 // 主程序 .dynamic 的实际地址，0表示没有
+    uint64_t m_r_debug;                     // r_debug 的地址，0表示尚未找到
+    uint64_t m_event_address;
+    bool m_complete;
+    shared_object m_interp;                 // 动态链接器自身，用于查找 _dl_debug_state 和 _r_debug
+    std::vector<shared_object> m_modules;   // 不含主程序
+
+    /**
+     * @brief 从主程序 .dynamic 的 DT_DEBUG 或 ld.so 的 _r_debug 符号找到 r_debug。
+     *
+     */
+    uint64_t find_r_debug();
+
+    /**
+     * @brief 在ELF的符号表中查找已定义符号，返回文件中的地址。
+     *
+     */
+    std::vector<uint64_t> lookup_defined(shared_object &so, const std::string &name, bool functions_only);
+
+    /**
+     * @brief 读取被调试进程中以0结尾的字符串。
+     *
+     */
+    std::string read_string(uint64_t addr);
+};
+
+}   // namespace minidbg
+
+#endif
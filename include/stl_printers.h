@@ -0,0 +1,141 @@
+/**
+ * @file stl_printers.h
+ * @brief libstdc++ 容器的显示：std::vector、std::string、std::map/set、std::unordered_map/set 和 std::shared_ptr
+ * 按类型库中的成员布局识别，每个类型只识别一次。连续存放的元素按页一次读取；红黑树和哈希表的节点分页遍历，
+ * 每一轮把已知的待读节点用一次批量读取读入页缓存，遍历进度保留到本次停止结束，展开的元素个数有上限。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_STL_PRINTERS_H
+#define MINIDBG_STL_PRINTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "stop_state.h"
+#include "type_db.h"
+
+namespace minidbg {
+
+/**
+ * @brief 识别出的容器种类。
+ *
+ */
+enum class stl_kind : uint8_t {
+    none,           // 不是认识的容器，按普通结构体显示
+    vector,
+    string,
+    tree,           // std::map、std::set 及其 multi 版本，红黑树
+    hashtable,      // std::unordered_map、std::unordered_set 及其 multi 版本
+    shared_ptr
+};
+
+/**
+ * @brief 容器对象的布局，偏移均从容器对象开头起算（树节点的链接除外）。
+ *
+ */
+struct stl_layout {
+    stl_kind kind = stl_kind::none;
+    bool is_map = false;            // 元素是 std::pair<const K, V>，显示为 [K] = V
+    std::string name;               // 显示的容器名，如 "std::map"
+    type_id element = no_type;      // 元素类型，shared_ptr 为所指对象的类型
+    uint32_t first = 0;             // vector::_M_start、string::_M_p、树的 _M_header、哈希表的 _M_before_begin、shared_ptr::_M_ptr
+    uint32_t last = 0;              // vector::_M_finish、哈希表的 _M_buckets
+    uint32_t limit = 0;             // vector::_M_end_of_storage、哈希表的 _M_bucket_count
+    uint32_t count = 0;             // string::_M_string_length、树的 _M_node_count、哈希表的 _M_element_count、shared_ptr 的控制块指针
+    uint32_t node_value = 0;        // 节点中元素的偏移
+    uint32_t left = 0;              // 树节点 _Rb_tree_node_base 中的链接；哈希表节点的 _M_nxt 用 left
+    uint32_t right = 0;
+    uint32_t parent = 0;
+    uint32_t use_count = 0;         // shared_ptr 控制块中的引用计数
+    uint32_t weak_count = 0;
+};
+
+/**
+ * @brief 容器的长度和元素位置，内存经停止快照读取。
+ *
+ */
+class stl_printers {
+public:
+    static constexpr std::size_t max_node_elements = 10000;    // 树和哈希表最多展开的元素个数
+    static constexpr std::size_t page_elements = 64;           // 每次批量读取和遍历推进的元素个数
+    static constexpr std::size_t max_string = 200;             // 字符串最多显示的字符数
+
+    stl_printers(type_db &types, stop_state &state);
+
+    /**
+     * @brief 丢弃识别结果（类型库已清空）。
+     *
+     */
+    void clear();
+
+    /**
+     * @brief 类型的容器布局，不认识的类型 kind 为 none。
+     *
+     */
+    const stl_layout &layout(type_id type);
+
+    /**
+     * @brief 元素个数：vector 和 string 由指针或长度算出，树和哈希表取其计数成员，不遍历节点。
+     *
+     * @return false 容器对象不可读
+     */
+    bool length(const stl_layout &l, uint64_t address, uint64_t &n);
+
+    /**
+     * @brief 可以展开的元素个数，树和哈希表不超过 max_node_elements。
+     *
+     */
+    std::size_t element_count(const stl_layout &l, uint64_t address);
+
+    /**
+     * @brief 第i个元素的地址。vector 直接算出，每页第一个元素时把整页元素一次读入；
+     * 树和哈希表从已遍历的位置继续，每推进一页先批量读入邻近的节点。
+     *
+     * @return false 下标越界或节点不可读
+     */
+    bool element(const stl_layout &l, uint64_t address, std::size_t i, uint64_t &out);
+
+    /**
+     * @brief string 的内容，带引号和转义，超过 max_string 的部分省略。
+     *
+     */
+    bool text(const stl_layout &l, uint64_t address, std::string &out);
+
+    /**
+     * @brief shared_ptr 所指对象的地址和计数，空指针时两个计数为0。
+     *
+     */
+    bool counts(const stl_layout &l, uint64_t address, uint64_t &pointer, uint32_t &use, uint32_t &weak);
+
+private:
+    /**
+     * @brief 一个树或哈希表容器在本次停止中已遍历到的位置。
+     *
+     */
+    struct walk {
+        std::vector<uint64_t> nodes;    // 已遍历的节点，按迭代顺序
+        uint64_t end = 0;               // 树的头节点（end()）或哈希表的 _M_before_begin 的地址
+        bool done = false;              // 遍历已到末尾或遇到不可读的节点
+    };
+
+    type_db &m_types;
+    stop_state &m_state;
+    std::unordered_map<type_id, stl_layout> m_layouts;
+    std::unordered_map<uint64_t, walk> m_walks;             // 键：容器地址
+    uint64_t m_generation;                                  // m_walks 所属的快照
+
+    bool identify(type_id type, stl_layout &l);
+    bool read_word(uint64_t addr, uint64_t &value);
+    walk &walk_of(const stl_layout &l, uint64_t address);
+    void advance(const stl_layout &l, walk &w, std::size_t want);
+    void prefetch_tree(const stl_layout &l, uint64_t from, std::size_t budget);
+    void prefetch_buckets(const stl_layout &l, uint64_t address);
+};
+
+}   // namespace minidbg
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @file stop_state.h
+ * @brief 一次停止期间被调试进程的状态快照：寄存器组只读取一次，/proc/pid/maps 只解析一次并按地址排序，
+ * 读过的内存按页缓存。进程再次运行或内存被改写前，变量求值不再产生系统调用。进程运行后，若能得知期间写过哪些页，
+ * 其余缓存的页继续使用。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_STOP_STATE_H
+#define MINIDBG_STOP_STATE_H
+
+#include <sys/user.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "inferior_memory.h"
+
+namespace minidbg {
+
+/**
+ * @brief 两次采集之间被写过的页。
+ *
+ */
+struct page_changes {
+    std::vector<std::pair<uint64_t, uint64_t>> tracked;    // 被跟踪的地址区间 [lo, hi)，按地址递增，其中未列入 dirty 的页未被写过
+    std::vector<uint64_t> dirty;                            // 被写过的页首地址，递增
+};
+
+/**
+ * @brief 返回自上次采集以来被写过的页。参数为缓存中的页数，采集比重读这些页还贵时返回nullptr，无法得知时也返回nullptr。
+ *
+ */
+using change_source = std::function<const page_changes *(std::size_t cached_pages)>;
+
+/**
+ * @brief 当前停止的寄存器、内存区域和内存页缓存，均在第一次使用时读取。
+ *
+ */
+class stop_state {
+public:
+    static constexpr std::size_t page_size = 4096;
+    static constexpr std::size_t max_pages = 1024;     // 超过后整体丢弃，避免扫描大数组时无限增长
+
+    /**
+     * @param changes 进程运行期间写过的页的来源，为空时每次停止都丢弃全部缓存的页
+     */
+    explicit stop_state(inferior_memory &memory, change_source changes = change_source());
+
+    /**
+     * @brief 丢弃快照。寄存器或内存被调试器改写、换了被调试进程时调用。
+     *
+     */
+    void reset();
+
+    /**
+     * @brief 进程运行后再次停止：丢弃寄存器和映射表。缓存的页在下次使用时按写过的页筛选，
+     * 被写过的、不在跟踪区间内的页丢弃；无法得知写过哪些页时全部丢弃。
+     *
+     */
+    void next_stop();
+
+    pid_t pid() const { return m_memory.pid(); }
+
+    /**
+     * @brief 当前线程的寄存器组，每次停止只 PTRACE_GETREGS 一次。
+     *
+     * @return const user_regs_struct* 进程已退出时返回nullptr
+     */
+    const user_regs_struct *regs();
+
+    /**
+     * @brief [addr, addr + len) 是否全部落在可读的映射中。
+     *
+     */
+    bool readable(uint64_t addr, std::size_t len);
+
+    /**
+     * @brief 经页缓存读取内存，未缓存的页整页读入。
+     *
+     * @return std::size_t 实际读取的字节数，遇到不可读的页时提前结束
+     */
+    std::size_t read(uint64_t addr, void *buf, std::size_t len);
+
+    /**
+     * @brief [addr, addr + len) 所在的页是否都已在缓存中，不读取内存。
+     *
+     */
+    bool cached(uint64_t addr, std::size_t len);
+
+    /**
+     * @brief 把若干区间覆盖的、尚未缓存的可读页用一次批量读取读入缓存。
+     *
+     * @param ranges (地址, 长度) 列表
+     */
+    void prefetch(const std::vector<std::pair<uint64_t, std::size_t>> &ranges);
+
+    /**
+     * @brief 把之后 read() 和 readable() 涉及的页首地址追加到 pages 中（可能重复），传入nullptr停止记录。
+     * 用于记下一次求值依赖哪些页。
+     *
+     */
+    void log_pages(std::vector<uint64_t> *pages) { m_page_log = pages; }
+
+    std::size_t page_misses() const { return m_page_misses; }      // 本次停止读入的页数
+    std::size_t pages_kept() const { return m_pages_kept; }        // 本次停止沿用的上次的页数
+    uint64_t generation() const { return m_generation; }            // 每次 reset() 或 next_stop() 加一，用于判断按快照缓存的结果是否过期
+    uint64_t resets() const { return m_resets; }                    // 每次 reset() 加一：内存或寄存器被调试器改写，写过的页无从得知
+
+private:
+    struct region {
+        uint64_t lo;
+        uint64_t hi;
+        bool readable;
+    };
+
+    struct page {
+        std::array<uint8_t, page_size> data;
+        std::size_t valid;      // 从页首起读到的字节数
+    };
+
+    inferior_memory &m_memory;
+    change_source m_changes;
+    bool m_unverified;                  // next_stop() 后缓存的页尚未筛选
+    bool m_have_regs;
+    bool m_regs_ok;
+    user_regs_struct m_regs;
+    bool m_have_regions;
+    std::vector<region> m_regions;      // 按起始地址排序
+    std::unordered_map<uint64_t, std::unique_ptr<page>> m_pages;   // 键：页首地址
+    std::size_t m_page_misses;
+    std::size_t m_pages_kept;
+    uint64_t m_generation;
+    uint64_t m_resets;
+    std::vector<uint64_t> *m_page_log;  // 非空时记录涉及的页
+
+    void verify();
+    void log_range(uint64_t addr, std::size_t len);
+    void load_regions();
+    const page &page_at(uint64_t base);
+};
+
+}   // namespace minidbg
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * @file tracepoint.h
+ * @brief 快速追踪点：把探测点处至少5字节的指令替换为跳转到注入的蹦床（trampoline）代码，蹦床把寄存器和指定内存写入共享内存环形缓冲区后跳回，被调试进程不会停下。调试器在后台线程中异步读取环形缓冲区。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_TRACEPOINT_H
+#define MINIDBG_TRACEPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+#include "inferior_memory.h"
+#include "registers.h"
+
+namespace minidbg {
+
+/**
+ * @brief 环形缓冲区中每条记录保存的寄存器，顺序与蹦床压栈后复制的顺序一致。
+ *
+ */
+static constexpr std::size_t n_trace_regs = 18;
+extern const char *const g_trace_reg_names[n_trace_regs];
+
+/**
+ * @brief 环形缓冲区布局：64字节头部，随后是 capacity 条定长记录。
+ * 记录：seq(8) + 追踪点编号(8) + 寄存器(18*8) + 采集的内存(trace_max_collect)。
+ * seq 为0表示记录正在写入，写完后蹦床写入全局递增的序号。
+ */
+static constexpr uint64_t trace_ring_header = 64;
+static constexpr uint64_t trace_ring_capacity = 4096;                  // 必须为2的幂
+static constexpr uint64_t trace_max_collect = 256;
+static constexpr uint64_t trace_record_size = 16 + n_trace_regs * 8 + trace_max_collect;
+static constexpr uint64_t trace_ring_bytes = trace_ring_header + trace_ring_capacity * trace_record_size;
+
+/**
+ * @brief 追踪点命中时采集的一段内存：[寄存器 + offset, + len)。
+ *
+ */
+struct trace_collect {
+    reg base;
+    int64_t offset;
+    uint32_t len;
+};
+
+/**
+ * @brief 已安装的追踪点。
+ *
+ */
+struct tracepoint {
+    int id;
+    std::string spec;
+    uint64_t addr;                          // 探测点地址
+    std::vector<uint8_t> original;          // 被跳转指令覆盖的原始字节
+    uint64_t trampoline;                    // 蹦床在被调试进程中的地址
+    uint64_t displaced_copy;                // 蹦床中被搬来的指令的地址
+    std::vector<trace_collect> collects;
+    uint64_t hits;                          // 已读取到的命中次数
+};
+
+/**
+ * @brief 从环形缓冲区读出的一条记录。
+ *
+ */
+struct trace_record {
+    uint64_t seq;
+    int id;
+    uint64_t regs[n_trace_regs];
+    std::vector<uint8_t> memory;            // 按collects顺序拼接的内存内容
+};
+
+/**
+ * @brief 追踪点管理器：生成蹦床代码、修补探测点，并在后台线程中读取环形缓冲区。
+ *
+ * @details 代码区和环形缓冲区由debugger通过注入系统调用在被调试进程中分配后交给本类。
+ * 环形缓冲区优先与调试器共享（memfd），读取时不需要任何系统调用；共享失败时退回用 process_vm_readv 读取。
+ */
+class tracepoint_manager {
+public:
+    explicit tracepoint_manager(inferior_memory &mem);
+    ~tracepoint_manager();
+
+    tracepoint_manager(const tracepoint_manager &) = delete;
+    tracepoint_manager &operator=(const tracepoint_manager &) = delete;
+
+    /**
+     * @brief 寄存器能否作为采集内存的基址：蹦床保存的15个通用寄存器、rsp和rip。
+     *
+     */
+    static bool collectable(reg r);
+
+    /**
+     * @brief 是否已经分配了代码区和环形缓冲区。
+     *
+     */
+    bool ready() const { return m_code_base != 0; }
+
+    /**
+     * @brief 设置被调试进程中的代码区和环形缓冲区。
+     *
+     * @param code_base 代码区地址（须位于探测点±2GB内）
+     * @param code_size 代码区大小
+     * @param ring_remote 环形缓冲区在被调试进程中的地址
+     * @param ring_local 环形缓冲区在调试器中的映射，为nullptr时通过inferior_memory读取
+     */
+    void setup(uint64_t code_base, uint64_t code_size, uint64_t ring_remote, uint8_t *ring_local);
+
+    /**
+     * @brief 安装追踪点。
+     *
+     * @param addr 探测点地址
+     * @param displaced 将被搬到蹦床中执行的完整指令字节，长度至少为5，且不能依赖其所在地址
+     * @param collects 需要采集的内存
+     * @param spec 用户输入的描述
+     * @return int 追踪点编号，失败时返回-1
+     */
+    int install(uint64_t addr, const std::vector<uint8_t> &displaced,
+                const std::vector<trace_collect> &collects, const std::string &spec);
+
+    /**
+     * @brief 恢复探测点的原始指令。蹦床代码保留在被调试进程中。
+     *
+     */
+    bool remove(int id);
+
+    /**
+     * @brief 恢复全部探测点的原始指令但保留追踪点表，用于复制进程（checkpoint）前得到干净的副本。
+     *
+     */
+    void suspend();
+
+    /**
+     * @brief 重新写入 suspend() 移除的跳转。
+     *
+     */
+    void resume();
+
+    /**
+     * @brief 地址是否落在某个追踪点覆盖的指令范围内。
+     *
+     */
+    bool covers(uint64_t addr) const;
+
+    /**
+     * @brief 跳转第一个字节之后、仍在覆盖范围内的地址，对应到蹦床中被搬来的同一条指令；其余地址原样返回。
+     * 这些字节在 rel32 或填充的nop中，原处写入0xcc会破坏跳转或永远不会执行到。
+     *
+     */
+    uint64_t displaced_address(uint64_t addr) const;
+
+    /**
+     * @brief 读取环形缓冲区中新提交的记录，后台线程周期性调用，也可在停止时手动调用。
+     *
+     */
+    void drain();
+
+    /**
+     * @brief 复制最近读取的记录（最多 max_records 条）。
+     *
+     */
+    std::vector<trace_record> recent(std::size_t max_records) const;
+
+    /**
+     * @brief 复制追踪点列表（含命中次数）。
+     *
+     */
+    std::vector<tracepoint> list() const;
+
+    /**
+     * @brief 因覆盖而丢失的记录数。
+     *
+     */
+    uint64_t lost() const;
+
+    /**
+     * @brief 停止后台线程、丢弃全部状态。被调试进程已被替换时使用，不访问其内存。
+     *
+     */
+    void reset();
+
+private:
+    inferior_memory &m_memory;
+    uint64_t m_code_base;
+    uint64_t m_code_size;
+    uint64_t m_code_used;
+    uint64_t m_ring_remote;
+    uint8_t *m_ring_local;
+    int m_next_id;
+
+    mutable std::mutex m_mutex;             // 保护以下成员，后台线程与UI线程共享
+    std::vector<tracepoint> m_tracepoints;
+    std::deque<trace_record> m_records;
+    uint64_t m_tail;                        // 下一条要读取的记录序号
+    uint64_t m_lost;
+
+    std::thread m_drain_thread;
+    std::atomic<bool> m_stop;
+
+    void start_drain_thread();
+    void stop_drain_thread();
+
+    /**
+     * @brief 生成蹦床机器码。
+     *
+     */
+    std::vector<uint8_t> build_trampoline(int id, uint64_t addr, uint64_t trampoline,
+                                          const std::vector<uint8_t> &displaced,
+                                          const std::vector<trace_collect> &collects) const;
+
+    /**
+     * @brief 从环形缓冲区读取一段字节，共享时直接复制，否则通过inferior_memory。
+     *
+     */
+    bool ring_read(uint64_t offset, void *buf, std::size_t len);
+};
+
+}   // namespace minidbg
+
+#endif
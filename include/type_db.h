@@ -0,0 +1,230 @@
+/**
+ * @file type_db.h
+ * @brief 类型布局库：每个类型DIE只遍历一次，得到大小、对齐、种类、成员偏移与位域、数组维度、指向的类型和枚举值，
+ * 按DIE偏移记忆，存为紧凑的平坦记录。此后从内存缓冲区解码任意类型的值都不再访问DIE树。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_TYPE_DB_H
+#define MINIDBG_TYPE_DB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dwarf/dwarf++.hh"
+
+namespace minidbg {
+
+/**
+ * @brief 类型的种类。typedef 和 const/volatile/restrict 修饰在建库时已被剥去。
+ *
+ */
+enum class type_kind : uint8_t {
+    unknown,        // 没有类型信息或不支持的类型，按整数显示
+    void_,
+    signed_int,
+    unsigned_int,
+    signed_char,
+    unsigned_char,
+    boolean,
+    floating,
+    pointer,
+    reference,      // 左值和右值引用
+    structure,      // struct 和 class
+    union_,
+    array,
+    enumeration,
+    function
+};
+
+using type_id = int32_t;            // 类型在库中的编号，-1表示无
+constexpr type_id no_type = -1;
+
+/**
+ * @brief 一个类型的布局。成员、枚举值、数组维度存放在库的公共数组中，记录只保存其区间。
+ *
+ */
+struct type_record {
+    type_kind kind;
+    bool is_class;          // DW_TAG_class_type，只影响显示的名字
+    uint32_t size;          // 字节数，未知时为0
+    uint32_t align;
+    uint32_t name;          // 名字在字符串表中的下标
+    type_id target;         // 指针/引用指向的类型、数组元素类型、枚举的底层类型
+    uint32_t first;         // 成员、枚举值或数组维度的起始下标
+    uint32_t count;
+    uint32_t params;        // 类模板实例的类型实参的起始下标
+    uint32_t param_count;
+};
+
+/**
+ * @brief 结构体的成员或基类。
+ *
+ */
+struct type_member {
+    uint32_t name;
+    type_id type;
+    uint32_t bit_offset;    // 从结构体开头起的位偏移，普通成员为字节偏移的8倍
+    uint16_t bit_size;      // 位域的位数，普通成员为0
+    uint8_t flags;
+
+    static constexpr uint8_t base = 1;          // 基类子对象
+    static constexpr uint8_t virtual_base = 2;  // 虚基类，偏移要运行时从虚表得到，bit_offset无效
+    static constexpr uint8_t artificial = 4;    // 编译器生成的成员，如虚表指针
+
+    uint32_t byte_offset() const { return bit_offset / 8; }
+};
+
+/**
+ * @brief 枚举值。
+ *
+ */
+struct type_enumerator {
+    uint32_t name;
+    int64_t value;
+};
+
+/**
+ * @brief 主程序的类型布局库，类型在第一次用到时建立。
+ *
+ */
+class type_db {
+public:
+    static constexpr std::size_t max_elements = 200;       // 数组显示的元素个数上限
+
+    type_db();
+
+    /**
+     * @brief 丢弃全部类型（被调试程序已更换）。
+     *
+     */
+    void clear();
+
+    /**
+     * @brief 不对应DIE的基本类型，如表达式中的字面量和运算结果的 int、unsigned long、double，按名字只建立一次。
+     *
+     */
+    type_id scalar(type_kind kind, uint32_t size, const std::string &name);
+
+    /**
+     * @brief 指向 target 的指针类型，用于取地址和数组退化，每个目标类型只建立一次。
+     *
+     */
+    type_id pointer_to(type_id target);
+
+    /**
+     * @brief 类型DIE对应的记录，剥去 typedef 和 cv 修饰。
+     *
+     * @return type_id 非类型DIE返回 no_type
+     */
+    type_id of(const dwarf::die &type);
+
+    /**
+     * @brief 变量、成员或形参的 DW_AT_type 对应的记录。
+     *
+     */
+    type_id of_variable(const dwarf::die &var);
+
+    const type_record &record(type_id id) const { return m_records[id]; }
+    const std::string &name_of(uint32_t name) const { return m_strings[name]; }
+
+    /**
+     * @brief 类型的C/C++写法，如 "int *"、"struct point"、"char [16]"。
+     *
+     */
+    std::string type_name(type_id id) const;
+
+    const type_member *members(type_id id) const { return m_members.data() + m_records[id].first; }
+    const type_enumerator *enumerators(type_id id) const { return m_enumerators.data() + m_records[id].first; }
+
+    /**
+     * @brief 类模板实例的类型实参（DW_TAG_template_type_param），按声明顺序，个数为 record(id).param_count。
+     *
+     */
+    const type_id *template_args(type_id id) const { return m_params.data() + m_records[id].params; }
+
+    /**
+     * @brief 按名字查找非位域的数据成员，依次为直接成员、匿名结构体/联合体和非虚基类中的成员。
+     *
+     * @param offset 成员从 id 开头起的字节偏移
+     * @param type 成员的类型
+     */
+    bool find_field(type_id id, const std::string &name, uint32_t &offset, type_id &type) const;
+
+    /**
+     * @brief 数组的各维长度，最外层在前，未知长度（如柔性数组）为0。
+     *
+     */
+    const uint64_t *dimensions(type_id id) const { return m_dims.data() + m_records[id].first; }
+
+    /**
+     * @brief 数组元素的总个数，多维数组为各维长度之积；元素类型为 record(id).target。
+     *
+     */
+    uint64_t element_count(type_id id) const;
+
+    /**
+     * @brief 显示一个值时要读取的字节数，超过 limit 的取 limit。
+     *
+     */
+    std::size_t value_size(type_id id, std::size_t limit) const;
+
+    /**
+     * @brief 数组第dim维上一个元素的字节数，即由其后各维组成的子数组的大小。非数组返回类型的大小。
+     *
+     */
+    std::size_t stride(type_id id, uint32_t dim) const;
+
+    /**
+     * @brief 把缓冲区中的值按类型格式化。缓冲区不足时只显示已有部分，结构体和数组递归显示。
+     *
+     * @param bytes 值的起始处
+     * @param len 缓冲区中可用的字节数
+     * @param dim 多维数组从第几维开始（值是其子数组）
+     */
+    std::string format(type_id id, const uint8_t *bytes, std::size_t len, uint32_t dim = 0) const;
+
+    /**
+     * @brief 格式化一个位域，bit_offset 从 bytes 起算。
+     *
+     */
+    std::string format_bits(type_id id, const uint8_t *bytes, std::size_t len, uint32_t bit_offset, uint16_t bit_size) const;
+
+    /**
+     * @brief 把 len 个字节写成带双引号的C字符串，不可打印字符和NUL转义。
+     *
+     */
+    static std::string quote(const uint8_t *bytes, std::size_t len);
+
+    std::size_t size() const { return m_records.size(); }   // 已建立的类型数
+
+private:
+    std::vector<type_record> m_records;
+    std::vector<type_member> m_members;
+    std::vector<type_enumerator> m_enumerators;
+    std::vector<uint64_t> m_dims;
+    std::vector<type_id> m_params;
+    std::vector<std::string> m_strings;         // 下标0为空串
+    std::unordered_map<dwarf::section_offset, type_id> m_ids;      // 键：类型DIE的偏移
+    std::unordered_map<std::string, type_id> m_scalars;            // scalar() 建立的类型
+    std::unordered_map<type_id, type_id> m_pointers;               // pointer_to() 建立的类型，键：目标类型
+    type_id m_unknown;
+
+    uint32_t intern(const std::string &s);
+    type_id add(type_kind kind, uint32_t size, uint32_t name);
+    type_id build(const dwarf::die &die);
+    void build_struct(type_id id, const dwarf::die &die);
+    void build_array(type_id id, const dwarf::die &die);
+    void build_enum(type_id id, const dwarf::die &die);
+    void format_into(std::string &out, type_id id, const uint8_t *bytes, std::size_t len, unsigned depth) const;
+    void format_array(std::string &out, type_id id, uint32_t dim, const uint8_t *bytes, std::size_t len, unsigned depth) const;
+    void format_scalar(std::string &out, type_id id, const uint8_t *bytes, std::size_t len) const;
+    bool append_bits(std::string &out, type_id id, const uint8_t *bytes, std::size_t len, uint32_t bit_offset, uint16_t bit_size) const;
+};
+
+}   // namespace minidbg
+
+#endif
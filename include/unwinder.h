@@ -0,0 +1,275 @@
+/**
+ * @file unwinder.h
+ * @brief 基于DWARF调用帧信息（CFI）的栈回溯：按 .eh_frame_hdr 的二分查找表（或自建的有序FDE索引）找到pc所属的FDE，
+ * 执行CIE/FDE中的CFA指令得到该pc处的规则行，据此恢复调用者的寄存器，不依赖rbp帧指针链。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_UNWINDER_H
+#define MINIDBG_UNWINDER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/user.h>
+
+#include "elf/elf++.hh"
+#include "inferior_memory.h"
+
+namespace minidbg {
+
+static constexpr unsigned cfi_ra = 16;          // x86-64 DWARF 中返回地址所在的列
+static constexpr unsigned cfi_n_regs = 17;      // 跟踪的列：DWARF编号0-15的通用寄存器和返回地址
+
+/**
+ * @brief 一个栈帧及恢复出的寄存器。
+ *
+ */
+struct unwind_frame {
+    uint64_t pc;                    // 第0帧为当前pc，外层帧为返回地址
+    uint64_t cfa;                   // 规范帧地址（调用本函数之前的rsp），回溯到该帧之后才知道，未知时为0
+    uint64_t regs[cfi_n_regs];      // 按DWARF编号：0 rax、1 rdx、2 rcx、3 rbx、4 rsi、5 rdi、6 rbp、7 rsp、8-15 r8-r15
+    uint32_t valid;                 // regs 中已知的位，调用者帧中只有被调用者保存的寄存器可知
+    bool exact_pc;                  // pc 就是正在执行的指令（第0帧或被信号中断的帧），否则 pc 是返回地址
+    bool innermost;                 // 第0帧：不在 regs 中的寄存器（如xmm）就是当前值，外层帧中则无从得知
+
+    bool has(unsigned r) const { return r < cfi_n_regs && (valid & (1u << r)); }
+
+    /**
+     * @brief 用于查找函数、行号和CFI的地址：返回地址可能已是下一个函数的开头（noreturn调用），须减1。
+     *
+     */
+    uint64_t lookup_pc() const { return exact_pc ? pc : pc - 1; }
+};
+
+/**
+ * @brief CFI中一个寄存器的恢复规则。
+ *
+ */
+struct cfi_rule {
+    enum kind : uint8_t {
+        unspecified,        // 未出现：被调用者保存的寄存器视为未改变，其余未知
+        undefined,          // 不可恢复；返回地址列为undefined表示最外层帧
+        same_value,
+        at_offset,          // 保存在 CFA + offset
+        val_offset,         // 值为 CFA + offset
+        in_register,        // 保存在另一个寄存器中
+        at_expression,      // 保存在表达式算出的地址
+        val_expression      // 值为表达式的结果
+    };
+    kind how;
+    unsigned reg;
+    int64_t offset;
+    const uint8_t *expr;
+    std::size_t expr_len;
+};
+
+/**
+ * @brief 某个pc处的规则行：CFA的计算方式和各寄存器的恢复规则。
+ *
+ */
+struct cfi_row {
+    bool cfa_is_expr;           // CFA由 DW_CFA_def_cfa_expression 给出（如PLT）
+    unsigned cfa_reg;
+    int64_t cfa_offset;
+    const uint8_t *cfa_expr;
+    std::size_t cfa_expr_len;
+    cfi_rule rules[cfi_n_regs];
+    bool signal_frame;          // CIE增强串含'S'：信号返回跳板
+};
+
+/**
+ * @brief 一个ELF文件的调用帧信息。
+ *
+ * @details 优先使用 .eh_frame_hdr 中按起始地址排序的 (initial_location, fde) 表直接二分查找；
+ * 没有该表或其编码不是常见的 datarel|sdata4 时，扫描 .eh_frame 自建有序索引。
+ * .debug_frame 只在 .eh_frame 中找不到时才扫描。算出的规则行按pc缓存。
+ */
+class cfi_table {
+public:
+    explicit cfi_table(const elf::elf &f);
+
+    cfi_table(const cfi_table &) = delete;
+    cfi_table &operator=(const cfi_table &) = delete;
+
+    /**
+     * @brief 文件地址pc处的规则行。
+     *
+     * @return const cfi_row* 没有覆盖pc的FDE时返回nullptr
+     */
+    const cfi_row *row_for(uint64_t pc);
+
+private:
+    struct section_data {
+        const uint8_t *data;
+        std::size_t size;
+        uint64_t vaddr;
+    };
+
+    struct cie {
+        uint64_t code_align;
+        int64_t data_align;
+        unsigned ra_column;
+        uint8_t fde_encoding;
+        bool has_augmentation_data;     // 增强串以'z'开头，FDE中有增强数据长度
+        bool signal_frame;
+        const uint8_t *insns;
+        const uint8_t *insns_end;
+    };
+
+    struct fde {
+        const cie *owner;
+        uint64_t pc_begin;
+        uint64_t pc_end;
+        const uint8_t *insns;
+        const uint8_t *insns_end;
+    };
+
+    struct index_entry {
+        uint64_t pc_begin;
+        std::size_t offset;             // 在所属节中的偏移
+        bool debug_frame;
+    };
+
+    elf::elf m_elf;                     // 持有文件映射，保证节数据和规则行中的表达式指针有效
+    section_data m_eh_frame;
+    section_data m_debug_frame;
+    const uint8_t *m_hdr_table;         // .eh_frame_hdr 的二分查找表，不可用时为nullptr
+    uint64_t m_hdr_vaddr;
+    std::size_t m_hdr_count;
+    bool m_indexed;
+    std::vector<index_entry> m_index;
+    std::unordered_map<uint64_t, cie> m_cies;           // 键：节内偏移，.debug_frame 的置最高位
+    std::unordered_map<uint64_t, cfi_row> m_rows;
+    std::unordered_set<uint64_t> m_no_row;              // 没有FDE的pc，避免重复查找
+
+    bool find_fde(uint64_t pc, fde &out);
+    bool parse_fde(const section_data &sec, std::size_t offset, bool debug_frame, fde &out);
+    const cie *parse_cie(const section_data &sec, std::size_t offset, bool debug_frame);
+    void build_index();
+    bool execute(const fde &f, uint64_t pc, cfi_row &row);
+};
+
+/**
+ * @brief 栈回溯器：按模块缓存CFI，从当前寄存器逐帧恢复调用者。
+ *
+ */
+class unwinder {
+public:
+    /**
+     * @brief 查找包含pc的模块。
+     *
+     * @param bias 输出：文件地址加上bias为实际地址
+     * @param lo 输出：模块映射范围 [lo, hi)
+     * @return const elf::elf* 找不到时返回nullptr
+     */
+    using module_lookup = std::function<const elf::elf *(uint64_t pc, uint64_t &bias, uint64_t &lo, uint64_t &hi)>;
+
+    unwinder(inferior_memory &mem, module_lookup lookup);
+
+    unwinder(const unwinder &) = delete;
+    unwinder &operator=(const unwinder &) = delete;
+
+    /**
+     * @brief 丢弃全部模块的CFI（被调试程序已更换）。
+     *
+     */
+    void clear();
+
+    /**
+     * @brief 丢弃落在 [lo, hi) 中的模块（共享库已卸载）。
+     *
+     */
+    void forget(uint64_t lo, uint64_t hi);
+
+    /**
+     * @brief 由当前寄存器构造第0帧。
+     *
+     */
+    static unwind_frame first_frame(const user_regs_struct &regs);
+
+    /**
+     * @brief 计算frame的CFA并恢复其调用者帧。没有CFI的地址按rbp帧指针链回溯。
+     *
+     * @return false frame已是最外层帧或无法继续回溯
+     */
+    bool step(unwind_frame &frame, unwind_frame &caller);
+
+    /**
+     * @brief 进程停止后调用：以新的寄存器作为第0帧重新开始，上一次停止时的调用栈留作拼接。
+     *
+     * @details 之后按需向外回溯时，一旦某帧的CFA与上一次的某帧相同，且从其返回地址槽读出的返回地址
+     * 和恢复出的调用者寄存器也与上一次完全一致，说明调用者及更外层的帧没有变化，直接接上上一次的外层帧，不再继续回溯。
+     */
+    void begin_stack(const user_regs_struct &regs);
+
+    /**
+     * @brief 丢弃缓存的调用栈（被调试进程被替换、共享库被卸载等）。
+     *
+     */
+    void drop_stack();
+
+    /**
+     * @brief 第i帧（0为最内层），需要时继续向外回溯。
+     *
+     * @return const unwind_frame* 超出最外层帧时返回nullptr；指针在下一次调用本类的非const函数前有效
+     */
+    const unwind_frame *frame_at(std::size_t i);
+
+    std::size_t frames_known() const { return m_stack.size(); }     // 已回溯出（含拼接）的帧数
+    bool stack_complete() const { return m_stack_complete; }        // 是否已到达最外层帧
+    std::size_t frames_reused() const { return m_reused; }          // 本次停止从上一次拼接来的帧数
+    std::size_t frames_unwound() const { return m_unwound; }        // 本次停止实际回溯的帧数
+
+private:
+    struct module {
+        uint64_t hi;
+        uint64_t bias;
+        std::unique_ptr<cfi_table> table;
+    };
+
+    inferior_memory &m_memory;
+    module_lookup m_lookup;
+    std::map<uint64_t, module> m_modules;       // 按映射起始地址排序
+
+    std::deque<unwind_frame> m_stack;           // 当前调用栈，最外层在前，向外回溯时在前端追加
+    bool m_stack_complete;
+    std::deque<unwind_frame> m_prev;            // 上一次停止时的调用栈，CFA从前往后递减
+    bool m_prev_complete;
+    bool m_splicing;                            // 还可能与上一次的调用栈拼接
+    std::size_t m_reused;
+    std::size_t m_unwound;
+
+    /**
+     * @brief 刚回溯出 outer 的调用者 caller 时尝试与上一次的调用栈拼接。
+     *
+     * @return true 已拼接，m_stack 包含上一次的全部外层帧
+     */
+    bool splice(const unwind_frame &outer, const unwind_frame &caller);
+
+    module *module_for(uint64_t pc);
+    bool read_word(uint64_t addr, uint64_t &value);
+
+    /**
+     * @brief 计算CFI中的DWARF表达式（只支持CFI中常见的运算）。
+     *
+     * @param initial 寄存器规则中的表达式先把CFA压栈，CFA表达式传nullptr
+     */
+    bool evaluate(const uint8_t *p, std::size_t len, const unwind_frame &frame, const uint64_t *initial, uint64_t &result);
+
+    /**
+     * @brief 没有CFI时按rbp帧指针链恢复调用者。
+     *
+     */
+    bool step_frame_pointer(unwind_frame &frame, unwind_frame &caller);
+};
+
+}   // namespace minidbg
+
+#endif
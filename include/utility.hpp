@@ -3,6 +3,10 @@
 
 #include<string>
 #include<vector>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -49,6 +53,46 @@ public:
         return std::equal(s.begin(), s.end(), of.begin());
     }
 
+    /**
+     * @brief 把用户输入的十进制整数转换为int，整个字符串都须是数字。
+     * 
+     * @param s 
+     * @param out 成功时写入
+     * @return false 不是整数或超出范围
+     */
+    static inline bool parse_int(const std::string &s, int &out)
+    {
+        if (s.empty())
+            return false;
+        char *end = nullptr;
+        errno = 0;
+        long v = std::strtol(s.c_str(), &end, 10);
+        if (*end != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX)
+            return false;
+        out = static_cast<int>(v);
+        return true;
+    }
+
+    /**
+     * @brief 把用户输入的十进制非负整数转换为size_t，整个字符串都须是数字。
+     * 
+     * @param s 
+     * @param out 成功时写入
+     * @return false 不是非负整数或超出范围
+     */
+    static inline bool parse_size(const std::string &s, std::size_t &out)
+    {
+        if (s.empty() || s[0] < '0' || s[0] > '9')
+            return false;
+        char *end = nullptr;
+        errno = 0;
+        unsigned long long v = std::strtoull(s.c_str(), &end, 10);
+        if (*end != '\0' || errno == ERANGE || v > SIZE_MAX)
+            return false;
+        out = static_cast<std::size_t>(v);
+        return true;
+    }
+
     /**
      * @brief 判断地址是否有效：逐行读取/proc/_pid/maps文件。
      * 
@@ -0,0 +1,116 @@
+/**
+ * @file value_scanner.h
+ * @brief 按值查找未知地址：第一次扫描读取全部可写的映射，记录按宽度对齐、满足条件的地址；此后每次扫描只重读候选地址，
+ * 按与上次的值相比是否相等、变化、增大或减小逐步缩小候选集。候选地址和上次的值存放在按地址排序的紧凑数组中，
+ * 重读时相邻的候选合并为一段，全部段用批量读取读入。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_VALUE_SCANNER_H
+#define MINIDBG_VALUE_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "array_inspector.h"
+#include "inferior_memory.h"
+#include "memory_search.h"
+
+namespace minidbg {
+
+/**
+ * @brief 候选值的筛选条件。前四个与给定的值比较，其余与上次扫描时的值比较，只能用于后续扫描。
+ *
+ */
+enum class scan_filter : uint8_t {
+    eq, ne, gt, lt,
+    changed, unchanged, increased, decreased
+};
+
+class value_scanner {
+public:
+    static constexpr std::size_t chunk_bytes = 4u << 20;       // 第一次扫描每次读取的字节数
+    static constexpr std::size_t max_candidates = 32u << 20;   // 超过后第一次扫描停止
+    static constexpr uint64_t merge_gap = 1024;                // 间隔不超过该值的候选合并到同一段读取，每段的系统调用开销约等于复制数KB
+    static constexpr std::size_t max_span = 1u << 20;          // 每段的字节数上限
+    static constexpr std::size_t batch_bytes = 64u << 20;      // 每次批量读取的字节数上限
+
+    explicit value_scanner(inferior_memory &memory);
+
+    /**
+     * @brief 类型名对应的数值类型：i8 … u64、f32、f64，或 char、short、int、long、float、double、unsigned 及 int32_t 等。
+     *
+     */
+    static number_kind parse_kind(const std::string &name);
+
+    static std::size_t width(number_kind kind);
+
+    /**
+     * @brief 第一次扫描：丢弃原有候选，扫描全部可写的映射。
+     *
+     * @param filter 只能是 eq、ne、gt、lt
+     * @param operand 比较的值，整数可写作十六进制
+     * @return false 参数有误，原因见 error()
+     */
+    bool first(number_kind kind, scan_filter filter, const std::string &operand);
+
+    /**
+     * @brief 后续扫描：重读全部候选，保留满足条件的，记下其新值。已不可读的候选丢弃。
+     *
+     * @param operand eq、ne、gt、lt 比较的值，其余条件不用
+     */
+    bool next(scan_filter filter, const std::string &operand);
+
+    /**
+     * @brief 丢弃全部候选。
+     *
+     */
+    void reset();
+
+    bool active() const { return m_kind != number_kind::none; }
+    number_kind kind() const { return m_kind; }
+    std::size_t size() const { return m_addresses.size(); }
+    uint64_t address(std::size_t i) const { return m_addresses[i]; }
+
+    /**
+     * @brief 第i个候选在最近一次扫描时的值。
+     *
+     */
+    std::string format(std::size_t i) const;
+
+    /**
+     * @brief 地址所在的映射，映射表在第一次扫描时读取。
+     *
+     * @return const memory_region* 不在任何映射中时返回nullptr
+     */
+    const memory_region *region_of(uint64_t address) const;
+
+    std::size_t scans() const { return m_scans; }          // 本轮已扫描的次数
+    std::size_t spans() const { return m_spans; }          // 最近一次扫描读取的段数
+    uint64_t bytes_read() const { return m_bytes_read; }   // 最近一次扫描读取的字节数
+    double seconds() const { return m_seconds; }           // 最近一次扫描的用时
+    bool truncated() const { return m_truncated; }         // 第一次扫描达到候选数上限
+    const std::string &error() const { return m_error; }
+
+private:
+    inferior_memory &m_memory;
+    number_kind m_kind;
+    std::size_t m_width;
+    std::vector<memory_region> m_regions;
+    std::vector<uint64_t> m_addresses;      // 按地址递增
+    std::vector<uint8_t> m_values;          // 与 m_addresses 一一对应，每个 m_width 字节
+    std::size_t m_scans;
+    std::size_t m_spans;
+    uint64_t m_bytes_read;
+    double m_seconds;
+    bool m_truncated;
+    std::string m_error;
+
+    bool parse_operand(const std::string &text, uint64_t &raw);
+};
+
+}   // namespace minidbg
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * @file value_tree.h
+ * @brief 结构化的值：结构体、数组和指针可以逐层展开。每个节点只记录类型和位置，子节点在展开时才计算，
+ * 值在显示时才经本次停止的页缓存读取，大数组只读取屏幕上可见的元素。
+ * @version 0.1
+ * @date 2026-10-18
+ */
+#ifndef MINIDBG_VALUE_TREE_H
+#define MINIDBG_VALUE_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "stl_printers.h"
+#include "stop_state.h"
+#include "type_db.h"
+
+namespace minidbg {
+
+/**
+ * @brief 值树中的一个节点：变量、成员、数组元素或指针指向的对象。
+ *
+ */
+struct value_ref {
+    std::string label;      // 变量名、成员名、[i] 或 *name
+    type_id type = no_type;
+    uint32_t dim = 0;       // 多维数组的子数组从第几维开始
+    bool in_memory = false;
+    uint64_t address = 0;   // in_memory 时值所在的地址
+    uint64_t word = 0;      // 不在内存中的值（寄存器或 DW_OP_stack_value）
+    uint16_t bit_offset = 0;    // 位域从 address（或 word）起的位偏移
+    uint16_t bit_size = 0;      // 位域的位数，普通值为0
+    std::string error;      // 非空时没有值，如 "<optimized out>"
+};
+
+/**
+ * @brief 按类型布局展开值树，经停止快照读取内存。libstdc++ 容器按其元素展开和显示。
+ *
+ */
+class value_tree {
+public:
+    static constexpr std::size_t summary_bytes = 256;      // 结构体和数组的摘要最多读取的字节数
+    static constexpr std::size_t summary_elements = 10;    // 容器的摘要最多显示的元素个数
+    static constexpr unsigned max_summary_depth = 3;       // 含容器的值的摘要最多嵌套的层数
+
+    value_tree(type_db &types, stop_state &state);
+
+    /**
+     * @brief 丢弃按类型记忆的容器识别结果（类型库已清空）。
+     *
+     */
+    void clear();
+
+    /**
+     * @brief 子节点个数：结构体的成员和基类、数组本维的长度、非空类型指针为1，容器为其元素个数，其余为0。
+     *
+     */
+    std::size_t child_count(const value_ref &v);
+
+    /**
+     * @brief 第i个子节点，只计算位置；指针的子节点需要读取指针本身的值。
+     *
+     */
+    value_ref child(const value_ref &v, std::size_t i);
+
+    /**
+     * @brief 值的一行摘要，结构体和数组只读取开头 summary_bytes 字节。
+     *
+     */
+    std::string summary(const value_ref &v);
+
+    std::string type_name(const value_ref &v) const;
+
+    /**
+     * @brief summary() 读取的字节数，位于内存中的值才有意义。
+     *
+     */
+    std::size_t summary_size(const value_ref &v) const;
+
+    /**
+     * @brief 值是否为连续存放的元素：数组（多维数组按全部剩余的维展平）或 std::vector。
+     *
+     * @param address 首元素的地址
+     * @param element 元素类型
+     * @param count 元素个数
+     */
+    bool contiguous(const value_ref &v, uint64_t &address, type_id &element, uint64_t &count);
+
+    /**
+     * @brief 值是容器或含有容器，摘要还要读取值本身以外的内存，不能只凭 summary_size() 字节判断是否变化。
+     *
+     */
+    bool indirect(const value_ref &v);
+
+private:
+    type_db &m_types;
+    stop_state &m_state;
+    stl_printers m_stl;
+    std::unordered_map<type_id, bool> m_printable;     // 类型是否为容器或含有容器
+
+    std::size_t byte_size(const value_ref &v) const;
+    bool has_printer(type_id type);
+    const stl_layout *container(const value_ref &v);
+    std::string summary_at(const value_ref &v, unsigned depth);
+    std::string container_summary(const value_ref &v, const stl_layout &l, unsigned depth);
+};
+
+}   // namespace minidbg
+
+#endif
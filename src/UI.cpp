@@ -1,5 +1,10 @@
 #include "UI.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <climits>
+#include <cstring>
 
 namespace minidbg 
 {
@@ -46,6 +51,27 @@ static void glfw_error_callback(int error, const char *description)
 UI::UI(debugger& dbg) : dbg(dbg) {
     commandInput[0] = '\0';        // 命令行输入缓冲区
     newVariableName[0] = '\0';     // 输入变量名缓冲区
+    chainExpression[0] = '\0';
+    std::snprintf(chainFields, sizeof(chainFields), "next");
+    chainLimit = static_cast<int>(chain_walker::default_limit);
+    arrayExpression[0] = '\0';
+    arrayCount = 0;
+    arrayPredicate = 0;
+    arrayOperand = 0;
+    searchRange[0] = '\0';
+    searchPattern[0] = '\0';
+    searchLimit = static_cast<int>(memory_search::default_limit);
+    scanType = 4;      // i32
+    scanFilter = 0;
+    scanValue[0] = '\0';
+    memoryTarget[0] = '\0';
+    memoryFormat = 0;
+    memoryAscii = true;
+    memoryBase = 0;
+    memoryTop = 0;
+    memoryJump = 0;
+    memoryJumpPending = false;
+    memoryPlaced = false;
 }
 
 
@@ -59,6 +85,15 @@ bool UI::show_option_bar = true;
 bool UI::show_call_stack = true;
 bool UI::show_command_inputBar = true;
 bool UI::show_watcher = true;
+bool UI::show_tracepoints = false;
+bool UI::show_locals = true;
+bool UI::show_globals = false;
+bool UI::show_chains = false;
+bool UI::show_arrays = false;
+bool UI::show_search = false;
+bool UI::show_scanner = false;
+bool UI::show_changes = false;
+bool UI::show_memory = false;
 bool UI::show_demo_window = false;
 int UI::windows_status = (ImGuiWindowFlags_None);
 
@@ -97,6 +132,33 @@ void UI::render()
     if (show_watcher){
         showVariableWatcher();
     }
+    if (show_tracepoints) {
+        showTracepoints(&show_tracepoints);
+    }
+    if (show_locals) {
+        showLocals(&show_locals);
+    }
+    if (show_globals) {
+        showGlobals(&show_globals);
+    }
+    if (show_chains) {
+        showChains(&show_chains);
+    }
+    if (show_arrays) {
+        showArrays(&show_arrays);
+    }
+    if (show_search) {
+        showSearch(&show_search);
+    }
+    if (show_scanner) {
+        showScanner(&show_scanner);
+    }
+    if (show_changes) {
+        showChanges(&show_changes);
+    }
+    if (show_memory) {
+        showMemory(&show_memory);
+    }
 }
 
 void UI::showCommandInputBar()
@@ -122,7 +184,8 @@ void UI::showCommandInputBar()
 
 
 /**
- * @brief 变量监视窗口，输入变量名、点击Add即可进行监视。
+ * @brief 变量监视窗口，输入C/C++表达式、点击Add即可进行监视。结构体、数组和指针可以逐层展开，右键根节点可移除。
+ * 监视只在进程停止后由调试器重新求值，与上次停止时不同的值以红色显示。
  * 
  */
 void UI::showVariableWatcher() {
@@ -132,15 +195,32 @@ void UI::showVariableWatcher() {
         ImGuiWindowFlags window_flags = ImGuiWindowFlags_HorizontalScrollbar;
         ImGui::BeginChild("Variable Watcher Data", ImVec2(ImGui::GetContentRegionAvail().x, ImGui::GetContentRegionAvail().y), false, window_flags);
 
-        ImGui::InputText("Variable Name", newVariableName, IM_ARRAYSIZE(newVariableName));
-        if (ImGui::Button("Add")) {
-            watchedVariables[std::string(newVariableName)] = "Pending...";       // 初始值
+        ImGui::InputText("Expression", newVariableName, IM_ARRAYSIZE(newVariableName));
+        if (ImGui::Button("Add") && newVariableName[0] != '\0') {
+            dbg.add_watch(newVariableName);
             newVariableName[0] = '\0';          // 清空输入框
         }
-        updateWatchedVariables(); // 更新变量的值
-        for (auto& var : watchedVariables) {
-            // std::cout<<var.first<<"  "<<var.second<<std::endl;
-            ImGui::Text("%s: %s", var.first.c_str(), var.second.c_str());
+
+        static ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+        if (ImGui::BeginTable("watch", 3, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("name", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("value", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("type");
+            ImGui::TableHeadersRow();
+
+            int removed = -1;
+            for (const auto &w : dbg.get_watches())
+            {
+                ImGui::PushID(w.id);
+                if (showValueNode(w.root, &w))
+                    removed = w.id;
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+            if (removed >= 0)
+                dbg.remove_watch(removed);
         }
 
         ImGui::EndChild();
@@ -149,16 +229,763 @@ void UI::showVariableWatcher() {
 }
 
 /**
- * @brief 调用debugger类的方法，刷新被监视的变量值
+ * @brief 显示值树的一个节点，展开时才计算子节点。子节点多时用 ImGuiListClipper 分页，只计算和读取可见的行。
  * 
+ * @param watch 根节点所属的监视，其值已由调试器缓存；子节点为nullptr
+ * @return true 用户选择移除该根节点
  */
-void UI::updateWatchedVariables() {
-    for (auto& var : watchedVariables) {
-        var.second = dbg.read_variable(var.first);
+bool UI::showValueNode(const value_ref &v, const watch_entry *watch) {
+    static constexpr std::size_t clip_threshold = 64;
+    auto &tree = dbg.values();
+    std::size_t n = tree.child_count(v);
+
+    ImGui::TableNextRow();
+    ImGui::TableSetColumnIndex(0);
+    ImGuiTreeNodeFlags node_flags = ImGuiTreeNodeFlags_SpanFullWidth;
+    if (n == 0)
+        node_flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    bool open = ImGui::TreeNodeEx(v.label.c_str(), node_flags);
+    bool remove = false;
+    if (watch && ImGui::BeginPopupContextItem())
+    {
+        if (ImGui::MenuItem("Remove"))
+            remove = true;
+        ImGui::EndPopup();
     }
+    ImGui::TableSetColumnIndex(1);
+    if (!watch)
+        ImGui::TextUnformatted(tree.summary(v).c_str());
+    else if (watch->changed)
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", watch->value.c_str());
+    else
+        ImGui::TextUnformatted(watch->value.c_str());
+    ImGui::TableSetColumnIndex(2);
+    ImGui::TextUnformatted(tree.type_name(v).c_str());
+
+    if (n > 0 && open)
+    {
+        if (n <= clip_threshold)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                ImGui::PushID(static_cast<int>(i));
+                showValueNode(tree.child(v, i), nullptr);
+                ImGui::PopID();
+            }
+        }
+        else
+        {
+            // 行高按未展开的元素估计，展开其中的元素时滚动位置会略有偏差
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(std::min<std::size_t>(n, INT_MAX)));
+            while (clipper.Step())
+            {
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+                {
+                    ImGui::PushID(i);
+                    showValueNode(tree.child(v, i), nullptr);
+                    ImGui::PopID();
+                }
+            }
+        }
+        ImGui::TreePop();
+    }
+    return remove;
 }
 
 
+/**
+ * @brief 局部变量窗口：选中帧中可见的参数和局部变量。每次停止后整帧一次批量读取，其余时间直接显示缓存。
+ *
+ */
+void UI::showLocals(bool *p_open)
+{
+    ImGui::Begin("Locals", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        static ImGuiTableFlags flags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY;
+        if (ImGui::BeginTable("locals", 2, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("name");
+            ImGui::TableSetupColumn("value", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            const auto &vars = dbg.get_frame_variables();
+            ImGuiListClipper clipper;
+            clipper.Begin(vars.size());
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("%s%s", vars[row].name.c_str(), vars[row].parameter ? " (arg)" : "");
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::TextUnformatted(vars[row].value.c_str());
+                }
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief 全局变量窗口：按编译单元分组的全局变量和静态变量。每次停止后全部值一次批量读取，展开的编译单元只绘制可见的行。
+ *
+ */
+void UI::showGlobals(bool *p_open)
+{
+    ImGui::Begin("Globals", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        static ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+        if (ImGui::BeginTable("globals", 3, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("name", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("value", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("type");
+            ImGui::TableHeadersRow();
+
+            const auto &globals = dbg.get_globals();
+            const auto &vars = globals.variables();
+            for (const auto &unit : globals.units())
+            {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                bool open = ImGui::TreeNodeEx(unit.name.c_str(), ImGuiTreeNodeFlags_SpanFullWidth, "%s (%zu)", unit.name.c_str(), unit.count);
+                if (!open)
+                    continue;
+                ImGuiListClipper clipper;
+                clipper.Begin(static_cast<int>(unit.count));
+                while (clipper.Step())
+                {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                    {
+                        const auto &var = vars[unit.first + row];
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::Text("%s%s", var.name.c_str(), var.is_static ? " (static)" : "");
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::TextUnformatted(var.value.c_str());
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::TextUnformatted(var.type.c_str());
+                    }
+                }
+                ImGui::TreePop();
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief 链式结构窗口：从起点表达式沿指定的指针成员广度优先遍历，节点分层批量读取；节点按层缩进，只绘制可见的行。
+ *
+ */
+void UI::showChains(bool *p_open)
+{
+    ImGui::Begin("Pointer Chain", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        ImGui::InputText("Start", chainExpression, IM_ARRAYSIZE(chainExpression));
+        ImGui::InputText("Fields", chainFields, IM_ARRAYSIZE(chainFields));
+        ImGui::InputInt("Limit", &chainLimit);
+        if (ImGui::Button("Walk") && chainExpression[0] != '\0')
+        {
+            std::vector<std::string> fields;
+            std::stringstream list(chainFields);
+            std::string field;
+            while (std::getline(list, field, ','))
+            {
+                field.erase(std::remove(field.begin(), field.end(), ' '), field.end());
+                if (!field.empty())
+                    fields.push_back(field);
+            }
+            chainResult = dbg.follow(chainExpression, fields, static_cast<std::size_t>(std::max(chainLimit, 1)));
+            chainBackLinks.assign(chainResult.nodes.size(), std::string{});
+            for (const auto &link : chainResult.back_links)
+            {
+                auto &text = chainBackLinks[link.first];
+                text += (text.empty() ? "#" : ", #") + std::to_string(link.second);
+            }
+        }
+
+        if (!chainResult.error.empty())
+        {
+            ImGui::TextUnformatted(chainResult.error.c_str());
+        }
+        else if (!chainResult.nodes.empty())
+        {
+            ImGui::Text("%zu nodes in %zu levels (%zu batched reads)%s, %zu links back", chainResult.nodes.size(), chainResult.levels,
+                        chainResult.reads, chainResult.truncated ? " (limit reached)" : "", chainResult.back_links.size());
+        }
+
+        static ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+        if (!chainResult.nodes.empty() && ImGui::BeginTable("chain", 5, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("node", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("from");
+            ImGui::TableSetupColumn("address");
+            ImGui::TableSetupColumn("value", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("links back");
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(chainResult.nodes.size()));
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    const auto &node = chainResult.nodes[row];
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("%*s#%d", static_cast<int>(std::min<uint32_t>(node.depth, 32) * 2), "", row);
+                    ImGui::TableSetColumnIndex(1);
+                    if (node.parent >= 0)
+                        ImGui::Text("#%d->%s", node.parent, chainResult.fields[node.field].c_str());
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("0x%lx", node.address);
+                    ImGui::TableSetColumnIndex(3);
+                    ImGui::TextUnformatted(node.value.c_str());
+                    ImGui::TableSetColumnIndex(4);
+                    ImGui::TextUnformatted(chainBackLinks[row].c_str());
+                }
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief 数组检查窗口：整个数组每次停止只读取一次，显示统计量、降采样的曲线和直方图，可查找第一个满足条件的元素。
+ *
+ */
+void UI::showArrays(bool *p_open)
+{
+    static const char *predicates[] = {"==", "!=", "<", "<=", ">", ">=", "nan", "inf", "!finite"};
+    ImGui::Begin("Array Inspector", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        ImGui::InputText("Expression", arrayExpression, IM_ARRAYSIZE(arrayExpression));
+        ImGui::InputInt("Count", &arrayCount);
+        if (ImGui::Button("Load") && arrayExpression[0] != '\0')
+        {
+            dbg.inspect_array(arrayExpression, static_cast<uint64_t>(std::max(arrayCount, 0)));
+            arrayFound.clear();
+        }
+
+        const auto &array = dbg.get_array();
+        if (!array.loaded())
+        {
+            ImGui::TextUnformatted(array.error().c_str());
+        }
+        else
+        {
+            const auto &stats = array.stats();
+            ImGui::Text("%lu elements at 0x%lx", stats.count, array.address());
+            if (stats.count > 0)
+            {
+                ImGui::Text("min %s at [%lu], max %s at [%lu], mean %g", array.format(stats.min_index).c_str(), stats.min_index,
+                            array.format(stats.max_index).c_str(), stats.max_index, stats.mean);
+                ImGui::Text("%lu NaN, %lu Inf", stats.nan_count, stats.inf_count);
+            }
+
+            const auto &plot = array.plot();
+            float width = ImGui::GetContentRegionAvail().x;
+            if (!plot.empty())
+                ImGui::PlotLines("##values", plot.data(), static_cast<int>(plot.size()), 0, "values", FLT_MAX, FLT_MAX, ImVec2(width, 160));
+            if (!stats.histogram.empty())
+            {
+                std::vector<float> bins(stats.histogram.begin(), stats.histogram.end());
+                ImGui::PlotHistogram("##histogram", bins.data(), static_cast<int>(bins.size()), 0, "histogram", 0.0f, FLT_MAX, ImVec2(width, 120));
+            }
+
+            ImGui::Separator();
+            ImGui::SetNextItemWidth(120);
+            ImGui::Combo("##predicate", &arrayPredicate, predicates, IM_ARRAYSIZE(predicates));
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(200);
+            ImGui::InputDouble("##operand", &arrayOperand);
+            ImGui::SameLine();
+            if (ImGui::Button("Find"))
+            {
+                auto index = array.find(static_cast<array_predicate>(arrayPredicate), arrayOperand);
+                arrayFound = index < 0 ? "No element matches." : "[" + std::to_string(index) + "] = " + array.format(static_cast<uint64_t>(index));
+            }
+            ImGui::TextUnformatted(arrayFound.c_str());
+        }
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief 内存查找窗口：查找在后台线程中进行，每帧取回新命中；命中表只绘制可见的行。
+ *
+ */
+void UI::showSearch(bool *p_open)
+{
+    ImGui::Begin("Memory Search", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        const auto &search = dbg.get_search();
+        ImGui::InputText("Range", searchRange, IM_ARRAYSIZE(searchRange));
+        ImGui::InputText("Pattern", searchPattern, IM_ARRAYSIZE(searchPattern));
+        ImGui::InputInt("Limit", &searchLimit);
+        if (search.running())
+        {
+            if (ImGui::Button("Cancel"))
+                dbg.cancel_search();
+        }
+        else if (ImGui::Button("Find") && searchPattern[0] != '\0')
+        {
+            std::string args = searchRange[0] == '\0' ? std::string(searchPattern) : std::string(searchRange) + ", " + searchPattern;
+            if (dbg.find_memory(args, static_cast<std::size_t>(std::max(searchLimit, 1)), searchError))
+                searchError.clear();
+        }
+
+        const auto &hits = dbg.get_search_hits();
+        if (!searchError.empty())
+        {
+            ImGui::TextUnformatted(searchError.c_str());
+        }
+        else if (search.total() > 0)
+        {
+            float done = static_cast<float>(static_cast<double>(search.scanned()) / search.total());
+            char label[64];
+            std::snprintf(label, sizeof(label), "%.1f / %.1f MiB", search.scanned() / 1048576.0, search.total() / 1048576.0);
+            ImGui::ProgressBar(done, ImVec2(-1, 0), label);
+            double seconds = search.seconds();
+            ImGui::Text("%zu matches%s in %.3fs (%.0f MiB/s)%s", hits.size(), search.truncated() ? " (limit reached)" : "", seconds,
+                        seconds > 0 ? search.scanned() / 1048576.0 / seconds : 0.0, search.cancelled() ? ", cancelled" : "");
+        }
+
+        static ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+        if (!hits.empty() && ImGui::BeginTable("hits", 3, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("address", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("bytes");
+            ImGui::TableSetupColumn("where", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(hits.size()));
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    const auto &hit = hits[row];
+                    char bytes[3 * 16 + 1] = {};
+                    for (std::size_t k = 0; k < hit.context_len; ++k)
+                        std::snprintf(bytes + 3 * k, sizeof(bytes) - 3 * k, "%02x ", hit.context[k]);
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("0x%lx", hit.address);
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::TextUnformatted(bytes);
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::TextUnformatted(hit.where.c_str());
+                }
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief 值扫描窗口：第一次扫描按类型和值记录候选地址，进程每运行一段后按条件筛选；只显示前若干个候选。
+ *
+ */
+void UI::showScanner(bool *p_open)
+{
+    static const char *types[] = {"i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32", "f64"};
+    static const char *filters[] = {"==", "!=", ">", "<", "changed", "unchanged", "increased", "decreased"};
+    ImGui::Begin("Value Scanner", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        const auto &scanner = dbg.get_scanner();
+        ImGui::SetNextItemWidth(120);
+        ImGui::Combo("Type", &scanType, types, IM_ARRAYSIZE(types));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(200);
+        ImGui::Combo("Filter", &scanFilter, filters, IM_ARRAYSIZE(filters));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(200);
+        ImGui::InputText("Value", scanValue, IM_ARRAYSIZE(scanValue));
+        // 与上次的值比较的条件不需要给出值
+        std::string args = std::string(filters[scanFilter]) + (scanFilter < 4 ? std::string(" ") + scanValue : std::string{});
+        if (ImGui::Button("New Scan"))
+        {
+            if (dbg.scan_values(std::string(types[scanType]) + " " + args, scanError))
+                scanError.clear();
+        }
+        ImGui::SameLine();
+        if (scanner.active() && ImGui::Button("Next Scan"))
+        {
+            if (dbg.scan_values(args, scanError))
+                scanError.clear();
+        }
+        ImGui::SameLine();
+        if (scanner.active() && ImGui::Button("Reset"))
+        {
+            dbg.reset_scan();
+            scanError.clear();
+        }
+
+        if (!scanError.empty())
+        {
+            ImGui::TextUnformatted(scanError.c_str());
+        }
+        else if (scanner.active())
+        {
+            ImGui::Text("%zu candidates%s after scan %zu: %zu reads, %lu KiB in %.3fs", scanner.size(), scanner.truncated() ? " (limit reached)" : "",
+                        scanner.scans(), scanner.spans(), scanner.bytes_read() / 1024, scanner.seconds());
+        }
+
+        const auto &rows = dbg.get_scan_candidates();
+        static ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+        if (!rows.empty() && ImGui::BeginTable("candidates", 3, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("address", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("value");
+            ImGui::TableSetupColumn("where", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(rows.size()));
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("0x%lx", rows[row].address);
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::TextUnformatted(rows[row].value.c_str());
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::TextUnformatted(rows[row].where.c_str());
+                }
+            }
+            ImGui::EndTable();
+        }
+        if (scanner.size() > rows.size())
+            ImGui::Text("(%zu more)", scanner.size() - rows.size());
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief 被写过的内存窗口：上次查看以来可写映射中被写过的页，相邻的合并为一段。
+ *
+ */
+void UI::showChanges(bool *p_open)
+{
+    ImGui::Begin("Changed Memory", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        const auto &rows = dbg.get_changed_memory();
+        const auto &tracker = dbg.get_dirty_tracker();
+        if (tracker.mode() == tracking_mode::none)
+        {
+            ImGui::TextUnformatted("no process to track");
+        }
+        else
+        {
+            ImGui::Text("%zu pages written since last look (%s, %lu KiB read in %.3f ms)", dbg.get_changed_pages(),
+                        tracker.mode() == tracking_mode::soft_dirty ? "soft-dirty bits" : "page hashes",
+                        tracker.bytes_read() / 1024, tracker.seconds() * 1000);
+        }
+
+        static ImGuiTableFlags flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+        if (!rows.empty() && ImGui::BeginTable("changes", 3, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("range", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("bytes");
+            ImGui::TableSetupColumn("where", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(rows.size()));
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("0x%lx-0x%lx", rows[row].lo, rows[row].hi);
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%lu", rows[row].hi - rows[row].lo);
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::TextUnformatted(rows[row].where.c_str());
+                }
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief 内存查看器：表格只铺开从 memoryBase 起的一段行，由 ImGuiListClipper 只读取和绘制可见的行；
+ * 滚到这一段的边缘时平移 memoryBase 并补偿滚动位置，整个地址空间都能连续滚动。
+ *
+ */
+void UI::showMemory(bool *p_open)
+{
+    static const char *formats[] = {"u8", "u16", "u32", "u64", "float", "double"};
+    static const int widths[] = {1, 2, 4, 8, 4, 8};
+    const uint64_t row_bytes = 16;
+    const int window_rows = 1 << 18;            // 铺开的行数（4MiB），滚动位置保持在 float 能精确表示的范围内
+    const uint64_t window_bytes = row_bytes * window_rows;
+    const uint64_t user_top = 1ull << 47;       // 用户空间的上界
+    ImGui::Begin("Memory", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        if (!memoryPlaced)
+        {
+            // 第一次打开时停在栈顶
+            memoryPlaced = true;
+            memoryJump = dbg.get_rsp();
+            memoryJumpPending = true;
+        }
+        ImGui::SetNextItemWidth(300);
+        bool go = ImGui::InputText("##target", memoryTarget, IM_ARRAYSIZE(memoryTarget), ImGuiInputTextFlags_EnterReturnsTrue);
+        ImGui::SameLine();
+        go |= ImGui::Button("Go");
+        if (go)
+        {
+            uint64_t address;
+            if (dbg.resolve_view_address(memoryTarget, address, memoryError))
+            {
+                memoryError.clear();
+                memoryJump = address;
+                memoryJumpPending = true;
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("SP"))
+        {
+            memoryJump = dbg.get_rsp();
+            memoryJumpPending = true;
+        }
+        ImGui::SameLine();
+        uint64_t target;
+        if (ImGui::Button("Prev Region") && dbg.adjacent_view_region(memoryTop, false, target))
+        {
+            memoryJump = target;
+            memoryJumpPending = true;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Next Region") && dbg.adjacent_view_region(memoryTop, true, target))
+        {
+            memoryJump = target;
+            memoryJumpPending = true;
+        }
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(150);
+        ImGui::Combo("Format", &memoryFormat, formats, IM_ARRAYSIZE(formats));
+        ImGui::SameLine();
+        ImGui::Checkbox("ASCII", &memoryAscii);
+
+        if (!memoryError.empty())
+            ImGui::TextUnformatted(memoryError.c_str());
+        else
+            ImGui::Text("0x%lx  %s", memoryTop, dbg.describe_view_address(memoryTop).c_str());
+
+        // 目标所在的行放在铺开的一段的中间
+        int jump_row = -1;
+        if (memoryJumpPending)
+        {
+            uint64_t row_address = std::min(memoryJump, user_top - 1) & ~(row_bytes - 1);
+            memoryBase = row_address > window_bytes / 2 ? row_address - window_bytes / 2 : 0;
+            memoryBase = std::min(memoryBase, user_top - window_bytes);
+            jump_row = static_cast<int>((row_address - memoryBase) / row_bytes);
+            memoryTop = row_address;
+            memoryJumpPending = false;
+        }
+
+        int width = widths[memoryFormat];
+        int columns = static_cast<int>(row_bytes) / width;
+        static ImGuiTableFlags flags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_ScrollY;
+        if (ImGui::BeginTable("memory", 1 + columns + (memoryAscii ? 1 : 0), flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("address");
+            for (int column = 0; column < columns; ++column)
+            {
+                char name[8];
+                std::snprintf(name, sizeof(name), "+%x", column * width);
+                ImGui::TableSetupColumn(name);
+            }
+            if (memoryAscii)
+                ImGui::TableSetupColumn("ascii");
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin(window_rows);
+            if (jump_row >= 0)
+                clipper.IncludeItemByIndex(jump_row);
+            while (clipper.Step())
+            {
+                uint64_t first = memoryBase + static_cast<uint64_t>(clipper.DisplayStart) * row_bytes;
+                dbg.view_memory(first, static_cast<std::size_t>(clipper.DisplayEnd - clipper.DisplayStart) * row_bytes, memoryBytes, memoryValid);
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    std::size_t offset = static_cast<std::size_t>(row - clipper.DisplayStart) * row_bytes;
+                    const uint8_t *bytes = memoryBytes.data() + offset;
+                    const uint8_t *valid = memoryValid.data() + offset;
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("%016lx", first + offset);
+                    if (row == jump_row)
+                        ImGui::SetScrollHereY(0.0f);
+                    for (int column = 0; column < columns; ++column)
+                    {
+                        ImGui::TableSetColumnIndex(column + 1);
+                        const uint8_t *p = bytes + column * width;
+                        // 值的字节有任何一个不可读就整体显示为 ??
+                        if (std::find(valid + column * width, valid + (column + 1) * width, 0) != valid + (column + 1) * width)
+                        {
+                            ImGui::TextUnformatted("??");
+                            continue;
+                        }
+                        uint64_t word = 0;
+                        std::memcpy(&word, p, width);
+                        if (memoryFormat == 4)
+                        {
+                            float f;
+                            std::memcpy(&f, p, sizeof(f));
+                            ImGui::Text("%g", f);
+                        }
+                        else if (memoryFormat == 5)
+                        {
+                            double d;
+                            std::memcpy(&d, p, sizeof(d));
+                            ImGui::Text("%g", d);
+                        }
+                        else
+                        {
+                            ImGui::Text("%0*lx", width * 2, word);
+                        }
+                    }
+                    if (memoryAscii)
+                    {
+                        char text[row_bytes + 1];
+                        for (std::size_t i = 0; i < row_bytes; ++i)
+                            text[i] = !valid[i] ? ' ' : std::isprint(bytes[i]) ? static_cast<char>(bytes[i]) : '.';
+                        text[row_bytes] = '\0';
+                        ImGui::TableSetColumnIndex(columns + 1);
+                        ImGui::TextUnformatted(text);
+                    }
+                }
+            }
+
+            // 滚到铺开的一段的前后四分之一时平移半段，下一帧起生效，显示的地址不变
+            float row_height = clipper.ItemsHeight;
+            if (row_height > 0 && jump_row < 0)
+            {
+                float scroll = ImGui::GetScrollY();
+                uint64_t top_row = static_cast<uint64_t>(scroll / row_height);
+                memoryTop = memoryBase + top_row * row_bytes;
+                if (top_row < window_rows / 4 && memoryBase > 0)
+                {
+                    uint64_t shift = std::min<uint64_t>(memoryBase, window_bytes / 2);
+                    memoryBase -= shift;
+                    ImGui::SetScrollY(scroll + shift / row_bytes * row_height);
+                }
+                else if (top_row > window_rows * 3 / 4 && memoryBase + window_bytes < user_top)
+                {
+                    uint64_t shift = std::min<uint64_t>(user_top - window_bytes - memoryBase, window_bytes / 2);
+                    memoryBase += shift;
+                    ImGui::SetScrollY(scroll - shift / row_bytes * row_height);
+                }
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief 追踪点窗口：上方为追踪点及命中次数，下方为后台线程读取到的最近记录（pc、常用寄存器和采集的内存）。
+ * 
+ * @param p_open 
+ */
+void UI::showTracepoints(bool *p_open)
+{
+    ImGui::Begin("Tracepoints", p_open, windows_status);
+    ImGui::SetWindowFontScale(1.5f);
+    {
+        auto tracepoints = dbg.get_tracepoints();
+        for (auto &tp : tracepoints)
+        {
+            ImGui::Text("#%d  0x%lx  %s  hits: %lu", tp.id, tp.addr, tp.spec.c_str(), tp.hits);
+        }
+        ImGui::Text("lost: %lu", dbg.get_trace_lost());
+        ImGui::Separator();
+
+        static ImGuiTableFlags flags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY;
+        if (ImGui::BeginTable("trace records", 7, flags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("seq");
+            ImGui::TableSetupColumn("tp");
+            ImGui::TableSetupColumn("rip");
+            ImGui::TableSetupColumn("rsp");
+            ImGui::TableSetupColumn("rdi");
+            ImGui::TableSetupColumn("rax");
+            ImGui::TableSetupColumn("memory", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            // 记录的寄存器顺序见 g_trace_reg_names
+            auto records = dbg.get_trace_records(1000);
+            ImGuiListClipper clipper;
+            clipper.Begin(records.size());
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    // 最新的记录显示在最上面
+                    auto &rec = records[records.size() - 1 - row];
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("%lu", rec.seq);
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%d", rec.id);
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("%lx", rec.regs[17]);
+                    ImGui::TableSetColumnIndex(3);
+                    ImGui::Text("%lx", rec.regs[16]);
+                    ImGui::TableSetColumnIndex(4);
+                    ImGui::Text("%lx", rec.regs[8]);
+                    ImGui::TableSetColumnIndex(5);
+                    ImGui::Text("%lx", rec.regs[14]);
+                    ImGui::TableSetColumnIndex(6);
+                    std::string hex;
+                    char buf[4];
+                    for (auto b : rec.memory)
+                    {
+                        sprintf(buf, "%02x", b);
+                        hex += buf;
+                    }
+                    ImGui::TextUnformatted(hex.c_str());
+                }
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
 /**
  * @brief 在 ImGui 窗口中显示源代码。
  * 
@@ -279,10 +1106,11 @@ void UI::showGlobalStack(bool *p_open)
         ImGuiWindowFlags window_flags = ImGuiWindowFlags_HorizontalScrollbar;       // 水平滚动条
         ImGui::BeginChild("Global Stack info", ImVec2(ImGui::GetContentRegionAvail().x, ImGui::GetContentRegionAvail().y), false, window_flags);
 
-        // 获取全局堆栈信息
+        // 获取全局堆栈信息：只读取可见的行，经调试器的页缓存读取
         auto rsp = dbg.get_rsp();
         auto rbp = dbg.get_rbp();
-        std::vector<std::pair<uint64_t, std::vector<uint8_t>>> global_stack_vct = std::move(dbg.get_global_stack_vct(rsp - 512, rbp + 512));
+        uint64_t lo = rsp - 512;
+        uint64_t hi = rbp >= rsp && rbp - rsp <= (1u << 20) ? rbp + 512 : rsp + 512;   // rbp 未用作帧指针时只显示 rsp 附近
 
         static ImGuiTableFlags flags = ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable | ImGuiTableFlags_Hideable;
         
@@ -301,33 +1129,42 @@ void UI::showGlobalStack(bool *p_open)
 
             ImGui::TableHeadersRow();
 
-            // 遍历全局堆栈信息并绘制每一行. 
-            // row.first: address,  row.second: data
-            for (auto &row : global_stack_vct)
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>((hi - lo) / 8));
+            while (clipper.Step())
             {
-                ImGui::TableNextRow();
-                ImGui::TableSetColumnIndex(0);
-                if (row.first != rsp && row.first != rbp)
-                {
-                    ImGui::Text("%lx", row.first);
-                }
-                else        // 如果是栈顶或基址指针，则以按钮的形式显示地址值
-                {
-                    char buf[128];
-                    sprintf(buf, "%lx", row.first);
-                    ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
-                    ImGui::PushStyleVar(ImGuiStyleVar_ButtonTextAlign, ImVec2(0.0f, 0.5f));
-                    ImGui::Button(buf, ImVec2(-FLT_MIN, 0.0f));
-                    ImGui::PopStyleVar();
-                    ImGui::PopStyleColor();
-                }
-
-                // 填充每行的数据
-                u_int32_t column = 0;
-                for (auto &col : row.second)
+                uint64_t first = lo + static_cast<uint64_t>(clipper.DisplayStart) * 8;
+                dbg.view_memory(first, static_cast<std::size_t>(clipper.DisplayEnd - clipper.DisplayStart) * 8, memoryBytes, memoryValid);
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
                 {
-                    ImGui::TableSetColumnIndex(++column);
-                    ImGui::Text("%02x", col);
+                    uint64_t address = lo + static_cast<uint64_t>(row) * 8;
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    if (address != rsp && address != rbp)
+                    {
+                        ImGui::Text("%lx", address);
+                    }
+                    else        // 如果是栈顶或基址指针，则以按钮的形式显示地址值
+                    {
+                        char buf[128];
+                        sprintf(buf, "%lx", address);
+                        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
+                        ImGui::PushStyleVar(ImGuiStyleVar_ButtonTextAlign, ImVec2(0.0f, 0.5f));
+                        ImGui::Button(buf, ImVec2(-FLT_MIN, 0.0f));
+                        ImGui::PopStyleVar();
+                        ImGui::PopStyleColor();
+                    }
+
+                    // 填充每行的数据，不可读的字节显示为 ??
+                    std::size_t offset = static_cast<std::size_t>(address - first);
+                    for (int column = 0; column < 8; ++column)
+                    {
+                        ImGui::TableSetColumnIndex(column + 1);
+                        if (memoryValid[offset + column])
+                            ImGui::Text("%02x", memoryBytes[offset + column]);
+                        else
+                            ImGui::TextUnformatted("??");
+                    }
                 }
             }
 
@@ -384,17 +1221,31 @@ void UI::showCallStack(bool *p_open)
 {
     ImGui::Begin("Call Stack", p_open, windows_status);
 
-    std::vector<std::pair<uint64_t, std::string>> call_stack_vct = move(dbg.get_backtrace_vct());
-
     ImGui::SetWindowFontScale(1.5f);
     {
         ImGuiWindowFlags window_flags = ImGuiWindowFlags_HorizontalScrollbar;
         ImGui::BeginChild("Src data", ImVec2(ImGui::GetContentRegionAvail().x, ImGui::GetContentRegionAvail().y), false, window_flags);
 
-        int index = 0;
-        for (auto p : call_stack_vct)
+        // 只回溯可见的帧：尚未到达最外层时多显示一行，滚动到该行时再向外回溯一批
+        const int batch = 64;
+        dbg.get_stack_frame(0);
+        int rows = static_cast<int>(dbg.get_stack_frames_known()) + (dbg.is_stack_complete() ? 0 : 1);
+        ImGuiListClipper clipper;
+        clipper.Begin(rows);
+        while (clipper.Step())
         {
-            ImGui::Text("f#%d:0x%lx\t%s", ++index, p.first, p.second.c_str());
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+            {
+                if (row >= static_cast<int>(dbg.get_stack_frames_known()))
+                {
+                    dbg.get_stack_frame(row + batch);
+                    ImGui::TextUnformatted("...");
+                    continue;
+                }
+                auto entry = dbg.get_backtrace_entry(row);
+                ImGui::Text("f#%d:0x%lx\t%s%s", row + 1, entry.first, entry.second.c_str(),
+                            dbg.is_inlined_frame(row) ? " [inlined]" : "");
+            }
         }
 
         ImGui::EndChild();
@@ -468,6 +1319,42 @@ void UI::showOptionMainMenuBar()
                 {
                     show_ram = !show_ram;
                 }
+                if (ImGui::MenuItem("Tracepoints", NULL, show_tracepoints))
+                {
+                    show_tracepoints = !show_tracepoints;
+                }
+                if (ImGui::MenuItem("Locals", NULL, show_locals))
+                {
+                    show_locals = !show_locals;
+                }
+                if (ImGui::MenuItem("Globals", NULL, show_globals))
+                {
+                    show_globals = !show_globals;
+                }
+                if (ImGui::MenuItem("Pointer Chain", NULL, show_chains))
+                {
+                    show_chains = !show_chains;
+                }
+                if (ImGui::MenuItem("Array Inspector", NULL, show_arrays))
+                {
+                    show_arrays = !show_arrays;
+                }
+                if (ImGui::MenuItem("Memory Search", NULL, show_search))
+                {
+                    show_search = !show_search;
+                }
+                if (ImGui::MenuItem("Value Scanner", NULL, show_scanner))
+                {
+                    show_scanner = !show_scanner;
+                }
+                if (ImGui::MenuItem("Changed Memory", NULL, show_changes))
+                {
+                    show_changes = !show_changes;
+                }
+                if (ImGui::MenuItem("Memory", NULL, show_memory))
+                {
+                    show_memory = !show_memory;
+                }
 
                 if (ImGui::MenuItem("Demo Table ", NULL, show_demo_window))
                 {
@@ -516,12 +1403,15 @@ void UI::showOptionMainMenuBar()
  *
  * @details 此函数创建了一个名为 "Option Bar" 的选项栏窗口，其中包含多个按钮，用于调用相应函数执行调试器操作。
  *          - "file": 用于执行文件相关操作。
- *          - "start": 用于启动调试器。
+ *          - "start": 回到main处的检查点，重新开始调试。
+ *          - "checkpoint": 在当前位置保存检查点。
  *          - "next": 用于执行下一条指令。
  *          - "si": 用于单步执行。
  *          - "step in": 用于进入函数调用。
  *          - "finish": 用于跳出当前函数调用。
  *          - "continue": 用于继续执行程序。
+ *          - "rev next": 记录模式下反向执行到上一行。
+ *          - "rev cont": 记录模式下反向执行到上一个断点或记录起点。
  * 
  * @param p_open 控制窗口是否可见的指针。
  */
@@ -560,12 +1450,22 @@ void UI::showOptionBar(bool *p_open)
                     dbg.initDbg(filePath, pid);
                     dbg.break_execution("main");
                     dbg.continue_execution();
+                    dbg.checkpoint_at_main();       // "start" 回到这里
                 }
             }
         };
         ImGui::TableNextColumn();
         if (ImGui::Button("start", ImVec2(-FLT_MIN, -FLT_MIN)))
         {
+            if (dbg.get_start_checkpoint() < 0)
+                std::cout << "no checkpoint at main, open the program again to restart" << std::endl;
+            else
+                dbg.restart_execution(dbg.get_start_checkpoint());
+        };
+        ImGui::TableNextColumn();
+        if (ImGui::Button("checkpoint", ImVec2(-FLT_MIN, -FLT_MIN)))
+        {
+            dbg.checkpoint_execution();
         };
         ImGui::TableNextColumn();
         if (ImGui::Button("next", ImVec2(-FLT_MIN, -FLT_MIN)))
@@ -592,6 +1492,16 @@ void UI::showOptionBar(bool *p_open)
         {
             dbg.continue_execution();
         };
+        ImGui::TableNextColumn();
+        if (ImGui::Button("rev next", ImVec2(-FLT_MIN, -FLT_MIN)))
+        {
+            dbg.reverse_next_execution();
+        };
+        ImGui::TableNextColumn();
+        if (ImGui::Button("rev cont", ImVec2(-FLT_MIN, -FLT_MIN)))
+        {
+            dbg.reverse_continue_execution();
+        };
 
         ImGui::EndTable();
     }
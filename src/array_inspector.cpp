@@ -0,0 +1,419 @@
+#include "array_inspector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace minidbg {
+
+constexpr std::size_t array_inspector::max_bytes;
+constexpr std::size_t array_inspector::histogram_bins;
+constexpr std::size_t array_inspector::plot_columns;
+
+namespace {
+
+/**
+ * @brief 一次扫描得到的量，NaN 不计入 min、max 和 sum。
+ *
+ */
+struct moments {
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0;
+    uint64_t nan = 0;
+    uint64_t inf = 0;
+};
+
+template <typename T>
+void scan_scalar(const T *p, std::size_t n, moments &m)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        double x = static_cast<double>(p[i]);
+        if (std::isnan(x)) {
+            ++m.nan;
+            continue;
+        }
+        if (std::isinf(x))
+            ++m.inf;
+        m.min = std::min(m.min, x);
+        m.max = std::max(m.max, x);
+        m.sum += x;
+    }
+}
+
+template <typename T>
+void scan_integers(const T *p, std::size_t n, moments &m)
+{
+    // 整数没有 NaN 和无穷，最值在原类型上比较，编译器可以向量化
+    if (n == 0)
+        return;
+    T lo = p[0], hi = p[0];
+    double sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        lo = std::min(lo, p[i]);
+        hi = std::max(hi, p[i]);
+        sum += static_cast<double>(p[i]);
+    }
+    m.min = static_cast<double>(lo);
+    m.max = static_cast<double>(hi);
+    m.sum = sum;
+}
+
+#if defined(__SSE2__)
+void scan_f32(const float *p, std::size_t n, moments &m)
+{
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 lo = inf;
+    __m128 hi = _mm_sub_ps(_mm_setzero_ps(), inf);
+    __m128d sum_lo = _mm_setzero_pd();
+    __m128d sum_hi = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(p + i);
+        __m128 is_nan = _mm_cmpunord_ps(x, x);
+        m.nan += __builtin_popcount(_mm_movemask_ps(is_nan));
+        m.inf += __builtin_popcount(_mm_movemask_ps(_mm_cmpeq_ps(_mm_and_ps(x, abs_mask), inf)));
+        // minps/maxps 在有 NaN 时返回第二个操作数，NaN 因此被跳过
+        lo = _mm_min_ps(x, lo);
+        hi = _mm_max_ps(x, hi);
+        // 单精度逐个累加会丢失精度，转为双精度再求和
+        __m128 v = _mm_andnot_ps(is_nan, x);
+        sum_lo = _mm_add_pd(sum_lo, _mm_cvtps_pd(v));
+        sum_hi = _mm_add_pd(sum_hi, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    float lanes[4], highs[4];
+    double sums[2];
+    _mm_storeu_ps(lanes, lo);
+    _mm_storeu_ps(highs, hi);
+    _mm_storeu_pd(sums, _mm_add_pd(sum_lo, sum_hi));
+    for (int k = 0; k < 4; ++k) {
+        m.min = std::min(m.min, static_cast<double>(lanes[k]));
+        m.max = std::max(m.max, static_cast<double>(highs[k]));
+    }
+    m.sum += sums[0] + sums[1];
+    scan_scalar(p + i, n - i, m);
+}
+
+void scan_f64(const double *p, std::size_t n, moments &m)
+{
+    const __m128d inf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffll));
+    __m128d lo = inf;
+    __m128d hi = _mm_sub_pd(_mm_setzero_pd(), inf);
+    __m128d sum = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(p + i);
+        __m128d is_nan = _mm_cmpunord_pd(x, x);
+        m.nan += __builtin_popcount(_mm_movemask_pd(is_nan));
+        m.inf += __builtin_popcount(_mm_movemask_pd(_mm_cmpeq_pd(_mm_and_pd(x, abs_mask), inf)));
+        lo = _mm_min_pd(x, lo);
+        hi = _mm_max_pd(x, hi);
+        sum = _mm_add_pd(sum, _mm_andnot_pd(is_nan, x));
+    }
+    double lanes[2], highs[2], sums[2];
+    _mm_storeu_pd(lanes, lo);
+    _mm_storeu_pd(highs, hi);
+    _mm_storeu_pd(sums, sum);
+    m.min = std::min({m.min, lanes[0], lanes[1]});
+    m.max = std::max({m.max, highs[0], highs[1]});
+    m.sum += sums[0] + sums[1];
+    scan_scalar(p + i, n - i, m);
+}
+
+/**
+ * @brief 第一个 NaN（或非有限值）的下标，每次比较16个单精度数。
+ *
+ */
+int64_t first_not_finite_f32(const float *p, std::size_t n, std::size_t from, bool nan_only)
+{
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    std::size_t i = from;
+    for (; i + 16 <= n; i += 16) {
+        int mask = 0;
+        for (int k = 0; k < 4; ++k) {
+            __m128 x = _mm_loadu_ps(p + i + 4 * k);
+            // |x| 不小于无穷即为无穷或 NaN
+            __m128 hit = nan_only ? _mm_cmpunord_ps(x, x) : _mm_cmpnlt_ps(_mm_and_ps(x, abs_mask), inf);
+            mask |= _mm_movemask_ps(hit) << (4 * k);
+        }
+        if (mask)
+            return static_cast<int64_t>(i + __builtin_ctz(mask));
+    }
+    for (; i < n; ++i) {
+        if (nan_only ? std::isnan(p[i]) : !std::isfinite(p[i]))
+            return static_cast<int64_t>(i);
+    }
+    return -1;
+}
+
+int64_t first_not_finite_f64(const double *p, std::size_t n, std::size_t from, bool nan_only)
+{
+    const __m128d inf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffll));
+    std::size_t i = from;
+    for (; i + 8 <= n; i += 8) {
+        int mask = 0;
+        for (int k = 0; k < 4; ++k) {
+            __m128d x = _mm_loadu_pd(p + i + 2 * k);
+            __m128d hit = nan_only ? _mm_cmpunord_pd(x, x) : _mm_cmpnlt_pd(_mm_and_pd(x, abs_mask), inf);
+            mask |= _mm_movemask_pd(hit) << (2 * k);
+        }
+        if (mask)
+            return static_cast<int64_t>(i + __builtin_ctz(mask));
+    }
+    for (; i < n; ++i) {
+        if (nan_only ? std::isnan(p[i]) : !std::isfinite(p[i]))
+            return static_cast<int64_t>(i);
+    }
+    return -1;
+}
+#endif
+
+template <typename T, typename F>
+int64_t first_of(const T *p, std::size_t n, std::size_t from, F match)
+{
+    for (std::size_t i = from; i < n; ++i) {
+        if (match(static_cast<double>(p[i])))
+            return static_cast<int64_t>(i);
+    }
+    return -1;
+}
+
+template <typename T>
+int64_t find_in(const T *p, std::size_t n, std::size_t from, array_predicate predicate, double operand)
+{
+    switch (predicate) {
+    case array_predicate::eq: return first_of(p, n, from, [operand](double x) { return x == operand; });
+    case array_predicate::ne: return first_of(p, n, from, [operand](double x) { return x != operand; });
+    case array_predicate::lt: return first_of(p, n, from, [operand](double x) { return x < operand; });
+    case array_predicate::le: return first_of(p, n, from, [operand](double x) { return x <= operand; });
+    case array_predicate::gt: return first_of(p, n, from, [operand](double x) { return x > operand; });
+    case array_predicate::ge: return first_of(p, n, from, [operand](double x) { return x >= operand; });
+    case array_predicate::nan: return first_of(p, n, from, [](double x) { return std::isnan(x); });
+    case array_predicate::inf: return first_of(p, n, from, [](double x) { return std::isinf(x); });
+    case array_predicate::not_finite: return first_of(p, n, from, [](double x) { return !std::isfinite(x); });
+    }
+    return -1;
+}
+
+number_kind kind_of(const type_record &rec)
+{
+    bool is_signed = rec.kind == type_kind::signed_int || rec.kind == type_kind::signed_char || rec.kind == type_kind::enumeration;
+    switch (rec.kind) {
+    case type_kind::signed_int:
+    case type_kind::unsigned_int:
+    case type_kind::signed_char:
+    case type_kind::unsigned_char:
+    case type_kind::boolean:
+    case type_kind::enumeration:
+        switch (rec.size) {
+        case 1: return is_signed ? number_kind::i8 : number_kind::u8;
+        case 2: return is_signed ? number_kind::i16 : number_kind::u16;
+        case 4: return is_signed ? number_kind::i32 : number_kind::u32;
+        case 8: return is_signed ? number_kind::i64 : number_kind::u64;
+        default: return number_kind::none;
+        }
+    case type_kind::floating:
+        return rec.size == 4 ? number_kind::f32 : rec.size == 8 ? number_kind::f64 : number_kind::none;
+    default:
+        return number_kind::none;
+    }
+}
+
+}   // namespace
+
+array_inspector::array_inspector(inferior_memory &memory, type_db &types)
+    : m_memory(memory), m_types(types), m_kind{number_kind::none}, m_element_size{0}, m_address{0}, m_requested{0}
+{
+}
+
+void array_inspector::clear(const std::string &error)
+{
+    m_kind = number_kind::none;
+    m_element_size = 0;
+    m_address = 0;
+    m_requested = 0;
+    m_bytes.clear();
+    m_stats = array_stats{};
+    m_plot.clear();
+    m_error = error;
+}
+
+bool array_inspector::load(uint64_t address, type_id element, uint64_t count)
+{
+    clear();
+    m_address = address;
+    m_requested = count;
+    auto kind = element == no_type ? number_kind::none : kind_of(m_types.record(element));
+    if (kind == number_kind::none) {
+        m_error = "'" + m_types.type_name(element) + "' is not a numeric type";
+        return false;
+    }
+    std::size_t size = m_types.record(element).size;
+    uint64_t n = std::min<uint64_t>(count, max_bytes / size);
+
+    // 整个缓冲区一次读取，不经页缓存
+    m_bytes.resize(n * size);
+    mem_request req{address, m_bytes.data(), m_bytes.size(), 0};
+    if (n > 0)
+        m_memory.read_batch(&req, 1);
+    n = req.done / size;
+    m_bytes.resize(n * size);
+    if (n == 0 && count > 0) {
+        std::ostringstream oss;
+        oss << "Cannot access memory at address 0x" << std::hex << address;
+        m_error = oss.str();
+        return false;
+    }
+    m_kind = kind;
+    m_element_size = size;
+    compute();
+    return true;
+}
+
+void array_inspector::compute()
+{
+    uint64_t n = m_bytes.size() / m_element_size;
+    m_stats.count = n;
+    moments m;
+    const uint8_t *data = m_bytes.data();
+#if defined(__SSE2__)
+    if (m_kind == number_kind::f32)
+        scan_f32(reinterpret_cast<const float *>(data), n, m);
+    else if (m_kind == number_kind::f64)
+        scan_f64(reinterpret_cast<const double *>(data), n, m);
+    else
+#endif
+    if (m_kind == number_kind::f32)
+        scan_scalar(reinterpret_cast<const float *>(data), n, m);
+    else if (m_kind == number_kind::f64)
+        scan_scalar(reinterpret_cast<const double *>(data), n, m);
+    else {
+        auto scan = [&](auto p) { scan_integers(p, n, m); };
+        DISPATCH_NUMBERS(m_kind, data, scan)
+    }
+
+    m_stats.nan_count = m.nan;
+    m_stats.inf_count = m.inf;
+    uint64_t counted = n - m.nan;
+    if (counted == 0) {
+        m_stats.min = m_stats.max = m_stats.mean = std::numeric_limits<double>::quiet_NaN();
+        m_plot.assign(std::min<uint64_t>(n, plot_columns), 0.0f);
+        return;
+    }
+    m_stats.min = m.min;
+    m_stats.max = m.max;
+    m_stats.mean = m.sum / static_cast<double>(counted);
+    m_stats.min_index = static_cast<uint64_t>(std::max<int64_t>(find(array_predicate::eq, m.min), 0));
+    m_stats.max_index = static_cast<uint64_t>(std::max<int64_t>(find(array_predicate::eq, m.max), 0));
+
+    // 直方图只统计有限值；有无穷时另求有限值的范围
+    double lo = m.min, hi = m.max;
+    if (m.inf > 0) {
+        lo = std::numeric_limits<double>::infinity();
+        hi = -lo;
+        for (uint64_t i = 0; i < n; ++i) {
+            double x = value(i);
+            if (std::isfinite(x)) {
+                lo = std::min(lo, x);
+                hi = std::max(hi, x);
+            }
+        }
+    }
+    m_stats.histogram.assign(histogram_bins, 0);
+    if (lo <= hi) {
+        double scale = hi > lo ? histogram_bins / (hi - lo) : 0;
+        auto fill = [&](auto p) {
+            for (uint64_t i = 0; i < n; ++i) {
+                double x = static_cast<double>(p[i]);
+                if (!std::isfinite(x))
+                    continue;
+                auto bin = static_cast<std::size_t>((x - lo) * scale);
+                ++m_stats.histogram[std::min(bin, histogram_bins - 1)];
+            }
+        };
+        DISPATCH_NUMBERS(m_kind, data, fill)
+    }
+
+    // 降采样：每列保留最小值和最大值，尖峰不会被平均掉；NaN 画为0
+    m_plot.clear();
+    auto sample = [&](auto p) {
+        if (n <= plot_columns) {
+            for (uint64_t i = 0; i < n; ++i) {
+                double x = static_cast<double>(p[i]);
+                m_plot.push_back(std::isnan(x) ? 0.0f : static_cast<float>(x));
+            }
+            return;
+        }
+        m_plot.reserve(2 * plot_columns);
+        for (std::size_t c = 0; c < plot_columns; ++c) {
+            uint64_t begin = n * c / plot_columns, end = n * (c + 1) / plot_columns;
+            double column_lo = std::numeric_limits<double>::infinity(), column_hi = -column_lo;
+            for (uint64_t i = begin; i < end; ++i) {
+                double x = static_cast<double>(p[i]);
+                column_lo = std::min(column_lo, x);     // std::min 遇到 NaN 保留原值
+                column_hi = std::max(column_hi, x);
+            }
+            if (column_lo > column_hi)
+                column_lo = column_hi = 0;
+            m_plot.push_back(static_cast<float>(column_lo));
+            m_plot.push_back(static_cast<float>(column_hi));
+        }
+    };
+    DISPATCH_NUMBERS(m_kind, data, sample)
+}
+
+double array_inspector::value(uint64_t i) const
+{
+    double result = 0;
+    auto get = [&](auto p) { result = static_cast<double>(p[i]); };
+    if (i < m_stats.count)
+        DISPATCH_NUMBERS(m_kind, m_bytes.data(), get)
+    return result;
+}
+
+std::string array_inspector::format(uint64_t i) const
+{
+    if (i >= m_stats.count)
+        return "<out of range>";
+    if (m_kind == number_kind::f32 || m_kind == number_kind::f64) {
+        std::ostringstream oss;
+        oss << value(i);
+        return oss.str();
+    }
+    std::string result;
+    auto get = [&](auto p) { result = std::to_string(+p[i]); };
+    DISPATCH_NUMBERS(m_kind, m_bytes.data(), get)
+    return result;
+}
+
+int64_t array_inspector::find(array_predicate predicate, double operand, uint64_t from) const
+{
+    uint64_t n = m_stats.count;
+    if (from >= n)
+        return -1;
+    if (m_kind != number_kind::f32 && m_kind != number_kind::f64
+        && (predicate == array_predicate::nan || predicate == array_predicate::inf || predicate == array_predicate::not_finite))
+        return -1;      // 整数都是有限值
+#if defined(__SSE2__)
+    if (predicate == array_predicate::nan || predicate == array_predicate::not_finite) {
+        bool nan_only = predicate == array_predicate::nan;
+        if (m_kind == number_kind::f32)
+            return first_not_finite_f32(reinterpret_cast<const float *>(m_bytes.data()), n, from, nan_only);
+        return first_not_finite_f64(reinterpret_cast<const double *>(m_bytes.data()), n, from, nan_only);
+    }
+#endif
+    int64_t result = -1;
+    auto search = [&](auto p) { result = find_in(p, n, from, predicate, operand); };
+    DISPATCH_NUMBERS(m_kind, m_bytes.data(), search)
+    return result;
+}
+
+}   // namespace minidbg
@@ -34,6 +34,14 @@ std::vector<asm_head> asmparaser::get_asm_data(std::string file_path)
             {
                 result.push_back(cope_asm_head(line));
             }
+            // 只有地址和机器码的行是上一条长指令的续行（objdump每行最多显示7个字节），将机器码拼接到上一条指令
+            else if (utility::split(line, '\t').size() == 2 && !result.back().asm_entris.empty())
+            {
+                std::string bytes = utility::split(line, '\t')[1];
+                trimLeft(bytes);
+                trimRight(bytes);
+                result.back().asm_entris.back().mechine_code += " " + bytes;
+            }
             // 否则，当前行是汇编指令的一部分, 加入result结尾元素的asm_entris中
             else
             {
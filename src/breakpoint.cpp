@@ -1,54 +1,262 @@
 #include "breakpoint.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <sys/ptrace.h> 
+#include <algorithm>
 
 namespace minidbg
 {
 
-breakpoint::breakpoint() = default;
-breakpoint::breakpoint(pid_t pid, std::intptr_t addr)
-    : m_pid{pid}, m_addr{addr}, m_enabled{false}, m_save_data{}
+static constexpr std::intptr_t page_size = 4096;
+static constexpr uint8_t int3 = 0xcc;   // 系统软件中断，程序运行到这个地方，就会执行主函数的wait函数
+
+breakpoint_table::breakpoint_table(inferior_memory &mem)
+    : m_memory{mem}, m_next_id{1}
+{
+}
+
+int breakpoint_table::add(const std::vector<std::intptr_t> &addrs, const std::string &spec)
+{
+    apply(plan_insert(addrs), {});
+
+    logical_breakpoint bp;
+    bp.id = m_next_id++;
+    bp.spec = spec;
+    bp.addrs = addrs;
+    m_logical.push_back(std::move(bp));
+    return m_logical.back().id;
+}
+
+bool breakpoint_table::extend(int id, const std::vector<std::intptr_t> &addrs)
+{
+    auto it = std::find_if(m_logical.begin(), m_logical.end(),
+                           [id](const logical_breakpoint &bp) { return bp.id == id; });
+    if (it == m_logical.end()) {
+        return false;
+    }
+    apply(plan_insert(addrs), {});
+    it->addrs.insert(it->addrs.end(), addrs.begin(), addrs.end());
+    return true;
+}
+
+bool breakpoint_table::remove(int id)
+{
+    auto it = std::find_if(m_logical.begin(), m_logical.end(),
+                           [id](const logical_breakpoint &bp) { return bp.id == id; });
+    if (it == m_logical.end()) {
+        return false;
+    }
+    apply({}, plan_remove(it->addrs));
+    m_logical.erase(it);
+    return true;
+}
+
+void breakpoint_table::acquire(const std::vector<std::intptr_t> &addrs)
+{
+    apply(plan_insert(addrs), {});
+}
+
+void breakpoint_table::release(const std::vector<std::intptr_t> &addrs)
+{
+    apply({}, plan_remove(addrs));
+}
+
+std::vector<breakpoint_site>::iterator breakpoint_table::lower_bound(std::intptr_t addr)
+{
+    return std::lower_bound(m_sites.begin(), m_sites.end(), addr,
+                            [](const breakpoint_site &s, std::intptr_t a) { return s.addr < a; });
+}
+
+const breakpoint_site *breakpoint_table::find(std::intptr_t addr) const
+{
+    auto it = std::lower_bound(m_sites.begin(), m_sites.end(), addr,
+                               [](const breakpoint_site &s, std::intptr_t a) { return s.addr < a; });
+    if (it == m_sites.end() || it->addr != addr) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+std::vector<std::intptr_t> breakpoint_table::plan_insert(std::vector<std::intptr_t> addrs)
+{
+    std::sort(addrs.begin(), addrs.end());
+    addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+
+    // 已存在的位置只增加引用，新位置先追加到末尾，最后一次性合并，保证整批插入是 O(n log n)
+    std::vector<std::intptr_t> fresh;
+    size_t old_size = m_sites.size();
+    for (auto addr : addrs) {
+        auto it = std::lower_bound(m_sites.begin(), m_sites.begin() + old_size, addr,
+                                   [](const breakpoint_site &s, std::intptr_t a) { return s.addr < a; });
+        if (it != m_sites.begin() + old_size && it->addr == addr) {
+            if (it->refcount++ == 0) {
+                fresh.push_back(addr);
+            }
+            continue;
+        }
+        m_sites.push_back(breakpoint_site{addr, 1, 0, false});
+        fresh.push_back(addr);
+    }
+    std::inplace_merge(m_sites.begin(), m_sites.begin() + old_size, m_sites.end(),
+                       [](const breakpoint_site &a, const breakpoint_site &b) { return a.addr < b.addr; });
+    std::sort(fresh.begin(), fresh.end());
+    return fresh;
+}
+
+std::vector<std::intptr_t> breakpoint_table::plan_remove(const std::vector<std::intptr_t> &addrs)
+{
+    std::vector<std::intptr_t> dead;
+    for (auto addr : addrs) {
+        auto it = lower_bound(addr);
+        if (it == m_sites.end() || it->addr != addr || it->refcount == 0) {
+            continue;
+        }
+        if (--it->refcount == 0) {
+            dead.push_back(addr);
+        }
+    }
+    std::sort(dead.begin(), dead.end());
+    dead.erase(std::unique(dead.begin(), dead.end()), dead.end());
+    return dead;
+}
+
+void breakpoint_table::apply(const std::vector<std::intptr_t> &to_insert, const std::vector<std::intptr_t> &to_remove)
+{
+    // 合并两个有序列表，按页切分为若干段：每段覆盖同一页内的 [首地址, 末地址]
+    std::vector<std::pair<std::intptr_t, bool>> ops;     // (地址, 是否插入)
+    ops.reserve(to_insert.size() + to_remove.size());
+    for (auto a : to_insert) ops.emplace_back(a, true);
+    for (auto a : to_remove) ops.emplace_back(a, false);
+    std::sort(ops.begin(), ops.end());
+
+    std::vector<uint8_t> buf;
+    size_t i = 0;
+    while (i < ops.size()) {
+        size_t j = i;
+        std::intptr_t page = ops[i].first / page_size;
+        while (j < ops.size() && ops[j].first / page_size == page) {
+            ++j;
+        }
+        std::intptr_t first = ops[i].first;
+        std::intptr_t last = ops[j - 1].first;
+        buf.resize(last - first + 1);
+
+        if (m_memory.read(first, buf.data(), buf.size()) != buf.size()) {
+            std::cerr << "breakpoint_table: failed to read memory at 0x" << std::hex << first << std::dec << std::endl;
+            i = j;
+            continue;
+        }
+        for (size_t k = i; k < j; ++k) {
+            auto site = lower_bound(ops[k].first);
+            uint8_t &byte = buf[ops[k].first - first];
+            if (ops[k].second) {
+                if (!site->inserted) {
+                    site->saved_data = byte;
+                    byte = int3;
+                    site->inserted = true;
+                }
+            } else if (site->inserted) {
+                byte = site->saved_data;
+                site->inserted = false;
+            }
+        }
+        if (!m_memory.write(first, buf.data(), buf.size())) {
+            std::cerr << "breakpoint_table: failed to write memory at 0x" << std::hex << first << std::dec << std::endl;
+        }
+        i = j;
+    }
+
+    // 移除引用计数归零的位置
+    m_sites.erase(std::remove_if(m_sites.begin(), m_sites.end(),
+                                 [](const breakpoint_site &s) { return s.refcount == 0; }),
+                  m_sites.end());
+}
+
+void breakpoint_table::lift(std::intptr_t addr)
+{
+    auto it = lower_bound(addr);
+    if (it == m_sites.end() || it->addr != addr || !it->inserted) {
+        return;
+    }
+    m_memory.write(addr, &it->saved_data, 1);
+    it->inserted = false;
+}
+
+void breakpoint_table::restore(std::intptr_t addr)
 {
+    auto it = lower_bound(addr);
+    if (it == m_sites.end() || it->addr != addr || it->inserted) {
+        return;
+    }
+    m_memory.write(addr, &int3, 1);
+    it->inserted = true;
 }
 
-/**
- * @brief 启用断点
- * 通过ptrace系统调用读取原始数据，将其最低有效字节（LSB）
- * 替换为软件中断0xcc（用于暂停程序执行），
- * 然后使用PTRACE_POKEDATA将修改后的数据写入目标地址
- */
-void breakpoint::enable()
+void breakpoint_table::suspend()
 {
-    auto data = ptrace(PTRACE_PEEKDATA, m_pid, m_addr, nullptr);
-    m_save_data = static_cast<uint8_t>(data & 0xff);
-    uint64_t int3 = 0xcc; // 系统软件中断，程序运行到这个地方，就会执行主函数的wait函数
-    uint64_t data_with_int3 = ((data & ~0xff) | int3);
-    ptrace(PTRACE_POKEDATA, m_pid, m_addr, data_with_int3);
+    std::vector<std::intptr_t> addrs;
+    for (const auto &site : m_sites) {
+        if (site.inserted) addrs.push_back(site.addr);
+    }
+    apply({}, addrs);
+}
 
-    m_enabled = true;
-};
+void breakpoint_table::resume()
+{
+    std::vector<std::intptr_t> addrs;
+    for (const auto &site : m_sites) {
+        if (!site.inserted) addrs.push_back(site.addr);
+    }
+    apply(addrs, {});
+}
 
-/**
- * @brief 将软件中断0xcc替换成原来的数据. 删除debugger类的向量m_breakpoints的元素前，要先禁用，才是真正删除。
- * 
- */
-void breakpoint::disable()
+void breakpoint_table::invalidate()
 {
-    auto data = ptrace(PTRACE_PEEKDATA, m_pid, m_addr, nullptr);
-    auto restore_data = ((data & ~0xff) | m_save_data);
-    ptrace(PTRACE_POKEDATA, m_pid, m_addr, restore_data);
+    for (auto &site : m_sites) {
+        site.inserted = false;
+    }
+}
+
+std::vector<int> breakpoint_table::forget(std::intptr_t lo, std::intptr_t hi)
+{
+    auto in_range = [lo, hi](std::intptr_t a) { return a >= lo && a < hi; };
+    m_sites.erase(std::remove_if(m_sites.begin(), m_sites.end(),
+                                 [&](const breakpoint_site &s) { return in_range(s.addr); }),
+                  m_sites.end());
+
+    std::vector<int> orphans;
+    for (auto &bp : m_logical) {
+        if (bp.addrs.empty()) {
+            continue;
+        }
+        bp.addrs.erase(std::remove_if(bp.addrs.begin(), bp.addrs.end(), in_range), bp.addrs.end());
+        if (bp.addrs.empty()) {
+            orphans.push_back(bp.id);
+        }
+    }
+    return orphans;
+}
 
-    m_enabled = false;
-};
+const logical_breakpoint *breakpoint_table::get(int id) const
+{
+    auto it = std::find_if(m_logical.begin(), m_logical.end(),
+                           [id](const logical_breakpoint &bp) { return bp.id == id; });
+    return it == m_logical.end() ? nullptr : &*it;
+}
 
-auto breakpoint::is_enabled() const -> bool { return m_enabled; }
+void breakpoint_table::unpatch(std::intptr_t addr, uint8_t *buf, std::size_t len) const
+{
+    auto it = std::lower_bound(m_sites.begin(), m_sites.end(), addr,
+                               [](const breakpoint_site &s, std::intptr_t a) { return s.addr < a; });
+    for (; it != m_sites.end() && it->addr < addr + static_cast<std::intptr_t>(len); ++it) {
+        if (it->inserted) {
+            buf[it->addr - addr] = it->saved_data;
+        }
+    }
+}
 
-/**
- * @brief Get the breakpoint address object
- * @return intptr_t 
- */
-auto breakpoint::get_address() const -> intptr_t { return m_addr; }
+void breakpoint_table::clear()
+{
+    m_sites.clear();
+    m_logical.clear();
+}
 
-};  // minidbg
\ No newline at end of file
+};  // minidbg
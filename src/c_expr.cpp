@@ -0,0 +1,1128 @@
+#include "c_expr.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace minidbg {
+
+namespace {
+
+struct token {
+    enum class kind { end, ident, integer, floating, punct };
+    kind type;
+    std::string text;
+    uint64_t value;
+    double fvalue;
+    bool is_unsigned;
+    bool is_long;
+    bool is_char;
+};
+
+class syntax_error : public std::runtime_error {
+public:
+    explicit syntax_error(const std::string &what) : std::runtime_error(what) {}
+};
+
+char escape_char(const std::string &s, std::size_t &i)
+{
+    char c = s[i++];
+    if (c != '\\' || i >= s.size())
+        return c;
+    c = s[i++];
+    switch (c) {
+    case 'n': return '\n';
+    case 't': return '\t';
+    case 'r': return '\r';
+    case '0': return '\0';
+    case 'a': return '\a';
+    case 'b': return '\b';
+    case 'f': return '\f';
+    case 'v': return '\v';
+    case 'x': {
+        std::size_t start = i;
+        while (i < s.size() && std::isxdigit(static_cast<unsigned char>(s[i])))
+            ++i;
+        return static_cast<char>(std::strtoul(s.substr(start, i - start).c_str(), nullptr, 16));
+    }
+    default:
+        return c;   // \\ \' \" \?
+    }
+}
+
+std::vector<token> tokenize(const std::string &s)
+{
+    static const char *const two_char[] = {"->", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||"};
+    std::vector<token> tokens;
+    std::size_t i = 0;
+    while (i < s.size()) {
+        char c = s[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+            continue;
+        }
+        token t{token::kind::punct, std::string{}, 0, 0, false, false, false};
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            std::size_t start = i;
+            while (i < s.size() && (std::isalnum(static_cast<unsigned char>(s[i])) || s[i] == '_'))
+                ++i;
+            t.type = token::kind::ident;
+            t.text = s.substr(start, i - start);
+        } else if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && i + 1 < s.size() && std::isdigit(static_cast<unsigned char>(s[i + 1])))) {
+            const char *begin = s.c_str() + i;
+            char *end = nullptr;
+            bool hex = c == '0' && i + 1 < s.size() && (s[i + 1] == 'x' || s[i + 1] == 'X');
+            std::size_t j = i;
+            while (j < s.size() && (std::isalnum(static_cast<unsigned char>(s[j])) || s[j] == '.'))
+                ++j;
+            auto literal = s.substr(i, j - i);
+            if (!hex && literal.find_first_of(".eE") != std::string::npos) {
+                t.type = token::kind::floating;
+                t.fvalue = std::strtod(begin, &end);
+            } else {
+                t.type = token::kind::integer;
+                errno = 0;
+                t.value = std::strtoull(begin, &end, 0);
+                if (errno == ERANGE)
+                    throw syntax_error("integer constant is too large: " + literal);
+            }
+            i += end - begin;
+            // 后缀：u、l、ll 的任意组合，浮点数的 f
+            while (i < j) {
+                char suffix = static_cast<char>(std::tolower(static_cast<unsigned char>(s[i])));
+                if (suffix == 'u' && t.type == token::kind::integer)
+                    t.is_unsigned = true;
+                else if (suffix == 'l')
+                    t.is_long = true;
+                else if (suffix != 'f' || t.type != token::kind::floating)
+                    throw syntax_error("invalid number: " + literal);
+                ++i;
+            }
+            t.text = literal;
+        } else if (c == '\'') {
+            ++i;
+            if (i >= s.size())
+                throw syntax_error("unterminated character constant");
+            t.type = token::kind::integer;
+            t.is_char = true;
+            t.value = static_cast<unsigned char>(escape_char(s, i));
+            if (i >= s.size() || s[i] != '\'')
+                throw syntax_error("unterminated character constant");
+            ++i;
+            t.text = "'";
+        } else {
+            for (auto op : two_char) {
+                if (s.compare(i, 2, op) == 0)
+                    t.text = op;
+            }
+            if (t.text.empty()) {
+                if (!std::strchr("+-*/%&|^!~<>()[].", c))
+                    throw syntax_error(std::string("invalid character '") + c + "' in expression");
+                t.text = std::string(1, c);
+            }
+            i += t.text.size();
+        }
+        tokens.push_back(std::move(t));
+    }
+    tokens.push_back(token{token::kind::end, std::string{}, 0, 0, false, false, false});
+    return tokens;
+}
+
+bool is_integer(const type_record &rec)
+{
+    switch (rec.kind) {
+    case type_kind::signed_int:
+    case type_kind::unsigned_int:
+    case type_kind::signed_char:
+    case type_kind::unsigned_char:
+    case type_kind::boolean:
+    case type_kind::enumeration:
+    case type_kind::unknown:
+        return true;
+    default:
+        return false;
+    }
+}
+
+}   // namespace
+
+/**
+ * @brief 递归下降解析器，边解析边推出类型，节点追加到 c_expr 的平坦数组中。
+ *
+ */
+class expr_parser {
+public:
+    expr_parser(c_expr &expr, type_db &types, const expr_scope &scope, std::vector<token> tokens)
+        : m_expr(expr), m_types(types), m_scope(scope), m_tokens(std::move(tokens)), m_pos(0)
+    {
+        t_int = types.scalar(type_kind::signed_int, 4, "int");
+        t_uint = types.scalar(type_kind::unsigned_int, 4, "unsigned int");
+        t_long = types.scalar(type_kind::signed_int, 8, "long");
+        t_ulong = types.scalar(type_kind::unsigned_int, 8, "unsigned long");
+        t_double = types.scalar(type_kind::floating, 8, "double");
+        t_char = types.scalar(type_kind::signed_char, 1, "char");
+        t_bool = types.scalar(type_kind::boolean, 1, "bool");
+    }
+
+    int parse()
+    {
+        int n = binary(1);
+        if (peek().type != token::kind::end)
+            throw syntax_error("unexpected '" + peek().text + "'");
+        return n;
+    }
+
+private:
+    using op = c_expr::op;
+
+    c_expr &m_expr;
+    type_db &m_types;
+    const expr_scope &m_scope;
+    std::vector<token> m_tokens;
+    std::size_t m_pos;
+    type_id t_int, t_uint, t_long, t_ulong, t_double, t_char, t_bool;
+
+    const token &peek(std::size_t ahead = 0) const { return m_tokens[std::min(m_pos + ahead, m_tokens.size() - 1)]; }
+    bool is_punct(const char *text, std::size_t ahead = 0) const
+    {
+        const auto &t = peek(ahead);
+        return t.type == token::kind::punct && t.text == text;
+    }
+    bool accept(const char *text)
+    {
+        if (!is_punct(text))
+            return false;
+        ++m_pos;
+        return true;
+    }
+    void expect(const char *text)
+    {
+        if (!accept(text))
+            throw syntax_error(std::string("expected '") + text + "'");
+    }
+
+    const type_record &rec(int n) const { return m_types.record(m_expr.m_nodes[n].type); }
+
+    int add(op code, type_id type, int lhs = -1, int rhs = -1, uint64_t imm = 0, uint16_t bit_size = 0, uint32_t dim = 0)
+    {
+        m_expr.m_nodes.push_back(c_expr::node{code, type, dim, lhs, rhs, imm, bit_size, dwarf::die()});
+        return static_cast<int>(m_expr.m_nodes.size() - 1);
+    }
+
+    bool is_signed(type_id t) const
+    {
+        const auto &r = m_types.record(t);
+        if (r.kind == type_kind::enumeration)
+            return r.target == no_type || m_types.record(r.target).kind == type_kind::signed_int;
+        return r.kind == type_kind::signed_int || r.kind == type_kind::signed_char || r.kind == type_kind::unknown;
+    }
+
+    /**
+     * @brief 引用类型的值按其引用的对象使用。
+     *
+     */
+    int through_reference(int n)
+    {
+        if (rec(n).kind == type_kind::reference)
+            return add(op::deref, rec(n).target, n);
+        return n;
+    }
+
+    /**
+     * @brief 在运算中使用的值：数组退化为指针，结构体等不能参与运算。
+     *
+     */
+    int rvalue(int n)
+    {
+        const auto &r = rec(n);
+        if (r.kind == type_kind::array) {
+            if (m_expr.m_nodes[n].dim + 1 < r.count)
+                throw syntax_error("cannot use a sub-array of a multi-dimensional array as a value");
+            return add(op::decay, m_types.pointer_to(r.target), n);
+        }
+        if (!is_integer(r) && r.kind != type_kind::floating && r.kind != type_kind::pointer)
+            throw syntax_error("'" + m_types.type_name(m_expr.m_nodes[n].type) + "' is not a scalar value");
+        return n;
+    }
+
+    int cast(int n, type_id to)
+    {
+        if (m_expr.m_nodes[n].type == to)
+            return n;
+        const auto &r = m_types.record(to);
+        if (!is_integer(r) && r.kind != type_kind::floating && r.kind != type_kind::pointer)
+            throw syntax_error("cannot cast to '" + m_types.type_name(to) + "'");
+        n = rvalue(n);
+        if (rec(n).kind == type_kind::floating && r.kind == type_kind::pointer)
+            throw syntax_error("cannot cast a floating-point value to a pointer");
+        return add(op::cast, to, n);
+    }
+
+    type_id promote(type_id t) const
+    {
+        const auto &r = m_types.record(t);
+        if (is_integer(r) && r.size < 4)
+            return t_int;
+        return t;
+    }
+
+    /**
+     * @brief 算术运算的公共类型（简化的 usual arithmetic conversions）。
+     *
+     */
+    type_id common(type_id a, type_id b) const
+    {
+        const auto &ra = m_types.record(a);
+        const auto &rb = m_types.record(b);
+        if (ra.kind == type_kind::floating || rb.kind == type_kind::floating)
+            return t_double;
+        uint32_t size = std::max<uint32_t>(4, std::max(ra.size, rb.size)) > 4 ? 8 : 4;
+        bool is_unsigned = (!is_signed(a) && ra.size >= size) || (!is_signed(b) && rb.size >= size);
+        if (size == 8)
+            return is_unsigned ? t_ulong : t_long;
+        return is_unsigned ? t_uint : t_int;
+    }
+
+    uint64_t stride_of_pointer(int n) const
+    {
+        auto target = rec(n).target;
+        if (target == no_type)
+            return 1;       // void * 按字节计算
+        const auto &t = m_types.record(target);
+        if (t.kind == type_kind::void_ || t.kind == type_kind::function || t.size == 0)
+            return 1;
+        return t.size;
+    }
+
+    int binary_op(const std::string &text, int lhs, int rhs)
+    {
+        if (text == "&&" || text == "||") {
+            lhs = rvalue(lhs);
+            rhs = rvalue(rhs);
+            return add(text == "&&" ? op::logical_and : op::logical_or, t_int, lhs, rhs);
+        }
+        lhs = rvalue(lhs);
+        rhs = rvalue(rhs);
+        bool lp = rec(lhs).kind == type_kind::pointer;
+        bool rp = rec(rhs).kind == type_kind::pointer;
+        bool lf = rec(lhs).kind == type_kind::floating;
+        bool rf = rec(rhs).kind == type_kind::floating;
+
+        static const struct { const char *text; op code; } compares[] = {
+            {"<", op::lt}, {">", op::gt}, {"<=", op::le}, {">=", op::ge}, {"==", op::eq}, {"!=", op::ne}};
+        for (const auto &c : compares) {
+            if (text != c.text)
+                continue;
+            // 指针之间、指针与整数按无符号地址比较
+            auto type = lp || rp ? t_ulong : common(m_expr.m_nodes[lhs].type, m_expr.m_nodes[rhs].type);
+            if ((lp && rf) || (rp && lf))
+                throw syntax_error("cannot compare a pointer with a floating-point value");
+            return add(c.code, t_int, cast(lhs, type), cast(rhs, type));
+        }
+
+        if (text == "+" || text == "-") {
+            if (lp && rp) {
+                if (text == "+")
+                    throw syntax_error("cannot add two pointers");
+                return add(op::sub, t_long, lhs, rhs, stride_of_pointer(lhs));
+            }
+            if (rp && text == "+")
+                std::swap(lhs, rhs), std::swap(lp, rp), std::swap(lf, rf);
+            if (lp) {
+                if (rf || rp)
+                    throw syntax_error("invalid operand to pointer arithmetic");
+                return add(text == "+" ? op::add : op::sub, m_expr.m_nodes[lhs].type, lhs, cast(rhs, t_long), stride_of_pointer(lhs));
+            }
+            if (rp)
+                throw syntax_error("cannot subtract a pointer from an integer");
+        }
+        if (lp || rp)
+            throw syntax_error("invalid operands to binary " + text);
+
+        static const struct { const char *text; op code; bool integer_only; } arith[] = {
+            {"+", op::add, false}, {"-", op::sub, false}, {"*", op::mul, false}, {"/", op::div, false},
+            {"%", op::mod, true}, {"&", op::bit_and, true}, {"|", op::bit_or, true}, {"^", op::bit_xor, true},
+            {"<<", op::shl, true}, {">>", op::shr, true}};
+        for (const auto &a : arith) {
+            if (text != a.text)
+                continue;
+            if (a.integer_only && (lf || rf))
+                throw syntax_error("invalid operands to binary " + text + " (floating-point)");
+            if (a.code == op::shl || a.code == op::shr) {
+                auto type = promote(m_expr.m_nodes[lhs].type);
+                return add(a.code, type, cast(lhs, type), cast(rhs, promote(m_expr.m_nodes[rhs].type)));
+            }
+            auto type = common(m_expr.m_nodes[lhs].type, m_expr.m_nodes[rhs].type);
+            return add(a.code, type, cast(lhs, type), cast(rhs, type));
+        }
+        throw syntax_error("unknown operator " + text);
+    }
+
+    static int precedence(const token &t)
+    {
+        if (t.type != token::kind::punct)
+            return 0;
+        static const struct { const char *text; int prec; } table[] = {
+            {"||", 1}, {"&&", 2}, {"|", 3}, {"^", 4}, {"&", 5}, {"==", 6}, {"!=", 6},
+            {"<", 7}, {">", 7}, {"<=", 7}, {">=", 7}, {"<<", 8}, {">>", 8},
+            {"+", 9}, {"-", 9}, {"*", 10}, {"/", 10}, {"%", 10}};
+        for (const auto &entry : table) {
+            if (t.text == entry.text)
+                return entry.prec;
+        }
+        return 0;
+    }
+
+    int binary(int min_prec)
+    {
+        int lhs = unary();
+        while (true) {
+            int prec = precedence(peek());
+            if (prec < min_prec || prec == 0)
+                return lhs;
+            auto text = peek().text;
+            ++m_pos;
+            int rhs = binary(prec + 1);
+            lhs = binary_op(text, lhs, rhs);
+        }
+    }
+
+    bool is_type_keyword(const std::string &word) const
+    {
+        static const char *const keywords[] = {"const", "volatile", "signed", "unsigned", "short", "long", "int", "char",
+                                               "float", "double", "void", "bool", "_Bool", "struct", "union", "enum", "class"};
+        for (auto k : keywords) {
+            if (word == k)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 括号后是否为类型名（强制类型转换或 sizeof(type)）：关键字，或不是可见变量的已知类型名。
+     *
+     */
+    bool type_follows() const
+    {
+        const auto &t = peek();
+        if (t.type != token::kind::ident)
+            return false;
+        if (is_type_keyword(t.text))
+            return true;
+        return !m_scope.variable(t.text).valid() && m_scope.type(t.text).valid();
+    }
+
+    type_id type_name()
+    {
+        bool is_unsigned = false, is_signed_kw = false, any = false;
+        int longs = 0;
+        std::string base;
+        type_id type = no_type;
+        while (peek().type == token::kind::ident) {
+            const auto &word = peek().text;
+            if (word == "const" || word == "volatile") {
+            } else if (word == "unsigned") {
+                is_unsigned = any = true;
+            } else if (word == "signed") {
+                is_signed_kw = any = true;
+            } else if (word == "long") {
+                ++longs;
+                any = true;
+            } else if (word == "short" || word == "int" || word == "char" || word == "float" || word == "double"
+                       || word == "void" || word == "bool" || word == "_Bool") {
+                if (!base.empty() && !(base == "short" && word == "int"))
+                    throw syntax_error("invalid type name");
+                if (base.empty())
+                    base = word;
+                any = true;
+            } else if (word == "struct" || word == "union" || word == "enum" || word == "class") {
+                ++m_pos;
+                if (peek().type != token::kind::ident)
+                    throw syntax_error("expected a name after '" + word + "'");
+                auto name = word + " " + peek().text;
+                auto die = m_scope.type(name);
+                if (!die.valid())
+                    throw syntax_error("no type named '" + name + "'");
+                type = m_types.of(die);
+            } else if (!any && type == no_type) {
+                auto die = m_scope.type(word);
+                if (!die.valid())
+                    break;
+                type = m_types.of(die);
+            } else {
+                break;
+            }
+            ++m_pos;
+        }
+        if (any) {
+            if (type != no_type)
+                throw syntax_error("invalid type name");
+            if (base == "float") {
+                type = m_types.scalar(type_kind::floating, 4, "float");
+            } else if (base == "double") {
+                if (longs)
+                    throw syntax_error("long double is not supported");
+                type = t_double;
+            } else if (base == "void") {
+                type = m_types.scalar(type_kind::void_, 0, "void");
+            } else if (base == "bool" || base == "_Bool") {
+                type = t_bool;
+            } else if (base == "char") {
+                type = is_unsigned ? m_types.scalar(type_kind::unsigned_char, 1, "unsigned char")
+                                   : is_signed_kw ? m_types.scalar(type_kind::signed_char, 1, "signed char") : t_char;
+            } else if (base == "short") {
+                type = is_unsigned ? m_types.scalar(type_kind::unsigned_int, 2, "unsigned short")
+                                   : m_types.scalar(type_kind::signed_int, 2, "short");
+            } else if (longs) {
+                type = is_unsigned ? t_ulong : t_long;
+            } else {
+                type = is_unsigned ? t_uint : t_int;
+            }
+        }
+        if (type == no_type)
+            throw syntax_error("expected a type name");
+        while (true) {
+            if (accept("*"))
+                type = m_types.pointer_to(type);
+            else if (peek().type == token::kind::ident && (peek().text == "const" || peek().text == "volatile"))
+                ++m_pos;
+            else
+                break;
+        }
+        return type;
+    }
+
+    uint64_t size_of(int n) const
+    {
+        const auto &node = m_expr.m_nodes[n];
+        const auto &r = m_types.record(node.type);
+        if (r.kind == type_kind::array && node.dim > 0)
+            return m_types.dimensions(node.type)[node.dim] * m_types.stride(node.type, node.dim);
+        return r.size;
+    }
+
+    int unary()
+    {
+        if (accept("-")) {
+            int n = rvalue(unary());
+            if (rec(n).kind == type_kind::pointer)
+                throw syntax_error("invalid operand to unary -");
+            auto type = promote(m_expr.m_nodes[n].type);
+            return add(op::negate, type, cast(n, type));
+        }
+        if (accept("+")) {
+            int n = rvalue(unary());
+            return cast(n, promote(m_expr.m_nodes[n].type));
+        }
+        if (accept("!"))
+            return add(op::logical_not, t_int, rvalue(unary()));
+        if (accept("~")) {
+            int n = rvalue(unary());
+            if (!is_integer(rec(n)))
+                throw syntax_error("invalid operand to unary ~");
+            auto type = promote(m_expr.m_nodes[n].type);
+            return add(op::bit_not, type, cast(n, type));
+        }
+        if (accept("*")) {
+            int n = unary();
+            return dereference(n);
+        }
+        if (accept("&")) {
+            int n = unary();
+            const auto &node = m_expr.m_nodes[n];
+            if (node.code != op::variable && node.code != op::member && node.code != op::index && node.code != op::deref)
+                throw syntax_error("cannot take the address of an rvalue");
+            if (node.bit_size)
+                throw syntax_error("cannot take the address of a bit-field");
+            if (rec(n).kind == type_kind::array && node.dim > 0)
+                throw syntax_error("cannot take the address of a sub-array");
+            return add(op::address_of, m_types.pointer_to(node.type), n);
+        }
+        if (peek().type == token::kind::ident && peek().text == "sizeof") {
+            ++m_pos;
+            if (is_punct("(")) {
+                ++m_pos;
+                if (type_follows()) {
+                    auto size = m_types.record(type_name()).size;
+                    expect(")");
+                    return add(op::constant, t_ulong, -1, -1, size);
+                }
+                --m_pos;
+            }
+            return add(op::constant, t_ulong, -1, -1, size_of(unary()));
+        }
+        if (is_punct("(")) {
+            ++m_pos;
+            if (type_follows()) {
+                auto type = type_name();
+                expect(")");
+                return cast(unary(), type);
+            }
+            --m_pos;
+        }
+        return postfix(primary());
+    }
+
+    int dereference(int n)
+    {
+        const auto &r = rec(n);
+        if (r.kind == type_kind::array)
+            return index_into(n, add(op::constant, t_long, -1, -1, 0));
+        if (r.kind != type_kind::pointer)
+            throw syntax_error("cannot dereference a value of type '" + m_types.type_name(m_expr.m_nodes[n].type) + "'");
+        if (r.target == no_type || m_types.record(r.target).kind == type_kind::void_)
+            throw syntax_error("cannot dereference a void pointer");
+        if (m_types.record(r.target).kind == type_kind::function)
+            throw syntax_error("cannot dereference a function pointer");
+        return through_reference(add(op::deref, r.target, n));
+    }
+
+    int index_into(int base, int idx)
+    {
+        idx = rvalue(idx);
+        if (!is_integer(rec(idx)))
+            throw syntax_error("array subscript is not an integer");
+        idx = cast(idx, t_long);
+        const auto &node = m_expr.m_nodes[base];
+        const auto &r = rec(base);
+        if (r.kind == type_kind::array) {
+            auto stride = m_types.stride(node.type, node.dim);
+            if (node.dim + 1 < r.count)
+                return add(op::index, node.type, base, idx, stride, 0, node.dim + 1);
+            return through_reference(add(op::index, r.target, base, idx, stride));
+        }
+        if (r.kind == type_kind::pointer) {
+            if (r.target == no_type || m_types.record(r.target).kind == type_kind::void_)
+                throw syntax_error("cannot subscript a void pointer");
+            return through_reference(add(op::index, r.target, base, idx, stride_of_pointer(base)));
+        }
+        throw syntax_error("subscripted value is neither an array nor a pointer");
+    }
+
+    /**
+     * @brief 按名字查找成员，依次为直接成员、匿名结构体/联合体和基类中的成员，path 为逐层的成员下标。
+     *
+     */
+    bool find_member(type_id type, const std::string &name, std::vector<uint32_t> &path) const
+    {
+        const auto &r = m_types.record(type);
+        if (r.kind != type_kind::structure && r.kind != type_kind::union_)
+            return false;
+        auto members = m_types.members(type);
+        for (uint32_t i = 0; i < r.count; ++i) {
+            if (!(members[i].flags & type_member::base) && m_types.name_of(members[i].name) == name) {
+                path.push_back(i);
+                return true;
+            }
+        }
+        for (uint32_t i = 0; i < r.count; ++i) {
+            if (!(members[i].flags & type_member::base) && members[i].name != 0)
+                continue;
+            path.push_back(i);
+            if (find_member(members[i].type, name, path))
+                return true;
+            path.pop_back();
+        }
+        return false;
+    }
+
+    int member(int n, const std::string &name)
+    {
+        auto type = m_expr.m_nodes[n].type;
+        const auto &r = m_types.record(type);
+        if (r.kind != type_kind::structure && r.kind != type_kind::union_)
+            throw syntax_error("request for member '" + name + "' in a value of type '" + m_types.type_name(type) + "'");
+        std::vector<uint32_t> path;
+        if (!find_member(type, name, path))
+            throw syntax_error("'" + m_types.type_name(type) + "' has no member named '" + name + "'");
+        for (auto i : path) {
+            const auto &m = m_types.members(m_expr.m_nodes[n].type)[i];
+            if (m.flags & type_member::virtual_base)
+                throw syntax_error("members of virtual base classes are not supported");
+            n = add(op::member, m.type, n, -1, m.bit_offset, m.bit_size);
+        }
+        return through_reference(n);
+    }
+
+    int postfix(int n)
+    {
+        while (true) {
+            if (accept("[")) {
+                int idx = binary(1);
+                expect("]");
+                n = index_into(n, idx);
+            } else if (accept(".")) {
+                if (peek().type != token::kind::ident)
+                    throw syntax_error("expected a member name after '.'");
+                n = member(n, m_tokens[m_pos++].text);
+            } else if (accept("->")) {
+                if (peek().type != token::kind::ident)
+                    throw syntax_error("expected a member name after '->'");
+                if (rec(n).kind != type_kind::pointer)
+                    throw syntax_error("'->' applied to a value of type '" + m_types.type_name(m_expr.m_nodes[n].type) + "'");
+                n = member(dereference(n), m_tokens[m_pos++].text);
+            } else {
+                return n;
+            }
+        }
+    }
+
+    int primary()
+    {
+        const auto t = peek();
+        ++m_pos;
+        switch (t.type) {
+        case token::kind::integer: {
+            if (t.is_char)
+                return add(op::constant, t_char, -1, -1, t.value);
+            type_id type;
+            if (!t.is_long && !t.is_unsigned && t.value <= 0x7fffffffull)
+                type = t_int;
+            else if (!t.is_long && t.is_unsigned && t.value <= 0xffffffffull)
+                type = t_uint;
+            else if (!t.is_unsigned && t.value <= 0x7fffffffffffffffull)
+                type = t_long;
+            else
+                type = t_ulong;
+            return add(op::constant, type, -1, -1, t.value);
+        }
+        case token::kind::floating: {
+            uint64_t bits;
+            std::memcpy(&bits, &t.fvalue, sizeof(bits));
+            return add(op::constant, t_double, -1, -1, bits);
+        }
+        case token::kind::ident: {
+            if (t.text == "true" || t.text == "false")
+                return add(op::constant, t_bool, -1, -1, t.text == "true");
+            if (t.text == "nullptr" || t.text == "NULL")
+                return add(op::constant, m_types.pointer_to(m_types.scalar(type_kind::void_, 0, "void")), -1, -1, 0);
+            auto var = m_scope.variable(t.text);
+            if (!var.valid())
+                throw syntax_error("no symbol \"" + t.text + "\" in current context");
+            int n = add(op::variable, m_types.of_variable(var));
+            m_expr.m_nodes[n].var = var;
+            return through_reference(n);
+        }
+        case token::kind::punct:
+            if (t.text == "(") {
+                int n = binary(1);
+                expect(")");
+                return n;
+            }
+            throw syntax_error("unexpected '" + t.text + "'");
+        default:
+            throw syntax_error("incomplete expression");
+        }
+    }
+};
+
+c_expr::c_expr() : m_root{-1}, m_types{nullptr}
+{
+}
+
+bool c_expr::compile(const std::string &text, type_db &types, const expr_scope &scope)
+{
+    m_text = text;
+    m_error.clear();
+    m_nodes.clear();
+    m_root = -1;
+    m_types = &types;
+    try {
+        expr_parser parser(*this, types, scope, tokenize(text));
+        m_root = parser.parse();
+        return true;
+    } catch (const std::exception &e) {
+        m_error = e.what();
+        m_nodes.clear();
+        return false;
+    }
+}
+
+type_id c_expr::type() const
+{
+    return valid() ? m_nodes[m_root].type : no_type;
+}
+
+/**
+ * @brief 把位模式截断到类型的大小，有符号类型做符号扩展。
+ *
+ */
+static uint64_t normalize(const type_record &rec, uint64_t bits)
+{
+    if (rec.size == 0 || rec.size >= 8)
+        return bits;
+    uint64_t mask = (1ull << (rec.size * 8)) - 1;
+    bits &= mask;
+    if (rec.kind == type_kind::floating || rec.kind == type_kind::pointer)
+        return bits;
+    bool is_signed = rec.kind == type_kind::signed_int || rec.kind == type_kind::signed_char;
+    if (is_signed && ((bits >> (rec.size * 8 - 1)) & 1))
+        bits |= ~mask;
+    return bits;
+}
+
+bool c_expr::scalar(const value_ref &v, uint64_t &bits, std::string &error, const expr_env &env) const
+{
+    if (!v.error.empty()) {
+        error = v.error;
+        return false;
+    }
+    const auto &rec = m_types->record(v.type);
+    std::size_t size = rec.size ? rec.size : 8;
+    if (size > 8 || rec.kind == type_kind::structure || rec.kind == type_kind::union_ || rec.kind == type_kind::array) {
+        error = "'" + m_types->type_name(v.type) + "' is not a scalar value";
+        return false;
+    }
+    bits = v.word;
+    if (v.in_memory) {
+        std::size_t len = v.bit_size ? (v.bit_offset + v.bit_size + 7) / 8 : size;
+        bits = 0;
+        if (len > 8 || !env.memory->readable(v.address, len) || env.memory->read(v.address, &bits, len) != len) {
+            std::ostringstream oss;
+            oss << "cannot access memory at 0x" << std::hex << v.address;
+            error = oss.str();
+            return false;
+        }
+    }
+    if (v.bit_size) {
+        bits >>= v.bit_offset;
+        if (v.bit_size < 64) {
+            uint64_t mask = (1ull << v.bit_size) - 1;
+            bits &= mask;
+            bool is_signed = rec.kind == type_kind::signed_int || rec.kind == type_kind::signed_char;
+            if (is_signed && ((bits >> (v.bit_size - 1)) & 1))
+                bits |= ~mask;
+        }
+        return true;
+    }
+    bits = normalize(rec, bits);
+    return true;
+}
+
+static double to_double(const type_record &rec, uint64_t bits)
+{
+    if (rec.kind == type_kind::floating) {
+        if (rec.size == sizeof(float)) {
+            float f;
+            uint32_t low = static_cast<uint32_t>(bits);
+            std::memcpy(&f, &low, sizeof(f));
+            return f;
+        }
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+    if (rec.kind == type_kind::signed_int || rec.kind == type_kind::signed_char || rec.kind == type_kind::unknown)
+        return static_cast<double>(static_cast<int64_t>(bits));
+    return static_cast<double>(bits);
+}
+
+static uint64_t from_double(const type_record &rec, double d)
+{
+    if (rec.kind == type_kind::floating) {
+        if (rec.size == sizeof(float)) {
+            float f = static_cast<float>(d);
+            uint32_t low;
+            std::memcpy(&low, &f, sizeof(f));
+            return low;
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return bits;
+    }
+    if (rec.kind == type_kind::boolean)
+        return d != 0;
+    if (d < 0)
+        return normalize(rec, static_cast<uint64_t>(static_cast<int64_t>(d)));
+    return normalize(rec, static_cast<uint64_t>(d));
+}
+
+value_ref c_expr::eval(int n, const expr_env &env) const
+{
+    const auto &node = m_nodes[n];
+    value_ref out;
+    out.type = node.type;
+    out.dim = node.dim;
+
+    // 取操作数的值，失败时直接返回带错误的结果
+#define SCALAR(child, bits)                                                 \
+    uint64_t bits;                                                          \
+    {                                                                       \
+        auto v_ = eval(child, env);                                         \
+        if (!scalar(v_, bits, out.error, env))                              \
+            return out;                                                     \
+    }
+
+    switch (node.code) {
+    case op::variable:
+        if (!env.locate(node.var, out))
+            return out;
+        out.type = node.type;
+        return out;
+
+    case op::constant:
+        out.word = node.imm;
+        return out;
+
+    case op::member: {
+        auto base = eval(node.lhs, env);
+        if (!base.error.empty()) {
+            out.error = base.error;
+            return out;
+        }
+        uint32_t bit_offset = static_cast<uint32_t>(node.imm);
+        out.in_memory = base.in_memory;
+        out.bit_offset = node.bit_size ? bit_offset % 8 : 0;
+        out.bit_size = node.bit_size;
+        if (base.in_memory)
+            out.address = base.address + bit_offset / 8;
+        else
+            out.word = bit_offset < 64 ? base.word >> (bit_offset - out.bit_offset) : 0;
+        return out;
+    }
+
+    case op::index: {
+        SCALAR(node.rhs, i);
+        const auto &base_rec = m_types->record(m_nodes[node.lhs].type);
+        if (base_rec.kind == type_kind::pointer) {
+            SCALAR(node.lhs, pointer);
+            out.in_memory = true;
+            out.address = pointer + static_cast<int64_t>(i) * static_cast<int64_t>(node.imm);
+            return out;
+        }
+        auto base = eval(node.lhs, env);
+        if (!base.error.empty()) {
+            out.error = base.error;
+            return out;
+        }
+        uint64_t offset = static_cast<int64_t>(i) * static_cast<int64_t>(node.imm);
+        out.in_memory = base.in_memory;
+        if (base.in_memory)
+            out.address = base.address + offset;
+        else
+            out.word = offset < 8 ? base.word >> (offset * 8) : 0;
+        return out;
+    }
+
+    case op::deref: {
+        SCALAR(node.lhs, pointer);
+        out.in_memory = true;
+        out.address = pointer;
+        return out;
+    }
+
+    case op::address_of:
+    case op::decay: {
+        auto base = eval(node.lhs, env);
+        if (!base.error.empty()) {
+            out.error = base.error;
+            return out;
+        }
+        if (!base.in_memory) {
+            out.error = "cannot take the address of a value that is not in memory";
+            return out;
+        }
+        out.word = base.address;
+        return out;
+    }
+
+    case op::cast: {
+        SCALAR(node.lhs, bits);
+        const auto &from = m_types->record(m_nodes[node.lhs].type);
+        const auto &to = m_types->record(node.type);
+        if (from.kind == type_kind::floating || to.kind == type_kind::floating)
+            out.word = from_double(to, to_double(from, bits));
+        else if (to.kind == type_kind::boolean)
+            out.word = bits != 0;
+        else
+            out.word = normalize(to, bits);
+        return out;
+    }
+
+    case op::negate:
+    case op::logical_not:
+    case op::bit_not: {
+        SCALAR(node.lhs, bits);
+        const auto &operand = m_types->record(m_nodes[node.lhs].type);
+        const auto &rec = m_types->record(node.type);
+        if (node.code == op::logical_not)
+            out.word = operand.kind == type_kind::floating ? to_double(operand, bits) == 0 : bits == 0;
+        else if (node.code == op::bit_not)
+            out.word = normalize(rec, ~bits);
+        else if (rec.kind == type_kind::floating)
+            out.word = from_double(rec, -to_double(rec, bits));
+        else
+            out.word = normalize(rec, 0 - bits);
+        return out;
+    }
+
+    case op::logical_and:
+    case op::logical_or: {
+        SCALAR(node.lhs, lhs);
+        const auto &lrec = m_types->record(m_nodes[node.lhs].type);
+        bool left = lrec.kind == type_kind::floating ? to_double(lrec, lhs) != 0 : lhs != 0;
+        // 短路：左侧已决定结果时不求右侧，p && p->x 不会访问空指针
+        if (left == (node.code == op::logical_or)) {
+            out.word = left;
+            return out;
+        }
+        SCALAR(node.rhs, rhs);
+        const auto &rrec = m_types->record(m_nodes[node.rhs].type);
+        out.word = rrec.kind == type_kind::floating ? to_double(rrec, rhs) != 0 : rhs != 0;
+        return out;
+    }
+
+    default:
+        break;
+    }
+
+    // 二元运算：操作数在编译时已转换为公共类型
+    SCALAR(node.lhs, lhs);
+    SCALAR(node.rhs, rhs);
+#undef SCALAR
+    const auto &operand = m_types->record(m_nodes[node.lhs].type);
+    const auto &rec = m_types->record(node.type);
+    bool is_float = operand.kind == type_kind::floating;
+    bool is_signed = operand.kind == type_kind::signed_int || operand.kind == type_kind::signed_char;
+
+    switch (node.code) {
+    case op::lt:
+    case op::gt:
+    case op::le:
+    case op::ge:
+    case op::eq:
+    case op::ne: {
+        int cmp;
+        if (is_float) {
+            double a = to_double(operand, lhs), b = to_double(operand, rhs);
+            if (a != a || b != b) {     // NaN 与任何值都不相等
+                out.word = node.code == op::ne;
+                return out;
+            }
+            cmp = a < b ? -1 : a > b;
+        } else if (is_signed) {
+            cmp = static_cast<int64_t>(lhs) < static_cast<int64_t>(rhs) ? -1 : static_cast<int64_t>(lhs) > static_cast<int64_t>(rhs);
+        } else {
+            cmp = lhs < rhs ? -1 : lhs > rhs;
+        }
+        switch (node.code) {
+        case op::lt: out.word = cmp < 0; break;
+        case op::gt: out.word = cmp > 0; break;
+        case op::le: out.word = cmp <= 0; break;
+        case op::ge: out.word = cmp >= 0; break;
+        case op::eq: out.word = cmp == 0; break;
+        default: out.word = cmp != 0; break;
+        }
+        return out;
+    }
+    default:
+        break;
+    }
+
+    if (operand.kind == type_kind::pointer) {
+        // 指针加减整数，或两个指针相减（结果为元素个数）
+        if (rec.kind == type_kind::pointer)
+            out.word = node.code == op::add ? lhs + rhs * node.imm : lhs - rhs * node.imm;
+        else
+            out.word = static_cast<uint64_t>(static_cast<int64_t>(lhs - rhs) / static_cast<int64_t>(node.imm));
+        return out;
+    }
+
+    if (is_float) {
+        double a = to_double(operand, lhs), b = to_double(operand, rhs), r;
+        switch (node.code) {
+        case op::add: r = a + b; break;
+        case op::sub: r = a - b; break;
+        case op::mul: r = a * b; break;
+        default: r = a / b; break;
+        }
+        out.word = from_double(rec, r);
+        return out;
+    }
+
+    uint64_t r;
+    switch (node.code) {
+    case op::add: r = lhs + rhs; break;
+    case op::sub: r = lhs - rhs; break;
+    case op::mul: r = lhs * rhs; break;
+    case op::div:
+    case op::mod:
+        if (rhs == 0) {
+            out.error = "Division by zero";
+            return out;
+        }
+        if (is_signed) {
+            auto a = static_cast<int64_t>(lhs), b = static_cast<int64_t>(rhs);
+            if (b == -1)        // INT64_MIN / -1 会溢出
+                r = node.code == op::div ? 0 - lhs : 0;
+            else
+                r = static_cast<uint64_t>(node.code == op::div ? a / b : a % b);
+        } else {
+            r = node.code == op::div ? lhs / rhs : lhs % rhs;
+        }
+        break;
+    case op::shl: r = rhs >= 64 ? 0 : lhs << rhs; break;
+    case op::shr:
+        if (is_signed)
+            r = static_cast<uint64_t>(static_cast<int64_t>(lhs) >> (rhs >= 64 ? 63 : rhs));
+        else
+            r = rhs >= 64 ? 0 : lhs >> rhs;
+        break;
+    case op::bit_and: r = lhs & rhs; break;
+    case op::bit_or: r = lhs | rhs; break;
+    default: r = lhs ^ rhs; break;
+    }
+    out.word = normalize(rec, r);
+    return out;
+}
+
+value_ref c_expr::evaluate(const expr_env &env) const
+{
+    value_ref out;
+    if (!valid()) {
+        out.error = m_error.empty() ? "invalid expression" : m_error;
+    } else {
+        try {
+            out = eval(m_root, env);
+        } catch (const std::exception &e) {
+            out = value_ref{};
+            out.error = std::string("Error: ") + e.what();
+        }
+    }
+    out.label = m_text;
+    return out;
+}
+
+bool c_expr::test(const expr_env &env, std::string &error) const
+{
+    auto v = evaluate(env);
+    uint64_t bits;
+    if (!scalar(v, bits, error, env))
+        return false;
+    const auto &rec = m_types->record(v.type);
+    return rec.kind == type_kind::floating ? to_double(rec, bits) != 0 : bits != 0;
+}
+
+constexpr std::size_t scoped_expr::max_forms;
+
+const c_expr *scoped_expr::find(dwarf::section_offset function, int scope) const
+{
+    for (const auto &f : m_forms) {
+        if (f.function == function && f.scope == scope)
+            return &f.expr;
+    }
+    return nullptr;
+}
+
+const c_expr &scoped_expr::compile(dwarf::section_offset function, int scope, type_db &types, const expr_scope &names)
+{
+    if (m_forms.size() >= max_forms)
+        m_forms.erase(m_forms.begin());
+    m_forms.push_back(form{function, scope, c_expr()});
+    m_forms.back().expr.compile(m_text, types, names);
+    return m_forms.back().expr;
+}
+
+}   // namespace minidbg
@@ -0,0 +1,123 @@
+#include "chain_walker.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+namespace minidbg {
+
+constexpr std::size_t chain_walker::default_limit;
+constexpr std::size_t chain_walker::max_node_bytes;
+constexpr std::size_t chain_walker::narrow_level;
+constexpr std::size_t chain_walker::readahead_pages;
+
+chain_walker::chain_walker(stop_state &state, type_db &types) : m_state(state), m_types(types)
+{
+}
+
+chain_result chain_walker::walk(uint64_t start, type_id type, const std::vector<std::string> &fields, std::size_t limit)
+{
+    chain_result result;
+    result.type = type;
+    result.fields = fields;
+    const auto &rec = m_types.record(type);
+    if (rec.kind != type_kind::structure && rec.kind != type_kind::union_) {
+        result.error = "'" + m_types.type_name(type) + "' is not a structure";
+        return result;
+    }
+    if (fields.empty()) {
+        result.error = "no link field given";
+        return result;
+    }
+    // 链接成员在节点中的偏移
+    std::vector<uint32_t> offsets;
+    for (const auto &name : fields) {
+        uint32_t offset;
+        type_id field_type;
+        if (!m_types.find_field(type, name, offset, field_type)) {
+            result.error = "'" + m_types.type_name(type) + "' has no member named '" + name + "'";
+            return result;
+        }
+        const auto &f = m_types.record(field_type);
+        // 不同编译单元中的同一结构体是不同的记录，按名字比较
+        if (f.kind != type_kind::pointer || f.target == no_type
+            || (f.target != type && m_types.type_name(f.target) != m_types.type_name(type))) {
+            result.error = "'" + name + "' is not a pointer to '" + m_types.type_name(type) + "'";
+            return result;
+        }
+        offsets.push_back(offset);
+    }
+    std::size_t size = std::min<std::size_t>(rec.size ? rec.size : 8, max_node_bytes);
+    for (auto offset : offsets) {
+        if (offset + sizeof(uint64_t) > size) {
+            result.error = "link field beyond the first " + std::to_string(size) + " bytes of the node";
+            return result;
+        }
+    }
+    if (start == 0 || limit == 0)
+        return result;
+
+    std::unordered_map<uint64_t, int> visited;      // 地址 -> 节点下标
+    std::vector<int> level;                          // 本层节点的下标
+    std::vector<uint8_t> bytes(size);
+    std::vector<std::pair<uint64_t, std::size_t>> ranges;
+    result.nodes.push_back(chain_node{start, 0, -1, -1, false, std::string{}});
+    visited.emplace(start, 0);
+    level.push_back(0);
+    while (!level.empty()) {
+        // 本层节点所在的页一次批量读入；链表等窄的层遇到未缓存的节点时多读前后的页，相邻分配的后续节点随之读入
+        ranges.clear();
+        bool narrow = level.size() <= narrow_level;
+        for (auto index : level) {
+            uint64_t addr = result.nodes[index].address;
+            if (narrow && !m_state.cached(addr, size)) {
+                uint64_t half = readahead_pages / 2 * stop_state::page_size;
+                uint64_t lo = addr > half ? addr - half : 0;
+                ranges.emplace_back(lo, addr - lo + half + size);
+            } else {
+                ranges.emplace_back(addr, size);
+            }
+        }
+        std::size_t misses = m_state.page_misses();
+        m_state.prefetch(ranges);
+        if (m_state.page_misses() != misses)
+            ++result.reads;
+        ++result.levels;
+
+        std::vector<int> next;
+        for (auto index : level) {
+            uint64_t addr = result.nodes[index].address;
+            if (!m_state.readable(addr, size) || m_state.read(addr, bytes.data(), size) != size) {
+                std::ostringstream oss;
+                oss << "<cannot access memory at 0x" << std::hex << addr << ">";
+                result.nodes[index].value = oss.str();
+                continue;
+            }
+            result.nodes[index].readable = true;
+            result.nodes[index].value = m_types.format(type, bytes.data(), size);
+            for (std::size_t f = 0; f < offsets.size(); ++f) {
+                uint64_t to;
+                std::memcpy(&to, bytes.data() + offsets[f], sizeof(to));
+                if (to == 0)
+                    continue;
+                auto seen = visited.find(to);
+                if (seen != visited.end()) {
+                    result.back_links.emplace_back(index, seen->second);
+                    continue;
+                }
+                if (result.nodes.size() >= limit) {
+                    result.truncated = true;
+                    continue;
+                }
+                int child = static_cast<int>(result.nodes.size());
+                result.nodes.push_back(chain_node{to, result.nodes[index].depth + 1, index, static_cast<int>(f), false, std::string{}});
+                visited.emplace(to, child);
+                next.push_back(child);
+            }
+        }
+        level.swap(next);
+    }
+    return result;
+}
+
+}   // namespace minidbg
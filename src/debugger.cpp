@@ -1,735 +1,3431 @@
 #include "debugger.h"
 #include "utility.hpp"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <sstream>
 
 template class std::initializer_list<dwarf::taddr>; 
 
 namespace minidbg
 {
 
-dwarf::die debugger::get_function_die_from_pc(uint64_t pc) {
-    for (const auto &cu : m_dwarf.compilation_units()) {        // 找到编译单元
-        for(auto die : cu.root()){                   // 对于其中的每条die
-            if (die.tag == dwarf::DW_TAG::subprogram            // 如果是函数，且为当前正在执行的函数
-                && get_function_from_pc(pc).function_name == dwarf::at_name(die)) 
-            {     
-                    std::cout << "function "+dwarf::at_name(die)+"'s die found.\n";
-                    return die;
-            }
+constexpr std::size_t debugger::max_scan_rows;
+constexpr std::size_t debugger::max_change_rows;
+
+bool debugger::frame_scope(std::size_t i, frame_scope_info &scope)
+{
+    if (!expand_frames(i) || m_frames[i].inline_node < 0)
+        return false;
+    int node = m_frames[i].inline_node;
+    scope.function = m_inlines.node(node).die;
+    while (m_inlines.node(node).parent >= 0)
+        node = m_inlines.node(node).parent;
+    scope.subprogram = m_inlines.node(node).die;
+
+    // 先回溯出外一层，本帧的CFA才已知
+    auto physical = m_frames[i].physical;
+    get_physical_frame(physical + 1);
+    scope.regs = *get_physical_frame(physical);
+    scope.pc = offset_load_address(scope.regs.lookup_pc());
+    return true;
+}
+
+bool debugger::locate(ptrace_expr_context &context, const frame_scope_info &scope, const dwarf::die &var, value_ref &out)
+{
+    // 类型布局按类型DIE记忆，之后的解码不再访问DIE树
+    out.type = m_types.of_variable(var);
+    if (!var.has(dwarf::DW_AT::location))
+    {
+        out.error = "Error: Variable location not supported.";
+        return false;
+    }
+    // 单个表达式或位置列表中当前pc处的条目，解码结果按变量缓存
+    auto location = m_locations.find(var, scope.pc);
+    if (location == nullptr)
+    {
+        out.error = "<optimized out>";
+        return false;
+    }
+    auto result = location->evaluate(&context);
+    switch (result.location_type)
+    {
+    case dwarf::expr_result::type::address:
+        out.in_memory = true;
+        out.address = result.value;
+        return true;
+    case dwarf::expr_result::type::reg:
+        if (scope.regs.has(result.value))
+            out.word = scope.regs.regs[result.value];
+        else if (scope.regs.innermost)
+            out.word = get_register_value_from_dwarf_register(m_pid, result.value);
+        else
+        {
+            out.error = "<not saved>";      // 调用者保存的寄存器，回溯无法恢复
+            return false;
         }
+        return true;
+    case dwarf::expr_result::type::literal:     // DW_OP_stack_value：值本身
+        out.word = result.value;
+        return true;
+    case dwarf::expr_result::type::implicit:
+        std::memcpy(&out.word, result.implicit, std::min(result.implicit_len, sizeof(out.word)));
+        return true;
+    default:
+        out.error = "Error: Unhandled variable location type.";
+        return false;
     }
-    throw std::out_of_range{"get_function_die_from_pc(): funtion die not found.\n"};
 }
 
+void debugger::materialize(const frame_scope_info &scope, const std::vector<dwarf::die> &vars, std::vector<std::string> &values)
+{
+    // 变量在内存中时最多读取的字节数，更大的结构体和数组只显示开头
+    static constexpr std::size_t max_value_bytes = 4096;
+    struct pending
+    {
+        std::size_t var;
+        uint64_t addr;
+        std::size_t len;
+        type_id type;
+    };
+    std::vector<pending> loads;
+    values.assign(vars.size(), std::string{});
+
+    // 所有表达式都在同一份寄存器快照上求值，内存中的变量先只记下地址
+    ptrace_expr_context context(m_stop_state, m_load_address, &scope.regs, scope.subprogram);
+    for (std::size_t i = 0; i < vars.size(); ++i)
+    {
+        try
+        {
+            value_ref v;
+            if (!locate(context, scope, vars[i], v))
+                values[i] = v.error;
+            else if (v.in_memory)
+                loads.push_back(pending{i, v.address, m_types.value_size(v.type, max_value_bytes), v.type});
+            else
+                values[i] = m_types.format(v.type, reinterpret_cast<const uint8_t *>(&v.word), sizeof(v.word));
+        }
+        catch (const std::exception &e)
+        {
+            values[i] = std::string("Error: ") + e.what();
+        }
+    }
+    if (loads.empty())
+        return;
 
-std::string debugger::read_variable(const std::string& var_name) {
-    std::string error_msg;
+    // 涉及的页由一次 process_vm_readv 读入本次停止的页缓存，之后各变量直接从缓存中取值
+    std::vector<std::pair<uint64_t, std::size_t>> ranges;
+    ranges.reserve(loads.size());
+    for (const auto &load : loads)
+        ranges.emplace_back(load.addr, load.len);
+    m_stop_state.prefetch(ranges);
 
-    try {
-        // auto func = get_function_die_from_pc(get_offset_pc());
-        auto func_die = get_function_die_from_pc(get_pc());
-
-        for (const auto& die : func_die) {
-            // 跳过非变量, 检查变量名是否匹配
-            if (die.tag != dwarf::DW_TAG::variable) continue;
-            if (!die.has(dwarf::DW_AT::name) || dwarf::at_name(die) != var_name) continue;
-
-            //debug
-            // std::cout<<"read_variable(): variable " + var_name + "/" + dwarf::at_name(die) + "'s die" + " found.\n";
-
-            auto loc_val = die[dwarf::DW_AT::location];
-
-            // 只支持exprlocs类型的位置表达式
-            if (loc_val.get_type() == dwarf::value::type::exprloc) {
-                ptrace_expr_context context(m_pid, m_load_address);
-                auto result = loc_val.as_exprloc().evaluate(&context);
-
-                // 根据位置类型读取并返回变量的值
-                switch (result.location_type) {
-                    case dwarf::expr_result::type::address: {  // 地址
-                        auto offset_addr = result.value;
-                        long data = ptrace(PTRACE_PEEKDATA, m_pid, reinterpret_cast<void*>(offset_addr) + 16, nullptr);
-                        if (errno != 0) {
-                            error_msg = "Error: Failed to read memory at address " + std::to_string(offset_addr);
-                            return error_msg;
-                        }
-                        return std::to_string(data);
-                    }
-                    case dwarf::expr_result::type::reg: {  // 寄存器
-                        try {
-                            auto value = get_register_value_from_dwarf_register(m_pid, result.value);
-                            return std::to_string(value);
-                        } catch(const std::exception& e) {
-                            error_msg = "Error: Failed to read register value, " + std::string(e.what());
-                            return error_msg;
-                        }
-                    }
-                    default:
-                        return "Error: Unhandled variable location type.";
-                }
-            } else {
-                return "Error: Variable location not supported.";
-            }
+    std::vector<uint8_t> buffer(max_value_bytes);
+    for (const auto &load : loads)
+    {
+        if (!m_stop_state.readable(load.addr, load.len) || m_stop_state.read(load.addr, buffer.data(), load.len) != load.len)
+        {
+            values[load.var] = "Error: Failed to read memory at address " + std::to_string(load.addr);
+            continue;
         }
-        return "Error: Variable not found.";
-    } catch (const std::exception& e) {
-        // 处理所有预期之外的异常，并记录足够的信息来修复bug
-        std::stringstream ss;
-        ss << "read_variable(): exception: " << e.what();
-        ss << "Variable name: " << var_name << ", ";
-        ss << "PID: " << m_pid << ", Load Address: " << std::hex << m_load_address << "\n\n";
-        // 输出异常信息到标准错误
-        std::cerr << ss.str();
-        // 返回明确的错误消息
-        return "Error: An exception occurred while reading variable.";
+        values[load.var] = m_types.format(load.type, buffer.data(), load.len);
     }
 }
 
+const c_expr &debugger::compiled(scoped_expr &expr, const frame_scope_info &scope)
+{
+    // 作用域编号相同则可见的变量相同，编译结果可以共用
+    auto function = scope.function.get_section_offset();
+    int scope_id = m_scopes.scope_at(scope.function, scope.pc);
+    if (auto found = expr.find(function, scope_id))
+        return *found;
+    expr_scope names;
+    names.variable = [&](const std::string &name) {
+        auto var = m_scopes.lookup(scope.function, scope.pc, name);
+        return var != nullptr ? var->die : dwarf::die();
+    };
+    names.type = [this](const std::string &name) { return m_scopes.find_type(name); };
+    return expr.compile(function, scope_id, m_types, names);
+}
 
-void debugger::handle_command(const std::string &line)
+value_ref debugger::evaluate(const c_expr &expr, const frame_scope_info &scope, ptrace_expr_context &context)
 {
-    std::vector<std::string> args = utility::split(line, ' ');
-    std::string command = args[0];
+    expr_env env;
+    env.locate = [&](const dwarf::die &var, value_ref &out) { return locate(context, scope, var, out); };
+    env.memory = &m_stop_state;
+    return expr.evaluate(env);
+}
 
-    if (utility::is_prefix(command, "break"))
+bool debugger::evaluate_text(const std::string &text, value_ref &out, std::string &error)
+{
+    frame_scope_info scope;
+    if (!frame_scope(m_selected_frame, scope))
     {
-        if (args[1][0] == '0' && args[1][1] == 'x')
+        error = "No symbol table info available.";
+        return false;
+    }
+    // 一次性的表达式，编译形式不保存
+    c_expr expr;
+    expr_scope names;
+    names.variable = [&](const std::string &name) {
+        auto var = m_scopes.lookup(scope.function, scope.pc, name);
+        return var != nullptr ? var->die : dwarf::die();
+    };
+    names.type = [this](const std::string &name) { return m_scopes.find_type(name); };
+    if (!expr.compile(text, m_types, names))
+    {
+        error = expr.error();
+        return false;
+    }
+    ptrace_expr_context context(m_stop_state, m_load_address, &scope.regs, scope.subprogram);
+    out = evaluate(expr, scope, context);
+    return true;
+}
+
+void debugger::print_expression(const std::string &text)
+{
+    value_ref value;
+    std::string error;
+    if (!evaluate_text(text, value, error))
+    {
+        std::cout << error << std::endl;
+        return;
+    }
+    std::cout << "(" << m_values.type_name(value) << ") " << m_values.summary(value) << std::endl;
+}
+
+chain_result debugger::follow(const std::string &expression, const std::vector<std::string> &fields, std::size_t limit)
+{
+    chain_result result;
+    value_ref start;
+    if (!evaluate_text(expression, start, result.error))
+        return result;
+    if (!start.error.empty())
+    {
+        result.error = start.error;
+        return result;
+    }
+    const auto &rec = m_types.record(start.type);
+    uint64_t address = 0;
+    type_id type = no_type;
+    if (rec.kind == type_kind::pointer)
+    {
+        address = start.word;
+        if (start.in_memory && (!m_stop_state.readable(start.address, sizeof(address))
+                                || m_stop_state.read(start.address, &address, sizeof(address)) != sizeof(address)))
         {
-            std::string addr{args[1], 2}; // naively assume that the user has written 0xADDRESS like 0xff
-            set_breakpoint_at_address(std::stol(addr, 0, 16) + m_load_address);
+            result.error = "Cannot access memory for '" + expression + "'.";
+            return result;
         }
-        else if (args[1].find(':') != std::string::npos)
+        type = rec.target;
+    }
+    else if (start.in_memory && (rec.kind == type_kind::structure || rec.kind == type_kind::union_))
+    {
+        // 结构体左值从其自身开始
+        address = start.address;
+        type = start.type;
+    }
+    if (type == no_type)
+    {
+        result.error = "'" + expression + "' is not a pointer to a structure.";
+        return result;
+    }
+    return m_chains.walk(address, type, fields, limit);
+}
+
+const array_inspector &debugger::inspect_array(const std::string &expression, uint64_t count)
+{
+    m_array_expr = expression;
+    m_array_count = count;
+    load_array();
+    return m_array;
+}
+
+const array_inspector &debugger::get_array()
+{
+    if (!m_array_expr.empty() && m_array_stop_id != m_stop_id)
+        load_array();
+    return m_array;
+}
+
+void debugger::load_array()
+{
+    m_array_stop_id = m_stop_id;
+    value_ref value;
+    std::string error;
+    try
+    {
+        if (!evaluate_text(m_array_expr, value, error))
         {
-            auto file_and_line = utility::split(args[1], ':');
-            set_breakpoint_at_source_file(file_and_line[0], std::stoi(file_and_line[1]));
+            m_array.clear(error);
+            return;
         }
-        else
+    }
+    catch (const std::exception &e)
+    {
+        m_array.clear(std::string("Error: ") + e.what());
+        return;
+    }
+    if (!value.error.empty())
+    {
+        m_array.clear(value.error);
+        return;
+    }
+    uint64_t address = 0;
+    uint64_t count = 0;
+    type_id element = no_type;
+    if (!m_values.contiguous(value, address, element, count))
+    {
+        // 指针须给出元素个数
+        const auto &rec = m_types.record(value.type);
+        if (rec.kind != type_kind::pointer || m_array_count == 0)
         {
-            set_breakpoint_at_function(args[1]);
+            m_array.clear("'" + m_array_expr + "' is not an array or std::vector; give an element count for a pointer.");
+            return;
+        }
+        address = value.word;
+        if (value.in_memory && (!m_stop_state.readable(value.address, sizeof(address))
+                                || m_stop_state.read(value.address, &address, sizeof(address)) != sizeof(address)))
+        {
+            m_array.clear("Cannot access memory for '" + m_array_expr + "'.");
+            return;
         }
+        element = rec.target;
     }
-    else if(utility::is_prefix(command, "continue"))
+    m_array.load(address, element, m_array_count ? m_array_count : count);
+}
+
+void debugger::print_array()
+{
+    const auto &array = get_array();
+    if (!array.loaded())
     {
-        continue_execution();
+        std::cout << array.error() << std::endl;
+        return;
     }
-    else if (utility::is_prefix(command, "register"))
+    const auto &stats = array.stats();
+    std::cout << std::dec << stats.count << " elements at 0x" << std::hex << array.address() << std::dec;
+    if (stats.count < array.requested())
+        std::cout << " (" << array.requested() << " requested)";
+    std::cout << std::endl;
+    if (stats.count == 0)
+        return;
+    std::cout << "min " << array.format(stats.min_index) << " at [" << stats.min_index << "], max " << array.format(stats.max_index)
+              << " at [" << stats.max_index << "], mean " << stats.mean << std::endl;
+    std::cout << stats.nan_count << " NaN, " << stats.inf_count << " Inf" << std::endl;
+    // 直方图每4段合为一行
+    if (stats.histogram.empty())
+        return;
+    uint32_t peak = *std::max_element(stats.histogram.begin(), stats.histogram.end());
+    std::size_t group = 4;
+    for (std::size_t i = 0; i < stats.histogram.size(); i += group)
     {
-        if (utility::is_prefix(args[1], "dump"))
+        uint64_t n = 0;
+        for (std::size_t k = i; k < i + group && k < stats.histogram.size(); ++k)
+            n += stats.histogram[k];
+        std::size_t bar = peak ? static_cast<std::size_t>(n * 40 / (static_cast<uint64_t>(peak) * group)) : 0;
+        std::cout << std::setw(10) << n << " " << std::string(bar, '#') << std::endl;
+    }
+}
+
+bool debugger::evaluate_address(const std::string &text, uint64_t &address, std::string &error)
+{
+    value_ref value;
+    if (!evaluate_text(text, value, error))
+        return false;
+    if (!value.error.empty())
+    {
+        error = value.error;
+        return false;
+    }
+    const auto &rec = m_types.record(value.type);
+    if (rec.kind == type_kind::array)
+    {
+        // 数组取其首地址
+        if (!value.in_memory)
         {
-            dump_registers();
+            error = "'" + text + "' has no address.";
+            return false;
         }
-        else if (utility::is_prefix(args[1], "read"))
+        address = value.address;
+        return true;
+    }
+    std::size_t size = std::min<std::size_t>(rec.size ? rec.size : sizeof(address), sizeof(address));
+    address = value.word;
+    if (value.in_memory)
+    {
+        address = 0;
+        if (!m_stop_state.readable(value.address, size) || m_stop_state.read(value.address, &address, size) != size)
         {
-            std::cout << get_register_value(m_pid, get_register_from_name(args[2])) << std::endl;
+            error = "Cannot access memory for '" + text + "'.";
+            return false;
         }
-        else if (utility::is_prefix(args[1], "write"))
+    }
+    return true;
+}
+
+bool debugger::search_pattern(const std::string &text, std::vector<uint8_t> &bytes, std::string &error)
+{
+    bytes.clear();
+    if (!text.empty() && text[0] == '"')
+    {
+        // 字符串不含结尾的0
+        std::size_t i = 1;
+        for (; i < text.size() && text[i] != '"'; ++i)
         {
-            std::string val{args[3], 2}; // assume 0xVALUE
-            set_register_value(m_pid, get_register_from_name(args[2]), std::stol(val, 0, 16));
-            std::cout << "write data " << args[3] << " into reg " << args[2] << " successfully\n";
+            char c = text[i];
+            if (c != '\\' || i + 1 >= text.size())
+            {
+                bytes.push_back(static_cast<uint8_t>(c));
+                continue;
+            }
+            c = text[++i];
+            switch (c)
+            {
+            case 'n': bytes.push_back('\n'); break;
+            case 't': bytes.push_back('\t'); break;
+            case 'r': bytes.push_back('\r'); break;
+            case '0': bytes.push_back(0); break;
+            case 'x':
+            {
+                std::size_t used = 0;
+                std::string digits = text.substr(i + 1, 2);
+                unsigned long v = 0;
+                try
+                {
+                    v = std::stoul(digits, &used, 16);
+                }
+                catch (const std::exception &)
+                {
+                    used = 0;
+                }
+                if (used == 0)
+                {
+                    error = "bad \\x escape in search string";
+                    return false;
+                }
+                bytes.push_back(static_cast<uint8_t>(v));
+                i += used;
+                break;
+            }
+            default: bytes.push_back(static_cast<uint8_t>(c)); break;
+            }
         }
-        else
+        if (i >= text.size() || text.find_first_not_of(' ', i + 1) != std::string::npos)
         {
-            std::cout << "unknow command for register\n";
+            error = "unterminated search string";
+            return false;
         }
+        if (bytes.empty())
+            error = "empty search string";
+        return !bytes.empty();
     }
-    else if (utility::is_prefix(command, "symbol"))
+
+    // 表达式按其类型的大小取值的字节，如 0xdeadbeef 为4字节，(long)1 为8字节
+    value_ref value;
+    if (!evaluate_text(text, value, error))
+        return false;
+    if (!value.error.empty())
     {
-        auto syms = symboltype::lookup_symbol(args[1], m_elf);
-        for (auto &s : syms)
+        error = value.error;
+        return false;
+    }
+    std::size_t size = m_types.value_size(value.type, 4096);
+    if (size == 0)
+    {
+        error = "'" + text + "' has no size.";
+        return false;
+    }
+    bytes.resize(size);
+    if (value.in_memory)
+    {
+        if (!m_stop_state.readable(value.address, size) || m_stop_state.read(value.address, bytes.data(), size) != size)
         {
-            std::cout << s.name << " " << symboltype::to_string(s.type) << " 0x" << std::hex << s.addr << std::endl;
+            error = "Cannot access memory for '" + text + "'.";
+            return false;
         }
     }
-    else if (utility::is_prefix(command, "memory"))
+    else
     {
-        std::string addr{args[2], 2}; // assume 0xADDRESS
+        if (size > sizeof(value.word))
+        {
+            error = "'" + text + "' has no value in memory.";
+            return false;
+        }
+        std::memcpy(bytes.data(), &value.word, size);
+    }
+    return true;
+}
 
-        if (utility::is_prefix(args[1], "read"))
+bool debugger::find_memory(const std::string &args, std::size_t limit, std::string &error)
+{
+    // 按不在引号和括号中的逗号切分
+    std::vector<std::string> parts(1);
+    int depth = 0;
+    bool quoted = false;
+    for (std::size_t i = 0; i < args.size(); ++i)
+    {
+        char c = args[i];
+        if (quoted && c == '\\' && i + 1 < args.size())
         {
-            std::cout << std::hex << read_memory(std::stol(addr, 0, 16)) << std::endl;
+            parts.back() += c;
+            parts.back() += args[++i];
+            continue;
         }
-        if (utility::is_prefix(args[1], "write"))
+        if (c == '"')
+            quoted = !quoted;
+        else if (!quoted && (c == '(' || c == '['))
+            ++depth;
+        else if (!quoted && (c == ')' || c == ']'))
+            --depth;
+        else if (!quoted && depth == 0 && c == ',')
         {
-            std::string val{args[3], 2}; // assume 0xVAL
-            write_memory(std::stol(addr, 0, 16), std::stol(val, 0, 16));
+            parts.emplace_back();
+            continue;
         }
+        parts.back() += c;
     }
-    else if (utility::is_prefix(command, "si"))
+    for (auto &part : parts)
     {
-        single_step_instruction_with_breakpoint_check();
-        auto offset_pc = offset_load_address(get_pc());
-        auto line_entry = get_line_entry_from_pc(offset_pc);
+        auto begin = part.find_first_not_of(' ');
+        auto end = part.find_last_not_of(' ');
+        part = begin == std::string::npos ? std::string{} : part.substr(begin, end - begin + 1);
     }
-    else if (utility::is_prefix(command, "step"))
+    if ((parts.size() != 1 && parts.size() != 3) || parts.back().empty())
     {
-        step_in();
+        error = "usage: find[/N] [start, end|+length,] \"string\"|expression";
+        return false;
     }
-    else if (utility::is_prefix(command, "next"))
+
+    uint64_t lo = 0, hi = 0;
+    std::vector<uint8_t> pattern;
+    try
     {
-        step_over();
+        if (parts.size() == 3)
+        {
+            if (!evaluate_address(parts[0], lo, error))
+                return false;
+            bool length = !parts[1].empty() && parts[1][0] == '+';
+            if (!evaluate_address(length ? parts[1].substr(1) : parts[1], hi, error))
+                return false;
+            if (length)
+                hi += lo;
+            if (hi <= lo)
+            {
+                error = "empty search range";
+                return false;
+            }
+        }
+        if (!search_pattern(parts.back(), pattern, error))
+            return false;
     }
-    else if (utility::is_prefix(command, "finish"))
+    catch (const std::exception &e)
     {
-        step_out();
+        error = std::string("Error: ") + e.what();
+        return false;
     }
-    else if (utility::is_prefix(command, "backtrace"))
+    m_search_hits.clear();
+    if (!m_search.start(pattern, lo, hi, limit))
     {
-        // print_backtrace();
+        error = m_search.error();
+        return false;
     }
-    else if (utility::is_prefix(command, "ls"))
+    return true;
+}
+
+const std::vector<search_hit> &debugger::get_search_hits()
+{
+    std::size_t first = m_search_hits.size();
+    m_search.take(m_search_hits);
+    for (std::size_t i = first; i < m_search_hits.size(); ++i)
     {
+        auto &hit = m_search_hits[i];
+        if (hit.region < m_search.regions().size())
+            hit.where = describe_address(hit.address, m_search.regions()[hit.region]);
+    }
+    return m_search_hits;
+}
 
-        auto line_entry = get_line_entry_from_pc(get_offset_pc());
-        // print_source(line_entry->file->path, line_entry->line);
-        // print_asm(m_asm_name, get_offset_pc());
+std::string debugger::describe_address(uint64_t address, const memory_region &region)
+{
+    std::ostringstream oss;
+    auto slash = region.name.rfind('/');
+    std::string name = slash == std::string::npos ? region.name : region.name.substr(slash + 1);
+    if (!name.empty())
+    {
+        // 文件映射的偏移按文件计算
+        oss << name << "+0x" << std::hex << address - region.lo + (name[0] == '[' ? 0 : region.offset);
     }
-    else
+    if (region.executable)
     {
-        std::cerr << "unknow command\n";
+        uint64_t start = 0;
+        auto function = function_name_at(address, start);
+        if (start != 0)
+            oss << (name.empty() ? "<" : " <") << function << "+" << std::dec << address - start << ">";
+        return oss.str();
+    }
+    // 主程序的数据对象
+    uint64_t offset = address - m_load_address;
+    for (const auto &sec : m_elf.sections())
+    {
+        if (sec.get_hdr().type != elf::sht::symtab)
+            continue;
+        for (auto sym : sec.as_symtab())
+        {
+            auto &d = sym.get_data();
+            if (d.type() != elf::stt::object || d.shnxd == elf::shn::undef)
+                continue;
+            if (offset >= d.value && offset < d.value + std::max<uint64_t>(d.size, 1))
+            {
+                oss << (name.empty() ? "<" : " <") << sym.get_name() << "+" << std::dec << offset - d.value << ">";
+                return oss.str();
+            }
+        }
     }
+    return oss.str();
 }
 
+void debugger::print_find(const std::string &args, std::size_t limit)
+{
+    std::string error;
+    if (!find_memory(args, limit, error))
+    {
+        std::cout << error << std::endl;
+        return;
+    }
+    // 命中陆续到达时打印
+    std::size_t printed = 0;
+    while (true)
+    {
+        bool running = m_search.running();
+        const auto &hits = get_search_hits();
+        for (; printed < hits.size(); ++printed)
+        {
+            const auto &hit = hits[printed];
+            std::cout << "0x" << std::hex << std::setw(16) << std::setfill('0') << hit.address << std::setfill(' ') << " ";
+            for (std::size_t k = 0; k < hit.context_len; ++k)
+                std::cout << std::setw(2) << std::setfill('0') << static_cast<unsigned>(hit.context[k]) << std::setfill(' ') << (k + 1 < hit.context_len ? " " : "");
+            std::cout << std::dec << "  " << hit.where << std::endl;
+        }
+        if (!running)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    m_search.wait();
+    double seconds = m_search.seconds();
+    double mib = m_search.scanned() / 1048576.0;
+    std::cout << std::dec << printed << (printed == 1 ? " match" : " matches") << (m_search.truncated() ? " (limit reached)" : "")
+              << ", " << std::fixed << std::setprecision(1) << mib << " MiB scanned in " << std::setprecision(3) << seconds << "s";
+    if (seconds > 0)
+        std::cout << " (" << std::setprecision(0) << mib / seconds << " MiB/s)";
+    std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+}
 
-
-
-/**
-    * @brief 终止被调试程序
-    * 
-    */
-bool debugger::kill_prog()
+bool debugger::scan_values(const std::string &args, std::string &error)
 {
-    if (ptrace(PTRACE_KILL, m_pid, NULL, NULL) == -1) {
-        std::cerr << "Failed to ptrace PTRACE_KILL." << std::endl;
+    static const std::pair<const char *, scan_filter> filters[] = {
+        {"==", scan_filter::eq}, {"!=", scan_filter::ne}, {">", scan_filter::gt}, {"<", scan_filter::lt},
+        {"changed", scan_filter::changed}, {"unchanged", scan_filter::unchanged},
+        {"increased", scan_filter::increased}, {"decreased", scan_filter::decreased}};
+    std::vector<std::string> words;
+    std::istringstream in(args);
+    std::string word;
+    while (in >> word)
+        words.push_back(word);
+
+    // 第一个词是类型时开始新的一轮
+    number_kind kind = words.empty() ? number_kind::none : value_scanner::parse_kind(words[0]);
+    std::size_t at = kind == number_kind::none ? 0 : 1;
+    auto filter = at < words.size() ? std::find_if(std::begin(filters), std::end(filters), [&](const std::pair<const char *, scan_filter> &f) { return words[at] == f.first; })
+                                    : std::end(filters);
+    if (filter == std::end(filters) || words.size() > at + 2)
+    {
+        error = "usage: scan <type> ==|!=|>|< value, then scan ==|!=|>|< value or scan changed|unchanged|increased|decreased";
         return false;
     }
-    return true;
+    std::string operand = at + 1 < words.size() ? words[at + 1] : std::string{};
+    bool ok = kind != number_kind::none ? m_scanner.first(kind, filter->second, operand) : m_scanner.next(filter->second, operand);
+    m_scan_rows_scan = 0;
+    if (!ok)
+        error = m_scanner.error();
+    return ok;
 }
 
+void debugger::reset_scan()
+{
+    m_scanner.reset();
+    m_scan_rows.clear();
+    m_scan_rows_scan = 0;
+}
 
-std::vector<std::pair<std::string, u_int64_t>> debugger::get_ram_vct()
+const std::vector<scan_candidate> &debugger::get_scan_candidates()
 {
-    std::vector<std::pair<std::string, u_int64_t>> m_ram_vct;
-    for (const auto &rd : g_register_descriptors)
+    if (m_scan_rows_scan == m_scanner.scans())
+        return m_scan_rows;
+    m_scan_rows_scan = m_scanner.scans();
+    m_scan_rows.clear();
+    std::size_t n = std::min(m_scanner.size(), max_scan_rows);
+    for (std::size_t i = 0; i < n; ++i)
     {
-        m_ram_vct.push_back(std::make_pair(rd.name, get_register_value(m_pid, rd.r)));
+        uint64_t address = m_scanner.address(i);
+        const auto *region = m_scanner.region_of(address);
+        m_scan_rows.push_back(scan_candidate{address, m_scanner.format(i), region ? describe_address(address, *region) : std::string{}});
     }
-    return m_ram_vct;
-};
+    return m_scan_rows;
+}
 
-unsigned debugger::get_src_line()
+void debugger::print_scan(const std::string &args)
 {
-    auto line_entry = get_line_entry_from_pc(get_offset_pc());
-    return line_entry->line;
+    std::string error;
+    if (!scan_values(args, error))
+    {
+        std::cout << error << std::endl;
+        return;
+    }
+    std::cout << std::dec << m_scanner.size() << (m_scanner.size() == 1 ? " candidate" : " candidates")
+              << (m_scanner.truncated() ? " (limit reached)" : "") << " after scan " << m_scanner.scans() << ": "
+              << m_scanner.spans() << " reads, " << m_scanner.bytes_read() / 1024 << " KiB in "
+              << std::fixed << std::setprecision(3) << m_scanner.seconds() << "s" << std::defaultfloat << std::setprecision(6) << std::endl;
+    if (m_scanner.size() <= 20)
+        print_scan_candidates(20);
 }
 
-uint64_t debugger::get_pc()
+void debugger::print_scan_candidates(std::size_t limit)
 {
-    return get_register_value(m_pid, reg::rip);
-};
+    const auto &rows = get_scan_candidates();
+    std::size_t n = std::min(rows.size(), limit);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::cout << "0x" << std::hex << std::setw(16) << std::setfill('0') << rows[i].address << std::setfill(' ') << std::dec
+                  << " = " << rows[i].value << "  " << rows[i].where << std::endl;
+    }
+    if (m_scanner.size() > n)
+        std::cout << "(" << m_scanner.size() - n << " more)" << std::endl;
+}
 
-/**
-    * @brief 获取当前基址寄存器（RBP）的值。
-    * 
-    * @return uint64_t 当前基址寄存器（RBP）的值
-    */
-uint64_t debugger::get_rbp()
+const page_changes *debugger::memory_changes()
 {
-    return get_register_value(m_pid, reg::rbp);
+    if (m_changes_stop_id != m_stop_id)
+    {
+        m_changes_stop_id = m_stop_id;
+        m_changes = m_dirty.collect();
+        if (m_changes != nullptr && !m_changes->dirty.empty())
+        {
+            std::vector<uint64_t> merged;
+            merged.reserve(m_unseen_pages.size() + m_changes->dirty.size());
+            std::set_union(m_unseen_pages.begin(), m_unseen_pages.end(), m_changes->dirty.begin(), m_changes->dirty.end(),
+                           std::back_inserter(merged));
+            m_unseen_pages.swap(merged);
+            merged.clear();
+            std::set_union(m_watch_dirty.begin(), m_watch_dirty.end(), m_changes->dirty.begin(), m_changes->dirty.end(),
+                           std::back_inserter(merged));
+            m_watch_dirty.swap(merged);
+        }
+    }
+    return m_changes;
 }
 
-uint64_t debugger::get_rsp()
+const page_changes *debugger::cache_changes(std::size_t cached_pages)
 {
-    return get_register_value(m_pid, reg::rsp);
+    if (m_changes_stop_id == m_stop_id)
+        return m_changes;
+    // pagemap 每页8字节，跟踪的页数不超过缓存页数的64倍时，读 pagemap 的字节数不到重读缓存的八分之一
+    const uint64_t max_ratio = 64;
+    if (m_dirty.mode() != tracking_mode::soft_dirty || m_dirty.tracked_bytes() / dirty_tracker::page_size > cached_pages * max_ratio)
+        return nullptr;
+    return memory_changes();
 }
 
-std::vector<std::pair<uint64_t, std::string>> debugger::get_backtrace_vct()
+const std::vector<changed_range> &debugger::get_changed_memory()
 {
-    std::vector<std::pair<uint64_t, std::string>> backtrace_vct;
-
-    auto current_func = get_function_from_pc(get_pc());
-
-    // 结束地址为0表示没有找到有效的函数信息，可能已经到达了程序的起始位置
-    if (current_func.end_addr == 0)
-    {
-        return backtrace_vct;
-    }
-
-    // 将当前函数的起始地址和函数名加入回溯函数列表
-    backtrace_vct.push_back(std::make_pair(current_func.start_addr, current_func.function_name));
-
-    // 获取当前栈帧的帧指针（RBP寄存器的值）
-    auto frame_pointer = get_register_value(m_pid, reg::rbp);
-    auto return_address = read_memory(frame_pointer + 8);       // 读取返回地址，即上一级函数调用的地址
-
-    // 开始不断循环回溯，直到当前函数为main函数为止   
-    while (current_func.function_name != "main")
+    if (m_changed_rows_stop_id == m_stop_id)
+        return m_changed_rows;
+    const page_changes *changes = memory_changes();
+    m_changed_rows_stop_id = m_stop_id;
+    m_changed_rows.clear();
+    m_changed_pages = 0;
+    if (changes == nullptr)
+        return m_changed_rows;
+    // 这次查看用掉上次查看以来积累的页，本次停止内再看时直接用生成好的行
+    std::vector<uint64_t> pages;
+    pages.swap(m_unseen_pages);
+    // 被写过的页和映射表都按地址递增，一起向前推进
+    const auto &regions = m_dirty.regions();
+    auto region = regions.begin();
+    for (uint64_t page : pages)
     {
-        current_func = get_function_from_pc(return_address);
-        if (current_func.end_addr == 0)         // 检查获取到的函数信息是否有效
+        while (region != regions.end() && region->hi <= page)
+            ++region;
+        if (region == regions.end())
+            break;
+        if (page < region->lo || !region->writable)
+            continue;
+        ++m_changed_pages;
+        if (!m_changed_rows.empty() && m_changed_rows.back().hi == page && page != region->lo)
         {
-            return backtrace_vct;
+            m_changed_rows.back().hi += dirty_tracker::page_size;
+            continue;
         }
-        backtrace_vct.push_back(std::make_pair(current_func.start_addr, current_func.function_name));
+        if (m_changed_rows.size() < max_change_rows)
+            m_changed_rows.push_back(changed_range{page, page + dirty_tracker::page_size, describe_address(page, *region)});
+    }
+    return m_changed_rows;
+}
 
-        frame_pointer = read_memory(frame_pointer);         // 获取上一级函数的帧指针         
-        return_address = read_memory(frame_pointer + 8);        //上一级函数的返回地址，即再上一级函数的地址        
+void debugger::print_changes()
+{
+    const auto &rows = get_changed_memory();
+    if (m_changes == nullptr)
+    {
+        std::cout << "no process to track" << std::endl;
+        return;
+    }
+    std::cout << std::dec << m_changed_pages << (m_changed_pages == 1 ? " page" : " pages") << " written since last look ("
+              << (m_dirty.mode() == tracking_mode::soft_dirty ? "soft-dirty bits" : "page hashes") << ", "
+              << m_dirty.bytes_read() / 1024 << " KiB read in " << std::fixed << std::setprecision(3) << m_dirty.seconds() * 1000
+              << " ms)" << std::defaultfloat << std::setprecision(6) << std::endl;
+    for (const auto &row : rows)
+    {
+        std::cout << "0x" << std::hex << std::setw(16) << std::setfill('0') << row.lo << "-0x" << std::setw(16) << row.hi
+                  << std::setfill(' ') << std::dec << "  " << std::setw(8) << row.hi - row.lo << "  " << row.where << std::endl;
     }
-    return backtrace_vct;
 }
 
-std::vector<std::pair<uint64_t, std::vector<uint8_t>>> debugger::get_global_stack_vct(uint64_t start_addr, uint64_t end_addr)
+bool debugger::resolve_view_address(const std::string &text, uint64_t &address, std::string &error)
 {
-    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> global_stack_vct;    // 存储全局堆栈信息的向量，每个元素为一个地址和对应的字节向量        
-    
-    // 以8字节为单位遍历内存区域，读取每个地址处的数据，将其转换为字节向量存储起来
-    for (auto i = start_addr; i < end_addr; i += 8)
+    if (evaluate_address(text, address, error))
+        return true;
+    // 函数名等不能作为表达式求值的符号
+    for (const auto &sym : symboltype::lookup_symbol(text, m_elf))
     {
-        uint64_t temp_data = read_memory(i);        // 读取内存地址处的数据
-        std::vector<uint8_t> temp_byte_vct(8);          // 存储当前地址处数据的字节向量
+        if (sym.addr == 0)
+            continue;
+        address = sym.addr + m_load_address;
+        error.clear();
+        return true;
+    }
+    return false;
+}
 
-        // 提取uint64_t的每一个字节并存储到字节向量中
-        for (auto j = 0; j < 8; ++j)
+void debugger::view_memory(uint64_t addr, std::size_t len, std::vector<uint8_t> &bytes, std::vector<uint8_t> &valid)
+{
+    bytes.assign(len, 0);
+    valid.assign(len, 0);
+    std::size_t done = 0;
+    while (done < len)
+    {
+        uint64_t cur = addr + done;
+        std::size_t n = std::min<std::size_t>(len - done, stop_state::page_size - (cur & (stop_state::page_size - 1)));
+        if (m_stop_state.readable(cur, n))
         {
-            temp_byte_vct[j] = static_cast<uint8_t>((temp_data >> (8 * j)) & 0xff);
+            std::size_t got = m_stop_state.read(cur, bytes.data() + done, n);
+            std::fill(valid.begin() + done, valid.begin() + done + got, 1);
         }
-
-        // 将当前地址和对应的字节向量存储为一对键值对，并加入全局堆栈信息的向量中
-        global_stack_vct.push_back(std::make_pair(i, temp_byte_vct));
+        done += n;
     }
-    
-    return global_stack_vct;
 }
 
-
-debugger::debugger()
+const std::vector<memory_region> &debugger::view_regions()
 {
+    if (m_view_stop_id != m_stop_id)
+    {
+        m_view_stop_id = m_stop_id;
+        m_view_regions = memory_search::read_maps(m_pid);
+    }
+    return m_view_regions;
 }
 
-void debugger::initDbg(std::string prog_name, pid_t pid)
+std::string debugger::describe_view_address(uint64_t address)
 {
-    // 清理旧的调试状态
-    m_breakpoints.clear(); // 清除所有的断点
-    m_prog_name = std::move(prog_name);
-    m_pid = pid;
-    m_asm_name = m_prog_name + ".asm";
-    auto fd = open(m_prog_name.c_str(), O_RDONLY);
-    m_elf = elf::elf{elf::create_mmap_loader(fd)};
-    m_dwarf = dwarf::dwarf{dwarf::elf::create_loader(m_elf)};
-
-    // 等待目标进程发送信号
-    wait_for_signal();
-    // 初始化加载地址
-    initialise_load_address();
-    // 运行objdump获取汇编信息，加载源代码和汇编信息
-    initialise_run_objdump();
-    initialise_load_asm();
-    initialise_load_src();
+    const auto &regions = view_regions();
+    auto next = std::upper_bound(regions.begin(), regions.end(), address,
+                                 [](uint64_t v, const memory_region &r) { return v < r.lo; });
+    if (next == regions.begin() || address >= std::prev(next)->hi)
+        return std::string{};
+    return describe_address(address, *std::prev(next));
+}
 
-    std::cout << "初始化minidbg成功\n";
+bool debugger::adjacent_view_region(uint64_t address, bool forward, uint64_t &target)
+{
+    const auto &regions = view_regions();
+    if (forward)
+    {
+        for (const auto &r : regions)
+        {
+            if (r.readable && r.lo > address)
+            {
+                target = r.lo;
+                return true;
+            }
+        }
+        return false;
+    }
+    for (auto r = regions.rbegin(); r != regions.rend(); ++r)
+    {
+        if (r->readable && r->lo < address)
+        {
+            target = r->lo;
+            return true;
+        }
+    }
+    return false;
 }
 
-void debugger::continue_execution()
+void debugger::print_follow(const std::string &expression, const std::vector<std::string> &fields, std::size_t limit)
 {
-    step_over_breakpoint();
-    ptrace(PTRACE_CONT, m_pid, nullptr, nullptr);
-    wait_for_signal();
+    auto result = follow(expression, fields, limit);
+    if (!result.error.empty())
+    {
+        std::cout << result.error << std::endl;
+        return;
+    }
+    if (result.nodes.empty())
+    {
+        std::cout << "(" << m_types.type_name(result.type) << " *) 0x0" << std::endl;
+        return;
+    }
+    for (std::size_t i = 0; i < result.nodes.size(); ++i)
+    {
+        const auto &node = result.nodes[i];
+        std::cout << "#" << std::dec << i;
+        if (node.parent >= 0)
+            std::cout << " (#" << node.parent << "->" << result.fields[node.field] << ")";
+        std::cout << " 0x" << std::hex << node.address << " = " << node.value << std::endl;
+    }
+    std::cout << std::dec << result.nodes.size() << " nodes in " << result.levels << " levels, " << result.reads << " batched reads";
+    if (result.truncated)
+        std::cout << ", stopped at the limit of " << limit << " nodes";
+    std::cout << std::endl;
+    for (const auto &link : result.back_links)
+    {
+        std::cout << "#" << link.first << " links back to #" << link.second << std::endl;
+    }
 }
 
-void debugger::break_execution(std::string command)
+void debugger::set_breakpoint_condition(int id, const std::string &text)
 {
+    if (m_breakpoints.get(id) == nullptr)
+    {
+        std::cout << "no breakpoint number " << id << std::endl;
+        return;
+    }
+    if (text.empty())
+    {
+        m_conditions.erase(id);
+        std::cout << "Breakpoint " << id << " now unconditional." << std::endl;
+        return;
+    }
+    m_conditions[id] = scoped_expr(text);
+}
 
-    // 0x<hexadecimal> -> address breakpoint
-    // <filename>:<line> -> line number breakpoint
-    // <anything else> -> function name breakpoint
-    if (command[0] == '0' && command[1] == 'x')
+bool debugger::breakpoint_condition_holds(uint64_t pc)
+{
+    if (m_conditions.empty())
+        return true;
+    auto site = m_breakpoints.find(pc);
+    if (site == nullptr)
+        return true;        // 不是停在断点上
+    std::vector<scoped_expr *> conditions;
+    uint32_t users = 0;
+    for (const auto &bp : m_breakpoints.logical())
     {
-        std::string addr{command, 2}; // naively assume that the user has written 0xADDRESS like 0xff
-        set_breakpoint_at_address(std::stol(addr, 0, 16) + m_load_address);
+        if (std::find(bp.addrs.begin(), bp.addrs.end(), static_cast<std::intptr_t>(pc)) == bp.addrs.end())
+            continue;
+        ++users;
+        auto it = m_conditions.find(bp.id);
+        if (it == m_conditions.end())
+            return true;    // 无条件断点
+        conditions.push_back(&it->second);
     }
-    else if (command.find(':') != std::string::npos)
+    // 引用计数多于逻辑断点数说明还有 step over、finish 的临时断点
+    if (conditions.empty() || site->refcount > users)
+        return true;
+
+    frame_scope_info scope;
+    if (!frame_scope(0, scope))
     {
-        auto file_and_line = utility::split(command, ':');
-        set_breakpoint_at_source_file(file_and_line[0], std::stoi(file_and_line[1]));
+        std::cout << "Error in testing breakpoint condition: no symbol table info available." << std::endl;
+        return true;
     }
-    else
+    ptrace_expr_context context(m_stop_state, m_load_address, &scope.regs, scope.subprogram);
+    expr_env env;
+    env.locate = [&](const dwarf::die &var, value_ref &out) { return locate(context, scope, var, out); };
+    env.memory = &m_stop_state;
+    for (auto condition : conditions)
     {
-        set_breakpoint_at_function(command);
+        const auto &expr = compiled(*condition, scope);
+        std::string error;
+        if (!expr.valid())
+            error = expr.error();
+        else if (expr.test(env, error))
+            return true;
+        if (!error.empty())
+        {
+            std::cout << "Error in testing condition \"" << condition->text() << "\": " << error << std::endl;
+            return true;
+        }
     }
+    return false;
 }
 
-void debugger::next_execution()
+const global_table &debugger::get_globals()
 {
-    step_over();
+    if (m_globals_stop_id != m_stop_id)
+    {
+        m_globals_stop_id = m_stop_id;
+        m_globals.refresh(m_load_address);
+    }
+    return m_globals;
 }
 
-void debugger::finish_execution()
+void debugger::print_globals()
 {
-    step_out();
+    const auto &globals = get_globals();
+    const auto &vars = globals.variables();
+    for (const auto &unit : globals.units())
+    {
+        std::cout << "File " << unit.name << ":" << std::endl;
+        for (std::size_t i = unit.first; i < unit.first + unit.count; ++i)
+        {
+            std::cout << (vars[i].is_static ? "static " : "") << vars[i].type << " " << vars[i].name << " = " << vars[i].value << std::endl;
+        }
+    }
 }
 
-void debugger::step_into_execution()
+int debugger::add_watch(const std::string &expression)
 {
-    step_in();
+    m_watches.push_back(watch_entry{m_next_watch, scoped_expr(expression)});
+    m_watches_stop_id = 0;      // 其余监视的字节未变，重新求值时只格式化新加的一个
+    return m_next_watch++;
 }
 
-void debugger::si_execution()
+bool debugger::remove_watch(int id)
 {
-    single_step_instruction_with_breakpoint_check();
+    auto it = std::find_if(m_watches.begin(), m_watches.end(), [id](const watch_entry &w) { return w.id == id; });
+    if (it == m_watches.end())
+        return false;
+    m_watches.erase(it);
+    return true;
 }
 
-void debugger::handle_sigtrap(siginfo_t info)
+const std::vector<watch_entry> &debugger::get_watches()
 {
-    switch (info.si_code)
+    if (m_watches.empty() || (m_watches_stop_id == m_stop_id && m_watches_frame == m_selected_frame))
+        return m_watches;
+    m_watches_stop_id = m_stop_id;
+    m_watches_frame = m_selected_frame;
+
+    std::vector<value_ref> roots(m_watches.size());
+    std::vector<std::pair<uint64_t, std::size_t>> ranges;
+    frame_scope_info scope;
+    std::string scope_error;
+    try
     {
-    case SI_KERNEL:
-    case TRAP_BRKPT:
+        if (!frame_scope(m_selected_frame, scope))
+            scope_error = "Error: No debugging information for the selected frame.";
+    }
+    catch (const std::exception &e)
     {
-        auto nowpc = get_pc();
-        set_pc(nowpc - 1);
-        nowpc--;
-        return;
+        scope_error = std::string("Error: ") + e.what();
     }
-    case TRAP_TRACE:
-        std::cout << "get signal trap_trace" << std::endl;
-        return;
-    default:
-        std::cout << "unknow sigtrap code" << info.si_code << std::endl;
-        return;
+    // 寄存器未变时，上次读过的页都没有被写过的监视直接沿用上次的结果。采集被写过的页比重读这些页贵时不采集，全部重新求值
+    auto same_registers = [](const unwind_frame &a, const unwind_frame &b) {
+        if (a.pc != b.pc || a.cfa != b.cfa || a.valid != b.valid || a.exact_pc != b.exact_pc || a.innermost != b.innermost)
+            return false;
+        for (unsigned r = 0; r < cfi_n_regs; ++r)
+        {
+            if (a.has(r) && a.regs[r] != b.regs[r])
+                return false;
+        }
+        return true;
+    };
+    bool regs_same = scope_error.empty() && m_watch_resets == m_stop_state.resets() && same_registers(scope.regs, m_watch_regs);
+    std::vector<uint64_t> known_pages;
+    for (const auto &w : m_watches)
+    {
+        if (w.pages_known)
+            known_pages.insert(known_pages.end(), w.pages.begin(), w.pages.end());
+    }
+    std::sort(known_pages.begin(), known_pages.end());
+    known_pages.erase(std::unique(known_pages.begin(), known_pages.end()), known_pages.end());
+    const page_changes *changes = nullptr;
+    if (regs_same && !known_pages.empty())
+        changes = cache_changes(known_pages.size());
+    else if (m_changes_stop_id == m_stop_id)
+        changes = m_changes;
+    auto unchanged = [&](const watch_entry &w) {
+        if (!regs_same || !w.pages_known || w.value.empty() || m_values.indirect(w.root) || (changes == nullptr && !w.pages.empty()))
+            return false;
+        for (uint64_t page : w.pages)
+        {
+            auto range = std::upper_bound(changes->tracked.begin(), changes->tracked.end(), page,
+                                          [](uint64_t v, const std::pair<uint64_t, uint64_t> &r) { return v < r.first; });
+            if (range == changes->tracked.begin() || page + dirty_tracker::page_size > std::prev(range)->second
+                || std::binary_search(m_watch_dirty.begin(), m_watch_dirty.end(), page))
+                return false;
+        }
+        return true;
+    };
+    std::vector<bool> skip(m_watches.size());
+    std::vector<std::vector<uint64_t>> previous(m_watches.size());     // 字节未变时不再格式化，格式化读过的页仍要算上
+    for (std::size_t i = 0; i < m_watches.size(); ++i)
+    {
+        skip[i] = unchanged(m_watches[i]);
+        if (!skip[i])
+            previous[i].swap(m_watches[i].pages);
+    }
+    // 本次停止采集过，m_watch_dirty 之后从这次采集算起
+    if (changes != nullptr)
+        m_watch_dirty.clear();
+    if (scope_error.empty())
+    {
+        m_watch_regs = scope.regs;
+        m_watch_resets = m_stop_state.resets();
     }
-};
 
-uint64_t debugger::offset_load_address(uint64_t addr)
-{
-    return addr - m_load_address;
-}
+    if (scope_error.empty())
+    {
+        // 作用域未变的监视直接使用已编译的表达式
+        ptrace_expr_context context(m_stop_state, m_load_address, &scope.regs, scope.subprogram);
+        for (std::size_t i = 0; i < m_watches.size(); ++i)
+        {
+            if (skip[i])
+                continue;
+            auto &w = m_watches[i];
+            auto &root = roots[i];
+            m_stop_state.log_pages(&w.pages);
+            const auto &expr = compiled(w.expr, scope);
+            if (!expr.valid())
+                root.error = "Error: " + expr.error();
+            else if ((root = evaluate(expr, scope, context)).error.empty() && root.in_memory)
+                ranges.emplace_back(root.address, m_values.summary_size(root));
+            m_stop_state.log_pages(nullptr);
+        }
+    }
+    else
+    {
+        for (auto &root : roots)
+            root.error = scope_error;
+    }
 
-uint64_t debugger::offset_dwarf_address(uint64_t addr)
-{
-    return addr + m_load_address;
+    // 所有监视涉及的页一次批量读入，之后逐个与上次读到的字节比较
+    m_stop_state.prefetch(ranges);
+    std::vector<uint8_t> raw;
+    for (std::size_t i = 0; i < m_watches.size(); ++i)
+    {
+        auto &w = m_watches[i];
+        if (skip[i])
+        {
+            w.changed = false;
+            continue;
+        }
+        auto &root = roots[i];
+        root.label = w.expr.text();
+        m_stop_state.log_pages(&w.pages);
+        raw.clear();
+        if (root.error.empty() && root.in_memory)
+        {
+            raw.resize(m_values.summary_size(root));
+            raw.resize(m_stop_state.readable(root.address, raw.size()) ? m_stop_state.read(root.address, raw.data(), raw.size()) : 0);
+        }
+        else if (root.error.empty())
+        {
+            auto word = reinterpret_cast<const uint8_t *>(&root.word);
+            raw.assign(word, word + sizeof(root.word));
+        }
+        // 容器的元素在值本身以外，字节相同也要重新显示
+        bool same = !w.value.empty() && !m_values.indirect(root) && root.error == w.root.error && root.type == w.root.type && root.dim == w.root.dim
+                    && root.in_memory == w.root.in_memory && root.address == w.root.address
+                    && root.bit_offset == w.root.bit_offset && root.bit_size == w.root.bit_size && raw == w.raw;
+        if (same)
+        {
+            w.changed = false;
+            w.pages.insert(w.pages.end(), previous[i].begin(), previous[i].end());
+        }
+        else
+        {
+            auto value = m_values.summary(root);
+            w.changed = !w.value.empty() && value != w.value;
+            w.value = std::move(value);
+            w.raw.swap(raw);
+        }
+        m_stop_state.log_pages(nullptr);
+        std::sort(w.pages.begin(), w.pages.end());
+        w.pages.erase(std::unique(w.pages.begin(), w.pages.end()), w.pages.end());
+        w.pages_known = scope_error.empty();
+        w.root = std::move(root);
+    }
+    return m_watches;
 }
 
-uint64_t debugger::get_offset_pc()
+void debugger::print_watches()
 {
-    return offset_load_address(get_pc());
+    for (const auto &w : get_watches())
+    {
+        std::cout << std::dec << w.id << (w.changed ? "* " : ": ") << w.expr.text() << " = " << w.value << std::endl;
+    }
 }
 
-uint64_t debugger::read_memory(uint64_t address)
-{
-    return ptrace(PTRACE_PEEKDATA, m_pid, address, nullptr);
-};
-
-void debugger::write_memory(uint64_t address, uint64_t value)
+const std::vector<frame_variable> &debugger::get_frame_variables()
 {
-    ptrace(PTRACE_POKEDATA, m_pid, address, value);
-};
+    if (m_locals_stop_id == m_stop_id && m_locals_frame == m_selected_frame)
+        return m_locals;
+    m_locals_stop_id = m_stop_id;
+    m_locals_frame = m_selected_frame;
+    m_locals.clear();
+
+    frame_scope_info scope;
+    if (!frame_scope(m_selected_frame, scope))
+        return m_locals;
+    const auto &visible = m_scopes.frame_variables(scope.function, scope.pc);
+    std::vector<dwarf::die> dies;
+    dies.reserve(visible.size());
+    for (const auto &var : visible)
+        dies.push_back(var.die);
+    std::vector<std::string> values;
+    materialize(scope, dies, values);
+    for (std::size_t i = 0; i < visible.size(); ++i)
+        m_locals.push_back(frame_variable{visible[i].name, visible[i].kind == scope_kind::parameter, values[i]});
+    return m_locals;
+}
 
-void debugger::set_breakpoint_at_address(std::intptr_t addr)
+void debugger::print_frame_variables(bool parameters)
 {
-    // std::cout << "set breakpoint at address 0x" << std::hex << addr << std::endl;
-    breakpoint bp(m_pid, addr);
-    bp.enable();
-    m_breakpoints[addr] = bp;
-};
+    frame_scope_info scope;
+    if (!frame_scope(m_selected_frame, scope))
+    {
+        std::cout << "No symbol table info available." << std::endl;
+        return;
+    }
+    bool any = false;
+    for (const auto &var : get_frame_variables())
+    {
+        if (var.parameter != parameters)
+            continue;
+        any = true;
+        std::cout << var.name << " = " << var.value << std::endl;
+    }
+    if (!any)
+        std::cout << (parameters ? "No arguments." : "No locals.") << std::endl;
+}
 
-void debugger::dump_registers()
-{
-    for (const auto &rd : g_register_descriptors)
-    {                                                           // 最小宽度为 16 个字符
-        std::cout << rd.name << "  0x" << std::setfill('0') << std::setw(16) << std::hex << get_register_value(m_pid, rd.r) << std::endl;
+std::string debugger::read_variable(const std::string& var_name) {
+    try {
+        frame_scope_info scope;
+        if (!frame_scope(m_selected_frame, scope)) {
+            return "Error: No debugging information for the selected frame.";
+        }
+        // 局部变量由内向外、参数、本编译单元的静态变量、全局变量，同名时内层遮蔽外层
+        auto var = m_scopes.lookup(scope.function, scope.pc, var_name);
+        if (var != nullptr) {
+            std::vector<std::string> values;
+            materialize(scope, {var->die}, values);
+            return values[0];
+        }
+        return "Error: Variable not found.";
+    } catch (const std::exception& e) {
+        // 处理所有预期之外的异常，并记录足够的信息来修复bug
+        std::stringstream ss;
+        ss << "read_variable(): exception: " << e.what();
+        ss << "Variable name: " << var_name << ", ";
+        ss << "PID: " << m_pid << ", Load Address: " << std::hex << m_load_address << "\n\n";
+        // 输出异常信息到标准错误
+        std::cerr << ss.str();
+        // 返回明确的错误消息
+        return "Error: An exception occurred while reading variable.";
     }
-};
+}
 
-void debugger::set_pc(uint64_t pc)
-{
-    set_register_value(m_pid, reg::rip, pc);
-};
 
-void debugger::wait_for_signal()
+void debugger::handle_command(const std::string &line)
 {
-    int wait_status;
-    auto options = 0;
-    // 将状态信息存储到 wait_status 中
-    waitpid(m_pid, &wait_status, options);
-    auto siginfo = get_signal_info();
+    std::vector<std::string> args = utility::split(line, ' ');
+    std::string command = args[0];
 
-    switch (siginfo.si_signo)
+    if (utility::is_prefix(command, "break"))
+    {
+        auto count = m_breakpoints.logical().size();
+        if (args[1][0] == '0' && args[1][1] == 'x')
+        {
+            std::string addr{args[1], 2}; // naively assume that the user has written 0xADDRESS like 0xff
+            set_breakpoint_at_address(std::stol(addr, 0, 16) + m_load_address);
+        }
+        else if (args[1].find(':') != std::string::npos)
+        {
+            auto file_and_line = utility::split(args[1], ':');
+            set_breakpoint_at_source_file(file_and_line[0], std::stoi(file_and_line[1]));
+        }
+        else
+        {
+            set_breakpoint_at_function(args[1]);
+        }
+        // break <位置> if <条件>
+        auto cond = line.find(" if ");
+        if (cond != std::string::npos && args.size() > 3 && args[2] == "if" && m_breakpoints.logical().size() > count)
+        {
+            set_breakpoint_condition(m_breakpoints.logical().back().id, line.substr(cond + 4));
+        }
+    }
+    else if (command == "rbreak" && args.size() > 1)
+    {
+        set_breakpoint_at_regex(args[1]);
+    }
+    else if (command == "trace")
+    {
+        set_tracepoint(args);
+    }
+    else if (command == "tstatus")
+    {
+        m_tracepoints.drain();
+        for (const auto &tp : m_tracepoints.list())
+        {
+            std::cout << std::dec << "tracepoint " << tp.id << " at 0x" << std::hex << tp.addr
+                      << " (" << tp.spec << "), hits: " << std::dec << tp.hits << std::endl;
+        }
+        std::cout << "lost records: " << std::dec << m_tracepoints.lost() << std::endl;
+    }
+    else if (command == "tdump")
+    {
+        std::size_t n = 20;
+        if (args.size() > 1 && !utility::parse_size(args[1], n))
+        {
+            std::cout << "usage: tdump [count]" << std::endl;
+            return;
+        }
+        m_tracepoints.drain();
+        for (const auto &rec : m_tracepoints.recent(n))
+        {
+            std::cout << std::dec << "#" << rec.seq << " tp" << rec.id << std::hex;
+            for (std::size_t i = 0; i < n_trace_regs; ++i)
+            {
+                std::cout << " " << g_trace_reg_names[i] << "=0x" << rec.regs[i];
+            }
+            if (!rec.memory.empty())
+            {
+                std::cout << " mem=";
+                for (auto b : rec.memory)
+                {
+                    std::cout << std::setfill('0') << std::setw(2) << static_cast<unsigned>(b);
+                }
+            }
+            std::cout << std::dec << std::endl;
+        }
+    }
+    else if (command == "tdelete" && args.size() > 1)
+    {
+        int id;
+        if (!utility::parse_int(args[1], id) || !m_tracepoints.remove(id))
+        {
+            std::cout << "no tracepoint number " << args[1] << std::endl;
+        }
+    }
+    else if (utility::is_prefix(command, "delete") && args.size() > 2 && args[1] == "checkpoint")
+    {
+        int id = -1;
+        utility::parse_int(args[2], id);
+        auto it = std::find_if(m_checkpoints.begin(), m_checkpoints.end(),
+                               [id](const checkpoint &cp) { return cp.id == id; });
+        if (it == m_checkpoints.end())
+        {
+            std::cout << "no checkpoint number " << args[2] << std::endl;
+        }
+        else
+        {
+            kill(it->pid, SIGKILL);
+            waitpid(it->pid, nullptr, __WALL);
+            m_checkpoints.erase(it);
+        }
+    }
+    else if (utility::is_prefix(command, "delete") && args.size() > 1)
+    {
+        int id;
+        if (!utility::parse_int(args[1], id) || !m_breakpoints.remove(id))
+        {
+            std::cout << "no breakpoint number " << args[1] << std::endl;
+        }
+        else
+        {
+            m_conditions.erase(id);
+        }
+    }
+    else if ((command == "print" || command == "p") && args.size() > 1)
+    {
+        print_expression(line.substr(line.find(' ') + 1));
+    }
+    else if (command == "condition" && args.size() > 1)
+    {
+        int id;
+        auto begin = line.find_first_not_of(' ', line.find(args[1], command.size()) + args[1].size());
+        if (utility::parse_int(args[1], id))
+            set_breakpoint_condition(id, begin == std::string::npos ? std::string{} : line.substr(begin));
+        else
+            std::cout << "no breakpoint number " << args[1] << std::endl;
+    }
+    else if ((command == "follow" || command.rfind("follow/", 0) == 0) && args.size() > 2)
+    {
+        // follow[/N] 成员[,成员...] 表达式
+        std::size_t limit = chain_walker::default_limit;
+        if (command.size() > 6 && !utility::parse_size(command.substr(7), limit))
+        {
+            std::cout << "usage: follow[/N] member[,member...] expression" << std::endl;
+            return;
+        }
+        std::vector<std::string> fields;
+        std::stringstream list(args[1]);
+        std::string field;
+        while (std::getline(list, field, ','))
+        {
+            if (!field.empty())
+                fields.push_back(field);
+        }
+        auto begin = line.find_first_not_of(' ', line.find(args[1], command.size()) + args[1].size());
+        print_follow(line.substr(begin), fields, limit);
+    }
+    else if (command == "inspect" && args.size() > 1 && args[1] == "find")
+    {
+        // inspect find 条件 [值] [起始下标]，条件为 == != < <= > >= nan inf !finite
+        static const std::pair<const char *, array_predicate> predicates[] = {
+            {"==", array_predicate::eq}, {"!=", array_predicate::ne}, {"<", array_predicate::lt}, {"<=", array_predicate::le},
+            {">", array_predicate::gt}, {">=", array_predicate::ge}, {"nan", array_predicate::nan}, {"inf", array_predicate::inf},
+            {"!finite", array_predicate::not_finite}};
+        const auto &array = get_array();
+        auto it = args.size() > 2 ? std::find_if(std::begin(predicates), std::end(predicates), [&](const std::pair<const char *, array_predicate> &p) { return args[2] == p.first; })
+                                  : std::end(predicates);
+        if (!array.loaded())
+        {
+            std::cout << (m_array_expr.empty() ? "No array is being inspected." : array.error()) << std::endl;
+        }
+        else if (it == std::end(predicates))
+        {
+            std::cout << "usage: inspect find ==|!=|<|<=|>|>=|nan|inf|!finite [value] [from]" << std::endl;
+        }
+        else
+        {
+            bool takes_value = it->second != array_predicate::nan && it->second != array_predicate::inf && it->second != array_predicate::not_finite;
+            std::size_t next = takes_value ? 4 : 3;
+            double operand = takes_value && args.size() > 3 ? std::stod(args[3]) : 0;
+            uint64_t from = args.size() > next ? std::stoull(args[next]) : 0;
+            auto index = array.find(it->second, operand, from);
+            if (index < 0)
+                std::cout << "No element matches." << std::endl;
+            else
+                std::cout << "[" << index << "] = " << array.format(static_cast<uint64_t>(index)) << std::endl;
+        }
+    }
+    else if ((command == "inspect" || command.rfind("inspect/", 0) == 0) && (args.size() > 1 || !m_array_expr.empty()))
+    {
+        // inspect[/N] 表达式；不带表达式时重新显示当前数组
+        if (args.size() > 1)
+            inspect_array(line.substr(line.find(' ') + 1), command.size() > 8 ? std::stoull(command.substr(8)) : 0);
+        print_array();
+    }
+    else if ((command == "find" || command.rfind("find/", 0) == 0) && args.size() > 1)
+    {
+        // find[/N] [起始, 结束|+长度,] 模式
+        std::size_t limit = memory_search::default_limit;
+        if (command.size() > 4 && !utility::parse_size(command.substr(5), limit))
+            std::cout << "usage: find[/N] [start, end|+length,] pattern" << std::endl;
+        else
+            print_find(line.substr(line.find(' ') + 1), limit);
+    }
+    else if (command == "scan" && args.size() > 1 && args[1] == "list")
+    {
+        print_scan_candidates(args.size() > 2 ? std::stoul(args[2]) : 20);
+    }
+    else if (command == "scan" && args.size() > 1 && args[1] == "reset")
+    {
+        reset_scan();
+    }
+    else if (command == "scan" && args.size() > 1)
+    {
+        // scan 类型 条件 值：新的一轮；scan 条件 [值]：在候选中筛选
+        print_scan(line.substr(line.find(' ') + 1));
+    }
+    else if (command == "display" && args.size() > 1)
+    {
+        int id = add_watch(line.substr(line.find(' ') + 1));
+        for (const auto &w : get_watches())
+        {
+            if (w.id == id)
+                std::cout << std::dec << w.id << ": " << w.expr.text() << " = " << w.value << std::endl;
+        }
+    }
+    else if (command == "undisplay" && args.size() > 1)
+    {
+        int id;
+        if (!utility::parse_int(args[1], id) || !remove_watch(id))
+        {
+            std::cout << "no display number " << args[1] << std::endl;
+        }
+    }
+    else if (command == "record")
+    {
+        if (args.size() > 1 && args[1] == "stop")
+        {
+            print_record_info();
+            m_record.stop();
+        }
+        else
+        {
+            std::size_t cap_mb = 256;
+            if (args.size() > 1 && (!utility::parse_size(args[1], cap_mb) || cap_mb == 0 || cap_mb > (SIZE_MAX >> 20)))
+            {
+                std::cout << "usage: record [memory cap in MB] | record stop" << std::endl;
+            }
+            else
+            {
+                m_record.start(cap_mb << 20);
+                std::cout << std::dec << "recording, memory cap " << cap_mb << " MB" << std::endl;
+            }
+        }
+    }
+    else if (command == "reverse-stepi" || command == "rsi")
+    {
+        reverse_stepi_execution();
+    }
+    else if (command == "reverse-next" || command == "rn")
+    {
+        reverse_next_execution();
+    }
+    else if (command == "reverse-continue" || command == "rc")
+    {
+        reverse_continue_execution();
+    }
+    else if (command == "checkpoint")
+    {
+        checkpoint_execution();
+    }
+    else if (command == "restart" && args.size() > 1)
+    {
+        int id;
+        if (utility::parse_int(args[1], id))
+            restart_execution(id);
+        else
+            std::cout << "no checkpoint number " << args[1] << std::endl;
+    }
+    else if (command == "info" && args.size() > 1)
+    {
+        if (utility::is_prefix(args[1], "record"))
+        {
+            print_record_info();
+        }
+        else if (utility::is_prefix(args[1], "locals"))
+        {
+            print_frame_variables(false);
+        }
+        else if (utility::is_prefix(args[1], "args"))
+        {
+            print_frame_variables(true);
+        }
+        else if (utility::is_prefix(args[1], "globals"))
+        {
+            print_globals();
+        }
+        else if (utility::is_prefix(args[1], "display"))
+        {
+            print_watches();
+        }
+        else if (utility::is_prefix(args[1], "checkpoints"))
+        {
+            for (const auto &cp : m_checkpoints)
+            {
+                std::cout << std::dec << cp.id << "\tpid " << cp.pid << "\t0x" << std::hex << cp.pc
+                          << "\t" << cp.where << std::dec << std::endl;
+            }
+        }
+        else if (utility::is_prefix(args[1], "changes"))
+        {
+            print_changes();
+        }
+        else if (utility::is_prefix(args[1], "sharedlibrary"))
+        {
+            for (const auto &so : m_solibs.modules())
+            {
+                std::cout << "0x" << std::hex << so.start << "-0x" << so.end << " "
+                          << (so.dwarf.valid() ? "dwarf " : so.elf.valid() ? "elf   " : "      ")
+                          << so.name << std::dec << std::endl;
+            }
+        }
+        else if (utility::is_prefix(args[1], "breakpoints"))
+        {
+            for (const auto &bp : m_breakpoints.logical())
+            {
+                std::cout << std::dec << bp.id << "\t" << bp.spec;
+                if (bp.addrs.empty())
+                    std::cout << "\t<pending>";
+                for (auto addr : bp.addrs)
+                    std::cout << "\t0x" << std::hex << addr;
+                auto condition = m_conditions.find(bp.id);
+                if (condition != m_conditions.end())
+                    std::cout << "\tif " << condition->second.text();
+                std::cout << std::dec << std::endl;
+            }
+        }
+        else
+        {
+            std::cout << "unknow command for info: " << args[1] << std::endl;
+        }
+    }
+    else if(utility::is_prefix(command, "continue"))
+    {
+        continue_execution();
+    }
+    else if (utility::is_prefix(command, "register"))
+    {
+        if (utility::is_prefix(args[1], "dump"))
+        {
+            dump_registers();
+        }
+        else if (utility::is_prefix(args[1], "read"))
+        {
+            std::cout << get_register_value(m_pid, get_register_from_name(args[2])) << std::endl;
+        }
+        else if (utility::is_prefix(args[1], "write"))
+        {
+            std::string val{args[3], 2}; // assume 0xVALUE
+            set_register_value(m_pid, get_register_from_name(args[2]), std::stol(val, 0, 16));
+            note_stop();
+            std::cout << "write data " << args[3] << " into reg " << args[2] << " successfully\n";
+        }
+        else
+        {
+            std::cout << "unknow command for register\n";
+        }
+    }
+    else if (utility::is_prefix(command, "symbol"))
+    {
+        auto syms = symboltype::lookup_symbol(args[1], m_elf);
+        for (auto &s : syms)
+        {
+            std::cout << s.name << " " << symboltype::to_string(s.type) << " 0x" << std::hex << s.addr << std::endl;
+        }
+    }
+    else if (utility::is_prefix(command, "memory"))
+    {
+        std::string addr{args[2], 2}; // assume 0xADDRESS
+
+        if (utility::is_prefix(args[1], "read"))
+        {
+            std::cout << std::hex << read_memory(std::stol(addr, 0, 16)) << std::endl;
+        }
+        if (utility::is_prefix(args[1], "write"))
+        {
+            std::string val{args[3], 2}; // assume 0xVAL
+            write_memory(std::stol(addr, 0, 16), std::stol(val, 0, 16));
+        }
+    }
+    else if (utility::is_prefix(command, "si"))
+    {
+        single_step_instruction_with_breakpoint_check();
+        auto offset_pc = offset_load_address(get_pc());
+        auto line_entry = get_line_entry_from_pc(offset_pc);
+    }
+    else if (utility::is_prefix(command, "step"))
+    {
+        step_in();
+    }
+    else if (utility::is_prefix(command, "next"))
+    {
+        step_over();
+    }
+    else if (utility::is_prefix(command, "finish"))
+    {
+        step_out();
+    }
+    else if (utility::is_prefix(command, "backtrace") || command == "bt")
+    {
+        print_backtrace(args.size() > 1 ? std::stoul(args[1]) : 0);
+    }
+    else if (command == "frame")
+    {
+        std::size_t index = args.size() > 1 ? std::stoul(args[1]) : m_selected_frame;
+        auto frame = get_stack_frame(index);
+        if (frame == nullptr)
+        {
+            std::cout << std::dec << "no frame #" << index << ", the stack has " << get_stack_frames_known() << " frames" << std::endl;
+            return;
+        }
+        m_selected_frame = index;
+        std::cout << std::dec << "#" << index << "  0x" << std::hex << frame->pc << std::dec << " in "
+                  << get_backtrace_entry(index).second << (is_inlined_frame(index) ? " [inlined]" : "") << std::endl;
+    }
+    else if (utility::is_prefix(command, "ls"))
+    {
+
+        auto line_entry = get_line_entry_from_pc(get_offset_pc());
+        // print_source(line_entry->file->path, line_entry->line);
+        // print_asm(m_asm_name, get_offset_pc());
+    }
+    else
+    {
+        std::cerr << "unknow command\n";
+    }
+}
+
+
+
+
+/**
+    * @brief 终止被调试程序
+    * 
+    */
+bool debugger::kill_prog()
+{
+    discard_checkpoints();
+    if (ptrace(PTRACE_KILL, m_pid, NULL, NULL) == -1) {
+        std::cerr << "Failed to ptrace PTRACE_KILL." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+std::vector<std::pair<std::string, u_int64_t>> debugger::get_ram_vct()
+{
+    std::vector<std::pair<std::string, u_int64_t>> m_ram_vct;
+    for (const auto &rd : g_register_descriptors)
+    {
+        m_ram_vct.push_back(std::make_pair(rd.name, get_register_value(m_pid, rd.r)));
+    }
+    return m_ram_vct;
+};
+
+unsigned debugger::get_src_line()
+{
+    auto line_entry = get_line_entry_from_pc(get_offset_pc());
+    return line_entry->line;
+}
+
+uint64_t debugger::get_pc()
+{
+    return get_register_value(m_pid, reg::rip);
+};
+
+/**
+    * @brief 获取当前基址寄存器（RBP）的值。
+    * 
+    * @return uint64_t 当前基址寄存器（RBP）的值
+    */
+uint64_t debugger::get_rbp()
+{
+    return get_register_value(m_pid, reg::rbp);
+}
+
+uint64_t debugger::get_rsp()
+{
+    return get_register_value(m_pid, reg::rsp);
+}
+
+std::vector<std::pair<uint64_t, std::string>> debugger::get_backtrace_vct()
+{
+    std::vector<std::pair<uint64_t, std::string>> backtrace_vct;
+
+    // 按CFI逐帧回溯，不依赖rbp帧指针链，也不在main处截止
+    for (std::size_t i = 0; get_stack_frame(i); ++i)
+    {
+        backtrace_vct.push_back(get_backtrace_entry(i));
+    }
+    return backtrace_vct;
+}
+
+const unwind_frame *debugger::get_stack_frame(std::size_t i)
+{
+    if (!expand_frames(i))
+        return nullptr;
+    return get_physical_frame(m_frames[i].physical);
+}
+
+const unwind_frame *debugger::get_physical_frame(std::size_t p)
+{
+    if (m_stack_stop_id != m_stop_id)
+    {
+        m_frames.clear();
+        m_frames_physical = 0;
+        auto regs = m_stop_state.regs();
+        if (regs == nullptr)
+        {
+            m_unwinder.drop_stack();    // 进程已退出
+            return nullptr;
+        }
+        m_unwinder.begin_stack(*regs);
+        m_stack_stop_id = m_stop_id;
+    }
+    return m_unwinder.frame_at(p);
+}
+
+bool debugger::expand_frames(std::size_t i)
+{
+    if (get_physical_frame(0) == nullptr)
+        return false;
+    std::vector<int> chain;
+    while (m_frames.size() <= i)
+    {
+        auto frame = get_physical_frame(m_frames_physical);
+        if (frame == nullptr)
+            return false;
+        // 一个物理栈帧展开为其中的各层内联帧，最内层在前
+        inline_chain_at(frame->lookup_pc(), chain);
+        if (chain.empty())
+            m_frames.push_back(virtual_frame{m_frames_physical, -1});
+        for (int node : chain)
+            m_frames.push_back(virtual_frame{m_frames_physical, node});
+        ++m_frames_physical;
+    }
+    return true;
+}
+
+void debugger::inline_chain_at(uint64_t pc, std::vector<int> &out)
+{
+    out.clear();
+    if (m_solibs.module_for_pc(pc) == nullptr)
+        m_inlines.chain(offset_load_address(pc), out);
+}
+
+std::pair<uint64_t, std::string> debugger::get_backtrace_entry(std::size_t i)
+{
+    if (!expand_frames(i))
+        return std::make_pair(0, std::string{});
+    if (is_inlined_frame(i))
+    {
+        const auto &node = m_inlines.node(m_frames[i].inline_node);
+        return std::make_pair(node.entry + m_load_address, node.name);
+    }
+    auto frame = get_physical_frame(m_frames[i].physical);
+    auto pc = frame->lookup_pc();
+    auto it = m_symbol_cache.find(pc);
+    if (it == m_symbol_cache.end())
+    {
+        uint64_t start;
+        auto name = function_name_at(pc, start);
+        it = m_symbol_cache.emplace(pc, std::make_pair(start ? start : frame->pc, name)).first;
+    }
+    return it->second;
+}
+
+bool debugger::is_inlined_frame(std::size_t i)
+{
+    return expand_frames(i) && m_frames[i].inline_node >= 0 && m_inlines.node(m_frames[i].inline_node).inlined;
+}
+
+bool debugger::get_frame_location(std::size_t i, std::string &file, unsigned &line)
+{
+    if (!expand_frames(i))
+        return false;
+    // 同一物理栈帧中更内层的内联展开，其调用位置就是本帧正在执行的行
+    if (i > 0 && m_frames[i - 1].physical == m_frames[i].physical)
+    {
+        const auto &inner = m_inlines.node(m_frames[i - 1].inline_node);
+        if (inner.call_line == 0)
+            return false;
+        file = inner.call_file;
+        line = inner.call_line;
+        return true;
+    }
+    auto pc = get_physical_frame(m_frames[i].physical)->lookup_pc();
+    if (m_solibs.module_for_pc(pc))
+        return false;
+    try
+    {
+        auto entry = get_line_entry_from_pc(offset_load_address(pc));
+        file = entry->file->path;
+        line = entry->line;
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void debugger::note_stop()
+{
+    m_selected_frame = 0;
+    ++m_stop_id;
+    m_stop_state.next_stop();
+    m_search.cancel();          // 进程运行过，尚未扫描的内存已不属于这次查找
+}
+
+const elf::elf *debugger::unwind_module_for_pc(uint64_t pc, uint64_t &bias, uint64_t &lo, uint64_t &hi)
+{
+    // 主程序的范围取各 PT_LOAD 段的并集
+    uint64_t exe_lo = UINT64_MAX, exe_hi = 0;
+    for (const auto &seg : m_elf.segments())
+    {
+        const auto &hdr = seg.get_hdr();
+        if (hdr.type != elf::pt::load)
+            continue;
+        exe_lo = std::min<uint64_t>(exe_lo, hdr.vaddr + m_load_address);
+        exe_hi = std::max<uint64_t>(exe_hi, hdr.vaddr + hdr.memsz + m_load_address);
+    }
+    if (pc >= exe_lo && pc < exe_hi)
+    {
+        bias = m_load_address;
+        lo = exe_lo;
+        hi = exe_hi;
+        return &m_elf;
+    }
+
+    auto so = m_solibs.module_for_pc(pc);
+    if (so == nullptr || !m_solibs.load_elf(*so))
+        return nullptr;
+    bias = so->base;
+    lo = so->start;
+    hi = so->end;
+    return &so->elf;
+}
+
+std::string debugger::function_name_at(uint64_t pc, uint64_t &start)
+{
+    for (const auto &head : m_asm_vct)
+    {
+        if (pc >= head.start_addr && pc <= head.end_addr)
+        {
+            start = head.start_addr;
+            return head.function_name;
+        }
+    }
+    std::string name;
+    auto so = m_solibs.module_for_pc(pc);
+    if (so && m_solibs.symbolize(*so, pc, start, name))
+        return name;
+    start = 0;
+    return "??";
+}
+
+void debugger::print_backtrace(std::size_t limit)
+{
+    for (std::size_t i = 0; limit == 0 || i < limit; ++i)
+    {
+        auto frame = get_stack_frame(i);
+        if (frame == nullptr)
+            break;
+        std::cout << (i == m_selected_frame ? "*" : " ") << std::dec << "#" << std::left << std::setw(3) << i << std::right
+                  << "0x" << std::hex << std::setw(16) << std::setfill('0') << frame->pc << std::setfill(' ')
+                  << std::dec << " in " << get_backtrace_entry(i).second;
+        if (is_inlined_frame(i))
+            std::cout << " [inlined]";
+        std::string file;
+        unsigned line;
+        if (get_frame_location(i, file, line))
+        {
+            std::cout << " at " << file << ":" << line;
+        }
+        else
+        {
+            auto so = m_solibs.module_for_pc(frame->lookup_pc());
+            if (so)
+                std::cout << " from " << so->name;
+        }
+        std::cout << std::endl;
+    }
+    if (limit != 0 && get_stack_frame(limit))
+        std::cout << "(more stack frames follow...)" << std::endl;
+}
+
+std::vector<tracepoint> debugger::get_tracepoints()
+{
+    return m_tracepoints.list();
+}
+
+std::vector<trace_record> debugger::get_trace_records(std::size_t max_records)
+{
+    return m_tracepoints.recent(max_records);
+}
+
+uint64_t debugger::get_trace_lost()
+{
+    return m_tracepoints.lost();
+}
+
+
+debugger::debugger() : m_stop_state{m_memory, [this](std::size_t cached_pages) { return cache_changes(cached_pages); }}, m_dirty{m_memory}, m_breakpoints{m_memory}, m_tracepoints{m_memory}, m_solibs{m_memory}, m_solib_event{0}, m_wait_status{0}, m_pending_signal{0}, m_next_checkpoint{0}, m_start_checkpoint{-1},
+                       m_unwinder{m_memory, [this](uint64_t pc, uint64_t &bias, uint64_t &lo, uint64_t &hi) {
+                           return unwind_module_for_pc(pc, bias, lo, hi);
+                       }},
+                       m_selected_frame{0}, m_stop_id{1}, m_stack_stop_id{0}, m_values{m_types, m_stop_state},
+                       m_locals_stop_id{0}, m_locals_frame{0}, m_globals{m_memory, m_types}, m_globals_stop_id{0}, m_chains{m_stop_state, m_types}, m_array{m_memory, m_types}, m_array_count{0}, m_array_stop_id{0}, m_search{m_memory}, m_scanner{m_memory}, m_scan_rows_scan{0}, m_changes{nullptr}, m_changes_stop_id{0}, m_changed_pages{0}, m_changed_rows_stop_id{0}, m_view_stop_id{0}, m_next_watch{1}, m_watches_stop_id{0}, m_watches_frame{0}, m_watch_regs{}, m_watch_resets{0}, m_frames_physical{0}
+{
+}
+
+void debugger::initDbg(std::string prog_name, pid_t pid)
+{
+    // 清理旧的调试状态
+    discard_checkpoints(); // 检查点属于旧程序
+    m_breakpoints.clear(); // 清除所有的断点
+    m_tracepoints.reset(); // 追踪点属于旧进程
+    m_record.stop();       // 执行记录属于旧进程
+    m_unwinder.clear();    // CFI属于旧程序
+    m_symbol_cache.clear();
+    m_locations.clear();   // 位置表属于旧程序的DWARF
+    m_types.clear();       // 类型布局属于旧程序的DWARF
+    m_values.clear();
+    for (auto &w : m_watches)      // 编译形式绑定的变量和类型属于旧程序，保留表达式重新编译
+    {
+        w = watch_entry{w.id, scoped_expr(w.expr.text())};
+    }
+    m_watches_stop_id = 0;
+    for (auto &condition : m_conditions)
+    {
+        condition.second.clear();
+    }
+    m_search.cancel();         // 查找线程读取的是旧进程
+    m_search_hits.clear();
+    reset_scan();              // 候选地址属于旧进程
+    m_prog_name = std::move(prog_name);
+    m_pid = pid;
+    m_memory.attach(pid);
+    m_dirty.detach();          // 进程停下后再绑定，试写需要进程处于停止状态
+    m_stop_state.reset();
+    m_asm_name = m_prog_name + ".asm";
+    auto fd = open(m_prog_name.c_str(), O_RDONLY);
+    m_elf = elf::elf{elf::create_mmap_loader(fd)};
+    m_dwarf = dwarf::dwarf{dwarf::elf::create_loader(m_elf)};
+    m_inlines.reset(m_dwarf);  // 第一次查询内联链时才建立索引
+    m_scopes.reset(m_dwarf);   // 函数的作用域在第一次查找变量时建立
+    m_globals.reset(m_dwarf);  // 全局变量表在第一次显示时建立
+    m_globals_stop_id = 0;
+    m_array.clear();           // 数组在下次停止时按原表达式重新读取
+    m_array_stop_id = 0;
+
+    // 等待目标进程发送信号
+    wait_for_signal();
+    m_pending_signal = 0;
+    m_dirty.attach(m_pid);
+    m_unseen_pages.clear();
+    m_watch_dirty.clear();
+    // 初始化加载地址
+    initialise_load_address();
+    // 动态链接器此时尚未运行，共享库在其通知断点处陆续出现
+    m_pending_breakpoints.clear();
+    m_solib_event = 0;
+    m_solibs.reset(m_pid, m_elf, m_load_address);
+    install_solib_event_breakpoint();
+    // 运行objdump获取汇编信息，加载源代码和汇编信息
+    initialise_run_objdump();
+    initialise_load_asm();
+    initialise_load_src();
+
+    std::cout << "初始化minidbg成功\n";
+}
+
+void debugger::continue_execution()
+{
+    if (m_record.active())
+    {
+        record_continue();
+        return;
+    }
+    while (true)
+    {
+        step_over_breakpoint();
+        ptrace(PTRACE_CONT, m_pid, nullptr, reinterpret_cast<void *>(static_cast<intptr_t>(m_pending_signal)));
+        m_pending_signal = 0;
+        wait_for_signal();
+        if (!WIFSTOPPED(m_wait_status))
+            return;
+
+        install_solib_event_breakpoint();
+        auto pc = get_pc();
+        if (m_solib_event != 0 && pc == m_solib_event)
+        {
+            // 停在动态链接器的通知断点上：更新共享库后自动继续，除非用户也在这里设置了断点
+            handle_solib_event();
+            auto site = m_breakpoints.find(pc);
+            if (!site || site->refcount <= 1)
+                continue;
+        }
+        // 条件断点：条件为假时不停下
+        if (breakpoint_condition_holds(pc))
+            return;
+    }
+}
+
+void debugger::break_execution(std::string command)
+{
+
+    // 0x<hexadecimal> -> address breakpoint
+    // <filename>:<line> -> line number breakpoint
+    // <anything else> -> function name breakpoint
+    if (command[0] == '0' && command[1] == 'x')
+    {
+        std::string addr{command, 2}; // naively assume that the user has written 0xADDRESS like 0xff
+        set_breakpoint_at_address(std::stol(addr, 0, 16) + m_load_address);
+    }
+    else if (command.find(':') != std::string::npos)
+    {
+        auto file_and_line = utility::split(command, ':');
+        set_breakpoint_at_source_file(file_and_line[0], std::stoi(file_and_line[1]));
+    }
+    else
+    {
+        set_breakpoint_at_function(command);
+    }
+}
+
+void debugger::next_execution()
+{
+    step_over();
+}
+
+void debugger::finish_execution()
+{
+    step_out();
+}
+
+void debugger::step_into_execution()
+{
+    step_in();
+}
+
+void debugger::si_execution()
+{
+    single_step_instruction_with_breakpoint_check();
+}
+
+void debugger::handle_sigtrap(siginfo_t info)
+{
+    switch (info.si_code)
+    {
+    case SI_KERNEL:
+    case TRAP_BRKPT:
+    {
+        auto nowpc = get_pc();
+        set_pc(nowpc - 1);
+        nowpc--;
+        return;
+    }
+    case TRAP_TRACE:
+        std::cout << "get signal trap_trace" << std::endl;
+        return;
+    default:
+        std::cout << "unknow sigtrap code" << info.si_code << std::endl;
+        return;
+    }
+};
+
+uint64_t debugger::offset_load_address(uint64_t addr)
+{
+    return addr - m_load_address;
+}
+
+uint64_t debugger::offset_dwarf_address(uint64_t addr)
+{
+    return addr + m_load_address;
+}
+
+uint64_t debugger::get_offset_pc()
+{
+    return offset_load_address(get_pc());
+}
+
+uint64_t debugger::read_memory(uint64_t address)
+{
+    return ptrace(PTRACE_PEEKDATA, m_pid, address, nullptr);
+};
+
+void debugger::write_memory(uint64_t address, uint64_t value)
+{
+    ptrace(PTRACE_POKEDATA, m_pid, address, value);
+    m_stop_state.reset();
+};
+
+void debugger::set_breakpoint_at_address(std::intptr_t addr)
+{
+    std::stringstream spec;
+    spec << "0x" << std::hex << addr;
+    if (drop_traced_addresses({addr}).empty())
+        return;
+    int id = m_breakpoints.add({addr}, spec.str());
+    std::cout << std::dec << "breakpoint " << id << " at " << spec.str() << std::endl;
+};
+
+void debugger::dump_registers()
+{
+    for (const auto &rd : g_register_descriptors)
+    {                                                           // 最小宽度为 16 个字符
+        std::cout << rd.name << "  0x" << std::setfill('0') << std::setw(16) << std::hex << get_register_value(m_pid, rd.r) << std::endl;
+    }
+};
+
+void debugger::set_pc(uint64_t pc)
+{
+    set_register_value(m_pid, reg::rip, pc);
+};
+
+void debugger::wait_for_signal()
+{
+    auto options = 0;
+    // 将状态信息存储到 m_wait_status 中
+    waitpid(m_pid, &m_wait_status, options);
+    note_stop();
+    auto siginfo = get_signal_info();
+
+    switch (siginfo.si_signo)
+    {
+    case SIGTRAP:           // 遇到断点
+        handle_sigtrap(siginfo);
+        break;
+    case SIGSEGV:           // 段错误
+        std::cout << "sorry, segment fault . reason : " << siginfo.si_code << std::endl;
+        break;
+    default:
+        std::cout << "get signal  " << strsignal(siginfo.si_signo) << std::endl;
+        break;
+    }
+}
+
+void debugger::step_over_breakpoint()
+{
+    // 判断当前指令地址是否处于断点表中（二分查找，只查一次）
+    auto pc = get_pc();
+    auto site = m_breakpoints.find(pc);
+    if (site && site->inserted)
+    {
+        m_breakpoints.lift(pc);       // 将断点位置的0xcc替换为原指令，以允许程序继续执行
+        ptrace(PTRACE_SINGLESTEP, m_pid, nullptr, nullptr);     // 使用 ptrace 让目标进程执行一条指令，然后暂停, 方便调试器进行下一步操作。
+        wait_for_signal();
+        m_breakpoints.restore(pc);    // 恢复当前断点，确保在下次执行到该断点时，程序会暂停执行
+    }
+};
+
+asm_head debugger::get_function_from_pc(uint64_t pc)
+{
+    for (auto &head : m_asm_vct)
+    {
+        // 该 PC 地址位于当前函数的代码范围内，返回当前函数的信息
+        if (pc >= head.start_addr && pc <= head.end_addr)
+        {
+            return head;
+        }
+    }
+    asm_head temp;
+    temp.end_addr = 0;
+    return temp;
+}
+
+dwarf::line_table::iterator debugger::get_line_entry_from_pc(uint64_t pc)
+{
+    for (auto &cu : m_dwarf.compilation_units())
+    {
+        // 判断给定的 PC 地址是否在当前编译单元的调试信息条目范围内
+        if (die_pc_range(cu.root()).contains(pc))       // die_pc_range(): 计算给定编译单元的根DIE的地址范围
+        {
+            auto &lt = cu.get_line_table();
+            auto it = lt.find_address(pc);
+            if (it == lt.end())
+            {
+                return lt.begin();
+            }
+            else
+            {
+                return it;
+            }
+        }
+    }
+    throw std::out_of_range{"can't find line entry"};
+}
+
+dwarf::line_table::iterator debugger::get_next_line_entry_from_pc(uint64_t pc)
+{
+    auto line_entry = get_line_entry_from_pc(pc);
+    line_entry++;
+    return line_entry;
+}
+
+siginfo_t debugger::get_signal_info()
+{
+    siginfo_t info;
+    ptrace(PTRACE_GETSIGINFO, m_pid, nullptr, &info);
+    return info;
+}
+
+void debugger::single_step_instruction()
+{
+    ptrace(PTRACE_SINGLESTEP, m_pid, nullptr, nullptr);
+    wait_for_signal();
+}
+
+void debugger::single_step_instruction_with_breakpoint_check()
+{
+    if (m_record.active())
+    {
+        ptrace(PTRACE_GETREGS, m_pid, nullptr, &m_record_regs);
+        record_step();
+    }
+    else if (m_breakpoints.find(get_pc()))
+    {
+        step_over_breakpoint();
+    }
+    else
+    {
+        single_step_instruction();
+    }
+}
+
+void debugger::remove_breakpoint(std::intptr_t addr)
+{
+    m_breakpoints.release({addr});
+}
+
+void debugger::step_out()
+{
+    if (is_inlined_frame(0))
+    {
+        step_out_of_inline(m_frames[0].inline_node);
+        return;
+    }
+    auto caller = get_physical_frame(1);
+    if (caller == nullptr)
+    {
+        std::cout << "\"finish\" not meaningful in the outermost frame." << std::endl;
+        return;
+    }
+    // 返回后pc为返回地址，rsp恢复为本帧的CFA
+    auto return_address = caller->pc;
+    auto caller_rsp = get_physical_frame(0)->cfa;
+
+    // 临时断点与已有断点共享同一位置，释放时只减少引用计数
+    auto bp = temporary_breakpoint_address(return_address);
+    m_breakpoints.acquire({bp});
+    do
+    {
+        continue_execution();
+    } while (WIFSTOPPED(m_wait_status) && get_pc() == static_cast<uint64_t>(bp) && get_rsp() < caller_rsp);
+    if (WIFSTOPPED(m_wait_status))
+        remove_breakpoint(bp);
+}
+
+void debugger::step_out_of_inline(int node)
+{
+    // 内联展开没有自己的栈帧和返回地址，只能逐条执行直到离开其地址范围
+    int function = node;
+    while (m_inlines.node(function).parent >= 0)
+        function = m_inlines.node(function).parent;
+    auto rsp = get_rsp();
+    while (true)
+    {
+        single_step_instruction_with_breakpoint_check();
+        if (!WIFSTOPPED(m_wait_status))
+            return;
+        auto pc = offset_load_address(get_pc());
+        auto new_rsp = get_rsp();
+        if (new_rsp < rsp && !m_inlines.contains(function, pc))
+        {
+            // 刚执行了call：返回地址在栈顶，直接运行到返回为止（递归时更深的返回不算）
+            auto return_address = read_memory(new_rsp);
+            auto bp = temporary_breakpoint_address(return_address);
+            m_breakpoints.acquire({bp});
+            do
+            {
+                continue_execution();
+            } while (WIFSTOPPED(m_wait_status) && get_pc() == static_cast<uint64_t>(bp) && get_rsp() <= new_rsp);
+            if (!WIFSTOPPED(m_wait_status))
+                return;
+            remove_breakpoint(bp);
+            if (get_pc() != static_cast<uint64_t>(bp))
+                return;     // 被调用的函数中遇到了断点
+            pc = offset_load_address(get_pc());
+            new_rsp = get_rsp();
+        }
+        if (!m_inlines.contains(node, pc))
+            return;
+        rsp = new_rsp;
+    }
+}
+
+void debugger::step_in()
+{
+    auto line = get_line_entry_from_pc(get_offset_pc())->line;      //  line 成员变量
+    // 源代码行号没有改变，循环继续
+    while (get_line_entry_from_pc(get_offset_pc())->line == line)
+    {
+        single_step_instruction_with_breakpoint_check();
+    }
+
+    auto line_entry = get_line_entry_from_pc(get_offset_pc());
+    //print_source(line_entry->file->path, line_entry->line);
+}
+
+void debugger::step_over()
+{
+    std::vector<int> before, after;
+    inline_chain_at(get_pc(), before);
+
+    auto line_entry = get_next_line_entry_from_pc(get_offset_pc());
+    auto newpc = temporary_breakpoint_address(offset_dwarf_address(line_entry->address));
+    m_breakpoints.acquire({newpc});
+    continue_execution();
+    if (!WIFSTOPPED(m_wait_status))
+        return;
+
+    remove_breakpoint(newpc);
+
+    // 下一行属于刚进入的内联展开（外层的内联链不变）时，把整个内联调用当作一行执行完
+    if (get_pc() != static_cast<uint64_t>(newpc))
+        return;
+    inline_chain_at(get_pc(), after);
+    if (after.size() > before.size() && std::equal(before.rbegin(), before.rend(), after.rbegin()))
+        step_out_of_inline(after[after.size() - before.size() - 1]);
+};
+
+std::vector<std::intptr_t> debugger::function_breakpoint_addresses(const std::string &name)
+{
+    std::vector<std::intptr_t> addrs;
+    for (const auto &cu : m_dwarf.compilation_units())
+    {
+        // 检查每个 DIE 是否具有名称属性并且与参数匹配.
+        for (const auto &die : cu.root())
+        {
+            // 只声明（如外部库函数的原型）的DIE没有low_pc，跳过
+            if (die.has(dwarf::DW_AT::name) && die.has(dwarf::DW_AT::low_pc) && at_name(die) == name)
+            {
+                auto low_pc = at_low_pc(die);
+                auto entry = get_line_entry_from_pc(low_pc);
+                ++entry;                // 在源代码行条目的下一行设置断点
+                addrs.push_back(offset_dwarf_address(entry->address));
+            }
+        }
+    }
+    return addrs;
+}
+
+std::vector<std::intptr_t> debugger::resolve_location(const std::string &location)
+{
+    if (location.size() > 2 && location[0] == '0' && location[1] == 'x')
+    {
+        return {static_cast<std::intptr_t>(std::stoul(location.substr(2), 0, 16) + m_load_address)};
+    }
+    if (location.find(':') != std::string::npos)
+    {
+        auto file_and_line = utility::split(location, ':');
+        auto addr = source_line_address(file_and_line[0], std::stoi(file_and_line[1]));
+        if (addr == 0)
+            return resolve_in_solibs(location, nullptr);
+        return {addr};
+    }
+    auto addrs = function_breakpoint_addresses(location);
+    if (addrs.empty())
+        return resolve_in_solibs(location, nullptr);
+    return addrs;
+}
+
+std::vector<std::intptr_t> debugger::resolve_in_solibs(const std::string &location, const std::vector<std::size_t> *only)
+{
+    std::vector<std::intptr_t> addrs;
+    auto &modules = m_solibs.modules();
+    std::size_t n = only ? only->size() : modules.size();
+    auto colon = location.find(':');
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto &so = modules[only ? (*only)[i] : i];
+        if (colon != std::string::npos)
+        {
+            auto addr = m_solibs.source_line_address(so, location.substr(0, colon), std::stoi(location.substr(colon + 1)));
+            if (addr != 0)
+                addrs.push_back(addr);
+        }
+        else
+        {
+            auto found = m_solibs.function_addresses(so, location);
+            addrs.insert(addrs.end(), found.begin(), found.end());
+        }
+    }
+    return addrs;
+}
+
+void debugger::install_solib_event_breakpoint()
+{
+    if (m_solib_event != 0)
+        return;
+    m_solib_event = m_solibs.event_address();
+    if (m_solib_event != 0)
+        m_breakpoints.acquire({static_cast<std::intptr_t>(m_solib_event)});
+}
+
+void debugger::handle_solib_event()
+{
+    std::vector<std::size_t> added;
+    std::vector<std::pair<uint64_t, uint64_t>> removed;
+    if (!m_solibs.update(added, removed))
+        return;         // 链表修改中，等RT_CONSISTENT时再处理
+
+    // 卸载的库已不在内存中，其中的断点位置直接丢弃，失去全部位置的断点重新挂起
+    for (const auto &range : removed)
+    {
+        for (auto id : m_breakpoints.forget(range.first, range.second))
+            m_pending_breakpoints.push_back(id);
+        m_unwinder.forget(range.first, range.second);
+    }
+    if (!removed.empty())
+        m_symbol_cache.clear();
+    if (!added.empty() || !removed.empty())
+    {
+        std::cout << std::dec << "shared libraries: " << added.size() << " loaded, " << removed.size()
+                  << " unloaded, " << m_solibs.modules().size() << " total" << std::endl;
+    }
+    resolve_pending_breakpoints(added);
+}
+
+void debugger::resolve_pending_breakpoints(const std::vector<std::size_t> &added)
+{
+    if (added.empty() || m_pending_breakpoints.empty())
+        return;
+
+    std::vector<int> still_pending;
+    for (auto id : m_pending_breakpoints)
+    {
+        auto bp = m_breakpoints.get(id);
+        if (bp == nullptr)
+            continue;   // 已被删除
+        auto addrs = resolve_in_solibs(bp->spec, &added);
+        if (addrs.empty())
+        {
+            still_pending.push_back(id);
+            continue;
+        }
+        m_breakpoints.extend(id, addrs);
+        std::cout << std::dec << "breakpoint " << id << " (" << bp->spec << ") resolved: "
+                  << addrs.size() << " locations" << std::endl;
+    }
+    m_pending_breakpoints.swap(still_pending);
+}
+
+void debugger::set_breakpoint_at_function(const std::string &name)
+{
+    auto addrs = function_breakpoint_addresses(name);
+    if (addrs.empty())
+    {
+        addrs = resolve_in_solibs(name, nullptr);
+    }
+    if (!addrs.empty())
+    {
+        addrs = drop_traced_addresses(addrs);
+        if (addrs.empty())
+            return;
+    }
+    if (addrs.empty())
+    {
+        if (m_solibs.complete())
+        {
+            std::cout << "fails to set breakpoint at function " << name << "\nCan't find it\n";
+            return;
+        }
+        // 动态链接器还没有加载完共享库，可能位于尚未加载的库中，先挂起，库加载后再解析
+        int id = m_breakpoints.add({}, name);
+        m_pending_breakpoints.push_back(id);
+        std::cout << std::dec << "breakpoint " << id << " (" << name << ") pending" << std::endl;
+        return;
+    }
+    int id = m_breakpoints.add(addrs, name);
+    std::cout << std::dec << "breakpoint " << id << " at " << name << std::endl;
+}
+
+std::vector<std::intptr_t> debugger::drop_traced_addresses(const std::vector<std::intptr_t> &addrs)
+{
+    std::vector<std::intptr_t> kept;
+    for (auto addr : addrs)
+    {
+        if (m_tracepoints.covers(addr))
+            std::cout << "0x" << std::hex << addr << std::dec << " is patched by a tracepoint; delete the tracepoint first" << std::endl;
+        else
+            kept.push_back(addr);
+    }
+    return kept;
+}
+
+std::intptr_t debugger::temporary_breakpoint_address(uint64_t addr)
+{
+    return static_cast<std::intptr_t>(m_tracepoints.displaced_address(addr));
+}
+
+void debugger::set_breakpoint_at_regex(const std::string &pattern)
+{
+    std::regex re;
+    try
+    {
+        re = std::regex(pattern);
+    }
+    catch (const std::regex_error &e)
+    {
+        std::cout << "invalid regex " << pattern << ": " << e.what() << std::endl;
+        return;
+    }
+
+    // 先收集所有匹配函数的地址，再一次性批量插入
+    std::vector<std::intptr_t> addrs;
+    for (const auto &cu : m_dwarf.compilation_units())
+    {
+        for (const auto &die : cu.root())
+        {
+            if (die.tag != dwarf::DW_TAG::subprogram || !die.has(dwarf::DW_AT::name) || !die.has(dwarf::DW_AT::low_pc))
+                continue;
+            if (!std::regex_search(at_name(die), re))
+                continue;
+            auto entry = get_line_entry_from_pc(at_low_pc(die));
+            ++entry;
+            addrs.push_back(offset_dwarf_address(entry->address));
+        }
+    }
+    if (addrs.empty())
+    {
+        std::cout << "no function matches " << pattern << std::endl;
+        return;
+    }
+    addrs = drop_traced_addresses(addrs);
+    if (addrs.empty())
+        return;
+    int id = m_breakpoints.add(addrs, "rbreak " + pattern);
+    std::cout << std::dec << "breakpoint " << id << ": " << addrs.size() << " locations" << std::endl;
+}
+
+void debugger::set_breakpoint_at_source_file(const std::string &file, unsigned line)
+{
+    auto spec = file + ":" + std::to_string(line);
+    auto addr = source_line_address(file, line);
+    if (addr == 0)
+    {
+        auto addrs = resolve_in_solibs(spec, nullptr);
+        if (addrs.empty())
+        {
+            if (m_solibs.complete())
+            {
+                std::cout << "set breakpoint at function " << file << " and line " << line << " fails\n";
+                return;
+            }
+            int id = m_breakpoints.add({}, spec);
+            m_pending_breakpoints.push_back(id);
+            std::cout << std::dec << "breakpoint " << id << " (" << spec << ") pending" << std::endl;
+            return;
+        }
+        addr = addrs.front();
+    }
+    if (drop_traced_addresses({addr}).empty())
+        return;
+    int id = m_breakpoints.add({addr}, spec);
+    std::cout << std::dec << "breakpoint " << id << " at " + file + ":" + std::to_string(line) << std::endl;
+}
+
+std::intptr_t debugger::source_line_address(const std::string &file, unsigned line)
+{
+    for (const auto &cu : m_dwarf.compilation_units())
+    {
+        auto rootName = at_name(cu.root());         // 源文件的完整路径名
+        size_t pos = rootName.rfind('/');
+        if (pos != std::string::npos && pos != rootName.size() - 1)
+        {
+            rootName = rootName.substr(pos + 1);
+        }
+
+        if (file == rootName)
+        {
+            const auto &lt = cu.get_line_table();
+            // 在行表中查找与目标行匹配的行条目                    
+            for (const auto &entry : lt)
+            {
+                if (entry.is_stmt && entry.line == line)
+                {
+                    return offset_dwarf_address(entry.address);
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/*** @brief 初始化 * */
+void debugger::initialise_load_address()
+{
+    // 位置无关可执行文件（PIE）的类型也是 et::dyn，加载地址须从maps中读取
+    m_load_address = 0;
+    if (m_elf.get_hdr().type == elf::et::dyn)
+    {
+        // The load address is found in /proc/&lt;pid&gt;/maps
+        std::ifstream map("/proc/" + std::to_string(m_pid) + "/maps");
+        char exe_path[PATH_MAX];
+        std::string exe = realpath(m_prog_name.c_str(), exe_path) ? exe_path : m_prog_name;
+
+        // 不能只读第一行：第一行不一定属于程序本身，要找程序文件偏移为0的映射
+        std::string line;
+        while (std::getline(map, line))
+        {
+            auto pos = line.find('/');
+            if (pos == std::string::npos || line.substr(pos) != exe)
+                continue;
+            uint64_t start = 0, offset = 0;
+            if (std::sscanf(line.c_str(), "%lx-%*x %*s %lx", &start, &offset) == 2 && offset == 0)
+            {
+                m_load_address = start;
+                break;
+            }
+        }
+    }
+    std::cout<< "PID: " << m_pid << ", Load Address: 0x" << std::hex << m_load_address << "\n";
+}
+
+void debugger::initialise_load_asm()
+{
+    asmparaser paraser;
+    m_asm_vct = move(paraser.get_asm_data(m_asm_name));
+    // 将汇编数据块的起始地址和结束地址, 条目地址, 都加上加载地址，换为真实地址
+    for (auto &head : m_asm_vct)
+    {
+        head.start_addr += m_load_address;
+        head.end_addr += m_load_address;
+        for (auto &entry : head.asm_entris)
+        {
+            entry.addr += m_load_address;
+        }
+    }
+}
+
+void debugger::initialise_run_objdump()
+{
+    std::string binaryFile = m_prog_name;
+    std::string middleFile = m_prog_name + ".asm";
+
+    // 使用 objdump 命令生成反汇编代码
+    std::string command = "objdump -d " + binaryFile + "  | tail -n +4 > " + middleFile;
+    int result = std::system(command.c_str());
+
+    if (result != 0)
+    {
+        std::cerr << "error when run command: " + command << std::endl;
+    }
+}
+
+void debugger::initialise_load_src()
+{
+    m_src_vct.clear();
+    auto offset_pc = offset_load_address(get_pc());
+    auto line_entry = m_dwarf.compilation_units().begin()->get_line_table().begin();
+    std::string file_path = std::string(line_entry->file->path);
+
+    std::ifstream inFile(file_path);
+    std::string line;
+
+    if (!inFile)
+    {
+        std::cerr << "Failed to open input file " << file_path << std::endl;
+        return;
+    }
+
+    while (std::getline(inFile, line))
+    {
+        m_src_vct.push_back(line);
+    }
+
+    inFile.close();
+    return;
+};
+
+long debugger::inject_syscall(long number, std::initializer_list<uint64_t> args)
+{
+    static const uint8_t syscall_insn[2] = {0x0f, 0x05};
+
+    user_regs_struct saved;
+    ptrace(PTRACE_GETREGS, m_pid, nullptr, &saved);
+
+    // 在当前pc处临时写入 syscall 指令，单步执行后恢复原字节和寄存器
+    uint8_t original[2];
+    if (m_memory.read(saved.rip, original, 2) != 2 || !m_memory.write(saved.rip, syscall_insn, 2))
+    {
+        return -EFAULT;
+    }
+
+    user_regs_struct regs = saved;
+    decltype(&regs.rdi) arg_regs[] = {&regs.rdi, &regs.rsi, &regs.rdx, &regs.r10, &regs.r8, &regs.r9};
+    std::size_t i = 0;
+    for (auto arg : args)
+    {
+        *arg_regs[i++] = arg;
+    }
+    regs.rax = number;
+    regs.orig_rax = -1;     // 避免内核把它当作被中断的系统调用而重启
+    ptrace(PTRACE_SETREGS, m_pid, nullptr, &regs);
+
+    ptrace(PTRACE_SINGLESTEP, m_pid, nullptr, nullptr);
+    int status;
+    waitpid(m_pid, &status, 0);
+    if (!WIFSTOPPED(status) || WSTOPSIG(status) != SIGTRAP)
+    {
+        std::cerr << "inject_syscall(): unexpected stop status 0x" << std::hex << status << std::dec << std::endl;
+    }
+    ptrace(PTRACE_GETREGS, m_pid, nullptr, &regs);
+
+    m_memory.write(saved.rip, original, 2);
+    ptrace(PTRACE_SETREGS, m_pid, nullptr, &saved);
+    m_stop_state.reset();       // 系统调用可能改变了映射
+    return static_cast<long>(regs.rax);
+}
+
+bool debugger::record_step()
+{
+    auto t0 = std::chrono::steady_clock::now();
+    const user_regs_struct &before = m_record_regs;
+
+    // 断点处读到的是0xcc，解码前换回原始字节
+    uint8_t code[16];
+    std::size_t n = m_memory.read(before.rip, code, sizeof(code));
+    m_breakpoints.unpatch(before.rip, code, n);
+    m_record_writes.clear();
+    bool complete = decode_mem_writes(code, n, before, m_record_writes);
+
+    // 一次批量读取全部将被覆盖的内存
+    std::size_t total = 0;
+    for (const auto &w : m_record_writes) total += w.len;
+    m_record_buffer.resize(total);
+    m_record_images.resize(m_record_writes.size());
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < m_record_writes.size(); ++i)
+    {
+        m_record_images[i] = mem_request{m_record_writes[i].addr, m_record_buffer.data() + offset, m_record_writes[i].len, 0};
+        offset += m_record_writes[i].len;
+    }
+    m_memory.read_batch(m_record_images.data(), m_record_images.size());
+
+    // 单步执行，当前位置有断点时临时移除
+    auto site = m_breakpoints.find(before.rip);
+    bool lifted = site && site->inserted;
+    if (lifted)
+        m_breakpoints.lift(before.rip);
+    ptrace(PTRACE_SINGLESTEP, m_pid, nullptr, nullptr);
+    waitpid(m_pid, &m_wait_status, 0);
+    note_stop();
+    if (lifted && WIFSTOPPED(m_wait_status))
+        m_breakpoints.restore(before.rip);
+
+    if (!WIFSTOPPED(m_wait_status))
+    {
+        std::cout << "process exited, recording stopped" << std::endl;
+        print_record_info();
+        m_record.stop();
+        return false;
+    }
+    if (WSTOPSIG(m_wait_status) != SIGTRAP)
     {
-    case SIGTRAP:           // 遇到断点
-        handle_sigtrap(siginfo);
-        break;
-    case SIGSEGV:           // 段错误
-        std::cout << "sorry, segment fault . reason : " << siginfo.si_code << std::endl;
-        break;
-    default:
-        std::cout << "get signal  " << strsignal(siginfo.si_signo) << std::endl;
-        break;
+        // 指令没有执行完（如段错误），不产生记录。信号处理函数写入的信号栈帧无法记录，停止记录，
+        // 信号留到下次继续执行时送达，否则被调试进程的处理函数永远不会运行
+        m_pending_signal = WSTOPSIG(m_wait_status);
+        std::cout << "get signal  " << strsignal(m_pending_signal) << ", recording stopped" << std::endl;
+        print_record_info();
+        m_record.stop();
+        return false;
     }
+
+    user_regs_struct after;
+    ptrace(PTRACE_GETREGS, m_pid, nullptr, &after);
+    m_record.push(before, after, m_record_images.data(), m_record_images.size(), complete);
+    m_record_regs = after;
+    m_record.add_time(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+    return true;
 }
 
-void debugger::step_over_breakpoint()
+void debugger::record_continue()
 {
-    // 判断当前指令地址是否处于断点集合中
-    if (m_breakpoints.count(get_pc()))
+    ptrace(PTRACE_GETREGS, m_pid, nullptr, &m_record_regs);
+    while (record_step())
     {
-        auto &bp = m_breakpoints[get_pc()];   // 获取对映射中特定键值的引用
-        if (bp.is_enabled())
+        auto pc = m_record_regs.rip;
+        if (!m_breakpoints.find(pc))
+            continue;
+        if (pc == m_solib_event)
         {
-            bp.disable();       // 禁用当前断点，即将断点位置的0xcc替换为原指令，以允许程序继续执行
-            ptrace(PTRACE_SINGLESTEP, m_pid, nullptr, nullptr);     // 使用 ptrace 让目标进程执行一条指令，然后暂停, 方便调试器进行下一步操作。
-            wait_for_signal();
-            bp.enable();        // 恢复当前断点，确保在下次执行到该断点时，程序会暂停执行
+            // 处理通知时断点表可能增删位置，之前取得的指针会失效，重新查找
+            handle_solib_event();
+            auto site = m_breakpoints.find(pc);
+            if (!site || site->refcount <= 1)
+                continue;
         }
+        // 条件断点：条件为假时不停下，与 continue_execution 一致
+        if (breakpoint_condition_holds(pc))
+            return;
     }
-};
+}
 
-asm_head debugger::get_function_from_pc(uint64_t pc)
+bool debugger::undo_instruction()
 {
-    for (auto &head : m_asm_vct)
+    user_regs_struct regs;
+    ptrace(PTRACE_GETREGS, m_pid, nullptr, &regs);
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> images;
+    if (!m_record.pop(regs, images))
+        return false;
+    note_stop();
+    // 后写入的区间先恢复，同一条指令的区间重叠时保留最早的内容
+    for (auto it = images.rbegin(); it != images.rend(); ++it)
+        m_memory.write(it->first, it->second.data(), it->second.size());
+    ptrace(PTRACE_SETREGS, m_pid, nullptr, &regs);
+    return true;
+}
+
+void debugger::reverse_stepi_execution()
+{
+    if (!undo_instruction())
+        std::cout << "no more reverse-execution history" << std::endl;
+}
+
+void debugger::reverse_continue_execution()
+{
+    while (undo_instruction())
     {
-        // 该 PC 地址位于当前函数的代码范围内，返回当前函数的信息
-        if (pc >= head.start_addr && pc <= head.end_addr)
-        {
-            return head;
-        }
+        auto pc = get_pc();
+        auto site = m_breakpoints.find(pc);
+        if (site && (pc != m_solib_event || site->refcount > 1) && breakpoint_condition_holds(pc))
+            return;
     }
-    asm_head temp;
-    temp.end_addr = 0;
-    return temp;
+    std::cout << "no more reverse-execution history" << std::endl;
 }
 
-dwarf::line_table::iterator debugger::get_line_entry_from_pc(uint64_t pc)
+void debugger::reverse_next_execution()
 {
-    for (auto &cu : m_dwarf.compilation_units())
-    {
-        // 判断给定的 PC 地址是否在当前编译单元的调试信息条目范围内
-        if (die_pc_range(cu.root()).contains(pc))       // die_pc_range(): 计算给定编译单元的根DIE的地址范围
+    user_regs_struct regs;
+    ptrace(PTRACE_GETREGS, m_pid, nullptr, &regs);
+
+    // 先在记录中向前查找目标状态，再一次性撤销到那里。
+    // 同一函数中且rsp不低于帧基准的状态属于当前帧（序言中rsp更高），其他函数中rsp更低的状态属于被调用者
+    auto function_of = [this](uint64_t pc) -> const asm_head * {
+        for (const auto &head : m_asm_vct)
         {
-            auto &lt = cu.get_line_table();
-            auto it = lt.find_address(pc);
-            if (it == lt.end())
+            if (pc >= head.start_addr && pc <= head.end_addr)
+                return &head;
+        }
+        return nullptr;
+    };
+    const asm_head *func = function_of(regs.rip);
+    uint64_t frame_rsp = regs.rsp;
+    unsigned start_line = line_of_pc(regs.rip);
+    unsigned line = 0;
+    std::size_t target = 0;
+    bool found = false, stop_at_breakpoint = false;
+
+    // 第一阶段：当前帧（或调用者）中上一行的最后一条指令，被调用函数中的指令直接跳过
+    m_record.walk_back(regs, [&](const user_regs_struct &s) {
+        ++target;
+        const asm_head *f = function_of(s.rip);
+        bool same = f == func && s.rsp >= frame_rsp;
+        if (!same && s.rsp < frame_rsp)
+        {
+            auto site = m_breakpoints.find(s.rip);
+            if (site && (s.rip != m_solib_event || site->refcount > 1))
             {
-                return lt.begin();
+                found = stop_at_breakpoint = true;      // 被调用函数中的断点
+                return false;
             }
-            else
+            return true;
+        }
+        line = line_of_pc(s.rip);
+        if (line == 0 || (same && line == start_line))
+            return true;
+        func = f;
+        frame_rsp = s.rsp;
+        found = true;
+        return false;
+    });
+
+    // 第二阶段：继续向前到该行的第一条指令，行内调用的函数整体跳过
+    if (found && !stop_at_breakpoint)
+    {
+        std::size_t index = 0;
+        m_record.walk_back(regs, [&](const user_regs_struct &s) {
+            if (++index <= target)
+                return true;
+            const asm_head *f = function_of(s.rip);
+            if (f == func && s.rsp >= frame_rsp)
             {
-                return it;
+                if (line_of_pc(s.rip) != line)
+                    return false;
+                target = index;
+                return true;
             }
-        }
+            return s.rsp < frame_rsp;
+        });
     }
-    throw std::out_of_range{"can't find line entry"};
+
+    for (std::size_t i = 0; i < target; ++i)
+        undo_instruction();
+    if (!found)
+        std::cout << "no more reverse-execution history" << std::endl;
 }
 
-dwarf::line_table::iterator debugger::get_next_line_entry_from_pc(uint64_t pc)
+unsigned debugger::line_of_pc(uint64_t pc)
 {
-    auto line_entry = get_line_entry_from_pc(pc);
-    line_entry++;
-    return line_entry;
+    try
+    {
+        return get_line_entry_from_pc(offset_load_address(pc))->line;
+    }
+    catch (const std::exception &)
+    {
+        return 0;
+    }
 }
 
-siginfo_t debugger::get_signal_info()
+void debugger::print_record_info()
 {
-    siginfo_t info;
-    ptrace(PTRACE_GETSIGINFO, m_pid, nullptr, &info);
-    return info;
+    if (!m_record.active())
+    {
+        std::cout << "not recording" << std::endl;
+        return;
+    }
+    uint64_t recorded = m_record.recorded();
+    std::cout << std::dec << "recorded " << recorded << " instructions, " << m_record.entries()
+              << " in history (" << (m_record.bytes() >> 10) << " KB of " << (m_record.cap() >> 20) << " MB cap), "
+              << m_record.dropped() << " dropped";
+    if (m_record.entries() != 0)
+    {
+        std::ostringstream per_insn;
+        per_insn << std::fixed << std::setprecision(1) << double(m_record.bytes()) / m_record.entries();
+        std::cout << ", " << per_insn.str() << " bytes/insn";
+    }
+    if (recorded != 0)
+        std::cout << ", " << m_record.elapsed_ns() / recorded << " ns/insn";
+    std::cout << std::endl;
+    if (m_record.incomplete() != 0)
+        std::cout << m_record.incomplete() << " instructions with unknown memory writes" << std::endl;
 }
 
-void debugger::single_step_instruction()
+pid_t debugger::inject_fork(pid_t pid)
 {
-    ptrace(PTRACE_SINGLESTEP, m_pid, nullptr, nullptr);
-    wait_for_signal();
+    static const uint8_t syscall_insn[2] = {0x0f, 0x05};
+    inferior_memory mem;
+    mem.attach(pid);
+
+    user_regs_struct saved;
+    if (ptrace(PTRACE_GETREGS, pid, nullptr, &saved) != 0)
+    {
+        return -1;
+    }
+    uint8_t original[2];
+    if (mem.read(saved.rip, original, 2) != 2 || !mem.write(saved.rip, syscall_insn, 2))
+    {
+        return -1;
+    }
+
+    // 只在注入期间跟踪fork，被调试程序自己创建的子进程不受影响
+    ptrace(PTRACE_SETOPTIONS, pid, nullptr, PTRACE_O_TRACEFORK | PTRACE_O_EXITKILL);
+    user_regs_struct regs = saved;
+    regs.rax = SYS_fork;
+    regs.orig_rax = -1;
+    ptrace(PTRACE_SETREGS, pid, nullptr, &regs);
+
+    pid_t child = -1;
+    int status;
+    ptrace(PTRACE_SINGLESTEP, pid, nullptr, nullptr);
+    while (waitpid(pid, &status, __WALL) == pid && WIFSTOPPED(status))
+    {
+        if (status >> 8 == (SIGTRAP | (PTRACE_EVENT_FORK << 8)))
+        {
+            unsigned long msg = 0;
+            ptrace(PTRACE_GETEVENTMSG, pid, nullptr, &msg);
+            child = static_cast<pid_t>(msg);
+        }
+        else if (WSTOPSIG(status) == SIGTRAP)
+        {
+            break;      // 系统调用已返回
+        }
+        // fork事件之后继续完成系统调用；暂停期间积压的信号（如已结束副本的SIGCHLD）直接丢弃
+        ptrace(PTRACE_SINGLESTEP, pid, nullptr, nullptr);
+    }
+    ptrace(PTRACE_SETOPTIONS, pid, nullptr, PTRACE_O_EXITKILL);
+    mem.write(saved.rip, original, 2);
+    ptrace(PTRACE_SETREGS, pid, nullptr, &saved);
+    if (child <= 0)
+    {
+        return -1;
+    }
+
+    // 子进程的内存复制于注入时，同样含有syscall指令，恢复后让它停在与父进程相同的状态
+    waitpid(child, &status, __WALL);
+    ptrace(PTRACE_SETOPTIONS, child, nullptr, PTRACE_O_EXITKILL);
+    inferior_memory child_mem;
+    child_mem.attach(child);
+    child_mem.write(saved.rip, original, 2);
+    ptrace(PTRACE_SETREGS, child, nullptr, &saved);
+    return child;
 }
 
-void debugger::single_step_instruction_with_breakpoint_check()
+int debugger::checkpoint_execution()
 {
-    if (m_breakpoints.count(get_pc()))
+    // 断点和追踪点的跳转全部移除后再复制，检查点里是干净的代码，切换过去时按当前断点表重新写入；
+    // 追踪点的蹦床和环形缓冲区属于当前进程，不带到检查点中
+    m_breakpoints.suspend();
+    m_tracepoints.suspend();
+    pid_t child = inject_fork(m_pid);
+    m_tracepoints.resume();
+    m_breakpoints.resume();
+    if (child <= 0)
     {
-        step_over_breakpoint();
+        std::cout << "checkpoint failed" << std::endl;
+        return -1;
     }
-    else
+
+    checkpoint cp;
+    cp.id = m_next_checkpoint++;
+    cp.pid = child;
+    cp.pc = get_pc();
+    std::stringstream where;
+    try
     {
-        single_step_instruction();
+        auto entry = get_line_entry_from_pc(get_offset_pc());
+        auto path = entry->file->path;
+        where << path.substr(path.rfind('/') + 1) << ":" << std::dec << entry->line;
     }
+    catch (const std::exception &)
+    {
+        where << "0x" << std::hex << cp.pc;
+    }
+    cp.where = where.str();
+    m_checkpoints.push_back(cp);
+    std::cout << std::dec << "checkpoint " << cp.id << " at " << cp.where << " (pid " << cp.pid << ")" << std::endl;
+    return cp.id;
 }
 
-void debugger::remove_breakpoint(std::intptr_t addr)
+int debugger::checkpoint_at_main()
 {
-    if (m_breakpoints.at(addr).is_enabled())
+    if (!WIFSTOPPED(m_wait_status) || WSTOPSIG(m_wait_status) != SIGTRAP)
+    {
+        std::cout << "not stopped at main, no start checkpoint" << std::endl;
+        return -1;
+    }
+    auto addrs = function_breakpoint_addresses("main");
+    if (std::find(addrs.begin(), addrs.end(), static_cast<std::intptr_t>(get_pc())) == addrs.end())
     {
-        m_breakpoints.at(addr).disable();
+        std::cout << "not stopped at main, no start checkpoint" << std::endl;
+        return -1;
     }
-    m_breakpoints.erase(addr);
+    m_start_checkpoint = checkpoint_execution();
+    return m_start_checkpoint;
 }
 
-void debugger::step_out()
+bool debugger::restart_execution(int id)
 {
-    auto frame_pointer = get_register_value(m_pid, reg::rbp);
-    auto return_address = read_memory(frame_pointer + 8);
-
-    bool should_remove_breakpoint = false;
-    if (!m_breakpoints.count(return_address))
+    auto it = std::find_if(m_checkpoints.begin(), m_checkpoints.end(),
+                           [id](const checkpoint &cp) { return cp.id == id; });
+    if (it == m_checkpoints.end())
+    {
+        std::cout << "no checkpoint number " << id << std::endl;
+        return false;
+    }
+    pid_t child = inject_fork(it->pid);
+    if (child <= 0)
     {
-        set_breakpoint_at_address(return_address);
-        should_remove_breakpoint = true;
+        std::cout << "restart from checkpoint " << id << " failed" << std::endl;
+        return false;
     }
 
-    continue_execution();
+    // 检查点中没有追踪点的跳转，追踪点的蹦床和后台线程属于即将结束的进程
+    if (!m_tracepoints.list().empty())
+        std::cout << "tracepoints are not carried over to the restarted process" << std::endl;
+    m_tracepoints.reset();
+    kill(m_pid, SIGKILL);
+    waitpid(m_pid, nullptr, __WALL);
+    switch_inferior(child);
+    std::cout << std::dec << "restarted from checkpoint " << id << " at " << it->where << " (pid " << child << ")" << std::endl;
+    return true;
+}
+
+void debugger::switch_inferior(pid_t pid)
+{
+    m_search.cancel();          // 查找线程读取的是原进程
+    m_search_hits.clear();
+    m_pid = pid;
+    m_memory.attach(pid);
+    m_dirty.attach(pid);
+    m_pending_signal = 0;       // 信号是发给原进程的
+    m_unseen_pages.clear();
+    m_watch_dirty.clear();
+    m_record.stop();
+    m_unwinder.drop_stack();    // 副本的栈内容与当前进程不同
+    note_stop();
+    m_stop_state.reset();       // 缓存的页属于原进程
+    m_wait_status = (SIGTRAP << 8) | 0x7f;      // 副本停在注入fork之后，视为一次SIGTRAP停止
+
+    // 副本中没有断点：先全部标记为未写入，共享库列表可能与当前不同，丢弃/解析后再统一写入
+    m_breakpoints.invalidate();
+    m_solibs.rebind(pid);
+    handle_solib_event();
+    m_breakpoints.resume();
+}
 
-    if (should_remove_breakpoint)
+void debugger::discard_checkpoints()
+{
+    for (const auto &cp : m_checkpoints)
     {
-        remove_breakpoint(return_address);
+        kill(cp.pid, SIGKILL);
+        waitpid(cp.pid, nullptr, __WALL);
     }
+    m_checkpoints.clear();
+    m_next_checkpoint = 0;
+    m_start_checkpoint = -1;
 }
 
-void debugger::step_in()
+uint64_t debugger::find_free_area_near(uint64_t center, uint64_t size)
 {
-    auto line = get_line_entry_from_pc(get_offset_pc())->line;      //  line 成员变量
-    // 源代码行号没有改变，循环继续
-    while (get_line_entry_from_pc(get_offset_pc())->line == line)
+    static constexpr uint64_t reach = 0x7fff0000ull;        // rel32 跳转可达范围，留出余量
+    static constexpr uint64_t min_addr = 0x10000ull;        // mmap_min_addr
+
+    std::ifstream maps("/proc/" + std::to_string(m_pid) + "/maps");
+    std::string line;
+    uint64_t prev_end = min_addr;
+    uint64_t best = 0, best_distance = UINT64_MAX;
+    auto consider = [&](uint64_t gap_start, uint64_t gap_end) {
+        if (gap_end <= gap_start || gap_end - gap_start < size)
+            return;
+        // 空洞在中心之下时取最高处，在之上时取最低处
+        uint64_t candidate = gap_end <= center ? ((gap_end - size) & ~0xfffull) : gap_start;
+        if (candidate < gap_start)
+            return;
+        uint64_t distance = candidate > center ? candidate + size - center : center - candidate;
+        if (distance < reach && distance < best_distance)
+        {
+            best = candidate;
+            best_distance = distance;
+        }
+    };
+    while (std::getline(maps, line))
     {
-        single_step_instruction_with_breakpoint_check();
+        uint64_t start, end;
+        if (sscanf(line.c_str(), "%lx-%lx", &start, &end) != 2)
+            continue;
+        consider(prev_end, start);
+        prev_end = std::max(prev_end, end);
     }
-
-    auto line_entry = get_line_entry_from_pc(get_offset_pc());
-    //print_source(line_entry->file->path, line_entry->line);
+    return best;
 }
 
-void debugger::step_over()
+bool debugger::setup_tracepoint_area()
 {
-    auto line_entry = get_next_line_entry_from_pc(get_offset_pc());
-    auto newpc = offset_dwarf_address(line_entry->address);
-    if (!m_breakpoints.count(newpc))
+    static constexpr uint64_t code_size = 0x10000;
+    static constexpr uint64_t path_reserve = 256;           // 代码区末尾用于存放路径字符串
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+    uint64_t hint = find_free_area_near(m_load_address, code_size);
+    if (hint == 0)
     {
-        set_breakpoint_at_address(newpc);
+        std::cerr << "tracepoint: no free address range near the executable\n";
+        return false;
+    }
+    long code = inject_syscall(SYS_mmap, {hint, code_size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                                          static_cast<uint64_t>(-1), 0});
+    if (code < 0 && code > -4096)
+    {
+        std::cerr << "tracepoint: mmap in inferior failed: " << strerror(-code) << std::endl;
+        return false;
     }
-    continue_execution();
-
-    remove_breakpoint(newpc);
-};
 
-void debugger::set_breakpoint_at_function(const std::string &name)
-{
-    bool flag = false;
-    for (const auto &cu : m_dwarf.compilation_units())
+    // 环形缓冲区：调试器创建 memfd 并映射，被调试进程通过 /proc/<调试器pid>/fd/<fd> 打开同一文件
+    uint8_t *ring_local = nullptr;
+    long ring_remote = -1;
+    int fd = memfd_create("minidbg-trace", MFD_CLOEXEC);
+    if (fd >= 0 && ftruncate(fd, trace_ring_bytes) == 0)
     {
-        // 检查每个 DIE 是否具有名称属性并且与参数匹配.
-        for (const auto &die : cu.root())
+        void *local = mmap(nullptr, trace_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        std::string path = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd);
+        uint64_t path_addr = code + code_size - path_reserve;
+        if (local != MAP_FAILED && m_memory.write(path_addr, path.c_str(), path.size() + 1))
         {
-            if (die.has(dwarf::DW_AT::name) && at_name(die) == name)
+            long rfd = inject_syscall(SYS_open, {path_addr, O_RDWR, 0});
+            if (rfd >= 0)
             {
-                flag = true;
-                auto low_pc = at_low_pc(die);
-                auto entry = get_line_entry_from_pc(low_pc);
-                ++entry;                // 在源代码行条目的下一行设置断点
-                set_breakpoint_at_address(offset_dwarf_address(entry->address));
+                ring_remote = inject_syscall(SYS_mmap, {0, trace_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                                        static_cast<uint64_t>(rfd), 0});
+                inject_syscall(SYS_close, {static_cast<uint64_t>(rfd)});
+            }
+            if (ring_remote < 0 && ring_remote > -4096)
+            {
+                munmap(local, trace_ring_bytes);
+            }
+            else
+            {
+                ring_local = static_cast<uint8_t *>(local);
             }
         }
     }
-    if (!flag)
+    if (fd >= 0)
     {
-        std::cout << "fails to set breakpoint at function " << name << "\nCan't find it\n";
+        close(fd);
     }
-}
 
-void debugger::set_breakpoint_at_source_file(const std::string &file, unsigned line)
-{
-    for (const auto &cu : m_dwarf.compilation_units())
+    // 无法共享时在被调试进程中单独分配，由后台线程通过 process_vm_readv 读取
+    if (!ring_local)
     {
-        auto rootName = at_name(cu.root());         // 源文件的完整路径名
-        size_t pos = rootName.rfind('/');
-        if (pos != std::string::npos && pos != rootName.size() - 1)
-        {
-            rootName = rootName.substr(pos + 1);
-        }
-
-        if (file == rootName)
+        ring_remote = inject_syscall(SYS_mmap, {0, trace_ring_bytes, PROT_READ | PROT_WRITE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS, static_cast<uint64_t>(-1), 0});
+        if (ring_remote < 0 && ring_remote > -4096)
         {
-            const auto &lt = cu.get_line_table();
-            // 在行表中查找与目标行匹配的行条目                    
-            for (const auto &entry : lt)
-            {
-                if (entry.is_stmt && entry.line == line)
-                {
-                    set_breakpoint_at_address(offset_dwarf_address(entry.address));
-                    std::cout<<"set breakpoint at " + file + ":" + std::to_string(line)<<std::endl;
-                    return;
-                }
-            }
+            std::cerr << "tracepoint: ring allocation failed: " << strerror(-ring_remote) << std::endl;
+            return false;
         }
     }
-    std::cout << "set breakpoint at function " << file << " and line " << line << " fails\n";
+
+    m_tracepoints.setup(code, code_size - path_reserve, ring_remote, ring_local);
+    return true;
 }
 
-/*** @brief 初始化 * */
-void debugger::initialise_load_address()
+bool debugger::plan_displaced_instructions(uint64_t addr, std::vector<uint8_t> &displaced, std::string &why)
 {
-    //@todo: 为什么是动态库？
-    if (m_elf.get_hdr().type == elf::et::dyn)
+    auto func = get_function_from_pc(addr);
+    if (func.end_addr == 0)
     {
-        // The load address is found in /proc/&lt;pid&gt;/maps
-        std::ifstream map("/proc/" + std::to_string(m_pid) + "/maps");
+        why = "address is not in the disassembled executable";
+        return false;
+    }
 
-        std::string addr;
-        std::getline(map, addr, '-');
-        addr = "0x" + addr;
-        m_load_address = std::stoul(addr, 0, 16);       // 将字符串转换为unsigned long
+    auto &entries = func.asm_entris;
+    auto it = std::find_if(entries.begin(), entries.end(), [addr](const asm_entry &e) { return e.addr == addr; });
+    if (it == entries.end())
+    {
+        why = "address is not an instruction boundary";
+        return false;
     }
-    std::cout<< "PID: " << m_pid << ", Load Address: 0x" << std::hex << m_load_address << "\n";
-}
 
-void debugger::initialise_load_asm()
-{
-    asmparaser paraser;
-    m_asm_vct = move(paraser.get_asm_data(m_asm_name));
-    // 将汇编数据块的起始地址和结束地址, 条目地址, 都加上加载地址，换为真实地址
-    for (auto &head : m_asm_vct)
+    // 收集至少5字节的完整指令，这些指令会被搬到蹦床中执行，因此不能依赖自身地址
+    uint64_t len = 0;
+    for (; it != entries.end() && len < 5; ++it)
     {
-        head.start_addr += m_load_address;
-        head.end_addr += m_load_address;
-        for (auto &entry : head.asm_entris)
+        const std::string &code = it->asm_code;
+        std::string mnemonic = code.substr(0, code.find(' '));
+        if (code.find("%rip") != std::string::npos || mnemonic[0] == 'j' || utility::is_prefix("call", mnemonic)
+            || utility::is_prefix("ret", mnemonic) || utility::is_prefix("loop", mnemonic)
+            || mnemonic == "bnd" || mnemonic == "notrack")
         {
-            entry.addr += m_load_address;
+            why = "instruction '" + code + "' depends on its address";
+            return false;
         }
+        len += utility::split(it->mechine_code, ' ').size();
+    }
+    if (len < 5)
+    {
+        why = "function ends before 5 bytes of instructions";
+        return false;
     }
-}
 
-void debugger::initialise_run_objdump()
-{
-    std::string binaryFile = m_prog_name;
-    std::string middleFile = m_prog_name + ".asm";
+    // 被覆盖的范围内不能有断点，也不能是函数内其他跳转的目标
+    for (uint64_t a = addr; a < addr + len; ++a)
+    {
+        if (m_breakpoints.find(a) || m_tracepoints.covers(a))
+        {
+            why = "range overlaps a breakpoint or tracepoint";
+            return false;
+        }
+    }
+    for (const auto &e : entries)
+    {
+        if (e.asm_code.empty() || e.asm_code[0] != 'j')
+            continue;
+        auto operands = utility::split(e.asm_code, ' ');
+        auto target_str = std::find_if(operands.begin() + 1, operands.end(), [](const std::string &t) { return !t.empty(); });
+        if (target_str == operands.end() || target_str->find_first_not_of("0123456789abcdef") != std::string::npos)
+            continue;
+        uint64_t target = std::stoul(*target_str, 0, 16) + m_load_address;
+        if (target > addr && target < addr + len)
+        {
+            why = "range contains a jump target";
+            return false;
+        }
+    }
 
-    // 使用 objdump 命令生成反汇编代码
-    std::string command = "objdump -d " + binaryFile + "  | tail -n +4 > " + middleFile;
-    int result = std::system(command.c_str());
+    // 进程停在范围内，或调用栈上的返回地址指向范围内时，恢复执行或返回后会落在跳转指令的中间
+    for (std::size_t p = 0;; ++p)
+    {
+        auto frame = get_physical_frame(p);
+        if (frame == nullptr)
+            break;
+        if (frame->pc > addr && frame->pc < addr + len)
+        {
+            why = p == 0 ? "the program is stopped inside the range" : "a return address on the stack points inside the range";
+            return false;
+        }
+    }
 
-    if (result != 0)
+    displaced.resize(len);
+    if (m_memory.read(addr, displaced.data(), len) != len)
     {
-        std::cerr << "error when run command: " + command << std::endl;
+        why = "cannot read instructions";
+        return false;
     }
+    return true;
 }
 
-void debugger::initialise_load_src()
+void debugger::set_tracepoint(const std::vector<std::string> &args)
 {
-    m_src_vct.clear();
-    auto offset_pc = offset_load_address(get_pc());
-    auto line_entry = m_dwarf.compilation_units().begin()->get_line_table().begin();
-    std::string file_path = std::string(line_entry->file->path);
+    if (args.size() < 2)
+    {
+        std::cout << "usage: trace <location> [collect] [<reg>[+-offset]:<len> ...]\n";
+        return;
+    }
 
-    std::ifstream inFile(file_path);
-    std::string line;
+    std::vector<trace_collect> collects;
+    for (std::size_t i = 2; i < args.size(); ++i)
+    {
+        if (args[i] == "collect" || args[i].empty())
+            continue;
+        auto colon = args[i].find(':');
+        auto sign = args[i].find_first_of("+-");
+        if (colon == std::string::npos)
+        {
+            std::cout << "bad collect spec " << args[i] << std::endl;
+            return;
+        }
+        std::string name = args[i].substr(0, std::min(sign, colon));
+        auto rd = std::find_if(g_register_descriptors.begin(), g_register_descriptors.end(),
+                               [&name](const reg_descriptor &d) { return d.name == name; });
+        if (rd == g_register_descriptors.end())
+        {
+            std::cout << "unknown register " << name << std::endl;
+            return;
+        }
+        if (!tracepoint_manager::collectable(rd->r))
+        {
+            std::cout << "cannot collect relative to " << name << ": only general-purpose registers, rsp and rip are saved by the trampoline" << std::endl;
+            return;
+        }
+        trace_collect col;
+        col.base = rd->r;
+        std::string offset = sign < colon ? args[i].substr(sign, colon - sign) : "0";
+        std::string len = args[i].substr(colon + 1);
+        char *offset_end = nullptr, *len_end = nullptr;
+        col.offset = std::strtol(offset.c_str(), &offset_end, 0);
+        col.len = std::strtoul(len.c_str(), &len_end, 0);
+        if (*offset_end != '\0' || len.empty() || len[0] == '-' || *len_end != '\0')
+        {
+            std::cout << "bad collect spec " << args[i] << std::endl;
+            return;
+        }
+        collects.push_back(col);
+    }
 
-    if (!inFile)
+    auto addrs = resolve_location(args[1]);
+    if (addrs.empty())
     {
-        std::cerr << "Failed to open input file " << file_path << std::endl;
+        std::cout << "cannot resolve location " << args[1] << std::endl;
         return;
     }
-
-    while (std::getline(inFile, line))
+    if (!m_tracepoints.ready() && !setup_tracepoint_area())
     {
-        m_src_vct.push_back(line);
+        return;
+    }
+    for (auto addr : addrs)
+    {
+        std::vector<uint8_t> displaced;
+        std::string why;
+        if (!plan_displaced_instructions(addr, displaced, why))
+        {
+            std::cout << "cannot trace 0x" << std::hex << addr << std::dec << ": " << why << std::endl;
+            continue;
+        }
+        int id = m_tracepoints.install(addr, displaced, collects, args[1]);
+        if (id > 0)
+        {
+            std::cout << std::dec << "tracepoint " << id << " at 0x" << std::hex << addr << std::dec << std::endl;
+        }
     }
+}
 
-    inFile.close();
-    return;
 };
-
-};
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "dirty_tracker.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+namespace minidbg {
+
+constexpr std::size_t dirty_tracker::page_size;
+constexpr uint64_t dirty_tracker::max_hash_bytes;
+constexpr std::size_t dirty_tracker::chunk_bytes;
+
+namespace {
+
+constexpr uint64_t soft_dirty_bit = 1ull << 55;     // pagemap 表项中的软脏位
+constexpr uint64_t unreadable = 0;                  // 不可读的页的哈希
+
+// 这些内核映射的内容由内核更新，不经过页表写入
+bool special(const memory_region &r)
+{
+    return r.name == "[vvar]" || r.name == "[vvar_vclock]" || r.name == "[vsyscall]";
+}
+
+double since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief 一页的 64 位哈希，四路交错计算减少乘法的依赖链。结果不为 unreadable。
+ *
+ */
+uint64_t hash_page(const uint8_t *data)
+{
+    uint64_t h[4] = {0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full, 0x165667b19e3779f9ull, 0x27d4eb2f165667c5ull};
+    for (std::size_t i = 0; i < dirty_tracker::page_size; i += 32) {
+        for (std::size_t k = 0; k < 4; ++k) {
+            uint64_t w;
+            std::memcpy(&w, data + i + k * 8, 8);
+            h[k] = (h[k] ^ w) * 0xff51afd7ed558ccdull;
+            h[k] ^= h[k] >> 29;
+        }
+    }
+    uint64_t result = h[0] ^ (h[1] * 3) ^ (h[2] * 5) ^ (h[3] * 7);
+    return result == unreadable ? 1 : result;
+}
+
+}   // namespace
+
+dirty_tracker::dirty_tracker(inferior_memory &memory)
+    : m_memory(memory), m_pid{0}, m_pagemap{-1}, m_clear_refs{-1}, m_mode{tracking_mode::none}, m_bytes_read{0}, m_seconds{0}
+{
+}
+
+dirty_tracker::~dirty_tracker()
+{
+    detach();
+}
+
+void dirty_tracker::attach(pid_t pid)
+{
+    detach();
+    m_pid = pid;
+    std::string proc = "/proc/" + std::to_string(pid);
+    m_pagemap = open((proc + "/pagemap").c_str(), O_RDONLY | O_CLOEXEC);
+    m_clear_refs = open((proc + "/clear_refs").c_str(), O_WRONLY | O_CLOEXEC);
+    m_regions = memory_search::read_maps(pid);
+    if (soft_dirty_works()) {
+        m_mode = tracking_mode::soft_dirty;
+    } else {
+        // 没有上次的哈希，这次采集只建立基线
+        m_mode = tracking_mode::hashing;
+        collect_hashes();
+    }
+    m_changes = page_changes{};
+}
+
+void dirty_tracker::detach()
+{
+    if (m_pagemap >= 0)
+        close(m_pagemap);
+    if (m_clear_refs >= 0)
+        close(m_clear_refs);
+    m_pagemap = -1;
+    m_clear_refs = -1;
+    m_mode = tracking_mode::none;
+    m_changes = page_changes{};
+    m_regions.clear();
+    m_hashes.clear();
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_bytes_read = 0;
+    m_seconds = 0;
+}
+
+const page_changes *dirty_tracker::collect()
+{
+    if (m_mode == tracking_mode::none)
+        return nullptr;
+    auto start = std::chrono::steady_clock::now();
+    m_changes.tracked.clear();
+    m_changes.dirty.clear();
+    m_bytes_read = 0;
+    m_regions = memory_search::read_maps(m_pid);
+    if (m_mode == tracking_mode::soft_dirty)
+        collect_soft_dirty();
+    else
+        collect_hashes();
+    m_seconds = since(start);
+    return &m_changes;
+}
+
+uint64_t dirty_tracker::tracked_bytes() const
+{
+    uint64_t total = 0;
+    for (const auto &r : m_regions) {
+        if (r.readable && !r.shared && !special(r))
+            total += r.hi - r.lo;
+    }
+    return total;
+}
+
+bool dirty_tracker::clear_soft_dirty()
+{
+    return m_clear_refs >= 0 && pwrite(m_clear_refs, "4", 1, 0) == 1;
+}
+
+bool dirty_tracker::soft_dirty_works()
+{
+    if (m_pagemap < 0 || m_clear_refs < 0)
+        return false;
+    // 清除后原样写回一个字节，该页的软脏位应被置上；未配置 CONFIG_MEM_SOFT_DIRTY 的内核写 clear_refs 即失败
+    for (const auto &r : m_regions) {
+        if (!r.readable || !r.writable || r.shared || special(r))
+            continue;
+        uint8_t byte;
+        if (m_memory.read(r.lo, &byte, 1) != 1)
+            continue;
+        std::vector<uint64_t> dirty;
+        if (!clear_soft_dirty() || !m_memory.write(r.lo, &byte, 1) || !read_soft_dirty(r.lo, r.lo + page_size, dirty))
+            return false;
+        return !dirty.empty() && clear_soft_dirty();
+    }
+    return false;
+}
+
+bool dirty_tracker::read_soft_dirty(uint64_t lo, uint64_t hi, std::vector<uint64_t> &dirty)
+{
+    m_buffer.resize(chunk_bytes);
+    std::size_t per_chunk = chunk_bytes / sizeof(uint64_t);
+    for (uint64_t base = lo; base < hi; base += per_chunk * page_size) {
+        std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(per_chunk, (hi - base) / page_size));
+        std::size_t want = n * sizeof(uint64_t);
+        ssize_t got = pread(m_pagemap, m_buffer.data(), want, static_cast<off_t>(base / page_size * sizeof(uint64_t)));
+        if (got != static_cast<ssize_t>(want))
+            return false;
+        m_bytes_read += want;
+        for (std::size_t i = 0; i < n; ++i) {
+            uint64_t entry;
+            std::memcpy(&entry, m_buffer.data() + i * sizeof(uint64_t), sizeof(entry));
+            if (entry & soft_dirty_bit)
+                dirty.push_back(base + i * page_size);
+        }
+    }
+    return true;
+}
+
+void dirty_tracker::collect_soft_dirty()
+{
+    // 未访问过的页没有页表项，其软脏位取自映射本身，新建或扩展的映射整体算作被写过
+    for (const auto &r : m_regions) {
+        if (!r.readable || r.shared || special(r))
+            continue;
+        std::size_t before = m_changes.dirty.size();
+        if (read_soft_dirty(r.lo, r.hi, m_changes.dirty))
+            m_changes.tracked.emplace_back(r.lo, r.hi);
+        else
+            m_changes.dirty.resize(before);
+    }
+    // 清除失败时软脏位保留，下次采集多报而不会漏报
+    clear_soft_dirty();
+}
+
+void dirty_tracker::collect_hashes()
+{
+    std::vector<hashed_region> fresh;
+    uint64_t budget = max_hash_bytes;
+    m_buffer.resize(chunk_bytes);
+    // 只读的映射只能由调试器写入，不跟踪
+    for (const auto &r : m_regions) {
+        if (!r.readable || !r.writable || r.shared || special(r))
+            continue;
+        if (r.hi - r.lo > budget)
+            break;
+        budget -= r.hi - r.lo;
+        hashed_region h{r.lo, r.hi, {}};
+        h.hashes.reserve((r.hi - r.lo) / page_size);
+        for (uint64_t a = r.lo; a < r.hi; a += chunk_bytes) {
+            std::size_t want = static_cast<std::size_t>(std::min<uint64_t>(chunk_bytes, r.hi - a));
+            std::size_t pos = 0;
+            while (pos < want) {
+                std::size_t got = m_memory.read(a + pos, m_buffer.data() + pos, want - pos) / page_size * page_size;
+                m_bytes_read += got;
+                for (std::size_t p = pos; p < pos + got; p += page_size)
+                    h.hashes.push_back(hash_page(m_buffer.data() + p));
+                pos += got;
+                if (pos < want) {
+                    h.hashes.push_back(unreadable);
+                    pos += page_size;
+                }
+            }
+        }
+
+        // 与上次采集时起点相同的映射比较两者共有的部分
+        auto prev = std::lower_bound(m_hashes.begin(), m_hashes.end(), r.lo,
+                                     [](const hashed_region &x, uint64_t v) { return x.lo < v; });
+        if (prev != m_hashes.end() && prev->lo == r.lo) {
+            std::size_t n = std::min(prev->hashes.size(), h.hashes.size());
+            for (std::size_t i = 0; i < n; ++i) {
+                if (prev->hashes[i] != h.hashes[i])
+                    m_changes.dirty.push_back(r.lo + i * page_size);
+            }
+            m_changes.tracked.emplace_back(r.lo, r.lo + n * page_size);
+        }
+        fresh.push_back(std::move(h));
+    }
+    m_hashes = std::move(fresh);
+}
+
+}   // namespace minidbg
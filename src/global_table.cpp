@@ -0,0 +1,169 @@
+#include "global_table.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <sstream>
+
+namespace minidbg {
+
+constexpr std::size_t global_table::max_value_bytes;
+constexpr uint64_t global_table::merge_gap;
+
+static constexpr uint8_t op_addr = 0x03;                // DW_OP_addr
+static constexpr uint8_t op_form_tls_address = 0x9b;    // DW_OP_form_tls_address
+static constexpr uint8_t op_gnu_push_tls_address = 0xe0;
+
+global_table::global_table(inferior_memory &memory, type_db &types)
+    : m_memory(memory), m_types(types), m_built{false}, m_have_previous{false}
+{
+}
+
+void global_table::reset(const dwarf::dwarf &dw)
+{
+    m_dwarf = dw;
+    m_built = false;
+    m_vars.clear();
+    m_units.clear();
+    m_layout.clear();
+    m_spans.clear();
+    m_image.clear();
+    m_previous.clear();
+    m_done.clear();
+    m_seen.clear();
+    m_have_previous = false;
+}
+
+void global_table::collect(const dwarf::die &parent, const std::string &prefix, uint64_t load_address)
+{
+    for (const auto &die : parent) {
+        if (die.tag == dwarf::DW_TAG::namespace_) {
+            std::string name = die.has(dwarf::DW_AT::name) ? die[dwarf::DW_AT::name].as_string() : "(anonymous namespace)";
+            collect(die, prefix + name + "::", load_address);
+            continue;
+        }
+        // 函数内的静态变量，名字前加函数名
+        if (die.tag == dwarf::DW_TAG::subprogram) {
+            auto name = die.resolve(dwarf::DW_AT::name);
+            if (name.valid())
+                collect(die, prefix + name.as_string() + "::", load_address);
+            continue;
+        }
+        if (die.tag == dwarf::DW_TAG::lexical_block) {
+            collect(die, prefix, load_address);
+            continue;
+        }
+        if (die.tag != dwarf::DW_TAG::variable || !die.has(dwarf::DW_AT::location))
+            continue;
+        // 类的静态成员等在类外定义，名字在 DW_AT_specification 指向的声明中
+        auto name = die.resolve(dwarf::DW_AT::name);
+        if (!name.valid())
+            continue;
+        auto location = die[dwarf::DW_AT::location];
+        if (location.get_type() != dwarf::value::type::exprloc && location.get_type() != dwarf::value::type::block)
+            continue;
+        std::size_t size = 0;
+        auto ops = static_cast<const uint8_t *>(location.as_block(&size));
+        // 静态存储的变量只有 DW_OP_addr <地址>；其后跟TLS操作的是线程局部变量
+        if (size < 9 || ops[0] != op_addr)
+            continue;
+        uint64_t addr;
+        std::memcpy(&addr, ops + 1, sizeof(addr));
+        bool tls = size > 9 && (ops[9] == op_form_tls_address || ops[9] == op_gnu_push_tls_address);
+        if ((size > 9 && !tls) || (!tls && !m_seen.insert(addr).second))
+            continue;       // 内联函数的多个实例可能重复描述同一个静态变量
+
+        auto external = die.resolve(dwarf::DW_AT::external);
+        global_variable var{prefix + name.as_string(), !(external.valid() && external.as_flag()), tls ? 0 : addr + load_address, std::string{}, std::string{}};
+        layout lay{m_types.of_variable(die), 0, 0};
+        var.type = m_types.type_name(lay.type);
+        if (tls)
+            var.value = "<thread-local>";
+        else
+            lay.len = m_types.value_size(lay.type, max_value_bytes);
+        m_vars.push_back(std::move(var));
+        m_layout.push_back(lay);
+    }
+}
+
+void global_table::build(uint64_t load_address)
+{
+    m_built = true;
+    if (!m_dwarf.valid())
+        return;
+    for (const auto &cu : m_dwarf.compilation_units()) {
+        const auto &root = cu.root();
+        global_unit unit{root.has(dwarf::DW_AT::name) ? root[dwarf::DW_AT::name].as_string() : std::string("<unknown>"), m_vars.size(), 0};
+        collect(root, std::string{}, load_address);
+        unit.count = m_vars.size() - unit.first;
+        if (unit.count > 0)
+            m_units.push_back(std::move(unit));
+    }
+
+    // 按地址把变量合并成段：.data 和 .bss 中相邻的变量通常落在同一段里
+    std::vector<std::size_t> order(m_vars.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return m_vars[a].address < m_vars[b].address; });
+    std::size_t total = 0;
+    for (auto i : order) {
+        if (m_layout[i].len == 0)
+            continue;
+        uint64_t addr = m_vars[i].address;
+        uint64_t end = addr + m_layout[i].len;
+        if (m_spans.empty() || addr > m_spans.back().addr + m_spans.back().len + merge_gap) {
+            m_spans.push_back(span{addr, 0, total});
+        }
+        auto &s = m_spans.back();
+        if (end > s.addr + s.len) {
+            total += end - (s.addr + s.len);
+            s.len = end - s.addr;
+        }
+        m_layout[i].offset = s.offset + (addr - s.addr);
+    }
+    m_image.assign(total, 0);
+    m_previous.assign(total, 0);
+    m_done.assign(m_spans.size(), 0);
+}
+
+void global_table::refresh(uint64_t load_address)
+{
+    if (!m_built)
+        build(load_address);
+    if (m_spans.empty())
+        return;
+
+    // 全部段一次 process_vm_readv
+    m_image.swap(m_previous);
+    std::vector<std::size_t> previous_done(m_done);
+    std::vector<mem_request> reqs;
+    reqs.reserve(m_spans.size());
+    for (const auto &s : m_spans)
+        reqs.push_back(mem_request{s.addr, m_image.data() + s.offset, s.len, 0});
+    m_memory.read_batch(reqs.data(), reqs.size());
+    for (std::size_t i = 0; i < reqs.size(); ++i)
+        m_done[i] = reqs[i].done;
+
+    for (std::size_t i = 0; i < m_vars.size(); ++i) {
+        const auto &lay = m_layout[i];
+        if (lay.len == 0)
+            continue;
+        // 变量所在的段：offset 落在其中的那一段
+        auto it = std::upper_bound(m_spans.begin(), m_spans.end(), lay.offset,
+                                   [](std::size_t offset, const span &s) { return offset < s.offset; });
+        std::size_t index = std::prev(it) - m_spans.begin();
+        std::size_t valid_end = m_spans[index].offset + m_done[index];
+        std::size_t previous_end = m_spans[index].offset + previous_done[index];
+        if (lay.offset + lay.len > valid_end) {
+            std::ostringstream oss;
+            oss << "<cannot access memory at 0x" << std::hex << m_vars[i].address << ">";
+            m_vars[i].value = oss.str();
+            continue;
+        }
+        if (m_have_previous && lay.offset + lay.len <= previous_end
+            && std::memcmp(m_image.data() + lay.offset, m_previous.data() + lay.offset, lay.len) == 0)
+            continue;       // 字节未变，沿用上次的值
+        m_vars[i].value = m_types.format(lay.type, m_image.data() + lay.offset, lay.len);
+    }
+    m_have_previous = true;
+}
+
+}   // namespace minidbg
@@ -0,0 +1,154 @@
+#include "inferior_memory.h"
+#include <sys/ptrace.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <cstring>
+#include <algorithm>
+#include <string>
+
+namespace minidbg {
+
+inferior_memory::inferior_memory() : m_pid{0}, m_fd{-1}
+{
+}
+
+inferior_memory::~inferior_memory()
+{
+    detach();
+}
+
+void inferior_memory::attach(pid_t pid)
+{
+    detach();
+    m_pid = pid;
+    std::string path = "/proc/" + std::to_string(pid) + "/mem";
+    m_fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+}
+
+void inferior_memory::detach()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+    m_fd = -1;
+}
+
+size_t inferior_memory::read(uint64_t addr, void *buf, size_t len)
+{
+    if (len == 0) return 0;
+
+    struct iovec local{buf, len};
+    struct iovec remote{reinterpret_cast<void *>(addr), len};
+    ssize_t n = process_vm_readv(m_pid, &local, 1, &remote, 1, 0);
+    size_t done = n > 0 ? static_cast<size_t>(n) : 0;
+    if (done == len) return done;
+
+    // process_vm_readv 不可用或遇到不可读的页，剩余部分逐页尝试 /proc/pid/mem
+    if (m_fd >= 0) {
+        while (done < len) {
+            ssize_t r = pread(m_fd, static_cast<char *>(buf) + done, len - done, addr + done);
+            if (r <= 0) break;
+            done += r;
+        }
+        return done;
+    }
+    return done + peek_read(addr + done, static_cast<char *>(buf) + done, len - done);
+}
+
+size_t inferior_memory::read_batch(mem_request *reqs, size_t n)
+{
+    size_t complete = 0;
+    std::vector<struct iovec> local;
+    std::vector<struct iovec> remote;
+
+    size_t i = 0;
+    while (i < n) {
+        // 一次系统调用最多携带 IOV_MAX 个远端区间
+        size_t batch_end = std::min(n, i + static_cast<size_t>(IOV_MAX));
+        local.clear();
+        remote.clear();
+        size_t expected = 0;
+        for (size_t k = i; k < batch_end; ++k) {
+            reqs[k].done = 0;
+            local.push_back({reqs[k].buf, reqs[k].len});
+            remote.push_back({reinterpret_cast<void *>(reqs[k].addr), reqs[k].len});
+            expected += reqs[k].len;
+        }
+
+        ssize_t got = process_vm_readv(m_pid, local.data(), local.size(), remote.data(), remote.size(), 0);
+        size_t left = got > 0 ? static_cast<size_t>(got) : 0;
+
+        // 按顺序认领已传输的字节；第一个未读完的请求单独处理，其后的请求进入下一轮批量读取
+        size_t k = i;
+        for (; k < batch_end && left >= reqs[k].len; ++k) {
+            reqs[k].done = reqs[k].len;
+            left -= reqs[k].len;
+            ++complete;
+        }
+        if (got >= 0 && static_cast<size_t>(got) == expected) {
+            i = batch_end;
+            continue;
+        }
+        if (k < batch_end) {
+            reqs[k].done = read(reqs[k].addr, reqs[k].buf, reqs[k].len);
+            if (reqs[k].done == reqs[k].len) ++complete;
+            ++k;
+        }
+        i = k;
+    }
+    return complete;
+}
+
+bool inferior_memory::write(uint64_t addr, const void *buf, size_t len)
+{
+    if (m_fd < 0) {
+        return poke_write(addr, buf, len);
+    }
+    size_t done = 0;
+    while (done < len) {
+        ssize_t w = pwrite(m_fd, static_cast<const char *>(buf) + done, len - done, addr + done);
+        if (w <= 0) {
+            return poke_write(addr + done, static_cast<const char *>(buf) + done, len - done);
+        }
+        done += w;
+    }
+    return true;
+}
+
+size_t inferior_memory::peek_read(uint64_t addr, void *buf, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        uint64_t word_addr = (addr + done) & ~7ull;
+        errno = 0;
+        long data = ptrace(PTRACE_PEEKDATA, m_pid, word_addr, nullptr);
+        if (errno != 0) break;
+        size_t skip = (addr + done) - word_addr;
+        size_t take = std::min(len - done, 8 - skip);
+        std::memcpy(static_cast<char *>(buf) + done, reinterpret_cast<char *>(&data) + skip, take);
+        done += take;
+    }
+    return done;
+}
+
+bool inferior_memory::poke_write(uint64_t addr, const void *buf, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        uint64_t word_addr = (addr + done) & ~7ull;
+        errno = 0;
+        long data = ptrace(PTRACE_PEEKDATA, m_pid, word_addr, nullptr);
+        if (errno != 0) return false;
+        size_t skip = (addr + done) - word_addr;
+        size_t take = std::min(len - done, 8 - skip);
+        std::memcpy(reinterpret_cast<char *>(&data) + skip, static_cast<const char *>(buf) + done, take);
+        if (ptrace(PTRACE_POKEDATA, m_pid, word_addr, data) != 0) return false;
+        done += take;
+    }
+    return true;
+}
+
+}   // namespace minidbg
@@ -0,0 +1,147 @@
+#include "inline_index.h"
+#include <algorithm>
+
+namespace minidbg {
+
+inline_index::inline_index() : m_built{false}
+{
+}
+
+void inline_index::reset(const dwarf::dwarf &dw)
+{
+    m_dwarf = dw;
+    m_built = false;
+    m_nodes.clear();
+    m_segments.clear();
+}
+
+void inline_index::collect(const dwarf::die &die, const dwarf::line_table &lines, int parent)
+{
+    for (const auto &child : die) {
+        bool function = child.tag == dwarf::DW_TAG::subprogram || child.tag == dwarf::DW_TAG::inlined_subroutine;
+        if (!function) {
+            // 词法块和命名空间本身不是帧，但其中可能有内联展开或函数定义
+            if (child.tag == dwarf::DW_TAG::lexical_block || child.tag == dwarf::DW_TAG::namespace_)
+                collect(child, lines, parent);
+            continue;
+        }
+        // 抽象实例和声明没有地址
+        if (!child.has(dwarf::DW_AT::low_pc) && !child.has(dwarf::DW_AT::ranges))
+            continue;
+
+        inline_node node;
+        node.inlined = child.tag == dwarf::DW_TAG::inlined_subroutine;
+        node.parent = parent;
+        node.call_line = 0;
+        node.entry = UINT64_MAX;
+        node.die = child;
+        auto name = child.resolve(dwarf::DW_AT::name);
+        node.name = name.valid() ? name.as_string() : "??";
+        try {
+            for (const auto &range : dwarf::die_pc_range(child)) {
+                if (range.low < range.high) {
+                    node.ranges.emplace_back(range.low, range.high);
+                    node.entry = std::min(node.entry, range.low);
+                }
+            }
+            if (node.inlined && child.has(dwarf::DW_AT::call_file) && lines.valid())
+                node.call_file = lines.get_file(child[dwarf::DW_AT::call_file].as_uconstant())->path;
+            if (node.inlined && child.has(dwarf::DW_AT::call_line))
+                node.call_line = child[dwarf::DW_AT::call_line].as_uconstant();
+        } catch (const std::exception &) {
+            // 无法解析的范围或文件编号，保留已得到的部分
+        }
+        if (node.ranges.empty())
+            continue;
+
+        int index = static_cast<int>(m_nodes.size());
+        m_nodes.push_back(std::move(node));
+        collect(child, lines, index);
+    }
+}
+
+void inline_index::build()
+{
+    m_built = true;
+    if (!m_dwarf.valid())
+        return;
+    for (const auto &cu : m_dwarf.compilation_units()) {
+        dwarf::line_table lines;
+        try {
+            lines = cu.get_line_table();
+        } catch (const std::exception &) {
+        }
+        collect(cu.root(), lines, -1);
+    }
+
+    struct interval {
+        uint64_t lo;
+        uint64_t hi;
+        int node;
+    };
+    std::vector<interval> intervals;
+    for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+        for (const auto &range : m_nodes[i].ranges)
+            intervals.push_back(interval{range.first, range.second, static_cast<int>(i)});
+    }
+    // 起点相同时外层（更长、编号更小）的区间在前
+    std::sort(intervals.begin(), intervals.end(), [](const interval &a, const interval &b) {
+        if (a.lo != b.lo) return a.lo < b.lo;
+        if (a.hi != b.hi) return a.hi > b.hi;
+        return a.node < b.node;
+    });
+
+    // 扫描嵌套区间：栈顶为当前最内层，每当区间开始或结束就输出一段
+    auto emit = [this](uint64_t lo, uint64_t hi, int node) {
+        if (lo >= hi) return;
+        if (!m_segments.empty() && m_segments.back().hi == lo && m_segments.back().node == node)
+            m_segments.back().hi = hi;
+        else
+            m_segments.push_back(segment{lo, hi, node});
+    };
+    std::vector<interval> stack;
+    uint64_t cur = 0;
+    for (auto iv : intervals) {
+        while (!stack.empty() && stack.back().hi <= iv.lo) {
+            emit(cur, stack.back().hi, stack.back().node);
+            cur = stack.back().hi;
+            stack.pop_back();
+        }
+        if (!stack.empty()) {
+            emit(cur, iv.lo, stack.back().node);
+            iv.hi = std::min(iv.hi, stack.back().hi);      // 没有严格嵌套的区间截断到外层之内
+        }
+        cur = iv.lo;
+        if (iv.lo < iv.hi)
+            stack.push_back(iv);
+    }
+    while (!stack.empty()) {
+        emit(cur, stack.back().hi, stack.back().node);
+        cur = stack.back().hi;
+        stack.pop_back();
+    }
+}
+
+void inline_index::chain(uint64_t pc, std::vector<int> &out)
+{
+    out.clear();
+    if (!m_built)
+        build();
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), pc,
+                               [](uint64_t v, const segment &s) { return v < s.lo; });
+    if (it == m_segments.begin() || pc >= std::prev(it)->hi)
+        return;
+    for (int n = std::prev(it)->node; n >= 0; n = m_nodes[n].parent)
+        out.push_back(n);
+}
+
+bool inline_index::contains(int i, uint64_t pc) const
+{
+    for (const auto &range : m_nodes[i].ranges) {
+        if (pc >= range.first && pc < range.second)
+            return true;
+    }
+    return false;
+}
+
+}   // namespace minidbg
@@ -0,0 +1,408 @@
+#include "insn_decoder.h"
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <algorithm>
+
+namespace minidbg {
+
+static constexpr uint64_t xsave_area = 4096;    // xsave 系列写入的最大区域（与CPU特性有关，取保守值）
+static constexpr uint64_t max_syscall_buffer = 64 << 20;
+
+/**
+ * @brief 按 x86 编码中的寄存器编号（含 REX 扩展位）取通用寄存器的值。
+ *
+ */
+static uint64_t gpr(const user_regs_struct &regs, unsigned n)
+{
+    switch (n) {
+    case 0: return regs.rax;
+    case 1: return regs.rcx;
+    case 2: return regs.rdx;
+    case 3: return regs.rbx;
+    case 4: return regs.rsp;
+    case 5: return regs.rbp;
+    case 6: return regs.rsi;
+    case 7: return regs.rdi;
+    case 8: return regs.r8;
+    case 9: return regs.r9;
+    case 10: return regs.r10;
+    case 11: return regs.r11;
+    case 12: return regs.r12;
+    case 13: return regs.r13;
+    case 14: return regs.r14;
+    default: return regs.r15;
+    }
+}
+
+/**
+ * @brief 操作码之后没有 ModRM 字节的双字节（0F）指令。
+ *
+ */
+static bool map1_has_modrm(uint8_t op)
+{
+    if (op >= 0x80 && op <= 0x8f) return false;     // jcc rel32
+    if (op >= 0xc8 && op <= 0xcf) return false;     // bswap
+    if (op >= 0x30 && op <= 0x37) return false;     // wrmsr、rdtsc、sysenter 等
+    switch (op) {
+    case 0x05: case 0x06: case 0x07: case 0x08: case 0x09: case 0x0b: case 0x0e:
+    case 0x77: case 0xa0: case 0xa1: case 0xa2: case 0xa8: case 0xa9: case 0xaa:
+        return false;
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief 立即数长度，只用于计算 RIP 相对寻址的下一条指令地址。
+ *
+ */
+static unsigned immediate_size(unsigned map, uint8_t op, unsigned reg, bool op66)
+{
+    unsigned imm_z = op66 ? 2 : 4;
+    if (map == 0) {
+        switch (op) {
+        case 0x69: case 0x81: case 0xc7: return imm_z;
+        case 0x6b: case 0x80: case 0x82: case 0x83: case 0xc0: case 0xc1: case 0xc6: return 1;
+        case 0xf6: return reg <= 1 ? 1 : 0;
+        case 0xf7: return reg <= 1 ? imm_z : 0;
+        default: return 0;
+        }
+    }
+    if (map == 1) {
+        switch (op) {
+        case 0x70: case 0x71: case 0x72: case 0x73: case 0xa4: case 0xac: case 0xba:
+        case 0xc2: case 0xc4: case 0xc5: case 0xc6:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+    return map == 3 ? 1 : 0;
+}
+
+/**
+ * @brief 常见系统调用由内核写入的用户缓冲区。参数不是有效指针时读取原始内容会失败，不影响正确性。
+ *
+ */
+static void syscall_writes(const user_regs_struct &regs, std::vector<mem_write> &out)
+{
+    auto buffer = [&out](uint64_t addr, uint64_t len) {
+        if (addr != 0 && len != 0) out.push_back({addr, std::min(len, max_syscall_buffer)});
+    };
+    switch (regs.rax) {
+    case SYS_read: case SYS_pread64: case SYS_recvfrom: case SYS_readlink: case SYS_getdents64:
+        buffer(regs.rsi, regs.rdx);
+        break;
+    case SYS_getrandom:
+        buffer(regs.rdi, regs.rsi);
+        break;
+    case SYS_fstat: case SYS_stat: case SYS_lstat:
+        buffer(regs.rsi, sizeof(struct stat));
+        break;
+    case SYS_newfstatat:
+        buffer(regs.rdx, sizeof(struct stat));
+        break;
+    case SYS_clock_gettime:
+        buffer(regs.rsi, 16);
+        break;
+    case SYS_gettimeofday: case SYS_pipe: case SYS_pipe2:
+        buffer(regs.rdi, 16);
+        break;
+    case SYS_uname:
+        buffer(regs.rdi, sizeof(struct utsname));
+        break;
+    case SYS_ioctl:
+        buffer(regs.rdx, 64);
+        break;
+    case SYS_rt_sigaction:
+        buffer(regs.rdx, 32);
+        break;
+    case SYS_rt_sigprocmask:
+        buffer(regs.rdx, 8);
+        break;
+    case SYS_wait4:
+        buffer(regs.rsi, 4);
+        break;
+    }
+}
+
+bool decode_mem_writes(const uint8_t *code, std::size_t len, const user_regs_struct &regs, std::vector<mem_write> &out)
+{
+    std::size_t i = 0;
+    bool op66 = false, addr32 = false, rep_f2 = false, rep_f3 = false;
+    uint64_t seg_base = 0;
+    auto byte = [&](std::size_t k) -> uint8_t { return k < len ? code[k] : 0; };
+
+    // 传统前缀
+    for (; i < len && i < 14; ++i) {
+        uint8_t b = code[i];
+        if (b == 0x66) op66 = true;
+        else if (b == 0x67) addr32 = true;
+        else if (b == 0xf2) rep_f2 = true;
+        else if (b == 0xf3) rep_f3 = true;
+        else if (b == 0x64) seg_base = regs.fs_base;
+        else if (b == 0x65) seg_base = regs.gs_base;
+        else if (b == 0xf0 || b == 0x2e || b == 0x36 || b == 0x3e || b == 0x26) continue;
+        else break;
+    }
+    bool rexw = false, rexx = false, rexb = false;
+    if ((byte(i) & 0xf0) == 0x40) {
+        rexw = byte(i) & 8;
+        rexx = byte(i) & 2;
+        rexb = byte(i) & 1;
+        ++i;
+    }
+
+    // 操作码：map 0 为单字节，1/2/3 对应 0F、0F38、0F3A；VEX/EVEX 的 map 在前缀中
+    unsigned map = 0;
+    unsigned vec_bytes = 16;
+    bool vex = false, evex = false;
+    uint8_t b0 = byte(i);
+    if (b0 == 0x0f) {
+        ++i;
+        if (byte(i) == 0x38) { map = 2; ++i; }
+        else if (byte(i) == 0x3a) { map = 3; ++i; }
+        else map = 1;
+    } else if (b0 == 0xc5) {
+        uint8_t p = byte(i + 1);
+        map = 1;
+        vec_bytes = (p & 4) ? 32 : 16;
+        op66 = (p & 3) == 1; rep_f3 = (p & 3) == 2; rep_f2 = (p & 3) == 3;
+        vex = true;
+        i += 2;
+    } else if (b0 == 0xc4) {
+        uint8_t p0 = byte(i + 1), p1 = byte(i + 2);
+        rexx = !(p0 & 0x40);
+        rexb = !(p0 & 0x20);
+        map = p0 & 0x1f;
+        rexw = p1 & 0x80;
+        vec_bytes = (p1 & 4) ? 32 : 16;
+        op66 = (p1 & 3) == 1; rep_f3 = (p1 & 3) == 2; rep_f2 = (p1 & 3) == 3;
+        vex = true;
+        i += 3;
+    } else if (b0 == 0x62) {
+        uint8_t p0 = byte(i + 1), p1 = byte(i + 2), p2 = byte(i + 3);
+        rexx = !(p0 & 0x40);
+        rexb = !(p0 & 0x20);
+        map = p0 & 0x07;
+        rexw = p1 & 0x80;
+        op66 = (p1 & 3) == 1; rep_f3 = (p1 & 3) == 2; rep_f2 = (p1 & 3) == 3;
+        vec_bytes = 16u << ((p2 >> 5) & 3);
+        evex = true;
+        i += 4;
+    }
+    if (map > 3) {
+        return false;
+    }
+    uint8_t op = byte(i++);
+    unsigned gpr_width = rexw ? 8 : op66 ? 2 : 4;
+
+    // 不带 ModRM 的隐式写入
+    bool has_modrm;
+    if (map == 0) {
+        uint64_t rsp = regs.rsp;
+        if ((op >= 0x50 && op <= 0x57) || op == 0x68 || op == 0x6a || op == 0x9c || op == 0xe8) {
+            out.push_back({rsp - 8, 8});                // push、pushf、call
+            return true;
+        }
+        if (op == 0xc8) {
+            uint64_t level = byte(i + 2) & 0x1f;        // enter imm16, imm8
+            out.push_back({rsp - 8 * (level + 1), 8 * (level + 1)});
+            return true;
+        }
+        if (op == 0xa4 || op == 0xa5 || op == 0xaa || op == 0xab) {
+            uint64_t size = (op == 0xa4 || op == 0xaa) ? 1 : gpr_width;
+            uint64_t count = (rep_f2 || rep_f3) ? (addr32 ? regs.rcx & 0xffffffff : regs.rcx) : 1;
+            uint64_t dest = addr32 ? regs.rdi & 0xffffffff : regs.rdi;
+            if (count == 0) return true;
+            uint64_t bytes = count * size;
+            if (regs.eflags & 0x400) {                  // DF=1 时地址递减
+                dest = dest + size - bytes;
+            }
+            out.push_back({dest, bytes});
+            return true;
+        }
+        static const uint8_t with_modrm[] = {
+            0x62, 0x63, 0x69, 0x6b, 0xc0, 0xc1, 0xc4, 0xc5, 0xc6, 0xc7,
+            0xd0, 0xd1, 0xd2, 0xd3, 0xf6, 0xf7, 0xfe, 0xff};
+        has_modrm = (op < 0x40 && (op & 7) <= 3) || (op >= 0x80 && op <= 0x8f) || (op >= 0xd8 && op <= 0xdf);
+        for (auto m : with_modrm) has_modrm = has_modrm || op == m;
+    } else if (map == 1) {
+        if (op == 0x05) {
+            syscall_writes(regs, out);
+            return true;
+        }
+        has_modrm = map1_has_modrm(op);
+    } else {
+        has_modrm = true;
+    }
+    if (!has_modrm) {
+        return true;
+    }
+
+    // ModRM / SIB / 位移
+    uint8_t modrm = byte(i++);
+    unsigned mod = modrm >> 6, reg = (modrm >> 3) & 7, rm = modrm & 7;
+    bool memory = mod != 3;
+
+    // FF /2 call 与 FF /6 push 的栈写入与操作数是否为内存无关
+    if (map == 0 && op == 0xff && (reg == 2 || reg == 6)) {
+        out.push_back({regs.rsp - 8, 8});
+        return true;
+    }
+    if (!memory) {
+        return true;
+    }
+
+    uint64_t ea = 0;
+    bool rip_relative = false;
+    bool vsib = false;
+    if (rm == 4) {
+        uint8_t sib = byte(i++);
+        unsigned scale = sib >> 6;
+        unsigned index = ((sib >> 3) & 7) | (rexx ? 8 : 0);
+        unsigned base = (sib & 7) | (rexb ? 8 : 0);
+        if (index != 4) {
+            ea += gpr(regs, index) << scale;
+        }
+        if ((sib & 7) == 5 && mod == 0) {
+            ea += static_cast<int64_t>(static_cast<int32_t>(byte(i) | byte(i + 1) << 8 | byte(i + 2) << 16 | byte(i + 3) << 24));
+            i += 4;
+        } else {
+            ea += gpr(regs, base);
+        }
+        vsib = (vex || evex) && map == 2 && op >= 0x90 && op <= 0xa3;
+    } else if (rm == 5 && mod == 0) {
+        rip_relative = true;
+    } else {
+        ea = gpr(regs, rm | (rexb ? 8 : 0));
+    }
+    if (mod == 1) {
+        int64_t disp = static_cast<int8_t>(byte(i++));
+        ea += evex ? disp * vec_bytes : disp;     // EVEX disp8*N，按整向量宽度近似
+    } else if (mod == 2 || rip_relative) {
+        ea += static_cast<int64_t>(static_cast<int32_t>(byte(i) | byte(i + 1) << 8 | byte(i + 2) << 16 | byte(i + 3) << 24));
+        i += 4;
+    }
+    if (rip_relative) {
+        ea += regs.rip + i + immediate_size(map, op, reg, op66);
+    }
+    if (addr32) {
+        ea &= 0xffffffff;
+    }
+    ea += seg_base;
+
+    // 判断内存操作数是否被写入及宽度
+    uint64_t width = 0;
+    if (vex || evex) {
+        if (vsib) {
+            return !(map == 2 && op >= 0xa0);         // scatter 的目标由向量索引决定，无法得知
+        }
+        if (map == 1) {
+            switch (op) {
+            case 0x11: case 0x29: case 0x2b: case 0x7f: case 0xe7: width = vec_bytes; break;
+            case 0x13: case 0x17: case 0xd6: width = 8; break;
+            case 0x7e: width = rep_f3 ? 0 : (rexw ? 8 : 4); break;
+            }
+        } else if (map == 2) {
+            switch (op) {
+            case 0x2e: case 0x2f: case 0x8e: case 0x8a: case 0x8b: case 0x63: width = vec_bytes; break;
+            }
+        } else if (map == 3) {
+            switch (op) {
+            case 0x14: width = 1; break;
+            case 0x15: width = 2; break;
+            case 0x16: width = rexw ? 8 : 4; break;
+            case 0x17: width = 4; break;
+            case 0x19: case 0x1d: case 0x39: case 0x3b: width = vec_bytes / 2; break;
+            }
+        }
+    } else if (map == 0) {
+        bool byte_op = !(op & 1);
+        if (op < 0x40) {
+            // 算术组：方向位为0时目标是 r/m；cmp（38~3B）只读
+            if (!(op & 2) && (op >> 3) != 7) width = byte_op ? 1 : gpr_width;
+        } else {
+            switch (op) {
+            case 0x80: case 0x81: case 0x82: case 0x83:
+                if (reg != 7) width = (op == 0x80 || op == 0x82) ? 1 : gpr_width;
+                break;
+            case 0x86: case 0x87: case 0x88: case 0x89:
+                width = byte_op ? 1 : gpr_width;
+                break;
+            case 0x8c: width = 2; break;
+            case 0x8f: width = 8; break;
+            case 0xc0: case 0xc1: case 0xd0: case 0xd1: case 0xd2: case 0xd3:
+                width = (op == 0xc0 || op == 0xd0 || op == 0xd2) ? 1 : gpr_width;
+                break;
+            case 0xc6: case 0xc7: width = op == 0xc6 ? 1 : gpr_width; break;
+            case 0xf6: case 0xf7:
+                if (reg == 2 || reg == 3) width = op == 0xf6 ? 1 : gpr_width;
+                break;
+            case 0xfe: case 0xff:
+                if (reg <= 1) width = op == 0xfe ? 1 : gpr_width;
+                break;
+            case 0xd9:
+                if (reg == 2 || reg == 3) width = 4;
+                else if (reg == 6) width = 28;          // fnstenv
+                else if (reg == 7) width = 2;
+                break;
+            case 0xdb:
+                if (reg >= 1 && reg <= 3) width = 4;
+                else if (reg == 7) width = 10;
+                break;
+            case 0xdd:
+                if (reg >= 1 && reg <= 3) width = 8;
+                else if (reg == 6) width = 108;         // fnsave
+                else if (reg == 7) width = 2;
+                break;
+            case 0xdf:
+                if (reg >= 1 && reg <= 3) width = 2;
+                else if (reg == 6) width = 10;
+                else if (reg == 7) width = 8;
+                break;
+            }
+        }
+    } else if (map == 1) {
+        switch (op) {
+        case 0x11: case 0x29: case 0x2b: case 0x7f: case 0xe7: width = 16; break;
+        case 0x13: case 0x17: case 0xd6: width = 8; break;
+        case 0x7e: width = rep_f3 ? 0 : (rexw ? 8 : 4); break;
+        case 0xc3: width = gpr_width; break;
+        case 0x00: case 0x01: width = reg <= 1 ? 10 : 0; break;
+        case 0xa4: case 0xa5: case 0xac: case 0xad: case 0xab: case 0xb3: case 0xbb:
+        case 0xb0: case 0xb1: case 0xc0: case 0xc1:
+            width = gpr_width;
+            break;
+        case 0xba: width = reg >= 5 ? gpr_width : 0; break;
+        case 0xc7:
+            if (reg == 1) width = 16;
+            else if (reg == 4 || reg == 5) width = xsave_area;
+            break;
+        case 0xae:
+            if (reg == 0) width = 512;                  // fxsave
+            else if (reg == 3) width = 4;               // stmxcsr
+            else if (reg == 4 || (reg == 6 && !op66)) width = xsave_area;
+            break;
+        default:
+            if (op >= 0x90 && op <= 0x9f) width = 1;   // setcc
+            break;
+        }
+    } else if (map == 2) {
+        if (op == 0xf1 && !rep_f2) width = gpr_width;  // movbe 存储形式
+    } else if (map == 3) {
+        switch (op) {
+        case 0x14: width = 1; break;
+        case 0x15: width = 2; break;
+        case 0x16: width = rexw ? 8 : 4; break;
+        case 0x17: width = 4; break;
+        }
+    }
+    if (width != 0) {
+        out.push_back({ea, width});
+    }
+    return true;
+}
+
+}   // namespace minidbg
@@ -0,0 +1,49 @@
+#include "location_cache.h"
+#include <algorithm>
+
+namespace minidbg {
+
+void location_cache::decode(const dwarf::die &var, std::vector<entry> &out)
+{
+    if (!var.has(dwarf::DW_AT::location))
+        return;
+    auto value = var[dwarf::DW_AT::location];
+    switch (value.get_type()) {
+    case dwarf::value::type::exprloc:
+        out.push_back(entry{0, UINT64_MAX, value.as_exprloc()});
+        break;
+    case dwarf::value::type::loclist:
+        for (const auto &e : value.as_loclist()) {
+            if (e.low < e.high)
+                out.push_back(entry{e.low, e.high, e.location});
+        }
+        // 编译器生成的位置列表一般已按地址排序且互不重叠
+        std::stable_sort(out.begin(), out.end(), [](const entry &a, const entry &b) { return a.lo < b.lo; });
+        break;
+    default:
+        break;
+    }
+}
+
+const dwarf::expr *location_cache::find(const dwarf::die &var, uint64_t pc)
+{
+    auto it = m_tables.find(var.get_section_offset());
+    if (it == m_tables.end()) {
+        std::vector<entry> table;
+        try {
+            decode(var, table);
+        } catch (const std::exception &) {
+            // 位置列表损坏或缺少 .debug_loc，按没有位置处理
+            table.clear();
+        }
+        it = m_tables.emplace(var.get_section_offset(), std::move(table)).first;
+    }
+    const auto &table = it->second;
+    auto next = std::upper_bound(table.begin(), table.end(), pc,
+                                 [](uint64_t v, const entry &e) { return v < e.lo; });
+    if (next == table.begin() || pc >= std::prev(next)->hi)
+        return nullptr;
+    return &std::prev(next)->location;
+}
+
+}   // namespace minidbg
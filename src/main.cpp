@@ -51,6 +51,7 @@ int main(int argc, char *argv[])
         dbg.initDbg(prog, pid);
         dbg.break_execution("main");
         dbg.continue_execution();
+        dbg.checkpoint_at_main();
         // ui.buildWindows();
     }
 }
@@ -0,0 +1,233 @@
+#include "memory_search.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace minidbg {
+
+constexpr std::size_t memory_search::chunk_bytes;
+constexpr std::size_t memory_search::max_threads;
+constexpr std::size_t memory_search::default_limit;
+
+namespace {
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 读取这些内核映射会出错或没有意义
+bool skipped(const memory_region &r)
+{
+    return r.name == "[vvar]" || r.name == "[vvar_vclock]" || r.name == "[vsyscall]";
+}
+
+}   // namespace
+
+memory_search::memory_search(inferior_memory &memory)
+    : m_memory(memory), m_anchor{0}, m_limit{default_limit}, m_total{0}, m_next{0}, m_active{0}, m_found{0}, m_scanned{0},
+      m_cancel{false}, m_truncated{false}, m_elapsed_ns{0}, m_start_ns{0}
+{
+}
+
+memory_search::~memory_search()
+{
+    cancel();
+}
+
+std::vector<memory_region> memory_search::read_maps(pid_t pid)
+{
+    std::vector<memory_region> regions;
+    std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        unsigned long lo, hi, offset;
+        char perms[5] = {};
+        int path = 0;
+        if (std::sscanf(line.c_str(), "%lx-%lx %4s %lx %*s %*s %n", &lo, &hi, perms, &offset, &path) != 4)
+            continue;
+        std::string name = path > 0 && static_cast<std::size_t>(path) < line.size() ? line.substr(path) : std::string{};
+        regions.push_back(memory_region{lo, hi, perms[0] == 'r', perms[1] == 'w', perms[2] == 'x', perms[3] == 's', offset, name});
+    }
+    std::sort(regions.begin(), regions.end(), [](const memory_region &a, const memory_region &b) { return a.lo < b.lo; });
+    return regions;
+}
+
+bool memory_search::start(const std::vector<uint8_t> &pattern, uint64_t lo, uint64_t hi, std::size_t limit)
+{
+    cancel();
+    m_pattern = pattern;
+    m_chunks.clear();
+    m_pending.clear();
+    m_limit = limit;
+    m_total = 0;
+    m_error.clear();
+    m_next = 0;
+    m_found = 0;
+    m_scanned = 0;
+    m_cancel = false;
+    m_truncated = false;
+    m_elapsed_ns = 0;
+    m_regions = read_maps(m_memory.pid());
+    if (m_pattern.empty()) {
+        m_error = "empty search pattern";
+        return false;
+    }
+    bool whole = lo == 0 && hi == 0;
+
+    // 相邻的可读映射合并为连续的段，跨映射边界的命中也能找到；段按块切分，块尾多读模式长度减一的字节
+    std::size_t overlap = std::max(m_pattern.size(), search_hit{}.context.size()) - 1;
+    std::vector<std::pair<uint64_t, uint64_t>> runs;
+    for (const auto &r : m_regions) {
+        if (!r.readable || skipped(r))
+            continue;
+        uint64_t a = whole ? r.lo : std::max(r.lo, lo);
+        uint64_t b = whole ? r.hi : std::min(r.hi, hi);
+        if (a >= b)
+            continue;
+        if (!runs.empty() && runs.back().second == a)
+            runs.back().second = b;
+        else
+            runs.emplace_back(a, b);
+    }
+    for (const auto &run : runs) {
+        for (uint64_t a = run.first; a < run.second; a += chunk_bytes) {
+            std::size_t len = static_cast<std::size_t>(std::min<uint64_t>(chunk_bytes, run.second - a));
+            std::size_t tail = static_cast<std::size_t>(std::min<uint64_t>(overlap, run.second - a - len));
+            m_chunks.push_back(chunk{a, len, tail});
+            m_total += len;
+        }
+    }
+    if (m_chunks.empty()) {
+        m_error = "no readable memory in the range";
+        return false;
+    }
+
+    // 锚字节避开内存中最常见的 0x00 和 0xff，memchr 停下的次数少
+    m_anchor = 0;
+    for (std::size_t i = 0; i < m_pattern.size(); ++i) {
+        if (m_pattern[i] != 0x00 && m_pattern[i] != 0xff) {
+            m_anchor = i;
+            break;
+        }
+    }
+
+    std::size_t threads = std::min<std::size_t>(max_threads, std::max(1u, std::thread::hardware_concurrency()));
+    threads = std::min(threads, m_chunks.size());
+    m_elapsed_ns = -1;
+    m_start_ns = now_ns();
+    m_active = threads;
+    for (std::size_t i = 0; i < threads; ++i)
+        m_threads.emplace_back(&memory_search::worker, this);
+    return true;
+}
+
+void memory_search::cancel()
+{
+    if (running())
+        m_cancel = true;
+    wait();
+}
+
+void memory_search::wait()
+{
+    for (auto &t : m_threads) {
+        if (t.joinable())
+            t.join();
+    }
+    m_threads.clear();
+}
+
+std::size_t memory_search::take(std::vector<search_hit> &out)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    std::size_t n = m_pending.size();
+    out.insert(out.end(), std::make_move_iterator(m_pending.begin()), std::make_move_iterator(m_pending.end()));
+    m_pending.clear();
+    return n;
+}
+
+double memory_search::seconds() const
+{
+    int64_t elapsed = m_elapsed_ns.load();
+    if (elapsed < 0)
+        elapsed = now_ns() - m_start_ns;
+    return elapsed / 1e9;
+}
+
+void memory_search::worker()
+{
+    std::vector<uint8_t> buffer(chunk_bytes + m_pattern.size() + search_hit{}.context.size());
+    std::vector<search_hit> hits;
+    while (!m_cancel) {
+        std::size_t i = m_next.fetch_add(1);
+        if (i >= m_chunks.size())
+            break;
+        const auto &c = m_chunks[i];
+        uint64_t end = c.addr + c.len;
+        std::size_t want = c.len + c.tail;
+        std::size_t pos = 0;
+        // 块中个别不可读的页（如映射后被 mprotect 的页）跳过，其余部分分段扫描
+        while (pos < c.len && !m_cancel) {
+            std::size_t got = m_memory.read(c.addr + pos, buffer.data() + pos, want - pos);
+            if (got > 0)
+                scan(c.addr + pos, end, buffer.data() + pos, got, hits);
+            pos += got;
+            if (pos < want)
+                pos = static_cast<std::size_t>(((c.addr + pos) | 4095) + 1 - c.addr);
+        }
+        m_scanned += c.len;
+        if (!hits.empty()) {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_pending.insert(m_pending.end(), std::make_move_iterator(hits.begin()), std::make_move_iterator(hits.end()));
+            hits.clear();
+        }
+    }
+    if (m_active.fetch_sub(1) == 1)
+        m_elapsed_ns = now_ns() - m_start_ns;
+}
+
+void memory_search::scan(uint64_t base, uint64_t end, const uint8_t *data, std::size_t len, std::vector<search_hit> &hits)
+{
+    std::size_t n = m_pattern.size();
+    if (len < n)
+        return;
+    // 锚字节只可能出现在 [data + anchor, data + len - n + anchor]
+    const uint8_t key = m_pattern[m_anchor];
+    const uint8_t *p = data + m_anchor;
+    const uint8_t *last = data + len - n + m_anchor + 1;
+    while (p < last) {
+        p = static_cast<const uint8_t *>(std::memchr(p, key, last - p));
+        if (p == nullptr)
+            break;
+        const uint8_t *at = p - m_anchor;
+        uint64_t addr = base + (at - data);
+        if (addr >= end)
+            break;
+        if (std::memcmp(at, m_pattern.data(), n) == 0) {
+            if (m_found.fetch_add(1) >= m_limit) {
+                m_truncated = true;
+                m_cancel = true;
+                return;
+            }
+            search_hit hit;
+            hit.address = addr;
+            hit.region = region_of(addr);
+            hit.context_len = std::min<std::size_t>(hit.context.size(), data + len - at);
+            std::memcpy(hit.context.data(), at, hit.context_len);
+            hits.push_back(std::move(hit));
+        }
+        ++p;
+    }
+}
+
+std::size_t memory_search::region_of(uint64_t addr) const
+{
+    auto next = std::upper_bound(m_regions.begin(), m_regions.end(), addr,
+                                 [](uint64_t v, const memory_region &r) { return v < r.lo; });
+    return next == m_regions.begin() ? 0 : static_cast<std::size_t>(next - m_regions.begin() - 1);
+}
+
+}   // namespace minidbg
@@ -2,20 +2,49 @@
 #include "utility.hpp"
 #include <iostream>
 #include <iomanip>  
+#include <sstream>
 #include <sys/ptrace.h> 
 #include "registers.h"
-#include "utility.hpp"
 
 namespace minidbg{
 
 ptrace_expr_context::ptrace_expr_context(pid_t pid, uint64_t load_address) 
-    : m_pid(pid), m_load_address(load_address) {}
+    : m_pid(pid), m_load_address(load_address), m_frame(nullptr), m_state(nullptr), m_has_frame_base(false), m_frame_base(0) {}
+
+ptrace_expr_context::ptrace_expr_context(pid_t pid, uint64_t load_address, const unwind_frame *frame)
+    : m_pid(pid), m_load_address(load_address), m_frame(frame), m_state(nullptr), m_has_frame_base(false), m_frame_base(0) {}
+
+ptrace_expr_context::ptrace_expr_context(pid_t pid, uint64_t load_address, const unwind_frame *frame, const dwarf::die &subprogram)
+    : m_pid(pid), m_load_address(load_address), m_frame(frame), m_state(nullptr), m_subprogram(subprogram), m_has_frame_base(false), m_frame_base(0) {}
+
+ptrace_expr_context::ptrace_expr_context(stop_state &state, uint64_t load_address, const unwind_frame *frame, const dwarf::die &subprogram)
+    : m_pid(state.pid()), m_load_address(load_address), m_frame(frame), m_state(&state), m_subprogram(subprogram), m_has_frame_base(false), m_frame_base(0) {}
 
 dwarf::taddr ptrace_expr_context::reg(unsigned regnum) {
+    if (m_frame && m_frame->has(regnum)) {
+        return m_frame->regs[regnum];
+    }
+    // 外层帧中调用者保存的寄存器没有被恢复，当前值属于第0帧
+    if (m_frame && !m_frame->innermost) {
+        throw dwarf::expr_error("register not saved in this frame");
+    }
+    if (m_state) {
+        if (auto regs = m_state->regs()) {
+            return get_register_value_from_dwarf_register(*regs, regnum);
+        }
+    }
     return get_register_value_from_dwarf_register(m_pid, regnum);
 }
 
 dwarf::taddr ptrace_expr_context::pc(){
+    if (m_frame) {
+        return m_frame->lookup_pc() - m_load_address;
+    }
+    if (m_state) {
+        if (auto snapshot = m_state->regs()) {
+            return snapshot->rip - m_load_address;
+        }
+    }
     struct user_regs_struct regs;
     ptrace(PTRACE_GETREGS, m_pid, nullptr, &regs);
     return regs.rip - m_load_address;
@@ -23,7 +52,21 @@ dwarf::taddr ptrace_expr_context::pc(){
 
 dwarf::taddr ptrace_expr_context::deref_size(dwarf::taddr address, unsigned size) {
 
-    uint64_t full_address = address + m_load_address;
+    // 栈上的地址由寄存器算出，DW_OP_addr 已经过 relocate()，均为实际地址
+    if (m_state) {
+        if (size == 0 || size > sizeof(dwarf::taddr)) {
+            throw dwarf::expr_error("invalid dereference size");
+        }
+        // 先查区域表，野指针不必发起读取
+        uint64_t value = 0;
+        if (!m_state->readable(address, size) || m_state->read(address, &value, size) != size) {
+            std::ostringstream oss;
+            oss << "cannot access memory at 0x" << std::hex << address;
+            throw dwarf::expr_error(oss.str());
+        }
+        return value;
+    }
+    uint64_t full_address = address;
     if (!utility::is_valid_address(m_pid, full_address)) {
         std::cerr << "Attempt to dereference invalid address: " << std::hex << full_address << std::endl;
         return 0; // 或其他错误处理方式
@@ -38,4 +81,39 @@ dwarf::taddr ptrace_expr_context::deref_size(dwarf::taddr address, unsigned size
     return data;
 }
 
+dwarf::taddr ptrace_expr_context::relocate(dwarf::taddr address) {
+    return address + m_load_address;
+}
+
+dwarf::taddr ptrace_expr_context::frame_base() {
+    if (m_has_frame_base) {
+        return m_frame_base;
+    }
+    if (!m_subprogram.valid() || !m_subprogram.has(dwarf::DW_AT::frame_base)) {
+        throw dwarf::expr_error("DW_OP_fbreg used outside a function with DW_AT_frame_base");
+    }
+    // 常见的是 DW_OP_call_frame_cfa；旧的编译器也会给出 DW_OP_breg6 或直接给出寄存器 DW_OP_reg6
+    auto result = m_subprogram[dwarf::DW_AT::frame_base].as_exprloc().evaluate(this);
+    switch (result.location_type) {
+        case dwarf::expr_result::type::address:
+        case dwarf::expr_result::type::literal:
+            m_frame_base = result.value;
+            break;
+        case dwarf::expr_result::type::reg:
+            m_frame_base = reg(result.value);
+            break;
+        default:
+            throw dwarf::expr_error("unsupported DW_AT_frame_base");
+    }
+    m_has_frame_base = true;
+    return m_frame_base;
+}
+
+dwarf::taddr ptrace_expr_context::call_frame_cfa() {
+    if (m_frame == nullptr || m_frame->cfa == 0) {
+        throw dwarf::expr_error("CFA of the frame is unknown");
+    }
+    return m_frame->cfa;
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "record.h"
+#include <cstring>
+#include <algorithm>
+
+namespace minidbg {
+
+static constexpr std::size_t chunk_size = 1 << 20;
+static constexpr std::size_t n_user_regs = sizeof(user_regs_struct) / sizeof(uint64_t);
+static constexpr std::size_t trailer_size = sizeof(uint32_t);
+
+static_assert(n_user_regs <= 64, "register mask must fit in 64 bits");
+
+static void put_varint(std::vector<uint8_t> &out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static uint64_t get_varint(const uint8_t *&p)
+{
+    uint64_t v = 0;
+    unsigned shift = 0;
+    while (*p & 0x80) {
+        v |= static_cast<uint64_t>(*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    v |= static_cast<uint64_t>(*p++) << shift;
+    return v;
+}
+
+static uint64_t zigzag(int64_t v)
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+record_log::record_log()
+    : m_active{false}, m_cap{0}, m_bytes{0}, m_entries{0}, m_recorded{0}, m_dropped{0},
+      m_incomplete{0}, m_elapsed_ns{0}
+{
+}
+
+void record_log::start(std::size_t cap_bytes)
+{
+    stop();
+    m_active = true;
+    m_cap = cap_bytes;
+}
+
+void record_log::stop()
+{
+    m_active = false;
+    m_chunks.clear();
+    m_bytes = m_entries = 0;
+    m_recorded = m_dropped = m_incomplete = m_elapsed_ns = 0;
+}
+
+void record_log::push(const user_regs_struct &before, const user_regs_struct &after,
+                      const mem_request *images, std::size_t n, bool complete)
+{
+    uint64_t old_regs[n_user_regs], new_regs[n_user_regs];
+    std::memcpy(old_regs, &before, sizeof(old_regs));
+    std::memcpy(new_regs, &after, sizeof(new_regs));
+
+    std::size_t image_bytes = 0;
+    for (std::size_t i = 0; i < n; ++i) image_bytes += images[i].done;
+
+    // 新记录放不下时开一个新块，单条超过块大小的记录独占一块
+    std::size_t worst = 10 + n_user_regs * 10 + 10 + n * 20 + image_bytes + trailer_size;
+    if (m_chunks.empty() || m_chunks.back().data.size() + worst > m_chunks.back().data.capacity()) {
+        m_chunks.push_back(chunk{{}, 0});
+        m_chunks.back().data.reserve(std::max(chunk_size, worst));
+    }
+    auto &out = m_chunks.back().data;
+    std::size_t start = out.size();
+
+    uint64_t mask = 0;
+    for (std::size_t k = 0; k < n_user_regs; ++k) {
+        if (old_regs[k] != new_regs[k]) mask |= 1ull << k;
+    }
+    put_varint(out, mask);
+    for (std::size_t k = 0; k < n_user_regs; ++k) {
+        if (mask & (1ull << k)) put_varint(out, zigzag(static_cast<int64_t>(old_regs[k] - new_regs[k])));
+    }
+    put_varint(out, n);
+    for (std::size_t i = 0; i < n; ++i) {
+        put_varint(out, zigzag(static_cast<int64_t>(images[i].addr - after.rsp)));
+        put_varint(out, images[i].done);
+        auto p = static_cast<const uint8_t *>(images[i].buf);
+        out.insert(out.end(), p, p + images[i].done);
+    }
+    uint32_t length = static_cast<uint32_t>(out.size() - start);
+    out.insert(out.end(), reinterpret_cast<uint8_t *>(&length), reinterpret_cast<uint8_t *>(&length) + trailer_size);
+
+    m_bytes += out.size() - start;
+    ++m_chunks.back().entries;
+    ++m_entries;
+    ++m_recorded;
+    if (!complete) ++m_incomplete;
+
+    // 超出上限时整块丢弃最旧的记录
+    while (m_bytes > m_cap && m_chunks.size() > 1) {
+        m_bytes -= m_chunks.front().data.size();
+        m_entries -= m_chunks.front().entries;
+        m_dropped += m_chunks.front().entries;
+        m_chunks.pop_front();
+    }
+}
+
+bool record_log::last_entry(const uint8_t *&begin, const uint8_t *&end) const
+{
+    if (m_entries == 0) return false;
+    const auto &data = m_chunks.back().data;
+    uint32_t length;
+    std::memcpy(&length, data.data() + data.size() - trailer_size, trailer_size);
+    end = data.data() + data.size() - trailer_size;
+    begin = end - length;
+    return true;
+}
+
+void record_log::decode(const uint8_t *p, const uint8_t *end, user_regs_struct &regs,
+                        std::vector<std::pair<uint64_t, std::vector<uint8_t>>> *images)
+{
+    uint64_t r[n_user_regs];
+    std::memcpy(r, &regs, sizeof(r));
+    uint64_t rsp_after = regs.rsp;
+
+    uint64_t mask = get_varint(p);
+    for (std::size_t k = 0; k < n_user_regs; ++k) {
+        if (mask & (1ull << k)) r[k] += static_cast<uint64_t>(unzigzag(get_varint(p)));
+    }
+    std::memcpy(&regs, r, sizeof(r));
+    if (images == nullptr) return;
+
+    images->clear();
+    uint64_t n = get_varint(p);
+    for (uint64_t i = 0; i < n && p < end; ++i) {
+        uint64_t addr = rsp_after + static_cast<uint64_t>(unzigzag(get_varint(p)));
+        uint64_t len = get_varint(p);
+        images->emplace_back(addr, std::vector<uint8_t>(p, p + len));
+        p += len;
+    }
+}
+
+bool record_log::pop(user_regs_struct &regs, std::vector<std::pair<uint64_t, std::vector<uint8_t>>> &images)
+{
+    const uint8_t *begin, *end;
+    if (!last_entry(begin, end)) return false;
+    decode(begin, end, regs, &images);
+
+    auto &last = m_chunks.back();
+    std::size_t removed = (end - begin) + trailer_size;
+    last.data.resize(last.data.size() - removed);
+    --last.entries;
+    m_bytes -= removed;
+    --m_entries;
+    if (last.entries == 0) {
+        m_chunks.pop_back();
+    }
+    return true;
+}
+
+bool record_log::peek(const user_regs_struct &regs, user_regs_struct &before) const
+{
+    const uint8_t *begin, *end;
+    if (!last_entry(begin, end)) return false;
+    before = regs;
+    decode(begin, end, before, nullptr);
+    return true;
+}
+
+std::size_t record_log::walk_back(const user_regs_struct &regs,
+                                  const std::function<bool(const user_regs_struct &before)> &visit) const
+{
+    user_regs_struct state = regs;
+    std::size_t visited = 0;
+    for (auto it = m_chunks.rbegin(); it != m_chunks.rend(); ++it) {
+        const uint8_t *base = it->data.data();
+        const uint8_t *end = base + it->data.size();
+        while (end > base) {
+            uint32_t length;
+            std::memcpy(&length, end - trailer_size, trailer_size);
+            const uint8_t *begin = end - trailer_size - length;
+            decode(begin, end - trailer_size, state, nullptr);
+            ++visited;
+            if (!visit(state)) return visited;
+            end = begin;
+        }
+    }
+    return visited;
+}
+
+}   // namespace minidbg
@@ -109,6 +109,19 @@ namespace minidbg
         }
     }
 
+    uint64_t get_register_value_from_dwarf_register(const user_regs_struct &regs, unsigned regnum) {
+        auto it = std::find_if(begin(g_register_descriptors), end(g_register_descriptors),
+                            [regnum](const auto& rd)
+                            { return rd.dwarf_r == static_cast<int>(regnum); });
+        if (it == end(g_register_descriptors)) {
+            std::ostringstream oss;
+            oss << "Unknown dwarf register number: " << regnum;
+            throw std::out_of_range(oss.str());
+        }
+        // 描述符数组的顺序与 user_regs_struct 的字段顺序一致
+        return *(reinterpret_cast<const uint64_t *>(&regs) + (it - begin(g_register_descriptors)));
+    }
+
 
     reg get_register_from_name(const std::string &name)
     {
@@ -0,0 +1,271 @@
+#include "scope_index.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace minidbg {
+
+static bool read_ranges(const dwarf::die &die, std::vector<std::pair<uint64_t, uint64_t>> &out)
+{
+    if (!die.has(dwarf::DW_AT::low_pc) && !die.has(dwarf::DW_AT::ranges))
+        return false;
+    try {
+        for (const auto &range : dwarf::die_pc_range(die)) {
+            if (range.low < range.high)
+                out.emplace_back(range.low, range.high);
+        }
+    } catch (const std::exception &) {
+    }
+    return !out.empty();
+}
+
+/**
+ * @brief 变量名，内联展开和类外定义的名字在 DW_AT_abstract_origin / DW_AT_specification 中。
+ *
+ */
+static bool variable_name(const dwarf::die &die, std::string &name)
+{
+    auto value = die.resolve(dwarf::DW_AT::name);
+    if (!value.valid())
+        return false;
+    name = value.as_string();
+    return true;
+}
+
+scope_index::scope_index() : m_globals_built{false}, m_types_built{false}
+{
+}
+
+void scope_index::reset(const dwarf::dwarf &dw)
+{
+    m_dwarf = dw;
+    m_functions.clear();
+    m_statics.clear();
+    m_globals.clear();
+    m_globals_built = false;
+    m_types.clear();
+    m_types_built = false;
+}
+
+void scope_index::collect(function_scopes &fs, const dwarf::die &die, int current)
+{
+    for (const auto &child : die) {
+        std::string name;
+        switch (child.tag) {
+        case dwarf::DW_TAG::formal_parameter:
+            // 只有函数体直接包含的形参属于本函数
+            if (current == 0 && variable_name(child, name))
+                fs.parameters.push_back(scope_var{name, scope_kind::parameter, 0, child});
+            break;
+        case dwarf::DW_TAG::variable:
+            if (variable_name(child, name))
+                fs.scopes[current].vars.push_back(scope_var{name, scope_kind::local, fs.scopes[current].depth, child});
+            break;
+        case dwarf::DW_TAG::lexical_block: {
+            std::vector<std::pair<uint64_t, uint64_t>> ranges;
+            if (!read_ranges(child, ranges)) {
+                // 没有地址范围的块与外层作用域同时有效
+                collect(fs, child, current);
+                break;
+            }
+            int index = static_cast<int>(fs.scopes.size());
+            fs.scopes.push_back(scope{current, fs.scopes[current].depth + 1, std::move(ranges), {}});
+            collect(fs, child, index);
+            break;
+        }
+        default:
+            // 嵌套的内联展开是另一个帧，其中的变量在此不可见
+            break;
+        }
+    }
+}
+
+scope_index::function_scopes &scope_index::scopes_of(const dwarf::die &function)
+{
+    auto key = function.get_section_offset();
+    auto it = m_functions.find(key);
+    if (it != m_functions.end())
+        return it->second;
+
+    function_scopes fs;
+    fs.scopes.push_back(scope{-1, 0, {}, {}});
+    read_ranges(function, fs.scopes[0].ranges);
+    collect(fs, function, 0);
+
+    // 嵌套的块区间展开为互不重叠的区间，每段对应最内层的作用域
+    struct interval {
+        uint64_t lo;
+        uint64_t hi;
+        int scope;
+    };
+    std::vector<interval> intervals;
+    for (std::size_t i = 0; i < fs.scopes.size(); ++i) {
+        for (const auto &range : fs.scopes[i].ranges)
+            intervals.push_back(interval{range.first, range.second, static_cast<int>(i)});
+    }
+    std::sort(intervals.begin(), intervals.end(), [](const interval &a, const interval &b) {
+        if (a.lo != b.lo) return a.lo < b.lo;
+        if (a.hi != b.hi) return a.hi > b.hi;
+        return a.scope < b.scope;
+    });
+    auto emit = [&fs](uint64_t lo, uint64_t hi, int scope) {
+        if (lo >= hi) return;
+        if (!fs.segments.empty() && fs.segments.back().hi == lo && fs.segments.back().scope == scope)
+            fs.segments.back().hi = hi;
+        else
+            fs.segments.push_back(segment{lo, hi, scope});
+    };
+    std::vector<interval> stack;
+    uint64_t cur = 0;
+    for (auto iv : intervals) {
+        while (!stack.empty() && stack.back().hi <= iv.lo) {
+            emit(cur, stack.back().hi, stack.back().scope);
+            cur = stack.back().hi;
+            stack.pop_back();
+        }
+        if (!stack.empty()) {
+            emit(cur, iv.lo, stack.back().scope);
+            iv.hi = std::min(iv.hi, stack.back().hi);
+        }
+        cur = iv.lo;
+        if (iv.lo < iv.hi)
+            stack.push_back(iv);
+    }
+    while (!stack.empty()) {
+        emit(cur, stack.back().hi, stack.back().scope);
+        cur = stack.back().hi;
+        stack.pop_back();
+    }
+    return m_functions.emplace(key, std::move(fs)).first->second;
+}
+
+int scope_index::scope_at(const dwarf::die &function, uint64_t pc)
+{
+    const auto &fs = scopes_of(function);
+    auto next = std::upper_bound(fs.segments.begin(), fs.segments.end(), pc,
+                                 [](uint64_t v, const segment &s) { return v < s.lo; });
+    if (next != fs.segments.begin() && pc < std::prev(next)->hi)
+        return std::prev(next)->scope;
+    return 0;
+}
+
+const std::vector<scope_var> &scope_index::frame_variables(const dwarf::die &function, uint64_t pc)
+{
+    int innermost = scope_at(function, pc);
+    auto &fs = scopes_of(function);
+
+    auto it = fs.visible.find(innermost);
+    if (it != fs.visible.end())
+        return it->second;
+
+    // 由内向外，先出现的名字遮蔽外层的同名变量
+    std::vector<scope_var> visible;
+    std::unordered_set<std::string> seen;
+    for (int s = innermost; s >= 0; s = fs.scopes[s].parent) {
+        for (const auto &var : fs.scopes[s].vars) {
+            if (seen.insert(var.name).second)
+                visible.push_back(var);
+        }
+    }
+    for (const auto &var : fs.parameters) {
+        if (seen.insert(var.name).second)
+            visible.push_back(var);
+    }
+    return fs.visible.emplace(innermost, std::move(visible)).first->second;
+}
+
+const scope_index::name_map &scope_index::statics_of(const dwarf::unit &cu)
+{
+    auto key = cu.get_section_offset();
+    auto it = m_statics.find(key);
+    if (it != m_statics.end())
+        return it->second;
+
+    name_map statics;
+    for (const auto &die : cu.root()) {
+        std::string name;
+        if (die.tag != dwarf::DW_TAG::variable || !die.has(dwarf::DW_AT::location) || !variable_name(die, name))
+            continue;
+        auto external = die.resolve(dwarf::DW_AT::external);
+        auto kind = external.valid() && external.as_flag() ? scope_kind::global : scope_kind::file_static;
+        statics.emplace(name, scope_var{name, kind, 0, die});
+    }
+    return m_statics.emplace(key, std::move(statics)).first->second;
+}
+
+void scope_index::build_globals()
+{
+    m_globals_built = true;
+    if (!m_dwarf.valid())
+        return;
+    for (const auto &cu : m_dwarf.compilation_units()) {
+        for (const auto &entry : statics_of(cu)) {
+            if (entry.second.kind == scope_kind::global)
+                m_globals.emplace(entry.first, entry.second);
+        }
+    }
+}
+
+const scope_var *scope_index::lookup(const dwarf::die &function, uint64_t pc, const std::string &name)
+{
+    for (const auto &var : frame_variables(function, pc)) {
+        if (var.name == name)
+            return &var;
+    }
+    const auto &statics = statics_of(function.get_unit());
+    auto it = statics.find(name);
+    if (it != statics.end())
+        return &it->second;
+    if (!m_globals_built)
+        build_globals();
+    it = m_globals.find(name);
+    return it != m_globals.end() ? &it->second : nullptr;
+}
+
+void scope_index::build_types()
+{
+    m_types_built = true;
+    if (!m_dwarf.valid())
+        return;
+    for (const auto &cu : m_dwarf.compilation_units()) {
+        for (const auto &die : cu.root()) {
+            const char *keyword;
+            switch (die.tag) {
+            case dwarf::DW_TAG::structure_type:
+                keyword = "struct ";
+                break;
+            case dwarf::DW_TAG::class_type:
+                keyword = "class ";
+                break;
+            case dwarf::DW_TAG::union_type:
+                keyword = "union ";
+                break;
+            case dwarf::DW_TAG::enumeration_type:
+                keyword = "enum ";
+                break;
+            case dwarf::DW_TAG::typedef_:
+            case dwarf::DW_TAG::base_type:
+                keyword = nullptr;
+                break;
+            default:
+                continue;
+            }
+            // 只有声明的不完整类型不登记，同名时先出现的定义优先
+            if (!die.has(dwarf::DW_AT::name) || (die.has(dwarf::DW_AT::declaration) && die[dwarf::DW_AT::declaration].as_flag()))
+                continue;
+            auto name = die[dwarf::DW_AT::name].as_string();
+            if (keyword)
+                m_types.emplace(keyword + name, die);
+            m_types.emplace(name, die);
+        }
+    }
+}
+
+dwarf::die scope_index::find_type(const std::string &name)
+{
+    if (!m_types_built)
+        build_types();
+    auto it = m_types.find(name);
+    return it != m_types.end() ? it->second : dwarf::die();
+}
+
+}   // namespace minidbg
@@ -0,0 +1,418 @@
+#include "solib.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+namespace minidbg {
+
+static constexpr int64_t dt_null = 0;
+static constexpr int64_t dt_debug = 21;
+static constexpr int32_t rt_consistent = 0;
+static constexpr std::size_t max_link_map_entries = 65536;     // 防止链表被破坏时死循环
+
+/**
+ * @brief /proc/pid/maps 中的一行。
+ *
+ */
+struct map_entry {
+    uint64_t start;
+    uint64_t end;
+    uint64_t offset;
+    std::string path;
+};
+
+static std::vector<map_entry> read_maps(pid_t pid)
+{
+    std::vector<map_entry> maps;
+    std::ifstream in("/proc/" + std::to_string(pid) + "/maps");
+    std::string line;
+    while (std::getline(in, line)) {
+        map_entry e;
+        int path_pos = 0;
+        if (std::sscanf(line.c_str(), "%lx-%lx %*s %lx %*s %*s %n", &e.start, &e.end, &e.offset, &path_pos) < 3) {
+            continue;
+        }
+        if (path_pos > 0 && static_cast<std::size_t>(path_pos) < line.size()) {
+            e.path = line.substr(path_pos);
+        }
+        maps.push_back(std::move(e));
+    }
+    return maps;
+}
+
+static std::string real_path(const std::string &path)
+{
+    char buf[PATH_MAX];
+    if (realpath(path.c_str(), buf) == nullptr) {
+        return path;
+    }
+    return buf;
+}
+
+/**
+ * @brief 取包含地址 addr 的映射所属文件，以及该文件相邻映射合并后的范围。
+ *
+ */
+static bool module_range(const std::vector<map_entry> &maps, uint64_t addr,
+                         std::string &path, uint64_t &start, uint64_t &end)
+{
+    for (std::size_t i = 0; i < maps.size(); ++i) {
+        if (addr < maps[i].start || addr >= maps[i].end) {
+            continue;
+        }
+        path = maps[i].path;
+        std::size_t lo = i, hi = i;
+        while (lo > 0 && maps[lo - 1].path == path && maps[lo - 1].end == maps[lo].start) --lo;
+        while (hi + 1 < maps.size() && maps[hi + 1].path == path && maps[hi + 1].start == maps[hi].end) ++hi;
+        start = maps[lo].start;
+        end = maps[hi].end;
+        return true;
+    }
+    return false;
+}
+
+static shared_object make_object(const std::string &name, const std::string &file,
+                                 uint64_t base, uint64_t dynamic, uint64_t start, uint64_t end)
+{
+    shared_object so;
+    so.name = name;
+    so.file = file;
+    so.base = base;
+    so.dynamic = dynamic;
+    so.start = start;
+    so.end = end;
+    so.elf_tried = false;
+    so.dwarf_tried = false;
+    return so;
+}
+
+solib_manager::solib_manager(inferior_memory &mem)
+    : m_memory{mem}, m_pid{0}, m_exe_dynamic{0}, m_r_debug{0}, m_event_address{0}, m_complete{false},
+      m_interp{make_object("", "", 0, 0, 0, 0)}
+{
+}
+
+void solib_manager::reset(pid_t pid, const elf::elf &exe, uint64_t exe_load)
+{
+    m_pid = pid;
+    m_exe_dynamic = 0;
+    m_r_debug = 0;
+    m_event_address = 0;
+    m_complete = false;
+    m_interp = make_object("", "", 0, 0, 0, 0);
+    m_modules.clear();
+
+    std::string interp;
+    for (const auto &seg : exe.segments()) {
+        const auto &hdr = seg.get_hdr();
+        if (hdr.type == elf::pt::dynamic) {
+            m_exe_dynamic = hdr.vaddr + exe_load;
+        } else if (hdr.type == elf::pt::interp && hdr.filesz > 0) {
+            interp.assign(static_cast<const char *>(seg.data()), hdr.filesz - 1);
+        }
+    }
+    if (interp.empty()) {
+        m_complete = true;
+        return;     // 静态链接，没有动态链接器
+    }
+
+    // exec之后只有主程序和动态链接器被映射，按真实路径找到动态链接器偏移为0的映射
+    std::string interp_file = real_path(interp);
+    for (const auto &m : read_maps(pid)) {
+        if (m.offset == 0 && !m.path.empty() && real_path(m.path) == interp_file) {
+            m_interp = make_object(interp, m.path, 0, 0, m.start, m.start);
+            break;
+        }
+    }
+    if (m_interp.file.empty() || !load_elf(m_interp)) {
+        return;
+    }
+
+    // 第一个 PT_LOAD 被映射到 start，base = start - 该段的页对齐地址
+    uint64_t first_vaddr = UINT64_MAX;
+    uint64_t last_end = 0;
+    for (const auto &seg : m_interp.elf.segments()) {
+        const auto &hdr = seg.get_hdr();
+        if (hdr.type != elf::pt::load) continue;
+        first_vaddr = std::min<uint64_t>(first_vaddr, hdr.vaddr & ~0xfffull);
+        last_end = std::max<uint64_t>(last_end, hdr.vaddr + hdr.memsz);
+    }
+    if (first_vaddr != UINT64_MAX) {
+        m_interp.base = m_interp.start - first_vaddr;
+        m_interp.end = m_interp.base + last_end;
+    }
+}
+
+uint64_t solib_manager::event_address()
+{
+    if (m_event_address != 0) {
+        return m_event_address;
+    }
+    if (m_interp.elf.valid()) {
+        auto values = lookup_defined(m_interp, "_dl_debug_state", true);
+        if (!values.empty()) {
+            m_event_address = m_interp.base + values.front();
+            return m_event_address;
+        }
+    }
+    // ld.so 不导出 _dl_debug_state 时，只能等它初始化 r_debug 之后读取 r_brk
+    if (find_r_debug() != 0) {
+        uint64_t r_brk = 0;
+        if (m_memory.read(m_r_debug + 16, &r_brk, sizeof(r_brk)) == sizeof(r_brk)) {
+            m_event_address = r_brk;
+        }
+    }
+    return m_event_address;
+}
+
+uint64_t solib_manager::find_r_debug()
+{
+    if (m_r_debug != 0) {
+        return m_r_debug;
+    }
+    if (m_exe_dynamic != 0) {
+        int64_t dyn[2];
+        for (uint64_t addr = m_exe_dynamic; m_memory.read(addr, dyn, sizeof(dyn)) == sizeof(dyn); addr += sizeof(dyn)) {
+            if (dyn[0] == dt_null) break;
+            if (dyn[0] == dt_debug) {
+                m_r_debug = static_cast<uint64_t>(dyn[1]);      // 动态链接器启动前为0
+                break;
+            }
+        }
+    }
+    if (m_r_debug == 0 && m_interp.elf.valid()) {
+        auto values = lookup_defined(m_interp, "_r_debug", false);
+        if (!values.empty()) {
+            m_r_debug = m_interp.base + values.front();
+        }
+    }
+    return m_r_debug;
+}
+
+bool solib_manager::update(std::vector<std::size_t> &added, std::vector<std::pair<uint64_t, uint64_t>> &removed)
+{
+    added.clear();
+    removed.clear();
+    if (find_r_debug() == 0) {
+        return false;
+    }
+
+    // struct r_debug { int r_version; struct link_map *r_map; ElfW(Addr) r_brk; enum r_state; ElfW(Addr) r_ldbase; }
+    uint64_t r_debug[4];
+    if (m_memory.read(m_r_debug, r_debug, sizeof(r_debug)) != sizeof(r_debug)) {
+        return false;
+    }
+    if (static_cast<int32_t>(r_debug[3]) != rt_consistent) {
+        m_complete = false;
+        return false;
+    }
+    m_complete = true;
+
+    // struct link_map { ElfW(Addr) l_addr; char *l_name; ElfW(Dyn) *l_ld; struct link_map *l_next, *l_prev; }
+    std::vector<shared_object> current;
+    auto maps = read_maps(m_pid);
+    std::size_t count = 0;
+    for (uint64_t lm = r_debug[1]; lm != 0 && count < max_link_map_entries; ++count) {
+        uint64_t node[4];
+        if (m_memory.read(lm, node, sizeof(node)) != sizeof(node)) {
+            break;
+        }
+        lm = node[3];
+        if (node[2] == m_exe_dynamic) {
+            continue;               // 主程序自身
+        }
+        std::string name = read_string(node[1]);
+        if (name.empty()) {
+            continue;
+        }
+
+        auto it = std::find_if(m_modules.begin(), m_modules.end(), [&](const shared_object &so) {
+            return so.dynamic == node[2] && so.name == name;
+        });
+        if (it != m_modules.end()) {
+            current.push_back(std::move(*it));      // 保留已加载的ELF/DWARF
+            m_modules.erase(it);
+            continue;
+        }
+        std::string file;
+        uint64_t start = node[0], end = node[0];
+        if (!module_range(maps, node[2], file, start, end)) {
+            file = name;
+        }
+        current.push_back(make_object(name, file, node[0], node[2], start, end));
+        added.push_back(current.size() - 1);
+    }
+
+    for (const auto &so : m_modules) {
+        removed.emplace_back(so.start, so.end);
+    }
+    m_modules = std::move(current);
+    return true;
+}
+
+shared_object *solib_manager::module_for_pc(uint64_t pc)
+{
+    for (auto &so : m_modules) {
+        if (pc >= so.start && pc < so.end) {
+            return &so;
+        }
+    }
+    return nullptr;
+}
+
+bool solib_manager::load_elf(shared_object &so)
+{
+    if (!so.elf_tried) {
+        so.elf_tried = true;
+        int fd = open(so.file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            try {
+                so.elf = elf::elf{elf::create_mmap_loader(fd)};
+            } catch (const std::exception &) {
+                so.elf = elf::elf{};
+            }
+        }
+    }
+    return so.elf.valid();
+}
+
+bool solib_manager::load_dwarf(shared_object &so)
+{
+    if (!so.dwarf_tried) {
+        so.dwarf_tried = true;
+        if (load_elf(so)) {
+            try {
+                so.dwarf = dwarf::dwarf{dwarf::elf::create_loader(so.elf)};
+            } catch (const std::exception &) {
+                so.dwarf = dwarf::dwarf{};      // 没有 .debug_info 或版本不支持
+            }
+        }
+    }
+    return so.dwarf.valid();
+}
+
+bool solib_manager::symbolize(shared_object &so, uint64_t pc, uint64_t &start, std::string &name)
+{
+    if (!load_elf(so)) {
+        return false;
+    }
+    uint64_t offset = pc - so.base;
+    for (const auto &sec : so.elf.sections()) {
+        if (sec.get_hdr().type != elf::sht::symtab && sec.get_hdr().type != elf::sht::dynsym)
+            continue;
+        for (auto sym : sec.as_symtab()) {
+            auto &d = sym.get_data();
+            if (d.type() != elf::stt::func || d.shnxd == elf::shn::undef)
+                continue;
+            if (offset >= d.value && offset < d.value + d.size) {
+                start = d.value + so.base;
+                name = sym.get_name();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<uint64_t> solib_manager::lookup_defined(shared_object &so, const std::string &name, bool functions_only)
+{
+    std::vector<uint64_t> values;
+    if (!load_elf(so)) {
+        return values;
+    }
+    for (const auto &sec : so.elf.sections()) {
+        if (sec.get_hdr().type != elf::sht::symtab && sec.get_hdr().type != elf::sht::dynsym)
+            continue;
+        for (auto sym : sec.as_symtab()) {
+            auto &d = sym.get_data();
+            if (d.shnxd == elf::shn::undef || d.value == 0)
+                continue;
+            if (functions_only && d.type() != elf::stt::func)
+                continue;
+            if (sym.get_name() == name) {
+                values.push_back(d.value);
+            }
+        }
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+std::vector<std::intptr_t> solib_manager::function_addresses(shared_object &so, const std::string &name)
+{
+    std::vector<std::intptr_t> addrs;
+    auto values = lookup_defined(so, name, true);
+    if (values.empty()) {
+        return addrs;
+    }
+    bool has_dwarf = load_dwarf(so);
+    for (auto value : values) {
+        uint64_t addr = value;
+        // 有调试信息时与主程序一致，断在函数序言之后的下一行
+        if (has_dwarf) {
+            for (const auto &cu : so.dwarf.compilation_units()) {
+                try {
+                    if (!dwarf::die_pc_range(cu.root()).contains(value))
+                        continue;
+                    const auto &lt = cu.get_line_table();
+                    auto entry = lt.find_address(value);
+                    if (entry != lt.end() && entry->address == value && ++entry != lt.end()) {
+                        addr = entry->address;
+                    }
+                } catch (const std::exception &) {
+                }
+                break;
+            }
+        }
+        addrs.push_back(static_cast<std::intptr_t>(so.base + addr));
+    }
+    return addrs;
+}
+
+std::intptr_t solib_manager::source_line_address(shared_object &so, const std::string &file, unsigned line)
+{
+    if (!load_dwarf(so)) {
+        return 0;
+    }
+    for (const auto &cu : so.dwarf.compilation_units()) {
+        try {
+            auto root_name = at_name(cu.root());
+            size_t pos = root_name.rfind('/');
+            if (pos != std::string::npos && pos != root_name.size() - 1) {
+                root_name = root_name.substr(pos + 1);
+            }
+            if (root_name != file)
+                continue;
+            for (const auto &entry : cu.get_line_table()) {
+                if (entry.is_stmt && entry.line == line) {
+                    return static_cast<std::intptr_t>(so.base + entry.address);
+                }
+            }
+        } catch (const std::exception &) {
+        }
+    }
+    return 0;
+}
+
+std::string solib_manager::read_string(uint64_t addr)
+{
+    std::string s;
+    char chunk[256];
+    while (addr != 0 && s.size() < PATH_MAX) {
+        std::size_t n = m_memory.read(addr, chunk, sizeof(chunk));
+        if (n == 0) break;
+        std::size_t len = strnlen(chunk, n);
+        s.append(chunk, len);
+        if (len < n) break;
+        addr += n;
+    }
+    return s;
+}
+
+}   // namespace minidbg
@@ -0,0 +1,358 @@
+#include "stl_printers.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+#include <utility>
+
+namespace minidbg {
+
+constexpr std::size_t stl_printers::max_node_elements;
+constexpr std::size_t stl_printers::page_elements;
+constexpr std::size_t stl_printers::max_string;
+
+static constexpr std::size_t prefetch_value_bytes = 256;    // 预读节点时每个元素最多读取的字节数
+static constexpr std::size_t prefetch_bytes = 64 * 1024;    // vector 一页元素最多预读的字节数
+static constexpr std::size_t max_tree_depth = 128;          // 红黑树的高度不会超过此值，超过说明内存已损坏
+
+static bool starts_with(const std::string &s, const char *prefix)
+{
+    return s.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+static uint32_t align_up(uint32_t value, uint32_t align)
+{
+    return align > 1 ? (value + align - 1) / align * align : value;
+}
+
+stl_printers::stl_printers(type_db &types, stop_state &state) : m_types(types), m_state(state), m_generation{0}
+{
+}
+
+void stl_printers::clear()
+{
+    m_layouts.clear();
+    m_walks.clear();
+}
+
+const stl_layout &stl_printers::layout(type_id type)
+{
+    auto it = m_layouts.find(type);
+    if (it != m_layouts.end())
+        return it->second;
+    stl_layout l;
+    if (!identify(type, l))
+        l = stl_layout{};
+    return m_layouts.emplace(type, std::move(l)).first->second;
+}
+
+bool stl_printers::identify(type_id type, stl_layout &l)
+{
+    const auto &rec = m_types.record(type);
+    if (rec.kind != type_kind::structure)
+        return false;
+    const auto &name = m_types.name_of(rec.name);
+    uint32_t offset, inner;
+    type_id t, u;
+
+    if (starts_with(name, "vector<") && !starts_with(name, "vector<bool")) {
+        l.kind = stl_kind::vector;
+        l.name = "std::vector";
+        if (!m_types.find_field(type, "_M_impl", offset, t) || !m_types.find_field(t, "_M_start", l.first, u) || !m_types.find_field(t, "_M_finish", l.last, u)
+            || !m_types.find_field(t, "_M_end_of_storage", l.limit, u) || m_types.record(u).kind != type_kind::pointer)
+            return false;
+        l.first += offset;
+        l.last += offset;
+        l.limit += offset;
+        l.element = m_types.record(u).target;
+        return l.element != no_type && m_types.record(l.element).size > 0;
+    }
+
+    if (starts_with(name, "basic_string<")) {
+        // 只支持 C++11 ABI 的 std::__cxx11::basic_string，旧的写时复制实现没有 _M_string_length
+        l.kind = stl_kind::string;
+        l.name = "std::string";
+        if (!m_types.find_field(type, "_M_dataplus", offset, t) || !m_types.find_field(t, "_M_p", inner, u) || m_types.record(u).kind != type_kind::pointer
+            || !m_types.find_field(type, "_M_string_length", l.count, t))
+            return false;
+        l.first = offset + inner;
+        l.element = m_types.record(u).target;
+        return l.element != no_type && m_types.record(l.element).size == 1;
+    }
+
+    static const char *const trees[] = {"map<", "multimap<", "set<", "multiset<"};
+    for (auto prefix : trees) {
+        if (!starts_with(name, prefix))
+            continue;
+        l.kind = stl_kind::tree;
+        l.is_map = std::strstr(prefix, "map") != nullptr;
+        l.name = std::string("std::") + std::string(prefix, std::strlen(prefix) - 1);
+        // _Rb_tree<Key, Value, ...> 的第二个类型实参是元素类型
+        if (!m_types.find_field(type, "_M_t", offset, t) || m_types.record(t).param_count < 2)
+            return false;
+        l.element = m_types.template_args(t)[1];
+        type_id impl;
+        uint32_t impl_offset;
+        if (!m_types.find_field(t, "_M_impl", impl_offset, impl) || !m_types.find_field(impl, "_M_header", l.first, u) || !m_types.find_field(impl, "_M_node_count", l.count, t))
+            return false;
+        l.first += offset + impl_offset;
+        l.count += offset + impl_offset;
+        if (!m_types.find_field(u, "_M_left", l.left, t) || !m_types.find_field(u, "_M_right", l.right, t) || !m_types.find_field(u, "_M_parent", l.parent, t))
+            return false;
+        // _Rb_tree_node<Value> 在 _Rb_tree_node_base 之后存放元素
+        l.node_value = align_up(m_types.record(u).size, m_types.record(l.element).align);
+        return m_types.record(l.element).size > 0;
+    }
+
+    static const char *const hashtables[] = {"unordered_map<", "unordered_multimap<", "unordered_set<", "unordered_multiset<"};
+    for (auto prefix : hashtables) {
+        if (!starts_with(name, prefix))
+            continue;
+        l.kind = stl_kind::hashtable;
+        l.is_map = std::strstr(prefix, "map") != nullptr;
+        l.name = std::string("std::") + std::string(prefix, std::strlen(prefix) - 1);
+        // _Hashtable<Key, Value, ...> 的第二个类型实参是元素类型
+        if (!m_types.find_field(type, "_M_h", offset, t) || m_types.record(t).param_count < 2)
+            return false;
+        l.element = m_types.template_args(t)[1];
+        type_id base;
+        if (!m_types.find_field(t, "_M_before_begin", l.first, base) || !m_types.find_field(t, "_M_element_count", l.count, u)
+            || !m_types.find_field(t, "_M_buckets", l.last, u) || !m_types.find_field(t, "_M_bucket_count", l.limit, u) || !m_types.find_field(base, "_M_nxt", l.left, u))
+            return false;
+        l.first += offset;
+        l.count += offset;
+        l.last += offset;
+        l.limit += offset;
+        // _Hash_node 在 _Hash_node_base 之后存放元素，缓存的哈希值在元素之后
+        l.node_value = align_up(m_types.record(base).size, m_types.record(l.element).align);
+        return m_types.record(l.element).size > 0;
+    }
+
+    if (starts_with(name, "shared_ptr<")) {
+        l.kind = stl_kind::shared_ptr;
+        l.name = "std::shared_ptr";
+        if (!m_types.find_field(type, "_M_ptr", l.first, u) || m_types.record(u).kind != type_kind::pointer)
+            return false;
+        l.element = m_types.record(u).target;
+        // 控制块 _Sp_counted_base 中的计数
+        if (!m_types.find_field(type, "_M_refcount", offset, t) || !m_types.find_field(t, "_M_pi", inner, u) || m_types.record(u).kind != type_kind::pointer)
+            return false;
+        l.count = offset + inner;
+        auto control = m_types.record(u).target;
+        return m_types.find_field(control, "_M_use_count", l.use_count, t) && m_types.find_field(control, "_M_weak_count", l.weak_count, t);
+    }
+    return false;
+}
+
+bool stl_printers::read_word(uint64_t addr, uint64_t &value)
+{
+    return m_state.readable(addr, sizeof(value)) && m_state.read(addr, &value, sizeof(value)) == sizeof(value);
+}
+
+bool stl_printers::length(const stl_layout &l, uint64_t address, uint64_t &n)
+{
+    switch (l.kind) {
+    case stl_kind::vector: {
+        uint64_t start, finish;
+        if (!read_word(address + l.first, start) || !read_word(address + l.last, finish) || finish < start)
+            return false;
+        n = (finish - start) / m_types.record(l.element).size;
+        return true;
+    }
+    case stl_kind::string:
+    case stl_kind::tree:
+    case stl_kind::hashtable:
+        return read_word(address + l.count, n);
+    case stl_kind::shared_ptr: {
+        uint64_t pointer;
+        if (!read_word(address + l.first, pointer))
+            return false;
+        n = pointer ? 1 : 0;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+std::size_t stl_printers::element_count(const stl_layout &l, uint64_t address)
+{
+    uint64_t n;
+    if (l.kind == stl_kind::string || !length(l, address, n))
+        return 0;
+    if (l.kind == stl_kind::tree || l.kind == stl_kind::hashtable)
+        return static_cast<std::size_t>(std::min<uint64_t>(n, max_node_elements));
+    return static_cast<std::size_t>(n);
+}
+
+bool stl_printers::element(const stl_layout &l, uint64_t address, std::size_t i, uint64_t &out)
+{
+    switch (l.kind) {
+    case stl_kind::vector: {
+        uint64_t start, n;
+        if (!read_word(address + l.first, start) || !length(l, address, n) || i >= n)
+            return false;
+        std::size_t size = m_types.record(l.element).size;
+        out = start + i * size;
+        if (i % page_elements == 0) {
+            // 一页元素连续存放，一次读入
+            std::size_t len = std::min<uint64_t>(std::min<uint64_t>(n - i, page_elements) * size, prefetch_bytes);
+            m_state.prefetch({{out, len}});
+        }
+        return true;
+    }
+    case stl_kind::shared_ptr:
+        return i == 0 && read_word(address + l.first, out) && out != 0;
+    case stl_kind::tree:
+    case stl_kind::hashtable: {
+        if (i >= max_node_elements)
+            return false;
+        auto &w = walk_of(l, address);
+        if (i >= w.nodes.size())
+            advance(l, w, (i / page_elements + 1) * page_elements);
+        if (i >= w.nodes.size())
+            return false;
+        out = w.nodes[i] + l.node_value;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool stl_printers::text(const stl_layout &l, uint64_t address, std::string &out)
+{
+    uint64_t data, n;
+    if (l.kind != stl_kind::string || !read_word(address + l.first, data) || !length(l, address, n))
+        return false;
+    std::size_t len = static_cast<std::size_t>(std::min<uint64_t>(n, max_string));
+    std::vector<uint8_t> buffer(len);
+    if (len > 0 && (!m_state.readable(data, len) || m_state.read(data, buffer.data(), len) != len))
+        return false;
+    out = type_db::quote(buffer.data(), len);
+    if (len < n)
+        out += "...";
+    return true;
+}
+
+bool stl_printers::counts(const stl_layout &l, uint64_t address, uint64_t &pointer, uint32_t &use, uint32_t &weak)
+{
+    uint64_t control;
+    if (l.kind != stl_kind::shared_ptr || !read_word(address + l.first, pointer) || !read_word(address + l.count, control))
+        return false;
+    use = weak = 0;
+    if (control == 0)
+        return true;
+    return m_state.readable(control + l.use_count, sizeof(use)) && m_state.read(control + l.use_count, &use, sizeof(use)) == sizeof(use)
+           && m_state.readable(control + l.weak_count, sizeof(weak)) && m_state.read(control + l.weak_count, &weak, sizeof(weak)) == sizeof(weak);
+}
+
+stl_printers::walk &stl_printers::walk_of(const stl_layout &l, uint64_t address)
+{
+    // 遍历结果只在本次停止中有效
+    if (m_generation != m_state.generation()) {
+        m_walks.clear();
+        m_generation = m_state.generation();
+    }
+    auto it = m_walks.find(address);
+    if (it != m_walks.end())
+        return it->second;
+    auto &w = m_walks[address];
+    w.end = address + l.first;
+    if (l.kind == stl_kind::hashtable)
+        prefetch_buckets(l, address);
+    return w;
+}
+
+void stl_printers::advance(const stl_layout &l, walk &w, std::size_t want)
+{
+    while (!w.done && w.nodes.size() < want) {
+        uint64_t x = 0;
+        bool ok = false;
+        if (l.kind == stl_kind::hashtable) {
+            // 单链表：_M_before_begin._M_nxt 是第一个节点
+            ok = read_word((w.nodes.empty() ? w.end : w.nodes.back()) + l.left, x);
+        } else if (w.nodes.empty()) {
+            // 头节点的 _M_left 是最左节点，即 begin()
+            ok = read_word(w.end + l.left, x) && x != w.end;
+            if (ok)
+                prefetch_tree(l, x, 2 * page_elements);
+        } else {
+            // 中序后继，与 _Rb_tree_increment 相同；每推进一页先把附近的节点批量读入
+            x = w.nodes.back();
+            if (w.nodes.size() % page_elements == 0)
+                prefetch_tree(l, x, 2 * page_elements);
+            uint64_t next;
+            ok = read_word(x + l.right, next);
+            if (ok && next != 0) {
+                x = next;
+                for (std::size_t depth = 0; ok && depth < max_tree_depth; ++depth) {
+                    ok = read_word(x + l.left, next);
+                    if (!ok || next == 0)
+                        break;
+                    x = next;
+                }
+            } else if (ok) {
+                uint64_t y, right = 0;
+                ok = read_word(x + l.parent, y);
+                for (std::size_t depth = 0; ok && depth < max_tree_depth; ++depth) {
+                    ok = read_word(y + l.right, right);
+                    if (!ok || x != right)
+                        break;
+                    x = y;
+                    ok = read_word(y + l.parent, y);
+                }
+                if (ok && read_word(x + l.right, right) && right != y)
+                    x = y;
+            }
+        }
+        if (!ok || x == 0 || x == w.end) {
+            w.done = true;
+            break;
+        }
+        w.nodes.push_back(x);
+    }
+}
+
+void stl_printers::prefetch_tree(const stl_layout &l, uint64_t from, std::size_t budget)
+{
+    // 从当前节点按层向父节点和子节点扩展，每一层的节点一次批量读入，读到后才知道下一层的地址
+    std::size_t node_bytes = l.node_value + std::min<std::size_t>(m_types.record(l.element).size, prefetch_value_bytes);
+    std::vector<uint64_t> level{from};
+    std::unordered_set<uint64_t> seen{from};
+    std::vector<std::pair<uint64_t, std::size_t>> ranges;
+    while (!level.empty() && seen.size() < budget) {
+        ranges.clear();
+        for (auto node : level)
+            ranges.emplace_back(node, node_bytes);
+        m_state.prefetch(ranges);
+        std::vector<uint64_t> next;
+        for (auto node : level) {
+            for (auto link : {l.left, l.right, l.parent}) {
+                uint64_t to;
+                if (read_word(node + link, to) && to != 0 && seen.size() < budget && seen.insert(to).second)
+                    next.push_back(to);
+            }
+        }
+        level.swap(next);
+    }
+}
+
+void stl_printers::prefetch_buckets(const stl_layout &l, uint64_t address)
+{
+    // 桶数组中的指针指向各桶第一个节点的前驱，读入桶数组后这些节点可以一次批量读入
+    uint64_t buckets, bucket_count;
+    if (!read_word(address + l.last, buckets) || !read_word(address + l.limit, bucket_count) || buckets == 0)
+        return;
+    std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(bucket_count, 4 * page_elements));
+    m_state.prefetch({{buckets, n * sizeof(uint64_t)}});
+    std::size_t node_bytes = l.node_value + std::min<std::size_t>(m_types.record(l.element).size, prefetch_value_bytes);
+    std::vector<std::pair<uint64_t, std::size_t>> ranges;
+    for (std::size_t i = 0; i < n; ++i) {
+        uint64_t node;
+        if (read_word(buckets + i * sizeof(uint64_t), node) && node != 0)
+            ranges.emplace_back(node, node_bytes);
+    }
+    m_state.prefetch(ranges);
+}
+
+}   // namespace minidbg
@@ -0,0 +1,214 @@
+#include "stop_state.h"
+#include <sys/ptrace.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace minidbg {
+
+constexpr std::size_t stop_state::page_size;
+constexpr std::size_t stop_state::max_pages;
+
+stop_state::stop_state(inferior_memory &memory, change_source changes)
+    : m_memory(memory), m_changes(std::move(changes)), m_unverified{false}, m_have_regs{false}, m_regs_ok{false}, m_regs{},
+      m_have_regions{false}, m_page_misses{0}, m_pages_kept{0}, m_generation{0}, m_resets{0}, m_page_log{nullptr}
+{
+}
+
+void stop_state::reset()
+{
+    m_have_regs = false;
+    m_have_regions = false;
+    m_regions.clear();
+    m_pages.clear();
+    m_unverified = false;
+    m_page_misses = 0;
+    m_pages_kept = 0;
+    ++m_generation;
+    ++m_resets;
+}
+
+void stop_state::next_stop()
+{
+    m_have_regs = false;
+    m_have_regions = false;
+    m_regions.clear();
+    m_page_misses = 0;
+    m_pages_kept = 0;
+    ++m_generation;
+    if (!m_changes)
+        m_pages.clear();
+    else if (!m_pages.empty())
+        m_unverified = true;
+}
+
+void stop_state::verify()
+{
+    if (!m_unverified)
+        return;
+    m_unverified = false;
+    const page_changes *changes = m_changes(m_pages.size());
+    if (changes == nullptr) {
+        m_pages.clear();
+        return;
+    }
+    // 映射可能已被解除或改为不可读，这样的页即使未被写过也不能再用
+    for (auto it = m_pages.begin(); it != m_pages.end();) {
+        uint64_t base = it->first;
+        auto range = std::upper_bound(changes->tracked.begin(), changes->tracked.end(), base,
+                                      [](uint64_t v, const std::pair<uint64_t, uint64_t> &r) { return v < r.first; });
+        bool tracked = range != changes->tracked.begin() && base + page_size <= std::prev(range)->second;
+        if (!tracked || std::binary_search(changes->dirty.begin(), changes->dirty.end(), base) || !readable(base, page_size))
+            it = m_pages.erase(it);
+        else
+            ++it;
+    }
+    m_pages_kept = m_pages.size();
+}
+
+const user_regs_struct *stop_state::regs()
+{
+    if (!m_have_regs) {
+        m_have_regs = true;
+        m_regs_ok = ptrace(PTRACE_GETREGS, m_memory.pid(), nullptr, &m_regs) == 0;
+    }
+    return m_regs_ok ? &m_regs : nullptr;
+}
+
+void stop_state::load_regions()
+{
+    m_have_regions = true;
+    std::ifstream maps("/proc/" + std::to_string(m_memory.pid()) + "/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        unsigned long lo, hi;
+        char perms[5] = {};
+        if (std::sscanf(line.c_str(), "%lx-%lx %4s", &lo, &hi, perms) != 3)
+            continue;
+        m_regions.push_back(region{lo, hi, perms[0] == 'r'});
+    }
+    // maps 本身按地址递增，排序只是保险
+    std::sort(m_regions.begin(), m_regions.end(), [](const region &a, const region &b) { return a.lo < b.lo; });
+}
+
+void stop_state::log_range(uint64_t addr, std::size_t len)
+{
+    if (len == 0)
+        return;
+    uint64_t first = addr & ~static_cast<uint64_t>(page_size - 1);
+    uint64_t last = (addr + len - 1) & ~static_cast<uint64_t>(page_size - 1);
+    for (uint64_t base = first; base <= last && base >= first; base += page_size)
+        m_page_log->push_back(base);
+}
+
+bool stop_state::readable(uint64_t addr, std::size_t len)
+{
+    if (m_page_log != nullptr)
+        log_range(addr, len);
+    if (!m_have_regions)
+        load_regions();
+    uint64_t end = addr + len;
+    if (end < addr)
+        return false;
+    // 访问可能跨越相邻的映射
+    while (addr < end) {
+        auto next = std::upper_bound(m_regions.begin(), m_regions.end(), addr,
+                                     [](uint64_t v, const region &r) { return v < r.lo; });
+        if (next == m_regions.begin())
+            return false;
+        const auto &r = *std::prev(next);
+        if (addr >= r.hi || !r.readable)
+            return false;
+        addr = r.hi;
+    }
+    return true;
+}
+
+const stop_state::page &stop_state::page_at(uint64_t base)
+{
+    verify();
+    auto it = m_pages.find(base);
+    if (it != m_pages.end())
+        return *it->second;
+    if (m_pages.size() >= max_pages)
+        m_pages.clear();
+    std::unique_ptr<page> p(new page);
+    p->valid = m_memory.read(base, p->data.data(), page_size);
+    ++m_page_misses;
+    return *m_pages.emplace(base, std::move(p)).first->second;
+}
+
+bool stop_state::cached(uint64_t addr, std::size_t len)
+{
+    verify();
+    if (len == 0)
+        return true;
+    uint64_t first = addr & ~static_cast<uint64_t>(page_size - 1);
+    uint64_t last = (addr + len - 1) & ~static_cast<uint64_t>(page_size - 1);
+    for (uint64_t base = first; base <= last && base >= first; base += page_size) {
+        if (!m_pages.count(base))
+            return false;
+    }
+    return true;
+}
+
+void stop_state::prefetch(const std::vector<std::pair<uint64_t, std::size_t>> &ranges)
+{
+    verify();
+    std::vector<uint64_t> bases;
+    for (const auto &range : ranges) {
+        if (range.second == 0)
+            continue;
+        uint64_t first = range.first & ~static_cast<uint64_t>(page_size - 1);
+        uint64_t last = (range.first + range.second - 1) & ~static_cast<uint64_t>(page_size - 1);
+        for (uint64_t base = first; base <= last && base >= first; base += page_size) {
+            if (!m_pages.count(base) && readable(base, page_size))
+                bases.push_back(base);
+        }
+    }
+    std::sort(bases.begin(), bases.end());
+    bases.erase(std::unique(bases.begin(), bases.end()), bases.end());
+    if (bases.empty())
+        return;
+    if (m_pages.size() + bases.size() > max_pages)
+        m_pages.clear();
+
+    std::vector<std::unique_ptr<page>> fresh;
+    std::vector<mem_request> reqs;
+    for (auto base : bases) {
+        fresh.emplace_back(new page);
+        reqs.push_back(mem_request{base, fresh.back()->data.data(), page_size, 0});
+    }
+    m_memory.read_batch(reqs.data(), reqs.size());
+    for (std::size_t i = 0; i < bases.size(); ++i) {
+        fresh[i]->valid = reqs[i].done;
+        m_pages.emplace(bases[i], std::move(fresh[i]));
+    }
+    m_page_misses += bases.size();
+}
+
+std::size_t stop_state::read(uint64_t addr, void *buf, std::size_t len)
+{
+    if (m_page_log != nullptr)
+        log_range(addr, len);
+    auto out = static_cast<uint8_t *>(buf);
+    std::size_t done = 0;
+    while (done < len) {
+        uint64_t cur = addr + done;
+        uint64_t base = cur & ~static_cast<uint64_t>(page_size - 1);
+        std::size_t offset = cur - base;
+        const auto &p = page_at(base);
+        if (offset >= p.valid)
+            break;
+        std::size_t n = std::min(len - done, p.valid - offset);
+        std::memcpy(out + done, p.data.data() + offset, n);
+        done += n;
+        if (p.valid < page_size)
+            break;
+    }
+    return done;
+}
+
+}   // namespace minidbg
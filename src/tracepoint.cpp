@@ -0,0 +1,411 @@
+#include "tracepoint.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace minidbg {
+
+const char *const g_trace_reg_names[n_trace_regs] = {
+    "r15", "r14", "r13", "r12", "r11", "r10", "r9", "r8",
+    "rdi", "rsi", "rbp", "rbx", "rdx", "rcx", "rax", "eflags",
+    "rsp", "rip",
+};
+
+static constexpr std::size_t max_kept_records = 100000;     // 调试器中最多保留的记录数
+static constexpr int32_t red_zone = 128;                     // System V ABI 栈红区
+static constexpr int32_t saved_area = 16 * 8;                // 蹦床压栈的15个通用寄存器和rflags
+
+/**
+ * @brief 探测点的修补：jmp rel32 跳到蹦床，余下字节填nop。
+ *
+ */
+static std::vector<uint8_t> jump_patch(uint64_t addr, uint64_t trampoline, std::size_t len)
+{
+    int32_t distance = static_cast<int32_t>(static_cast<int64_t>(trampoline) - static_cast<int64_t>(addr + 5));
+    std::vector<uint8_t> patch(len, 0x90);
+    patch[0] = 0xe9;
+    std::memcpy(&patch[1], &distance, 4);
+    return patch;
+}
+
+/**
+ * @brief 寄存器在蹦床保存区中相对rsp的偏移；rsp、rip不在保存区中，返回-1。
+ *
+ */
+static int32_t saved_slot(reg r)
+{
+    switch (r) {
+    case reg::r15: return 0;
+    case reg::r14: return 8;
+    case reg::r13: return 16;
+    case reg::r12: return 24;
+    case reg::r11: return 32;
+    case reg::r10: return 40;
+    case reg::r9:  return 48;
+    case reg::r8:  return 56;
+    case reg::rdi: return 64;
+    case reg::rsi: return 72;
+    case reg::rbp: return 80;
+    case reg::rbx: return 88;
+    case reg::rdx: return 96;
+    case reg::rcx: return 104;
+    case reg::rax: return 112;
+    default:       return -1;
+    }
+}
+
+/**
+ * @brief 机器码拼接辅助。
+ *
+ */
+struct code_buffer {
+    std::vector<uint8_t> bytes;
+
+    void emit(std::initializer_list<uint8_t> b) { bytes.insert(bytes.end(), b); }
+    void emit32(uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i) bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+    void emit64(uint64_t v)
+    {
+        for (int i = 0; i < 8; ++i) bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+};
+
+tracepoint_manager::tracepoint_manager(inferior_memory &mem)
+    : m_memory{mem}, m_code_base{0}, m_code_size{0}, m_code_used{0},
+      m_ring_remote{0}, m_ring_local{nullptr}, m_next_id{1},
+      m_tail{0}, m_lost{0}, m_stop{false}
+{
+}
+
+tracepoint_manager::~tracepoint_manager()
+{
+    reset();
+}
+
+void tracepoint_manager::setup(uint64_t code_base, uint64_t code_size, uint64_t ring_remote, uint8_t *ring_local)
+{
+    m_code_base = code_base;
+    m_code_size = code_size;
+    m_code_used = 0;
+    m_ring_remote = ring_remote;
+    m_ring_local = ring_local;
+    m_tail = 0;
+    m_lost = 0;
+}
+
+std::vector<uint8_t> tracepoint_manager::build_trampoline(int id, uint64_t addr, uint64_t trampoline,
+                                                          const std::vector<uint8_t> &displaced,
+                                                          const std::vector<trace_collect> &collects) const
+{
+    code_buffer c;
+
+    // 跳过红区，保存rflags和全部通用寄存器
+    c.emit({0x48, 0x8d, 0x64, 0x24, static_cast<uint8_t>(-red_zone)});     // lea rsp, [rsp-128]
+    c.emit({0x9c});                                                         // pushfq
+    c.emit({0x50, 0x51, 0x52, 0x53, 0x55, 0x56, 0x57});                     // push rax rcx rdx rbx rbp rsi rdi
+    c.emit({0x41, 0x50, 0x41, 0x51, 0x41, 0x52, 0x41, 0x53});               // push r8 - r11
+    c.emit({0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});               // push r12 - r15
+    c.emit({0xfc});                                                         // cld
+
+    // 原子地领取一个槽位：rax = head++，r11 = 本条记录的序号
+    c.emit({0x48, 0xbf}); c.emit64(m_ring_remote);                          // movabs rdi, ring
+    c.emit({0xb8}); c.emit32(1);                                            // mov eax, 1
+    c.emit({0xf0, 0x48, 0x0f, 0xc1, 0x07});                                 // lock xadd [rdi], rax
+    c.emit({0x4c, 0x8d, 0x58, 0x01});                                       // lea r11, [rax+1]
+    c.emit({0x48, 0x25}); c.emit32(trace_ring_capacity - 1);                // and rax, capacity-1
+    c.emit({0x48, 0x69, 0xc0}); c.emit32(trace_record_size);                // imul rax, rax, record_size
+    c.emit({0x48, 0x8d, 0x7c, 0x07, static_cast<uint8_t>(trace_ring_header)}); // lea rdi, [rdi+rax+header]
+    c.emit({0x48, 0x89, 0xfa});                                             // mov rdx, rdi
+
+    // 记录头：seq先清零表示正在写入，再写追踪点编号
+    c.emit({0x48, 0xc7, 0x07}); c.emit32(0);                                // mov qword [rdi], 0
+    c.emit({0x48, 0xc7, 0x47, 0x08}); c.emit32(id);                         // mov qword [rdi+8], id
+    c.emit({0x48, 0x83, 0xc7, 0x10});                                       // add rdi, 16
+
+    // 复制保存区中的16个寄存器，然后是原始rsp和探测点地址
+    c.emit({0x48, 0x89, 0xe6});                                             // mov rsi, rsp
+    c.emit({0xb9}); c.emit32(16);                                           // mov ecx, 16
+    c.emit({0xf3, 0x48, 0xa5});                                             // rep movsq
+    c.emit({0x48, 0x8d, 0x84, 0x24}); c.emit32(saved_area + red_zone);      // lea rax, [rsp+256]
+    c.emit({0x48, 0xab});                                                   // stosq
+    c.emit({0x48, 0xb8}); c.emit64(addr);                                   // movabs rax, addr
+    c.emit({0x48, 0xab});                                                   // stosq
+
+    // 采集内存：rsi = 基址寄存器的原值 + offset，rep movsb
+    for (const auto &col : collects) {
+        int32_t slot = saved_slot(col.base);
+        if (col.base == reg::rsp) {
+            c.emit({0x48, 0x8d, 0xb4, 0x24}); c.emit32(saved_area + red_zone);  // lea rsi, [rsp+256]
+        } else if (col.base == reg::rip) {
+            c.emit({0x48, 0xbe}); c.emit64(addr);                               // movabs rsi, addr
+        } else {
+            c.emit({0x48, 0x8b, 0xb4, 0x24}); c.emit32(slot);                   // mov rsi, [rsp+slot]
+        }
+        c.emit({0x48, 0x81, 0xc6}); c.emit32(static_cast<uint32_t>(col.offset)); // add rsi, offset
+        c.emit({0xb9}); c.emit32(col.len);                                      // mov ecx, len
+        c.emit({0xf3, 0xa4});                                                   // rep movsb
+    }
+
+    // 提交记录
+    c.emit({0x4c, 0x89, 0x1a});                                             // mov [rdx], r11
+
+    // 恢复寄存器
+    c.emit({0x41, 0x5f, 0x41, 0x5e, 0x41, 0x5d, 0x41, 0x5c});               // pop r15 - r12
+    c.emit({0x41, 0x5b, 0x41, 0x5a, 0x41, 0x59, 0x41, 0x58});               // pop r11 - r8
+    c.emit({0x5f, 0x5e, 0x5d, 0x5b, 0x5a, 0x59, 0x58});                     // pop rdi rsi rbp rbx rdx rcx rax
+    c.emit({0x9d});                                                         // popfq
+    c.emit({0x48, 0x8d, 0xa4, 0x24}); c.emit32(red_zone);                   // lea rsp, [rsp+128]
+
+    // 执行被覆盖的指令，再跳回探测点之后
+    c.bytes.insert(c.bytes.end(), displaced.begin(), displaced.end());
+    int64_t back = static_cast<int64_t>(addr + displaced.size()) - static_cast<int64_t>(trampoline + c.bytes.size() + 5);
+    c.emit({0xe9}); c.emit32(static_cast<uint32_t>(back));                  // jmp addr+len
+    return c.bytes;
+}
+
+bool tracepoint_manager::collectable(reg r)
+{
+    return saved_slot(r) >= 0 || r == reg::rsp || r == reg::rip;
+}
+
+int tracepoint_manager::install(uint64_t addr, const std::vector<uint8_t> &displaced,
+                                const std::vector<trace_collect> &collects, const std::string &spec)
+{
+    if (!ready() || displaced.size() < 5) {
+        return -1;
+    }
+    uint64_t collect_bytes = 0;
+    for (const auto &col : collects) {
+        if (!collectable(col.base)) {
+            return -1;
+        }
+        collect_bytes += col.len;
+    }
+    if (collect_bytes > trace_max_collect) {
+        std::cerr << "tracepoint: at most " << trace_max_collect << " bytes can be collected\n";
+        return -1;
+    }
+
+    uint64_t trampoline = m_code_base + ((m_code_used + 15) & ~15ull);
+    int64_t distance = static_cast<int64_t>(trampoline) - static_cast<int64_t>(addr + 5);
+    if (distance > INT32_MAX || distance < INT32_MIN) {
+        std::cerr << "tracepoint: trampoline area is out of jump range\n";
+        return -1;
+    }
+
+    int id = m_next_id;
+    auto code = build_trampoline(id, addr, trampoline, displaced, collects);
+    if (trampoline + code.size() > m_code_base + m_code_size) {
+        std::cerr << "tracepoint: trampoline area is full\n";
+        return -1;
+    }
+    if (!m_memory.write(trampoline, code.data(), code.size())) {
+        return -1;
+    }
+
+    auto patch = jump_patch(addr, trampoline, displaced.size());
+    if (!m_memory.write(addr, patch.data(), patch.size())) {
+        return -1;
+    }
+    m_code_used = trampoline + code.size() - m_code_base;
+    ++m_next_id;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t copy = trampoline + code.size() - displaced.size() - 5;   // 蹦床以搬来的指令和5字节的jmp结尾
+        m_tracepoints.push_back(tracepoint{id, spec, addr, displaced, trampoline, copy, collects, 0});
+    }
+    start_drain_thread();
+    return id;
+}
+
+bool tracepoint_manager::remove(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_tracepoints.begin(), m_tracepoints.end(),
+                           [id](const tracepoint &tp) { return tp.id == id; });
+    if (it == m_tracepoints.end()) {
+        return false;
+    }
+    m_memory.write(it->addr, it->original.data(), it->original.size());
+    m_tracepoints.erase(it);
+    return true;
+}
+
+void tracepoint_manager::suspend()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &tp : m_tracepoints) {
+        m_memory.write(tp.addr, tp.original.data(), tp.original.size());
+    }
+}
+
+void tracepoint_manager::resume()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &tp : m_tracepoints) {
+        auto patch = jump_patch(tp.addr, tp.trampoline, tp.original.size());
+        m_memory.write(tp.addr, patch.data(), patch.size());
+    }
+}
+
+bool tracepoint_manager::covers(uint64_t addr) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &tp : m_tracepoints) {
+        if (addr >= tp.addr && addr < tp.addr + tp.original.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t tracepoint_manager::displaced_address(uint64_t addr) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &tp : m_tracepoints) {
+        if (addr > tp.addr && addr < tp.addr + tp.original.size()) {
+            return tp.displaced_copy + (addr - tp.addr);
+        }
+    }
+    return addr;
+}
+
+bool tracepoint_manager::ring_read(uint64_t offset, void *buf, std::size_t len)
+{
+    if (m_ring_local) {
+        std::memcpy(buf, m_ring_local + offset, len);
+        return true;
+    }
+    return m_memory.read(m_ring_remote + offset, buf, len) == len;
+}
+
+void tracepoint_manager::drain()
+{
+    if (!ready()) {
+        return;
+    }
+    uint64_t head = 0;
+    if (m_ring_local) {
+        head = __atomic_load_n(reinterpret_cast<uint64_t *>(m_ring_local), __ATOMIC_ACQUIRE);
+    } else if (!ring_read(0, &head, sizeof(head))) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (head - m_tail > trace_ring_capacity) {
+        m_lost += head - trace_ring_capacity - m_tail;
+        m_tail = head - trace_ring_capacity;
+    }
+
+    uint8_t raw[trace_record_size];
+    while (m_tail < head) {
+        uint64_t offset = trace_ring_header + (m_tail & (trace_ring_capacity - 1)) * trace_record_size;
+        if (!ring_read(offset, raw, sizeof(raw))) {
+            return;
+        }
+        uint64_t seq;
+        std::memcpy(&seq, raw, 8);
+        if (seq < m_tail + 1) {
+            break;                  // 槽位已领取但尚未提交，下次再读
+        }
+        // 读取期间被覆盖（seqlock校验）或已被后来的记录覆盖
+        uint64_t seq_after = 0;
+        if (m_ring_local) {
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            seq_after = __atomic_load_n(reinterpret_cast<uint64_t *>(m_ring_local + offset), __ATOMIC_RELAXED);
+        } else {
+            ring_read(offset, &seq_after, 8);
+        }
+        if (seq != m_tail + 1 || seq_after != seq) {
+            ++m_lost;
+            ++m_tail;
+            continue;
+        }
+
+        trace_record rec;
+        rec.seq = seq;
+        uint64_t id;
+        std::memcpy(&id, raw + 8, 8);
+        rec.id = static_cast<int>(id);
+        std::memcpy(rec.regs, raw + 16, sizeof(rec.regs));
+
+        auto tp = std::find_if(m_tracepoints.begin(), m_tracepoints.end(),
+                               [&rec](const tracepoint &t) { return t.id == rec.id; });
+        if (tp != m_tracepoints.end()) {
+            ++tp->hits;
+            std::size_t n = 0;
+            for (const auto &col : tp->collects) n += col.len;
+            const uint8_t *mem = raw + 16 + sizeof(rec.regs);
+            rec.memory.assign(mem, mem + n);
+        }
+        m_records.push_back(std::move(rec));
+        if (m_records.size() > max_kept_records) {
+            m_records.pop_front();
+        }
+        ++m_tail;
+    }
+}
+
+std::vector<trace_record> tracepoint_manager::recent(std::size_t max_records) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::size_t n = std::min(max_records, m_records.size());
+    return std::vector<trace_record>(m_records.end() - n, m_records.end());
+}
+
+std::vector<tracepoint> tracepoint_manager::list() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tracepoints;
+}
+
+uint64_t tracepoint_manager::lost() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lost;
+}
+
+void tracepoint_manager::start_drain_thread()
+{
+    if (m_drain_thread.joinable()) {
+        return;
+    }
+    m_stop = false;
+    m_drain_thread = std::thread([this]() {
+        while (!m_stop) {
+            drain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+}
+
+void tracepoint_manager::stop_drain_thread()
+{
+    m_stop = true;
+    if (m_drain_thread.joinable()) {
+        m_drain_thread.join();
+    }
+}
+
+void tracepoint_manager::reset()
+{
+    stop_drain_thread();
+    if (m_ring_local) {
+        munmap(m_ring_local, trace_ring_bytes);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_code_base = m_code_size = m_code_used = 0;
+    m_ring_remote = 0;
+    m_ring_local = nullptr;
+    m_tracepoints.clear();
+    m_records.clear();
+    m_tail = 0;
+    m_lost = 0;
+}
+
+}   // namespace minidbg
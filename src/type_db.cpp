@@ -0,0 +1,754 @@
+#include "type_db.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace minidbg {
+
+constexpr std::size_t type_db::max_elements;
+constexpr uint8_t type_member::base;
+constexpr uint8_t type_member::virtual_base;
+constexpr uint8_t type_member::artificial;
+
+static uint64_t constant_of(const dwarf::value &value)
+{
+    if (value.get_type() == dwarf::value::type::sconstant)
+        return static_cast<uint64_t>(value.as_sconstant());
+    return value.as_uconstant();
+}
+
+static bool has_flag(const dwarf::die &die, dwarf::DW_AT attr)
+{
+    return die.has(attr) && die[attr].as_flag();
+}
+
+static std::string die_name(const dwarf::die &die)
+{
+    return die.has(dwarf::DW_AT::name) ? die[dwarf::DW_AT::name].as_string() : std::string{};
+}
+
+/**
+ * @brief 成员相对结构体开头的字节偏移。DWARF2/3 用 DW_OP_plus_uconst 表达式给出，虚基类的表达式要读内存，求值失败。
+ *
+ */
+static bool member_location(const dwarf::die &member, uint64_t &offset)
+{
+    offset = 0;
+    if (!member.has(dwarf::DW_AT::data_member_location))
+        return true;       // 联合体的成员
+    auto value = member[dwarf::DW_AT::data_member_location];
+    switch (value.get_type()) {
+    case dwarf::value::type::constant:
+    case dwarf::value::type::uconstant:
+    case dwarf::value::type::sconstant:
+        offset = constant_of(value);
+        return true;
+    case dwarf::value::type::exprloc:
+    case dwarf::value::type::block:
+        try {
+            auto result = value.as_exprloc().evaluate(&dwarf::no_expr_context, 0);
+            offset = result.value;
+            return result.location_type == dwarf::expr_result::type::address;
+        } catch (const std::exception &) {
+            return false;
+        }
+    default:
+        return false;
+    }
+}
+
+type_db::type_db()
+{
+    clear();
+}
+
+void type_db::clear()
+{
+    m_records.clear();
+    m_members.clear();
+    m_enumerators.clear();
+    m_dims.clear();
+    m_params.clear();
+    m_strings.assign(1, std::string{});
+    m_ids.clear();
+    m_scalars.clear();
+    m_pointers.clear();
+    // 没有类型信息的变量按8字节有符号整数显示
+    m_unknown = add(type_kind::unknown, 8, 0);
+}
+
+uint32_t type_db::intern(const std::string &s)
+{
+    if (s.empty())
+        return 0;
+    m_strings.push_back(s);
+    return static_cast<uint32_t>(m_strings.size() - 1);
+}
+
+type_id type_db::add(type_kind kind, uint32_t size, uint32_t name)
+{
+    m_records.push_back(type_record{kind, false, size, size ? std::min<uint32_t>(size, 16) : 1, name, no_type, 0, 0, 0, 0});
+    return static_cast<type_id>(m_records.size() - 1);
+}
+
+type_id type_db::scalar(type_kind kind, uint32_t size, const std::string &name)
+{
+    auto it = m_scalars.find(name);
+    if (it != m_scalars.end())
+        return it->second;
+    auto id = add(kind, size, intern(name));
+    m_scalars.emplace(name, id);
+    return id;
+}
+
+type_id type_db::pointer_to(type_id target)
+{
+    auto it = m_pointers.find(target);
+    if (it != m_pointers.end())
+        return it->second;
+    auto id = add(type_kind::pointer, 8, 0);
+    m_records[id].target = target;
+    m_pointers.emplace(target, id);
+    return id;
+}
+
+type_id type_db::of_variable(const dwarf::die &var)
+{
+    auto type = var.resolve(dwarf::DW_AT::type);
+    if (!type.valid())
+        return m_unknown;
+    auto id = of(type.as_reference());
+    return id == no_type ? m_unknown : id;
+}
+
+type_id type_db::of(const dwarf::die &type)
+{
+    if (!type.valid())
+        return no_type;
+    auto it = m_ids.find(type.get_section_offset());
+    if (it != m_ids.end())
+        return it->second;
+    return build(type);
+}
+
+type_id type_db::build(const dwarf::die &die)
+{
+    auto key = die.get_section_offset();
+    uint32_t size = die.has(dwarf::DW_AT::byte_size) ? static_cast<uint32_t>(die[dwarf::DW_AT::byte_size].as_uconstant()) : 0;
+    dwarf::die target;
+    if (die.has(dwarf::DW_AT::type))
+        target = die[dwarf::DW_AT::type].as_reference();
+
+    type_id id;
+    switch (die.tag) {
+    case dwarf::DW_TAG::typedef_:
+    case dwarf::DW_TAG::const_type:
+    case dwarf::DW_TAG::volatile_type:
+    case dwarf::DW_TAG::restrict_type:
+        // 修饰和别名直接指向底层类型的记录，没有底层类型的是 const void
+        id = target.valid() ? of(target) : add(type_kind::void_, 0, intern("void"));
+        m_ids[key] = id;
+        return id;
+
+    case dwarf::DW_TAG::base_type: {
+        type_kind kind;
+        switch (static_cast<dwarf::DW_ATE>(die[dwarf::DW_AT::encoding].as_uconstant())) {
+        case dwarf::DW_ATE::float_:
+            kind = type_kind::floating;
+            break;
+        case dwarf::DW_ATE::boolean:
+            kind = type_kind::boolean;
+            break;
+        case dwarf::DW_ATE::signed_:
+            kind = type_kind::signed_int;
+            break;
+        case dwarf::DW_ATE::signed_char:
+            kind = type_kind::signed_char;
+            break;
+        case dwarf::DW_ATE::unsigned_char:
+            kind = type_kind::unsigned_char;
+            break;
+        default:
+            kind = type_kind::unsigned_int;
+            break;
+        }
+        id = add(kind, size, intern(die_name(die)));
+        break;
+    }
+
+    case dwarf::DW_TAG::pointer_type:
+    case dwarf::DW_TAG::ptr_to_member_type:
+    case dwarf::DW_TAG::reference_type:
+    case dwarf::DW_TAG::rvalue_reference_type: {
+        auto kind = die.tag == dwarf::DW_TAG::reference_type || die.tag == dwarf::DW_TAG::rvalue_reference_type
+                        ? type_kind::reference : type_kind::pointer;
+        id = add(kind, size ? size : 8, 0);
+        // 先登记，指向自身所在结构体的指针才不会无限递归
+        m_ids[key] = id;
+        auto pointee = of(target);
+        m_records[id].target = pointee;
+        return id;
+    }
+
+    case dwarf::DW_TAG::structure_type:
+    case dwarf::DW_TAG::class_type:
+    case dwarf::DW_TAG::union_type:
+        id = add(die.tag == dwarf::DW_TAG::union_type ? type_kind::union_ : type_kind::structure, size, intern(die_name(die)));
+        m_records[id].is_class = die.tag == dwarf::DW_TAG::class_type;
+        m_ids[key] = id;
+        build_struct(id, die);
+        return id;
+
+    case dwarf::DW_TAG::array_type:
+        id = add(type_kind::array, size, 0);
+        m_ids[key] = id;
+        build_array(id, die);
+        return id;
+
+    case dwarf::DW_TAG::enumeration_type:
+        id = add(type_kind::enumeration, size, intern(die_name(die)));
+        m_ids[key] = id;
+        build_enum(id, die);
+        return id;
+
+    case dwarf::DW_TAG::subroutine_type: {
+        // 名字即签名，如 "int (int, char *)"
+        id = add(type_kind::function, 0, 0);
+        m_ids[key] = id;
+        std::string signature = target.valid() ? type_name(of(target)) : "void";
+        signature += " (";
+        bool first = true;
+        for (const auto &param : die) {
+            if (param.tag == dwarf::DW_TAG::unspecified_parameters) {
+                signature += first ? "..." : ", ...";
+                first = false;
+            }
+            if (param.tag != dwarf::DW_TAG::formal_parameter || !param.has(dwarf::DW_AT::type))
+                continue;
+            if (!first)
+                signature += ", ";
+            signature += type_name(of(param[dwarf::DW_AT::type].as_reference()));
+            first = false;
+        }
+        signature += ")";
+        m_records[id].name = intern(signature);
+        return id;
+    }
+
+    case dwarf::DW_TAG::unspecified_type:
+        // decltype(nullptr) 等
+        id = add(type_kind::pointer, size ? size : 8, intern(die_name(die)));
+        break;
+
+    default:
+        id = m_unknown;
+        break;
+    }
+    m_ids[key] = id;
+    return id;
+}
+
+void type_db::build_struct(type_id id, const dwarf::die &die)
+{
+    // 成员的类型会递归建立并追加到公共数组，本结构体的成员先收集，最后连续存放
+    std::vector<type_member> members;
+    std::vector<type_id> params;
+    uint32_t align = 1;
+    for (const auto &child : die) {
+        if (child.tag == dwarf::DW_TAG::template_type_parameter && child.has(dwarf::DW_AT::type)) {
+            auto param = of(child[dwarf::DW_AT::type].as_reference());
+            params.push_back(param == no_type ? m_unknown : param);
+            continue;
+        }
+        if (child.tag != dwarf::DW_TAG::member && child.tag != dwarf::DW_TAG::inheritance)
+            continue;
+        // 静态数据成员只是声明
+        if (child.tag == dwarf::DW_TAG::member && (has_flag(child, dwarf::DW_AT::declaration) || has_flag(child, dwarf::DW_AT::external)))
+            continue;
+        if (!child.has(dwarf::DW_AT::type))
+            continue;
+        type_member member{};
+        member.type = of(child[dwarf::DW_AT::type].as_reference());
+        if (member.type == no_type)
+            member.type = m_unknown;
+        if (child.tag == dwarf::DW_TAG::inheritance) {
+            member.flags |= type_member::base;
+            member.name = 0;
+        } else {
+            member.name = intern(die_name(child));
+        }
+        if (has_flag(child, dwarf::DW_AT::artificial))
+            member.flags |= type_member::artificial;
+
+        uint64_t offset = 0;
+        if (child.has(dwarf::DW_AT::data_bit_offset)) {
+            offset = child[dwarf::DW_AT::data_bit_offset].as_uconstant();
+        } else if (member_location(child, offset)) {
+            offset *= 8;
+        } else {
+            member.flags |= type_member::virtual_base;
+            offset = 0;
+        }
+        if (child.has(dwarf::DW_AT::bit_size)) {
+            member.bit_size = static_cast<uint16_t>(child[dwarf::DW_AT::bit_size].as_uconstant());
+            if (child.has(dwarf::DW_AT::bit_offset)) {
+                // DWARF2/3：DW_AT_bit_offset 从存储单元的最高位数起
+                uint64_t storage = child.has(dwarf::DW_AT::byte_size) ? child[dwarf::DW_AT::byte_size].as_uconstant()
+                                                                      : m_records[member.type].size;
+                offset += storage * 8 - child[dwarf::DW_AT::bit_offset].as_uconstant() - member.bit_size;
+            }
+        }
+        member.bit_offset = static_cast<uint32_t>(offset);
+        align = std::max(align, m_records[member.type].align);
+        members.push_back(member);
+    }
+    auto &rec = m_records[id];
+    rec.first = static_cast<uint32_t>(m_members.size());
+    rec.count = static_cast<uint32_t>(members.size());
+    rec.align = align;
+    m_members.insert(m_members.end(), members.begin(), members.end());
+    rec.params = static_cast<uint32_t>(m_params.size());
+    rec.param_count = static_cast<uint32_t>(params.size());
+    m_params.insert(m_params.end(), params.begin(), params.end());
+}
+
+void type_db::build_array(type_id id, const dwarf::die &die)
+{
+    type_id element = m_unknown;
+    if (die.has(dwarf::DW_AT::type))
+        element = of(die[dwarf::DW_AT::type].as_reference());
+    if (element == no_type)
+        element = m_unknown;
+
+    std::vector<uint64_t> dims;
+    for (const auto &child : die) {
+        if (child.tag != dwarf::DW_TAG::subrange_type)
+            continue;
+        uint64_t count = 0;
+        try {
+            if (child.has(dwarf::DW_AT::count)) {
+                count = constant_of(child[dwarf::DW_AT::count]);
+            } else if (child.has(dwarf::DW_AT::upper_bound)) {
+                uint64_t lower = child.has(dwarf::DW_AT::lower_bound) ? constant_of(child[dwarf::DW_AT::lower_bound]) : 0;
+                count = constant_of(child[dwarf::DW_AT::upper_bound]) - lower + 1;
+            }
+        } catch (const std::exception &) {
+            count = 0;      // 变长数组的长度是表达式
+        }
+        dims.push_back(count);
+    }
+    if (dims.empty())
+        dims.push_back(0);
+
+    auto &rec = m_records[id];
+    rec.target = element;
+    rec.first = static_cast<uint32_t>(m_dims.size());
+    rec.count = static_cast<uint32_t>(dims.size());
+    rec.align = m_records[element].align;
+    if (rec.size == 0) {
+        uint64_t total = m_records[element].size;
+        for (auto d : dims)
+            total *= d;
+        rec.size = static_cast<uint32_t>(total);
+    }
+    m_dims.insert(m_dims.end(), dims.begin(), dims.end());
+}
+
+void type_db::build_enum(type_id id, const dwarf::die &die)
+{
+    type_id underlying = no_type;
+    if (die.has(dwarf::DW_AT::type))
+        underlying = of(die[dwarf::DW_AT::type].as_reference());
+
+    std::vector<type_enumerator> values;
+    for (const auto &child : die) {
+        if (child.tag != dwarf::DW_TAG::enumerator || !child.has(dwarf::DW_AT::const_value))
+            continue;
+        values.push_back(type_enumerator{intern(die_name(child)), static_cast<int64_t>(constant_of(child[dwarf::DW_AT::const_value]))});
+    }
+    auto &rec = m_records[id];
+    rec.target = underlying;
+    rec.first = static_cast<uint32_t>(m_enumerators.size());
+    rec.count = static_cast<uint32_t>(values.size());
+    if (rec.size == 0)
+        rec.size = 4;
+    rec.align = rec.size;
+    m_enumerators.insert(m_enumerators.end(), values.begin(), values.end());
+}
+
+std::string type_db::type_name(type_id id) const
+{
+    if (id == no_type)
+        return "void";
+    const auto &rec = m_records[id];
+    const auto &name = m_strings[rec.name];
+    switch (rec.kind) {
+    case type_kind::pointer:
+    case type_kind::reference: {
+        const char *suffix = rec.kind == type_kind::pointer ? "*" : "&";
+        if (rec.target == no_type)
+            return name.empty() ? std::string("void ") + suffix : name;
+        auto inner = type_name(rec.target);
+        if (m_records[rec.target].kind == type_kind::function) {
+            // 函数指针：int (int) -> int (*)(int)
+            auto paren = inner.find(" (");
+            if (paren != std::string::npos)
+                return inner.substr(0, paren) + " (" + suffix + ")" + inner.substr(paren + 1);
+        }
+        return inner + (inner.back() == '*' || inner.back() == '&' ? "" : " ") + suffix;
+    }
+    case type_kind::array: {
+        auto inner = type_name(rec.target);
+        inner += " ";
+        for (uint32_t i = 0; i < rec.count; ++i) {
+            auto d = m_dims[rec.first + i];
+            inner += d ? "[" + std::to_string(d) + "]" : "[]";
+        }
+        return inner;
+    }
+    case type_kind::structure:
+        return name.empty() ? (rec.is_class ? "class {...}" : "struct {...}") : name;
+    case type_kind::union_:
+        return name.empty() ? "union {...}" : name;
+    case type_kind::enumeration:
+        return name.empty() ? "enum {...}" : name;
+    case type_kind::unknown:
+        return "?";
+    default:
+        return name.empty() ? "?" : name;
+    }
+}
+
+bool type_db::find_field(type_id id, const std::string &name, uint32_t &offset, type_id &type) const
+{
+    if (id == no_type)
+        return false;
+    const auto &rec = m_records[id];
+    if (rec.kind != type_kind::structure && rec.kind != type_kind::union_)
+        return false;
+    auto list = members(id);
+    for (uint32_t i = 0; i < rec.count; ++i) {
+        const auto &m = list[i];
+        if (!(m.flags & type_member::base) && !m.bit_size && m.name != 0 && m_strings[m.name] == name) {
+            offset = m.byte_offset();
+            type = m.type;
+            return true;
+        }
+    }
+    for (uint32_t i = 0; i < rec.count; ++i) {
+        const auto &m = list[i];
+        if ((m.flags & type_member::virtual_base) || (!(m.flags & type_member::base) && m.name != 0))
+            continue;
+        uint32_t inner;
+        if (find_field(m.type, name, inner, type)) {
+            offset = m.byte_offset() + inner;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t type_db::element_count(type_id id) const
+{
+    const auto &rec = m_records[id];
+    if (rec.kind != type_kind::array)
+        return 1;
+    uint64_t total = 1;
+    for (uint32_t i = 0; i < rec.count; ++i)
+        total *= m_dims[rec.first + i];
+    return total;
+}
+
+std::size_t type_db::value_size(type_id id, std::size_t limit) const
+{
+    std::size_t size = m_records[id].size;
+    if (size == 0)
+        size = 8;
+    return std::min(size, limit);
+}
+
+std::size_t type_db::stride(type_id id, uint32_t dim) const
+{
+    const auto &rec = m_records[id];
+    if (rec.kind != type_kind::array)
+        return rec.size;
+    std::size_t size = m_records[rec.target].size;
+    for (uint32_t i = dim + 1; i < rec.count; ++i)
+        size *= m_dims[rec.first + i];
+    return size;
+}
+
+std::string type_db::format(type_id id, const uint8_t *bytes, std::size_t len, uint32_t dim) const
+{
+    std::string out;
+    if (id == no_type)
+        id = m_unknown;
+    if (dim > 0 && m_records[id].kind == type_kind::array)
+        format_array(out, id, dim, bytes, len, 0);
+    else
+        format_into(out, id, bytes, len, 0);
+    return out;
+}
+
+std::string type_db::format_bits(type_id id, const uint8_t *bytes, std::size_t len, uint32_t bit_offset, uint16_t bit_size) const
+{
+    std::string out;
+    if (!append_bits(out, id, bytes, len, bit_offset, bit_size))
+        out = "<unavailable>";
+    return out;
+}
+
+bool type_db::append_bits(std::string &out, type_id id, const uint8_t *bytes, std::size_t len, uint32_t bit_offset, uint16_t bit_size) const
+{
+    // 位域：取出包含它的至多8个字节再移位
+    std::size_t first = bit_offset / 8;
+    std::size_t last = (bit_offset + bit_size + 7) / 8;
+    if (last > len || last - first > 8)
+        return false;
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + first, last - first);
+    word >>= bit_offset % 8;
+    if (bit_size < 64)
+        word &= (1ull << bit_size) - 1;
+    const auto &rec = m_records[id];
+    bool is_signed = rec.kind == type_kind::signed_int || rec.kind == type_kind::signed_char
+                     || (rec.kind == type_kind::enumeration && rec.target != no_type
+                         && m_records[rec.target].kind == type_kind::signed_int);
+    if (is_signed && bit_size < 64 && ((word >> (bit_size - 1)) & 1))
+        word |= ~0ull << bit_size;
+    if (rec.kind == type_kind::enumeration || rec.kind == type_kind::boolean)
+        format_scalar(out, id, reinterpret_cast<const uint8_t *>(&word), sizeof(word));
+    else
+        out += is_signed ? std::to_string(static_cast<int64_t>(word)) : std::to_string(word);
+    return true;
+}
+
+static void append_char(std::string &out, unsigned char c, char quote)
+{
+    static const char hex[] = "0123456789abcdef";
+    switch (c) {
+    case '\n': out += "\\n"; return;
+    case '\t': out += "\\t"; return;
+    case '\r': out += "\\r"; return;
+    case '\0': out += "\\0"; return;
+    case '\\': out += "\\\\"; return;
+    default: break;
+    }
+    if (c == static_cast<unsigned char>(quote)) {
+        out += '\\';
+        out += quote;
+    } else if (c < 0x20 || c >= 0x7f) {
+        out += "\\x";
+        out += hex[c >> 4];
+        out += hex[c & 15];
+    } else {
+        out += static_cast<char>(c);
+    }
+}
+
+std::string type_db::quote(const uint8_t *bytes, std::size_t len)
+{
+    std::string out = "\"";
+    for (std::size_t i = 0; i < len; ++i)
+        append_char(out, bytes[i], '"');
+    out += "\"";
+    return out;
+}
+
+void type_db::format_scalar(std::string &out, type_id id, const uint8_t *bytes, std::size_t len) const
+{
+    const auto &rec = m_records[id];
+    std::size_t size = std::min<std::size_t>(rec.size ? rec.size : 8, len);
+    uint64_t raw = 0;
+    std::memcpy(&raw, bytes, std::min<std::size_t>(size, 8));
+    bool negative = size > 0 && size < 8 && ((raw >> (size * 8 - 1)) & 1);
+    uint64_t sign_extended = negative ? raw | (~0ull << (size * 8)) : raw;
+
+    std::ostringstream oss;
+    switch (rec.kind) {
+    case type_kind::floating:
+        if (size == sizeof(float)) {
+            float f;
+            std::memcpy(&f, bytes, sizeof(f));
+            oss << f;
+        } else if (size == sizeof(double)) {
+            double d;
+            std::memcpy(&d, bytes, sizeof(d));
+            oss << d;
+        } else {
+            long double ld = 0;
+            std::memcpy(&ld, bytes, std::min(size, sizeof(ld)));
+            oss << ld;
+        }
+        break;
+    case type_kind::boolean:
+        oss << (raw ? "true" : "false");
+        break;
+    case type_kind::pointer:
+        oss << "0x" << std::hex << raw;
+        break;
+    case type_kind::reference:
+        oss << "@0x" << std::hex << raw;
+        break;
+    case type_kind::signed_char:
+    case type_kind::unsigned_char: {
+        if (rec.kind == type_kind::signed_char)
+            oss << static_cast<int64_t>(sign_extended);
+        else
+            oss << raw;
+        std::string quoted = " '";
+        append_char(quoted, static_cast<unsigned char>(raw), '\'');
+        oss << quoted << "'";
+        break;
+    }
+    case type_kind::enumeration: {
+        uint64_t mask = size >= 8 ? ~0ull : (1ull << (size * 8)) - 1;
+        auto values = enumerators(id);
+        for (uint32_t i = 0; i < rec.count; ++i) {
+            if ((static_cast<uint64_t>(values[i].value) & mask) == (raw & mask)) {
+                out += m_strings[values[i].name];
+                return;
+            }
+        }
+        bool is_signed = rec.target == no_type || m_records[rec.target].kind == type_kind::signed_int;
+        if (is_signed)
+            oss << static_cast<int64_t>(sign_extended);
+        else
+            oss << raw;
+        break;
+    }
+    case type_kind::signed_int:
+    case type_kind::unknown:
+        if (size > 8) {
+            // __int128 只显示十六进制
+            oss << "0x" << std::hex << std::setfill('0');
+            for (std::size_t i = size; i-- > 0;)
+                oss << std::setw(2) << static_cast<unsigned>(bytes[i]);
+        } else {
+            oss << static_cast<int64_t>(sign_extended);
+        }
+        break;
+    case type_kind::function:
+        oss << "{" << type_name(id) << "}";
+        break;
+    case type_kind::void_:
+        oss << "void";
+        break;
+    default:
+        if (size > 8) {
+            oss << "0x" << std::hex << std::setfill('0');
+            for (std::size_t i = size; i-- > 0;)
+                oss << std::setw(2) << static_cast<unsigned>(bytes[i]);
+        } else {
+            oss << raw;
+        }
+        break;
+    }
+    out += oss.str();
+}
+
+void type_db::format_array(std::string &out, type_id id, uint32_t dim, const uint8_t *bytes, std::size_t len, unsigned depth) const
+{
+    const auto &rec = m_records[id];
+    const auto &elem = m_records[rec.target];
+    auto dims = dimensions(id);
+    // 多维数组逐层展开：第dim维的每个元素是由其后各维组成的数组
+    std::size_t step = stride(id, dim);
+    uint64_t count = dims[dim];
+    if (count == 0 || step == 0) {
+        out += "{...}";
+        return;
+    }
+    bool innermost = dim + 1 == rec.count;
+    if (innermost && elem.size == 1 && (elem.kind == type_kind::signed_char || elem.kind == type_kind::unsigned_char)) {
+        // 字符数组显示为字符串，到第一个 NUL 为止
+        out += "\"";
+        std::size_t n = std::min<std::size_t>(count, len);
+        std::size_t i = 0;
+        for (; i < n && bytes[i]; ++i)
+            append_char(out, bytes[i], '"');
+        out += "\"";
+        if (i == n && n < count)
+            out += "...";
+        return;
+    }
+    out += "{";
+    uint64_t shown = std::min<uint64_t>(count, max_elements);
+    for (uint64_t i = 0; i < shown; ++i) {
+        if (i)
+            out += ", ";
+        std::size_t offset = i * step;
+        if (offset >= len) {
+            out += "...";
+            break;
+        }
+        if (innermost)
+            format_into(out, rec.target, bytes + offset, len - offset, depth + 1);
+        else
+            format_array(out, id, dim + 1, bytes + offset, len - offset, depth + 1);
+    }
+    if (shown < count && shown * step < len)
+        out += "...";
+    out += "}";
+}
+
+void type_db::format_into(std::string &out, type_id id, const uint8_t *bytes, std::size_t len, unsigned depth) const
+{
+    const auto &rec = m_records[id];
+    if (depth > 8) {
+        out += "{...}";
+        return;
+    }
+    if (rec.size > len && rec.kind != type_kind::structure && rec.kind != type_kind::union_ && rec.kind != type_kind::array) {
+        out += "<unavailable>";
+        return;
+    }
+    switch (rec.kind) {
+    case type_kind::structure:
+    case type_kind::union_: {
+        if (rec.size == 0 && rec.count == 0) {
+            out += "<incomplete type>";
+            return;
+        }
+        out += "{";
+        auto list = members(id);
+        for (uint32_t i = 0; i < rec.count; ++i) {
+            const auto &m = list[i];
+            if (i)
+                out += ", ";
+            if (m.flags & type_member::base)
+                out += "<" + type_name(m.type) + "> = ";
+            else if (m.name)
+                out += m_strings[m.name] + " = ";
+            if (m.flags & type_member::virtual_base) {
+                out += "<virtual base>";
+                continue;
+            }
+            if (m.bit_size) {
+                if (!append_bits(out, m.type, bytes, len, m.bit_offset, m.bit_size)) {
+                    out += "...";
+                    break;
+                }
+                continue;
+            }
+            std::size_t offset = m.byte_offset();
+            if (offset >= len) {
+                out += "...";
+                break;
+            }
+            format_into(out, m.type, bytes + offset, len - offset, depth + 1);
+        }
+        out += "}";
+        return;
+    }
+    case type_kind::array:
+        format_array(out, id, 0, bytes, len, depth);
+        return;
+    default:
+        format_scalar(out, id, bytes, len);
+        return;
+    }
+}
+
+}   // namespace minidbg
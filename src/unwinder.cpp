@@ -0,0 +1,833 @@
+#include "unwinder.h"
+#include <cstring>
+#include <algorithm>
+#include <string>
+
+namespace minidbg {
+
+namespace {
+
+// DW_EH_PE_* 指针编码
+constexpr uint8_t pe_omit = 0xff;
+constexpr uint8_t pe_datarel_sdata4 = 0x3b;
+
+/**
+ * @brief 节数据上的读取游标，越界时置 ok = false 并停在末尾。
+ *
+ */
+struct reader {
+    const uint8_t *p;
+    const uint8_t *end;
+    const uint8_t *sec_begin;
+    uint64_t sec_vaddr;
+    bool ok;
+
+    template <typename T>
+    T fixed()
+    {
+        if (static_cast<std::size_t>(end - p) < sizeof(T)) {
+            ok = false;
+            p = end;
+            return 0;
+        }
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+
+    uint8_t u8() { return fixed<uint8_t>(); }
+
+    uint64_t uleb()
+    {
+        uint64_t v = 0;
+        unsigned shift = 0;
+        while (p < end) {
+            uint8_t b = *p++;
+            if (shift < 64) v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            shift += 7;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return v;
+    }
+
+    int64_t sleb()
+    {
+        int64_t v = 0;
+        unsigned shift = 0;
+        while (p < end) {
+            uint8_t b = *p++;
+            if (shift < 64) v |= static_cast<int64_t>(b & 0x7f) << shift;
+            shift += 7;
+            if (!(b & 0x80)) {
+                if (shift < 64 && (b & 0x40)) v |= -(static_cast<int64_t>(1) << shift);
+                return v;
+            }
+        }
+        ok = false;
+        return v;
+    }
+
+    void skip(uint64_t n)
+    {
+        if (n > static_cast<uint64_t>(end - p)) {
+            ok = false;
+            p = end;
+            return;
+        }
+        p += n;
+    }
+
+    /**
+     * @brief 按 DW_EH_PE_* 编码读取指针。间接指针（只用于personality）不解引用。
+     *
+     */
+    uint64_t encoded(uint8_t enc, uint64_t data_base)
+    {
+        if (enc == pe_omit) return 0;
+        uint64_t field = sec_vaddr + (p - sec_begin);
+        uint64_t v;
+        switch (enc & 0x0f) {
+        case 0x00: v = fixed<uint64_t>(); break;
+        case 0x01: v = uleb(); break;
+        case 0x02: v = fixed<uint16_t>(); break;
+        case 0x03: v = fixed<uint32_t>(); break;
+        case 0x04: v = fixed<uint64_t>(); break;
+        case 0x09: v = static_cast<uint64_t>(sleb()); break;
+        case 0x0a: v = static_cast<uint64_t>(static_cast<int64_t>(fixed<int16_t>())); break;
+        case 0x0b: v = static_cast<uint64_t>(static_cast<int64_t>(fixed<int32_t>())); break;
+        case 0x0c: v = fixed<uint64_t>(); break;
+        default: ok = false; return 0;
+        }
+        switch (enc & 0x70) {
+        case 0x00: break;
+        case 0x10: v += field; break;
+        case 0x30: v += data_base; break;
+        default: ok = false; break;         // textrel / funcrel / aligned 在x86-64上不会出现
+        }
+        return v;
+    }
+};
+
+/**
+ * @brief x86-64 System V 中被调用者保存的寄存器：rbx、rbp、r12-r15。
+ *
+ */
+bool callee_saved(unsigned r)
+{
+    return r == 3 || r == 6 || (r >= 12 && r <= 15);
+}
+
+}   // namespace
+
+cfi_table::cfi_table(const elf::elf &f)
+    : m_elf{f}, m_eh_frame{nullptr, 0, 0}, m_debug_frame{nullptr, 0, 0}, m_hdr_table{nullptr}, m_hdr_vaddr{0},
+      m_hdr_count{0}, m_indexed{false}
+{
+    auto load = [this](const char *name) -> section_data {
+        const auto &sec = m_elf.get_section(name);
+        if (!sec.valid() || sec.get_hdr().type == elf::sht::nobits) return section_data{nullptr, 0, 0};
+        return section_data{static_cast<const uint8_t *>(sec.data()), sec.size(), sec.get_hdr().addr};
+    };
+    m_eh_frame = load(".eh_frame");
+    m_debug_frame = load(".debug_frame");
+
+    // .eh_frame_hdr: version, eh_frame_ptr_enc, fde_count_enc, table_enc, eh_frame_ptr, fde_count, table
+    section_data hdr = load(".eh_frame_hdr");
+    if (hdr.data && hdr.size >= 4 && hdr.data[0] == 1 && m_eh_frame.data) {
+        reader r{hdr.data + 4, hdr.data + hdr.size, hdr.data, hdr.vaddr, true};
+        r.encoded(hdr.data[1], hdr.vaddr);
+        uint64_t count = r.encoded(hdr.data[2], hdr.vaddr);
+        if (r.ok && hdr.data[3] == pe_datarel_sdata4 && count <= static_cast<uint64_t>(r.end - r.p) / 8) {
+            m_hdr_table = r.p;
+            m_hdr_vaddr = hdr.vaddr;
+            m_hdr_count = count;
+        }
+    }
+}
+
+const cfi_row *cfi_table::row_for(uint64_t pc)
+{
+    auto it = m_rows.find(pc);
+    if (it != m_rows.end()) return &it->second;
+    if (m_no_row.count(pc)) return nullptr;
+
+    fde f;
+    cfi_row row;
+    if (!find_fde(pc, f) || !execute(f, pc, row)) {
+        m_no_row.insert(pc);
+        return nullptr;
+    }
+    return &m_rows.emplace(pc, row).first->second;
+}
+
+bool cfi_table::find_fde(uint64_t pc, fde &out)
+{
+    if (m_hdr_table) {
+        // 表项为两个相对 .eh_frame_hdr 的int32：(initial_location, FDE地址)，按initial_location排序
+        auto entry = [this](std::size_t i, std::size_t field) {
+            int32_t v;
+            std::memcpy(&v, m_hdr_table + i * 8 + field * 4, 4);
+            return m_hdr_vaddr + static_cast<int64_t>(v);
+        };
+        std::size_t lo = 0, hi = m_hdr_count;
+        while (lo < hi) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (entry(mid, 0) <= pc) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo > 0) {
+            uint64_t offset = entry(lo - 1, 1) - m_eh_frame.vaddr;
+            if (offset < m_eh_frame.size && parse_fde(m_eh_frame, offset, false, out) && pc >= out.pc_begin && pc < out.pc_end)
+                return true;
+        }
+    }
+
+    if (!m_indexed) build_index();
+    auto it = std::upper_bound(m_index.begin(), m_index.end(), pc,
+                               [](uint64_t v, const index_entry &e) { return v < e.pc_begin; });
+    while (it != m_index.begin()) {
+        --it;
+        const auto &sec = it->debug_frame ? m_debug_frame : m_eh_frame;
+        if (parse_fde(sec, it->offset, it->debug_frame, out) && pc < out.pc_end) return true;
+        if (it != m_index.begin() && std::prev(it)->pc_begin != it->pc_begin) break;
+    }
+    return false;
+}
+
+void cfi_table::build_index()
+{
+    m_indexed = true;
+    auto scan = [this](const section_data &sec, bool debug_frame) {
+        std::size_t offset = 0;
+        while (sec.data && offset + 4 <= sec.size) {
+            reader r{sec.data + offset, sec.data + sec.size, sec.data, sec.vaddr, true};
+            uint64_t length = r.fixed<uint32_t>();
+            bool is64 = length == 0xffffffff;
+            if (is64) length = r.fixed<uint64_t>();
+            if (length == 0) {
+                if (!debug_frame) break;        // .eh_frame 的结束标记
+                offset += 4;
+                continue;
+            }
+            std::size_t next = (r.p - sec.data) + length;
+            if (!r.ok || next > sec.size) break;
+            uint64_t id = is64 ? r.fixed<uint64_t>() : r.fixed<uint32_t>();
+            bool is_cie = debug_frame ? id == (is64 ? ~0ull : 0xffffffffull) : id == 0;
+            fde f;
+            if (!is_cie && parse_fde(sec, offset, debug_frame, f))
+                m_index.push_back(index_entry{f.pc_begin, offset, debug_frame});
+            offset = next;
+        }
+    };
+    if (!m_hdr_table) scan(m_eh_frame, false);
+    scan(m_debug_frame, true);
+    std::stable_sort(m_index.begin(), m_index.end(),
+                     [](const index_entry &a, const index_entry &b) { return a.pc_begin < b.pc_begin; });
+}
+
+bool cfi_table::parse_fde(const section_data &sec, std::size_t offset, bool debug_frame, fde &out)
+{
+    reader r{sec.data + offset, sec.data + sec.size, sec.data, sec.vaddr, true};
+    uint64_t length = r.fixed<uint32_t>();
+    bool is64 = length == 0xffffffff;
+    if (is64) length = r.fixed<uint64_t>();
+    if (!r.ok || length == 0 || length > static_cast<uint64_t>(r.end - r.p)) return false;
+    const uint8_t *end = r.p + length;
+
+    const uint8_t *id_pos = r.p;
+    uint64_t id = is64 ? r.fixed<uint64_t>() : r.fixed<uint32_t>();
+    std::size_t cie_offset;
+    if (debug_frame) {
+        if (id == (is64 ? ~0ull : 0xffffffffull)) return false;
+        cie_offset = id;
+    } else {
+        // .eh_frame 中是从该字段向前的距离
+        if (id == 0 || id > static_cast<uint64_t>(id_pos - sec.data)) return false;
+        cie_offset = (id_pos - sec.data) - id;
+    }
+    const cie *c = parse_cie(sec, cie_offset, debug_frame);
+    if (c == nullptr) return false;
+
+    uint64_t begin, range;
+    if (debug_frame) {
+        begin = r.fixed<uint64_t>();
+        range = r.fixed<uint64_t>();
+    } else {
+        begin = r.encoded(c->fde_encoding, 0);
+        range = r.encoded(c->fde_encoding & 0x0f, 0);
+    }
+    if (c->has_augmentation_data) r.skip(r.uleb());
+    if (!r.ok || r.p > end) return false;
+
+    out = fde{c, begin, begin + range, r.p, end};
+    return true;
+}
+
+const cfi_table::cie *cfi_table::parse_cie(const section_data &sec, std::size_t offset, bool debug_frame)
+{
+    uint64_t key = offset | (debug_frame ? 1ull << 63 : 0);
+    auto it = m_cies.find(key);
+    if (it != m_cies.end()) return &it->second;
+    if (offset + 4 > sec.size) return nullptr;
+
+    reader r{sec.data + offset, sec.data + sec.size, sec.data, sec.vaddr, true};
+    uint64_t length = r.fixed<uint32_t>();
+    bool is64 = length == 0xffffffff;
+    if (is64) length = r.fixed<uint64_t>();
+    if (!r.ok || length == 0 || length > static_cast<uint64_t>(r.end - r.p)) return nullptr;
+    const uint8_t *end = r.p + length;
+    r.end = end;
+
+    uint64_t id = is64 ? r.fixed<uint64_t>() : r.fixed<uint32_t>();
+    if (id != (debug_frame ? (is64 ? ~0ull : 0xffffffffull) : 0)) return nullptr;
+
+    uint8_t version = r.u8();
+    const char *aug = reinterpret_cast<const char *>(r.p);
+    std::size_t aug_len = strnlen(aug, end - r.p);
+    if (aug_len == static_cast<std::size_t>(end - r.p)) return nullptr;
+    std::string augmentation(aug, aug_len);
+    r.skip(aug_len + 1);
+    if (debug_frame && version >= 4) r.skip(2);        // address_size、segment_selector_size
+
+    cie c{};
+    if (augmentation == "eh") r.fixed<uint64_t>();     // 旧版GCC的异常表指针
+    c.code_align = r.uleb();
+    c.data_align = r.sleb();
+    c.ra_column = version == 1 ? r.u8() : static_cast<unsigned>(r.uleb());
+    c.fde_encoding = 0;
+
+    if (!augmentation.empty() && augmentation[0] == 'z') {
+        c.has_augmentation_data = true;
+        uint64_t n = r.uleb();
+        const uint8_t *data_end = r.p + std::min<uint64_t>(n, end - r.p);
+        for (std::size_t i = 1; i < augmentation.size() && r.ok; ++i) {
+            char ch = augmentation[i];
+            if (ch == 'R') c.fde_encoding = r.u8();
+            else if (ch == 'P') r.encoded(r.u8() & 0x7f, 0);
+            else if (ch == 'L') r.u8();
+            else if (ch == 'S') c.signal_frame = true;
+            else break;                 // 未知的增强字母，剩余增强数据按长度跳过
+        }
+        r.p = data_end;
+    } else if (!augmentation.empty() && augmentation != "eh") {
+        return nullptr;                 // 没有'z'就无法知道增强数据的长度
+    }
+    if (!r.ok) return nullptr;
+
+    c.insns = r.p;
+    c.insns_end = end;
+    return &m_cies.emplace(key, c).first->second;
+}
+
+bool cfi_table::execute(const fde &f, uint64_t pc, cfi_row &row)
+{
+    const cie &c = *f.owner;
+    bool debug_frame = f.insns >= m_debug_frame.data && f.insns < m_debug_frame.data + m_debug_frame.size;
+    const section_data &sec = debug_frame ? m_debug_frame : m_eh_frame;
+
+    row = cfi_row{};
+    row.cfa_reg = 7;
+    row.cfa_offset = 8;
+    row.signal_frame = c.signal_frame;
+    cfi_row initial{};
+    std::vector<cfi_row> saved;         // DW_CFA_remember_state
+
+    // 依次执行CIE的初始指令（得到DW_CFA_restore使用的初始行）和FDE的指令，直到位置超过pc
+    auto run = [&](const uint8_t *p, const uint8_t *end, uint64_t target) -> bool {
+        reader r{p, end, sec.data, sec.vaddr, true};
+        uint64_t loc = f.pc_begin;
+        auto rule = [&](uint64_t reg) -> cfi_rule * {
+            return reg < cfi_n_regs ? &row.rules[reg] : nullptr;
+        };
+        auto set = [&](uint64_t reg, cfi_rule::kind how, int64_t offset) {
+            if (auto *x = rule(reg)) *x = cfi_rule{how, 0, offset, nullptr, 0};
+        };
+        while (r.ok && r.p < r.end) {
+            uint8_t op = r.u8();
+            uint8_t operand = op & 0x3f;
+            uint64_t delta = 0;
+            bool advance = false;
+            switch (op & 0xc0) {
+            case 0x40:
+                delta = operand * c.code_align;
+                advance = true;
+                break;
+            case 0x80:
+                set(operand, cfi_rule::at_offset, static_cast<int64_t>(r.uleb()) * c.data_align);
+                continue;
+            case 0xc0:
+                if (auto *x = rule(operand)) *x = initial.rules[operand];
+                continue;
+            default:
+                break;
+            }
+            if (!advance) {
+                switch (op) {
+                case 0x00: break;                                               // nop
+                case 0x01:                                                      // set_loc
+                    loc = r.encoded(c.fde_encoding, 0);
+                    if (loc > target) return true;
+                    break;
+                case 0x02: delta = r.u8() * c.code_align; advance = true; break;
+                case 0x03: delta = r.fixed<uint16_t>() * c.code_align; advance = true; break;
+                case 0x04: delta = r.fixed<uint32_t>() * c.code_align; advance = true; break;
+                case 0x05: {                                                    // offset_extended
+                    uint64_t reg = r.uleb();
+                    set(reg, cfi_rule::at_offset, static_cast<int64_t>(r.uleb()) * c.data_align);
+                    break;
+                }
+                case 0x06: {                                                    // restore_extended
+                    uint64_t reg = r.uleb();
+                    if (auto *x = rule(reg)) *x = initial.rules[reg];
+                    break;
+                }
+                case 0x07: set(r.uleb(), cfi_rule::undefined, 0); break;
+                case 0x08: set(r.uleb(), cfi_rule::same_value, 0); break;
+                case 0x09: {                                                    // register
+                    uint64_t reg = r.uleb();
+                    uint64_t other = r.uleb();
+                    if (auto *x = rule(reg)) *x = cfi_rule{cfi_rule::in_register, static_cast<unsigned>(other), 0, nullptr, 0};
+                    break;
+                }
+                case 0x0a: saved.push_back(row); break;                         // remember_state
+                case 0x0b:                                                      // restore_state
+                    if (saved.empty()) return false;
+                    row = saved.back();
+                    saved.pop_back();
+                    break;
+                case 0x0c:                                                      // def_cfa
+                    row.cfa_reg = static_cast<unsigned>(r.uleb());
+                    row.cfa_offset = static_cast<int64_t>(r.uleb());
+                    row.cfa_is_expr = false;
+                    break;
+                case 0x0d:                                                      // def_cfa_register
+                    row.cfa_reg = static_cast<unsigned>(r.uleb());
+                    row.cfa_is_expr = false;
+                    break;
+                case 0x0e: row.cfa_offset = static_cast<int64_t>(r.uleb()); break;
+                case 0x0f: {                                                    // def_cfa_expression
+                    uint64_t len = r.uleb();
+                    row.cfa_expr = r.p;
+                    row.cfa_expr_len = len;
+                    row.cfa_is_expr = true;
+                    r.skip(len);
+                    break;
+                }
+                case 0x10:                                                      // expression
+                case 0x16: {                                                    // val_expression
+                    uint64_t reg = r.uleb();
+                    uint64_t len = r.uleb();
+                    if (auto *x = rule(reg))
+                        *x = cfi_rule{op == 0x10 ? cfi_rule::at_expression : cfi_rule::val_expression, 0, 0, r.p, len};
+                    r.skip(len);
+                    break;
+                }
+                case 0x11: {                                                    // offset_extended_sf
+                    uint64_t reg = r.uleb();
+                    set(reg, cfi_rule::at_offset, r.sleb() * c.data_align);
+                    break;
+                }
+                case 0x12:                                                      // def_cfa_sf
+                    row.cfa_reg = static_cast<unsigned>(r.uleb());
+                    row.cfa_offset = r.sleb() * c.data_align;
+                    row.cfa_is_expr = false;
+                    break;
+                case 0x13: row.cfa_offset = r.sleb() * c.data_align; break;   // def_cfa_offset_sf
+                case 0x14: {                                                    // val_offset
+                    uint64_t reg = r.uleb();
+                    set(reg, cfi_rule::val_offset, static_cast<int64_t>(r.uleb()) * c.data_align);
+                    break;
+                }
+                case 0x15: {                                                    // val_offset_sf
+                    uint64_t reg = r.uleb();
+                    set(reg, cfi_rule::val_offset, r.sleb() * c.data_align);
+                    break;
+                }
+                case 0x2e: r.uleb(); break;                                     // GNU_args_size
+                case 0x2f: {                                                    // GNU_negative_offset_extended
+                    uint64_t reg = r.uleb();
+                    set(reg, cfi_rule::at_offset, -static_cast<int64_t>(r.uleb()) * c.data_align);
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            if (advance) {
+                loc += delta;
+                if (loc > target) return true;
+            }
+        }
+        return r.ok;
+    };
+
+    if (!run(c.insns, c.insns_end, ~0ull)) return false;
+    initial = row;
+    saved.clear();
+    return run(f.insns, f.insns_end, pc);
+}
+
+unwinder::unwinder(inferior_memory &mem, module_lookup lookup)
+    : m_memory{mem}, m_lookup{std::move(lookup)}, m_stack_complete{false}, m_prev_complete{false}, m_splicing{false},
+      m_reused{0}, m_unwound{0}
+{
+}
+
+void unwinder::clear()
+{
+    m_modules.clear();
+    drop_stack();
+}
+
+void unwinder::forget(uint64_t lo, uint64_t hi)
+{
+    m_modules.erase(m_modules.lower_bound(lo), m_modules.lower_bound(hi));
+    drop_stack();
+}
+
+void unwinder::begin_stack(const user_regs_struct &regs)
+{
+    m_prev.swap(m_stack);
+    m_prev_complete = m_stack_complete;
+    m_stack.clear();
+    m_stack.push_back(first_frame(regs));
+    m_stack_complete = false;
+    m_splicing = !m_prev.empty();
+    m_reused = 0;
+    m_unwound = 0;
+}
+
+void unwinder::drop_stack()
+{
+    m_stack.clear();
+    m_prev.clear();
+    m_stack_complete = m_prev_complete = false;
+    m_splicing = false;
+}
+
+const unwind_frame *unwinder::frame_at(std::size_t i)
+{
+    while (m_stack.size() <= i && !m_stack_complete && !m_stack.empty()) {
+        unwind_frame caller;
+        if (!step(m_stack.front(), caller)) {
+            m_stack_complete = true;
+            break;
+        }
+        ++m_unwound;
+        if (m_splicing && splice(m_stack.front(), caller))
+            continue;
+        m_stack.push_front(caller);
+    }
+    return i < m_stack.size() ? &m_stack[m_stack.size() - 1 - i] : nullptr;
+}
+
+bool unwinder::splice(const unwind_frame &outer, const unwind_frame &caller)
+{
+    // 上一次最外层的帧如果还没有向外回溯过，CFA未知，不参与查找
+    std::size_t first = m_prev.front().cfa == 0 ? 1 : 0;
+    if (first >= m_prev.size() || outer.cfa > m_prev[first].cfa) {
+        m_splicing = false;         // 已经比上一次所有已知的帧更靠外，不可能再拼接
+        m_prev.clear();
+        return false;
+    }
+    auto it = std::lower_bound(m_prev.begin() + first, m_prev.end(), outer.cfa,
+                               [](const unwind_frame &f, uint64_t cfa) { return f.cfa > cfa; });
+    if (it == m_prev.end() || it->cfa != outer.cfa || it == m_prev.begin())
+        return false;
+
+    // 同一CFA处的帧：返回地址和恢复出的调用者寄存器必须全部相同
+    const unwind_frame &old_caller = *std::prev(it);
+    if (old_caller.pc != caller.pc || old_caller.valid != caller.valid || old_caller.exact_pc != caller.exact_pc)
+        return false;
+    for (unsigned r = 0; r < cfi_n_regs; ++r) {
+        if (caller.has(r) && caller.regs[r] != old_caller.regs[r])
+            return false;
+    }
+
+    // 保留上一次的外层帧，接上本次新回溯出的内层帧（outer 本身也用新值）
+    std::size_t k = it - m_prev.begin();
+    m_prev.erase(it, m_prev.end());
+    for (const auto &f : m_stack)
+        m_prev.push_back(f);
+    m_stack.swap(m_prev);
+    m_prev.clear();
+    m_stack_complete = m_prev_complete;
+    m_splicing = false;
+    m_reused = k;
+    return true;
+}
+
+unwind_frame unwinder::first_frame(const user_regs_struct &regs)
+{
+    unwind_frame f{};
+    const uint64_t values[cfi_n_regs] = {
+        regs.rax, regs.rdx, regs.rcx, regs.rbx, regs.rsi, regs.rdi, regs.rbp, regs.rsp,
+        regs.r8, regs.r9, regs.r10, regs.r11, regs.r12, regs.r13, regs.r14, regs.r15, regs.rip,
+    };
+    std::memcpy(f.regs, values, sizeof(values));
+    f.valid = (1u << cfi_n_regs) - 1;
+    f.pc = regs.rip;
+    f.exact_pc = true;
+    f.innermost = true;
+    return f;
+}
+
+unwinder::module *unwinder::module_for(uint64_t pc)
+{
+    auto it = m_modules.upper_bound(pc);
+    if (it != m_modules.begin() && pc < std::prev(it)->second.hi) return &std::prev(it)->second;
+
+    uint64_t bias = 0, lo = 0, hi = 0;
+    const elf::elf *f = m_lookup ? m_lookup(pc, bias, lo, hi) : nullptr;
+    if (f == nullptr || pc < lo || pc >= hi) return nullptr;
+    module m{hi, bias, std::unique_ptr<cfi_table>(new cfi_table(*f))};
+    return &m_modules.emplace(lo, std::move(m)).first->second;
+}
+
+bool unwinder::read_word(uint64_t addr, uint64_t &value)
+{
+    return m_memory.read(addr, &value, sizeof(value)) == sizeof(value);
+}
+
+bool unwinder::step(unwind_frame &frame, unwind_frame &caller)
+{
+    uint64_t pc = frame.lookup_pc();
+    module *m = module_for(pc);
+    const cfi_row *row = m ? m->table->row_for(pc - m->bias) : nullptr;
+    caller = unwind_frame{};
+    if (row == nullptr) return step_frame_pointer(frame, caller);
+
+    uint64_t cfa;
+    if (row->cfa_is_expr) {
+        if (!evaluate(row->cfa_expr, row->cfa_expr_len, frame, nullptr, cfa)) return false;
+    } else {
+        if (!frame.has(row->cfa_reg)) return false;
+        cfa = frame.regs[row->cfa_reg] + row->cfa_offset;
+    }
+    frame.cfa = cfa;
+
+    for (unsigned i = 0; i < cfi_n_regs; ++i) {
+        const cfi_rule &rule = row->rules[i];
+        uint64_t value = 0, addr = 0;
+        bool known = false;
+        switch (rule.how) {
+        case cfi_rule::unspecified:
+            known = callee_saved(i) && frame.has(i);
+            value = frame.regs[i];
+            break;
+        case cfi_rule::undefined:
+            break;
+        case cfi_rule::same_value:
+            known = frame.has(i);
+            value = frame.regs[i];
+            break;
+        case cfi_rule::at_offset:
+            known = read_word(cfa + rule.offset, value);
+            break;
+        case cfi_rule::val_offset:
+            value = cfa + rule.offset;
+            known = true;
+            break;
+        case cfi_rule::in_register:
+            known = frame.has(rule.reg);
+            value = known ? frame.regs[rule.reg] : 0;
+            break;
+        case cfi_rule::at_expression:
+            known = evaluate(rule.expr, rule.expr_len, frame, &cfa, addr) && read_word(addr, value);
+            break;
+        case cfi_rule::val_expression:
+            known = evaluate(rule.expr, rule.expr_len, frame, &cfa, value);
+            break;
+        }
+        if (known) {
+            caller.regs[i] = value;
+            caller.valid |= 1u << i;
+        }
+    }
+    // 调用者的rsp就是CFA
+    if (row->rules[7].how == cfi_rule::unspecified) {
+        caller.regs[7] = cfa;
+        caller.valid |= 1u << 7;
+    }
+
+    if (row->rules[cfi_ra].how == cfi_rule::unspecified || !caller.has(cfi_ra))
+        return false;           // 返回地址不可恢复：最外层帧（如_start）
+    caller.pc = caller.regs[cfi_ra];
+    caller.exact_pc = row->signal_frame;
+    if (caller.pc == 0 || !caller.has(7)) return false;
+    // 栈向低地址增长，调用者的rsp必须更高，否则CFI有误，停止以免死循环
+    return row->signal_frame || caller.regs[7] > frame.regs[7];
+}
+
+bool unwinder::step_frame_pointer(unwind_frame &frame, unwind_frame &caller)
+{
+    if (!frame.has(6) || !frame.has(7)) return false;
+    uint64_t rbp = frame.regs[6];
+    if (rbp < frame.regs[7] || (rbp & 7) != 0) return false;
+
+    uint64_t saved_rbp, ret;
+    if (!read_word(rbp, saved_rbp) || !read_word(rbp + 8, ret) || ret == 0) return false;
+    frame.cfa = rbp + 16;
+    for (unsigned i = 0; i < cfi_n_regs; ++i) {
+        if (callee_saved(i) && frame.has(i)) {
+            caller.regs[i] = frame.regs[i];
+            caller.valid |= 1u << i;
+        }
+    }
+    caller.regs[6] = saved_rbp;
+    caller.regs[7] = rbp + 16;
+    caller.regs[cfi_ra] = ret;
+    caller.valid |= (1u << 6) | (1u << 7) | (1u << cfi_ra);
+    caller.pc = ret;
+    caller.exact_pc = false;
+    return true;
+}
+
+bool unwinder::evaluate(const uint8_t *p, std::size_t len, const unwind_frame &frame, const uint64_t *initial,
+                        uint64_t &result)
+{
+    reader r{p, p + len, p, 0, true};
+    std::vector<uint64_t> stack;
+    if (initial) stack.push_back(*initial);
+
+    auto pop = [&](uint64_t &v) {
+        if (stack.empty()) return false;
+        v = stack.back();
+        stack.pop_back();
+        return true;
+    };
+
+    while (r.ok && r.p < r.end) {
+        uint8_t op = r.u8();
+        uint64_t a, b;
+        if (op >= 0x30 && op <= 0x4f) {                     // lit0-31
+            stack.push_back(op - 0x30);
+            continue;
+        }
+        if (op >= 0x70 && op <= 0x8f) {                     // breg0-31
+            unsigned reg = op - 0x70;
+            int64_t offset = r.sleb();
+            if (!frame.has(reg)) return false;
+            stack.push_back(frame.regs[reg] + offset);
+            continue;
+        }
+        switch (op) {
+        case 0x03: stack.push_back(r.fixed<uint64_t>()); break;                                  // addr
+        case 0x08: stack.push_back(r.u8()); break;                                               // const1u
+        case 0x09: stack.push_back(static_cast<uint64_t>(static_cast<int64_t>(r.fixed<int8_t>()))); break;
+        case 0x0a: stack.push_back(r.fixed<uint16_t>()); break;
+        case 0x0b: stack.push_back(static_cast<uint64_t>(static_cast<int64_t>(r.fixed<int16_t>()))); break;
+        case 0x0c: stack.push_back(r.fixed<uint32_t>()); break;
+        case 0x0d: stack.push_back(static_cast<uint64_t>(static_cast<int64_t>(r.fixed<int32_t>()))); break;
+        case 0x0e:
+        case 0x0f: stack.push_back(r.fixed<uint64_t>()); break;
+        case 0x10: stack.push_back(r.uleb()); break;                                             // constu
+        case 0x11: stack.push_back(static_cast<uint64_t>(r.sleb())); break;                      // consts
+        case 0x12:                                                                               // dup
+            if (stack.empty()) return false;
+            stack.push_back(stack.back());
+            break;
+        case 0x13: if (!pop(a)) return false; break;                                             // drop
+        case 0x14:                                                                               // over
+            if (stack.size() < 2) return false;
+            stack.push_back(stack[stack.size() - 2]);
+            break;
+        case 0x15: {                                                                             // pick
+            uint8_t i = r.u8();
+            if (i >= stack.size()) return false;
+            stack.push_back(stack[stack.size() - 1 - i]);
+            break;
+        }
+        case 0x16:                                                                               // swap
+            if (stack.size() < 2) return false;
+            std::swap(stack[stack.size() - 1], stack[stack.size() - 2]);
+            break;
+        case 0x17:                                                                               // rot
+            if (stack.size() < 3) return false;
+            std::rotate(stack.end() - 3, stack.end() - 1, stack.end());
+            break;
+        case 0x06: {                                                                             // deref
+            if (!pop(a) || !read_word(a, b)) return false;
+            stack.push_back(b);
+            break;
+        }
+        case 0x94: {                                                                             // deref_size
+            uint8_t size = r.u8();
+            b = 0;
+            if (size > 8 || !pop(a) || m_memory.read(a, &b, size) != size) return false;
+            stack.push_back(b);
+            break;
+        }
+        case 0x19:                                                                               // abs
+            if (!pop(a)) return false;
+            stack.push_back(static_cast<int64_t>(a) < 0 ? -a : a);
+            break;
+        case 0x1f:                                                                               // neg
+            if (!pop(a)) return false;
+            stack.push_back(-a);
+            break;
+        case 0x20:                                                                               // not
+            if (!pop(a)) return false;
+            stack.push_back(~a);
+            break;
+        case 0x23:                                                                               // plus_uconst
+            if (!pop(a)) return false;
+            stack.push_back(a + r.uleb());
+            break;
+        case 0x92: {                                                                             // bregx
+            uint64_t reg = r.uleb();
+            int64_t offset = r.sleb();
+            if (!frame.has(static_cast<unsigned>(reg))) return false;
+            stack.push_back(frame.regs[reg] + offset);
+            break;
+        }
+        case 0x28: {                                                                             // bra
+            int16_t skip = r.fixed<int16_t>();
+            if (!pop(a)) return false;
+            if (a != 0) {
+                if (skip < 0 ? -skip > r.p - p : skip > r.end - r.p) return false;
+                r.p += skip;
+            }
+            break;
+        }
+        case 0x2f: {                                                                             // skip
+            int16_t skip = r.fixed<int16_t>();
+            if (skip < 0 ? -skip > r.p - p : skip > r.end - r.p) return false;
+            r.p += skip;
+            break;
+        }
+        case 0x96: break;                                                                        // nop
+        default: {
+            // 二元运算：次栈顶 op 栈顶
+            if (!pop(b) || !pop(a)) return false;
+            int64_t sa = static_cast<int64_t>(a), sb = static_cast<int64_t>(b);
+            switch (op) {
+            case 0x1a: stack.push_back(a & b); break;
+            case 0x1b: if (sb == 0) return false; stack.push_back(static_cast<uint64_t>(sa / sb)); break;
+            case 0x1c: stack.push_back(a - b); break;
+            case 0x1d: if (b == 0) return false; stack.push_back(a % b); break;
+            case 0x1e: stack.push_back(a * b); break;
+            case 0x21: stack.push_back(a | b); break;
+            case 0x22: stack.push_back(a + b); break;
+            case 0x24: stack.push_back(b < 64 ? a << b : 0); break;
+            case 0x25: stack.push_back(b < 64 ? a >> b : 0); break;
+            case 0x26: stack.push_back(static_cast<uint64_t>(b < 64 ? sa >> b : (sa < 0 ? -1 : 0))); break;
+            case 0x27: stack.push_back(a ^ b); break;
+            case 0x29: stack.push_back(sa == sb); break;
+            case 0x2a: stack.push_back(sa >= sb); break;
+            case 0x2b: stack.push_back(sa > sb); break;
+            case 0x2c: stack.push_back(sa <= sb); break;
+            case 0x2d: stack.push_back(sa < sb); break;
+            case 0x2e: stack.push_back(sa != sb); break;
+            default: return false;                  // 寄存器位置（DW_OP_reg*）等在CFI中无意义
+            }
+            break;
+        }
+        }
+    }
+    return r.ok && pop(result);
+}
+
+}   // namespace minidbg
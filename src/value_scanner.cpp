@@ -0,0 +1,326 @@
+#include "value_scanner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+
+namespace minidbg {
+
+constexpr std::size_t value_scanner::chunk_bytes;
+constexpr std::size_t value_scanner::max_candidates;
+constexpr uint64_t value_scanner::merge_gap;
+constexpr std::size_t value_scanner::max_span;
+constexpr std::size_t value_scanner::batch_bytes;
+
+namespace {
+
+const uint8_t *const type_only = nullptr;      // 只为 DISPATCH_NUMBERS 提供元素类型
+
+template <typename T>
+T load(const uint8_t *p)
+{
+    T x;
+    std::memcpy(&x, p, sizeof(T));
+    return x;
+}
+
+/**
+ * @brief 新值 now 是否满足条件，before 为上次扫描时的值。变化与否按字节比较，NaN 也能判断。
+ *
+ */
+template <typename T>
+bool keep(scan_filter filter, T now, T before, T operand)
+{
+    switch (filter) {
+    case scan_filter::eq: return now == operand;
+    case scan_filter::ne: return now != operand;
+    case scan_filter::gt: return now > operand;
+    case scan_filter::lt: return now < operand;
+    case scan_filter::changed: return std::memcmp(&now, &before, sizeof(T)) != 0;
+    case scan_filter::unchanged: return std::memcmp(&now, &before, sizeof(T)) == 0;
+    case scan_filter::increased: return now > before;
+    case scan_filter::decreased: return now < before;
+    }
+    return false;
+}
+
+/**
+ * @brief 第一次扫描中的一块：按宽度对齐的位置逐个比较，满足条件的追加到候选中。
+ *
+ * @return false 达到候选数上限
+ */
+template <typename T, typename F>
+bool collect(const uint8_t *data, std::size_t len, uint64_t base, F match, std::vector<uint64_t> &addresses,
+             std::vector<uint8_t> &values, std::size_t limit)
+{
+    std::size_t n = len / sizeof(T);
+    for (std::size_t i = 0; i < n; ++i) {
+        T x = load<T>(data + i * sizeof(T));
+        if (!match(x))
+            continue;
+        if (addresses.size() >= limit)
+            return false;
+        addresses.push_back(base + i * sizeof(T));
+        values.insert(values.end(), data + i * sizeof(T), data + (i + 1) * sizeof(T));
+    }
+    return true;
+}
+
+double since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}   // namespace
+
+value_scanner::value_scanner(inferior_memory &memory)
+    : m_memory(memory), m_kind{number_kind::none}, m_width{0}, m_scans{0}, m_spans{0}, m_bytes_read{0}, m_seconds{0}, m_truncated{false}
+{
+}
+
+number_kind value_scanner::parse_kind(const std::string &name)
+{
+    static const std::pair<const char *, number_kind> names[] = {
+        {"i8", number_kind::i8}, {"u8", number_kind::u8}, {"i16", number_kind::i16}, {"u16", number_kind::u16},
+        {"i32", number_kind::i32}, {"u32", number_kind::u32}, {"i64", number_kind::i64}, {"u64", number_kind::u64},
+        {"f32", number_kind::f32}, {"f64", number_kind::f64},
+        {"char", number_kind::i8}, {"short", number_kind::i16}, {"int", number_kind::i32}, {"unsigned", number_kind::u32},
+        {"long", number_kind::i64}, {"float", number_kind::f32}, {"double", number_kind::f64},
+        {"int8_t", number_kind::i8}, {"uint8_t", number_kind::u8}, {"int16_t", number_kind::i16}, {"uint16_t", number_kind::u16},
+        {"int32_t", number_kind::i32}, {"uint32_t", number_kind::u32}, {"int64_t", number_kind::i64}, {"uint64_t", number_kind::u64}};
+    for (const auto &n : names) {
+        if (name == n.first)
+            return n.second;
+    }
+    return number_kind::none;
+}
+
+std::size_t value_scanner::width(number_kind kind)
+{
+    std::size_t result = 0;
+    auto size = [&](auto p) { result = sizeof(*p); };
+    DISPATCH_NUMBERS(kind, type_only, size)
+    return result;
+}
+
+void value_scanner::reset()
+{
+    m_kind = number_kind::none;
+    m_width = 0;
+    m_regions.clear();
+    m_addresses.clear();
+    m_addresses.shrink_to_fit();
+    m_values.clear();
+    m_values.shrink_to_fit();
+    m_scans = 0;
+    m_spans = 0;
+    m_bytes_read = 0;
+    m_seconds = 0;
+    m_truncated = false;
+    m_error.clear();
+}
+
+bool value_scanner::parse_operand(const std::string &text, uint64_t &raw)
+{
+    raw = 0;
+    bool ok = false;
+    auto parse = [&](auto p) {
+        using T = std::remove_const_t<std::remove_pointer_t<decltype(p)>>;
+        std::size_t used = 0;
+        T value{};
+        try {
+            if (std::is_floating_point<T>::value) {
+                value = static_cast<T>(std::stod(text, &used));
+            } else if (std::is_signed<T>::value) {
+                long long v = std::stoll(text, &used, 0);
+                if (v < static_cast<long long>(std::numeric_limits<T>::min()) || v > static_cast<long long>(std::numeric_limits<T>::max()))
+                    return;
+                value = static_cast<T>(v);
+            } else {
+                if (!text.empty() && text[0] == '-')
+                    return;
+                unsigned long long v = std::stoull(text, &used, 0);
+                if (v > static_cast<unsigned long long>(std::numeric_limits<T>::max()))
+                    return;
+                value = static_cast<T>(v);
+            }
+        } catch (const std::exception &) {
+            return;
+        }
+        if (used != text.size())
+            return;
+        std::memcpy(&raw, &value, sizeof(T));
+        ok = true;
+    };
+    DISPATCH_NUMBERS(m_kind, type_only, parse)
+    if (!ok)
+        m_error = "'" + text + "' is not a valid value of the scanned type";
+    return ok;
+}
+
+bool value_scanner::first(number_kind kind, scan_filter filter, const std::string &operand)
+{
+    reset();
+    if (kind == number_kind::none) {
+        m_error = "unknown value type";
+        return false;
+    }
+    if (filter != scan_filter::eq && filter != scan_filter::ne && filter != scan_filter::gt && filter != scan_filter::lt) {
+        m_error = "the first scan compares with a value: ==, !=, > or <";
+        return false;
+    }
+    m_kind = kind;
+    m_width = width(kind);
+    uint64_t raw;
+    if (!parse_operand(operand, raw)) {
+        m_kind = number_kind::none;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    m_regions = memory_search::read_maps(m_memory.pid());
+    std::vector<uint8_t> buffer(chunk_bytes);
+    bool room = true;
+    // 计数器之类的值只在可写的映射中
+    for (const auto &r : m_regions) {
+        if (!r.readable || !r.writable)
+            continue;
+        for (uint64_t a = r.lo; a < r.hi && room; a += chunk_bytes) {
+            std::size_t want = static_cast<std::size_t>(std::min<uint64_t>(chunk_bytes, r.hi - a));
+            std::size_t pos = 0;
+            // 块中不可读的页跳过
+            while (pos < want && room) {
+                std::size_t got = m_memory.read(a + pos, buffer.data() + pos, want - pos);
+                m_bytes_read += got;
+                auto scan = [&](auto p) {
+                    using T = std::remove_const_t<std::remove_pointer_t<decltype(p)>>;
+                    T value = load<T>(reinterpret_cast<const uint8_t *>(&raw));
+                    auto match = [&](T x) { return keep(filter, x, x, value); };
+                    room = collect<T>(buffer.data() + pos, got, a + pos, match, m_addresses, m_values, max_candidates);
+                };
+                DISPATCH_NUMBERS(m_kind, type_only, scan)
+                pos += got;
+                if (pos < want)
+                    pos = static_cast<std::size_t>(((a + pos) | 4095) + 1 - a);
+                ++m_spans;
+            }
+        }
+    }
+    m_truncated = !room;
+    m_scans = 1;
+    m_seconds = since(start);
+    return true;
+}
+
+bool value_scanner::next(scan_filter filter, const std::string &operand)
+{
+    m_error.clear();
+    if (!active()) {
+        m_error = "no scan in progress; start with a value type";
+        return false;
+    }
+    uint64_t raw = 0;
+    bool compares = filter == scan_filter::eq || filter == scan_filter::ne || filter == scan_filter::gt || filter == scan_filter::lt;
+    if (compares && !parse_operand(operand, raw))
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+    m_spans = 0;
+    m_bytes_read = 0;
+    std::size_t n = m_addresses.size();
+    std::size_t w = m_width;
+    std::size_t out = 0;
+    std::vector<uint8_t> buffer(std::min<uint64_t>(batch_bytes, n * (w + 8) + 8));
+    std::vector<mem_request> reqs;
+    std::vector<std::size_t> firsts;        // 各段的第一个候选
+    std::size_t i = 0;
+    while (i < n) {
+        // 相邻的候选合并为一段，段的起点按8字节对齐放入缓冲区
+        reqs.clear();
+        firsts.clear();
+        std::size_t used = 0;
+        std::size_t j = i;
+        for (; j < n; ++j) {
+            uint64_t a = m_addresses[j];
+            if (!reqs.empty()) {
+                auto &r = reqs.back();
+                uint64_t extended = a + w - r.addr;
+                if (a <= r.addr + r.len + merge_gap && extended <= max_span && used + (extended - r.len) <= buffer.size()) {
+                    used += extended - r.len;
+                    r.len = extended;
+                    continue;
+                }
+            }
+            std::size_t offset = (used + 7) & ~static_cast<std::size_t>(7);
+            if (offset + w > buffer.size())
+                break;
+            reqs.push_back(mem_request{a, buffer.data() + offset, w, 0});
+            firsts.push_back(j);
+            used = offset + w;
+        }
+        m_memory.read_batch(reqs.data(), reqs.size());
+        m_spans += reqs.size();
+
+        // 保留的候选前移，out 不超过正在处理的下标，原地覆盖是安全的
+        auto narrow = [&](auto p) {
+            using T = std::remove_const_t<std::remove_pointer_t<decltype(p)>>;
+            T value = load<T>(reinterpret_cast<const uint8_t *>(&raw));
+            uint64_t dead = 1;      // 最近一次重读失败的页，页首对齐，1表示没有
+            for (std::size_t s = 0; s < reqs.size(); ++s) {
+                const auto &r = reqs[s];
+                m_bytes_read += r.done;
+                std::size_t last = s + 1 < reqs.size() ? firsts[s + 1] : j;
+                for (std::size_t k = firsts[s]; k < last; ++k) {
+                    std::size_t offset = static_cast<std::size_t>(m_addresses[k] - r.addr);
+                    const uint8_t *now = static_cast<const uint8_t *>(r.buf) + offset;
+                    // 段中间有不可读的页时，其后的候选逐个重读，同一不可读页上的候选只试一次
+                    if (offset + sizeof(T) > r.done) {
+                        uint64_t page = m_addresses[k] & ~static_cast<uint64_t>(4095);
+                        if (page == dead || m_memory.read(m_addresses[k], static_cast<uint8_t *>(r.buf) + offset, sizeof(T)) != sizeof(T)) {
+                            dead = page;
+                            continue;
+                        }
+                    }
+                    if (!keep(filter, load<T>(now), load<T>(m_values.data() + k * sizeof(T)), value))
+                        continue;
+                    m_addresses[out] = m_addresses[k];
+                    std::memcpy(m_values.data() + out * sizeof(T), now, sizeof(T));
+                    ++out;
+                }
+            }
+        };
+        DISPATCH_NUMBERS(m_kind, type_only, narrow)
+        i = j;
+    }
+    m_addresses.resize(out);
+    m_values.resize(out * w);
+    ++m_scans;
+    m_seconds = since(start);
+    return true;
+}
+
+std::string value_scanner::format(std::size_t i) const
+{
+    if (i >= m_addresses.size())
+        return "<out of range>";
+    std::ostringstream oss;
+    auto get = [&](auto p) {
+        using T = std::remove_const_t<std::remove_pointer_t<decltype(p)>>;
+        oss << +load<T>(m_values.data() + i * m_width);
+    };
+    DISPATCH_NUMBERS(m_kind, type_only, get)
+    return oss.str();
+}
+
+const memory_region *value_scanner::region_of(uint64_t address) const
+{
+    auto next = std::upper_bound(m_regions.begin(), m_regions.end(), address,
+                                 [](uint64_t v, const memory_region &r) { return v < r.lo; });
+    if (next == m_regions.begin() || address >= std::prev(next)->hi)
+        return nullptr;
+    return &*std::prev(next);
+}
+
+}   // namespace minidbg
@@ -0,0 +1,327 @@
+#include "value_tree.h"
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+namespace minidbg {
+
+constexpr std::size_t value_tree::summary_bytes;
+constexpr std::size_t value_tree::summary_elements;
+constexpr unsigned value_tree::max_summary_depth;
+
+value_tree::value_tree(type_db &types, stop_state &state) : m_types(types), m_state(state), m_stl(types, state)
+{
+}
+
+void value_tree::clear()
+{
+    m_stl.clear();
+    m_printable.clear();
+}
+
+bool value_tree::has_printer(type_id type)
+{
+    if (type == no_type)
+        return false;
+    auto it = m_printable.find(type);
+    if (it != m_printable.end())
+        return it->second;
+    // 先记为否，含有指向自身的成员的类型不会无限递归
+    m_printable[type] = false;
+    const auto &rec = m_types.record(type);
+    bool result = false;
+    if (rec.kind == type_kind::structure || rec.kind == type_kind::union_) {
+        result = rec.kind == type_kind::structure && m_stl.layout(type).kind != stl_kind::none;
+        auto members = m_types.members(type);
+        for (uint32_t i = 0; i < rec.count && !result; ++i)
+            result = !(members[i].flags & type_member::virtual_base) && has_printer(members[i].type);
+    } else if (rec.kind == type_kind::array) {
+        result = has_printer(rec.target);
+    }
+    m_printable[type] = result;
+    return result;
+}
+
+const stl_layout *value_tree::container(const value_ref &v)
+{
+    if (!v.error.empty() || !v.in_memory || v.type == no_type || v.bit_size || m_types.record(v.type).kind != type_kind::structure)
+        return nullptr;
+    const auto &l = m_stl.layout(v.type);
+    return l.kind == stl_kind::none ? nullptr : &l;
+}
+
+bool value_tree::contiguous(const value_ref &v, uint64_t &address, type_id &element, uint64_t &count)
+{
+    if (!v.error.empty() || !v.in_memory || v.type == no_type || v.bit_size)
+        return false;
+    const auto &rec = m_types.record(v.type);
+    if (rec.kind == type_kind::array) {
+        auto dims = m_types.dimensions(v.type);
+        count = 1;
+        for (uint32_t i = v.dim; i < rec.count; ++i)
+            count *= dims[i];
+        address = v.address;
+        element = rec.target;
+        return true;
+    }
+    auto l = container(v);
+    if (l == nullptr || l->kind != stl_kind::vector || !m_stl.length(*l, v.address, count))
+        return false;
+    element = l->element;
+    address = 0;
+    return count == 0 || m_stl.element(*l, v.address, 0, address);
+}
+
+bool value_tree::indirect(const value_ref &v)
+{
+    return v.error.empty() && v.in_memory && has_printer(v.type);
+}
+
+std::size_t value_tree::byte_size(const value_ref &v) const
+{
+    const auto &rec = m_types.record(v.type);
+    if (rec.kind == type_kind::array && v.dim > 0)
+        return m_types.dimensions(v.type)[v.dim] * m_types.stride(v.type, v.dim);
+    return rec.size ? rec.size : 8;
+}
+
+std::size_t value_tree::summary_size(const value_ref &v) const
+{
+    if (v.bit_size)
+        return (v.bit_offset + v.bit_size + 7) / 8;
+    return std::min(byte_size(v), summary_bytes);
+}
+
+std::size_t value_tree::child_count(const value_ref &v)
+{
+    if (!v.error.empty() || v.type == no_type || v.bit_size)
+        return 0;
+    if (auto l = container(v))
+        return m_stl.element_count(*l, v.address);
+    const auto &rec = m_types.record(v.type);
+    switch (rec.kind) {
+    case type_kind::structure:
+    case type_kind::union_:
+        return rec.count;
+    case type_kind::array:
+        // 长度未知的数组（柔性数组、变长数组）不展开
+        return m_types.dimensions(v.type)[v.dim];
+    case type_kind::pointer:
+    case type_kind::reference: {
+        if (rec.target == no_type)
+            return 0;
+        auto kind = m_types.record(rec.target).kind;
+        return kind == type_kind::void_ || kind == type_kind::function || kind == type_kind::unknown ? 0 : 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+value_ref value_tree::child(const value_ref &v, std::size_t i)
+{
+    value_ref c;
+    if (auto l = container(v)) {
+        c.label = l->kind == stl_kind::shared_ptr ? "*" + v.label : "[" + std::to_string(i) + "]";
+        c.type = l->element;
+        c.in_memory = true;
+        if (!m_stl.element(*l, v.address, i, c.address))
+            c.error = "<unavailable>";
+        return c;
+    }
+    const auto &rec = m_types.record(v.type);
+    switch (rec.kind) {
+    case type_kind::structure:
+    case type_kind::union_: {
+        const auto &m = m_types.members(v.type)[i];
+        c.type = m.type;
+        c.label = (m.flags & type_member::base) ? "<" + m_types.type_name(m.type) + ">" : m_types.name_of(m.name);
+        if (m.flags & type_member::virtual_base) {
+            c.error = "<virtual base>";
+            return c;
+        }
+        c.in_memory = v.in_memory;
+        if (v.in_memory) {
+            c.address = v.address + m.byte_offset();
+            c.bit_offset = m.bit_size ? m.bit_offset % 8 : 0;
+        } else {
+            // 放在寄存器中的小结构体
+            c.word = m.bit_offset < 64 ? v.word >> (m.bit_offset - (m.bit_size ? m.bit_offset % 8 : 0)) : 0;
+            c.bit_offset = m.bit_size ? m.bit_offset % 8 : 0;
+        }
+        c.bit_size = m.bit_size;
+        return c;
+    }
+    case type_kind::array: {
+        c.label = "[" + std::to_string(i) + "]";
+        auto step = m_types.stride(v.type, v.dim);
+        if (v.dim + 1 < rec.count) {
+            c.type = v.type;
+            c.dim = v.dim + 1;
+        } else {
+            c.type = rec.target;
+        }
+        c.in_memory = v.in_memory;
+        if (v.in_memory)
+            c.address = v.address + i * step;
+        else
+            c.word = i * step < 8 ? v.word >> (i * step * 8) : 0;
+        return c;
+    }
+    case type_kind::pointer:
+    case type_kind::reference: {
+        c.label = "*" + v.label;
+        c.type = rec.target;
+        uint64_t pointer = v.word;
+        if (v.in_memory) {
+            if (!m_state.readable(v.address, sizeof(pointer)) || m_state.read(v.address, &pointer, sizeof(pointer)) != sizeof(pointer)) {
+                c.error = "<unavailable>";
+                return c;
+            }
+        }
+        c.in_memory = true;
+        c.address = pointer;
+        return c;
+    }
+    default:
+        c.error = "<no children>";
+        return c;
+    }
+}
+
+std::string value_tree::summary(const value_ref &v)
+{
+    return summary_at(v, 0);
+}
+
+std::string value_tree::container_summary(const value_ref &v, const stl_layout &l, unsigned depth)
+{
+    std::ostringstream oss;
+    uint64_t n = 0;
+    if (l.kind == stl_kind::string) {
+        std::string text;
+        if (m_stl.text(l, v.address, text))
+            return text;
+    } else if (l.kind == stl_kind::shared_ptr) {
+        uint64_t pointer;
+        uint32_t use, weak;
+        if (m_stl.counts(l, v.address, pointer, use, weak)) {
+            if (use == 0 && pointer == 0)
+                return l.name + " (empty) = nullptr";
+            // 有强引用时弱引用计数多记了1
+            oss << l.name << " (use count " << use << ", weak count " << (use && weak ? weak - 1 : weak) << ") = 0x" << std::hex << pointer;
+            return oss.str();
+        }
+    } else if (m_stl.length(l, v.address, n)) {
+        if (l.kind == stl_kind::vector) {
+            uint64_t start, limit;
+            // 容量由 _M_end_of_storage 算出
+            std::size_t size = m_types.record(l.element).size;
+            if (m_state.read(v.address + l.first, &start, sizeof(start)) == sizeof(start)
+                && m_state.read(v.address + l.limit, &limit, sizeof(limit)) == sizeof(limit) && limit >= start)
+                oss << l.name << " of length " << n << ", capacity " << (limit - start) / size;
+            else
+                oss << l.name << " of length " << n;
+        } else {
+            oss << l.name << " with " << n << (n == 1 ? " element" : " elements");
+        }
+        if (n == 0)
+            return oss.str();
+        if (depth >= max_summary_depth) {
+            oss << " = {...}";
+            return oss.str();
+        }
+        // 只有开头几个元素：树和哈希表只遍历第一页
+        oss << " = {";
+        std::size_t shown = static_cast<std::size_t>(std::min<uint64_t>(n, summary_elements));
+        for (std::size_t i = 0; i < shown; ++i) {
+            if (i)
+                oss << ", ";
+            auto e = child(v, i);
+            if (!l.is_map || !e.error.empty()) {
+                oss << summary_at(e, depth + 1);
+                continue;
+            }
+            // std::pair<const K, V> 显示为 [K] = V
+            value_ref key, value;
+            for (std::size_t k = 0, count = child_count(e); k < count; ++k) {
+                auto m = child(e, k);
+                if (m.label == "first")
+                    key = std::move(m);
+                else if (m.label == "second")
+                    value = std::move(m);
+            }
+            oss << "[" << summary_at(key, depth + 1) << "] = " << summary_at(value, depth + 1);
+        }
+        if (shown < n)
+            oss << "...";
+        oss << "}";
+        return oss.str();
+    }
+    oss << "<cannot access memory at 0x" << std::hex << v.address << ">";
+    return oss.str();
+}
+
+std::string value_tree::summary_at(const value_ref &v, unsigned depth)
+{
+    if (!v.error.empty())
+        return v.error;
+    if (auto l = container(v))
+        return container_summary(v, *l, depth);
+    if (v.in_memory && has_printer(v.type)) {
+        // 含有容器的结构体和数组逐个子节点显示，容器部分按其元素
+        if (depth >= max_summary_depth)
+            return "{...}";
+        bool is_array = m_types.record(v.type).kind == type_kind::array;
+        std::size_t n = child_count(v);
+        std::size_t shown = is_array ? std::min(n, summary_elements) : n;
+        std::string out = "{";
+        for (std::size_t i = 0; i < shown; ++i) {
+            auto c = child(v, i);
+            if (!is_array && c.label[0] == '<' && c.error.empty() && m_types.record(c.type).count == 0)
+                continue;       // 空基类，如 std::pair 的 __pair_base
+            if (out.size() > 1)
+                out += ", ";
+            if (!is_array)
+                out += c.label + " = ";
+            out += summary_at(c, depth + 1);
+        }
+        if (shown < n)
+            out += "...";
+        return out + "}";
+    }
+    if (!v.in_memory) {
+        if (v.bit_size)
+            return m_types.format_bits(v.type, reinterpret_cast<const uint8_t *>(&v.word), sizeof(v.word), v.bit_offset, v.bit_size);
+        return m_types.format(v.type, reinterpret_cast<const uint8_t *>(&v.word), sizeof(v.word), v.dim);
+    }
+
+    std::size_t len = summary_size(v);
+    std::vector<uint8_t> buffer(len);
+    std::size_t got = m_state.readable(v.address, len) ? m_state.read(v.address, buffer.data(), len) : 0;
+    if (got == 0 && len > 0) {
+        std::ostringstream oss;
+        oss << "<cannot access memory at 0x" << std::hex << v.address << ">";
+        return oss.str();
+    }
+    if (v.bit_size)
+        return m_types.format_bits(v.type, buffer.data(), got, v.bit_offset, v.bit_size);
+    return m_types.format(v.type, buffer.data(), got, v.dim);
+}
+
+std::string value_tree::type_name(const value_ref &v) const
+{
+    if (v.type == no_type)
+        return "?";
+    const auto &rec = m_types.record(v.type);
+    if (rec.kind != type_kind::array || v.dim == 0)
+        return m_types.type_name(v.type);
+    // 子数组：元素类型加剩余的维度
+    std::string name = m_types.type_name(rec.target) + " ";
+    auto dims = m_types.dimensions(v.type);
+    for (uint32_t i = v.dim; i < rec.count; ++i)
+        name += "[" + std::to_string(dims[i]) + "]";
+    return name;
+}
+
+}   // namespace minidbg